@@ -17,6 +17,10 @@
  * memory when it reaches the end of its life cycle. In PostgreSQL, a heap
  * allocated datum are usually reclaimed when a memory pool reaches the end of
  * its life cycle, so that objects are almost never explicitly deallocated.
+ * The latter approach is still available for the variable-length values
+ * produced by built-in functions: when a MemoryContext is installed as the
+ * current memory context (see utils/MemoryContext.h), these values are
+ * allocated in it, and the Datums only reference them without owning them.
  *
  * Part of the code is based on postgres.h in PostgreSQL. See COPYRIGHT
  * for a copyright notice for code copied or derived from PostgreSQL.
@@ -238,6 +242,15 @@ private:
  * pointer is not modified (e.g., the caller should have a lock on a tuple on a
  * buffer page).
  *
+ * A variable-length value of at most MaxInlineVarlenSize bytes may also be
+ * stored inline in the Datum itself (m_isinline is true in that case), which
+ * avoids any allocation for short strings such as CHAR(n) and short VARCHARs.
+ * Such a value is never owned (m_isowned is false) and it overlaps the
+ * m_inline_head, m_size and m_val fields. Because the bytes move along with
+ * the Datum, a pointer returned by GetVarlenBytes() on an inline Datum (or on
+ * a DatumRef referencing it) is invalidated when the Datum is moved or
+ * destructed.
+ *
  * Note that the ownership of the memory resource is **irrelevant** to the
  * ownership of the Datum. One should always ensure a Datum is live when it is
  * referenced through a DatumRef or a NullableDatumRef, even if the value is
@@ -304,7 +317,7 @@ public:
      */
     constexpr const char*
     GetVarlenBytes() const {
-        return (const char *) m_val;
+        return m_isinline ? GetInlineBytes() : (const char *) m_val;
     }
 
     /*!
@@ -312,7 +325,7 @@ public:
      */
     constexpr uint32_t
     GetVarlenSize() const {
-        return m_size;
+        return m_isinline ? (uint32_t) m_inline_size : m_size;
     }
 
     /*
@@ -323,7 +336,16 @@ public:
      */
     constexpr absl::string_view
     GetVarlenAsStringView() const {
-        return absl::string_view((const char *) m_val, m_size);
+        return absl::string_view(GetVarlenBytes(), GetVarlenSize());
+    }
+
+    /*!
+     * Returns whether the variable-length value of this datum is stored
+     * inline.
+     */
+    constexpr bool
+    IsInlineVarlen() const {
+        return m_isinline;
     }
 
     /*!
@@ -553,6 +575,21 @@ public:
         return Datum((datum_impl::DatumRep) bytes.release(), true, size);
     }
 
+    /*!
+     * Returns datum representation of a variable-length object by storing a
+     * copy of its bytes inline in the datum. \p size must not be greater than
+     * MaxInlineVarlenSize.
+     */
+    static Datum
+    FromInlineVarlenBytes(const char *bytes, uint32_t size) {
+        ASSERT(size <= MaxInlineVarlenSize);
+        Datum d((datum_impl::DatumRep) 0, false, 0);
+        d.m_isinline = true;
+        d.m_inline_size = (uint8_t) size;
+        memcpy(d.GetInlineBytesForWrite(), bytes, size);
+        return d;
+    }
+
     /*!
      * Returns datum representation of a variable-length object stored as an
      * absl::string_view that is not owned by this datum.
@@ -600,35 +637,51 @@ public:
     }
 
     /*!
-     * Whether this datum is variable-length and owns its byte array.  A Datum
-     * with `HasExternalRef() == true` may only be read when the byte array it
-     * references is still alive (e.g., it must be pinned if it is referencing
-     * a buffer frame). Otherwise, a Datum is safe to be read at any time.
+     * Whether this datum is variable-length and references a byte array that
+     * it neither owns nor stores inline. A Datum with `HasExternalRef() ==
+     * true` may only be read when the byte array it references is still alive
+     * (e.g., it must be pinned if it is referencing a buffer frame, or the
+     * memory context it is allocated in must not have been reset). Otherwise,
+     * a Datum is safe to be read at any time.
      */
     bool
     HasExternalRef() const {
-        return m_isvarlen && m_isowned;
+        return m_isvarlen && !m_isowned && !m_isinline;
     }
 
     /*!
      * Returns a deep copy of this datum so that `HasExternalRef() == false`.
+     * The bytes of a variable-length value are copied unless it is inline,
+     * as the copy may not share the ownership of them with this datum.
      *
      * It may just return itself.
      */
     Datum
     DeepCopy() const {
-        if (HasExternalRef()) {
+        if (HasExternalRef() || m_isowned) {
             const char *bytes = GetVarlenBytes();
             size_t size = GetVarlenSize();
+            if (size <= MaxInlineVarlenSize) {
+                return Datum::FromInlineVarlenBytes(bytes, size);
+            }
             // We don't know what exactly the alignment requirement is, so
             // make it the maximum a type might need.
-            unique_malloced_ptr bytes_copy = unique_aligned_alloc(8, size);
+            // Also note that aligned_alloc() may return a nullptr for a
+            // zero-length request, which would become a null datum.
+            unique_malloced_ptr bytes_copy =
+                unique_aligned_alloc(8, size ? MAXALIGN(size) : 8);
             memcpy(bytes_copy.get(), bytes, size);
             return Datum::FromVarlenBytes(std::move(bytes_copy), size);
         }
         return *this;
     }
 
+    /*!
+     * The maximum size of a variable-length value that may be stored inline
+     * in a Datum.
+     */
+    static constexpr uint32_t MaxInlineVarlenSize = 14;
+
 private:
     /*!
      * Constructs a Datum with a null value.
@@ -637,6 +690,9 @@ private:
         m_isowned(false),
         m_isnull(true),
         m_isvarlen(false),
+        m_isinline(false),
+        m_inline_size(0),
+        m_inline_head(0),
         m_size(0),
         m_val(0) {}
 
@@ -644,6 +700,9 @@ private:
         m_isowned(false),
         m_isnull(false),
         m_isvarlen(false),
+        m_isinline(false),
+        m_inline_size(0),
+        m_inline_head(0),
         m_size(0),
         m_val(value) {}
 
@@ -664,6 +723,9 @@ private:
         m_isowned(isowned),
         m_isnull(false),
         m_isvarlen(true),
+        m_isinline(false),
+        m_inline_size(0),
+        m_inline_head(0),
         m_size(size),
         m_val(value) {}
 
@@ -672,6 +734,29 @@ private:
     Datum(const Datum&) = default;
     Datum &operator=(const Datum&) = default;
 
+    /*!
+     * Returns the inline storage of a variable-length value, which starts at
+     * m_inline_head and extends through the end of m_val.
+     */
+    constexpr const char*
+    GetInlineBytes() const {
+        static_assert(offsetof(Datum, m_inline_head) + MaxInlineVarlenSize
+                      == sizeof(Datum),
+                      "inline varlen bytes must extend to the end of Datum");
+        static_assert(offsetof(Datum, m_size) ==
+                      offsetof(Datum, m_inline_head) + sizeof(uint16_t),
+                      "m_size must immediately follow m_inline_head");
+        static_assert(offsetof(Datum, m_val) ==
+                      offsetof(Datum, m_size) + sizeof(uint32_t),
+                      "m_val must immediately follow m_size");
+        return reinterpret_cast<const char*>(&m_inline_head);
+    }
+
+    char*
+    GetInlineBytesForWrite() {
+        return reinterpret_cast<char*>(&m_inline_head);
+    }
+
     /*!
      * Whether the managed object is owned by this Datum. Currently we assume
      * any owned object is passed by reference and its memory is allocated on
@@ -690,9 +775,26 @@ private:
      */
     bool        m_isvarlen : 1;
 
+    /*!
+     * Whether the variable-length value is stored inline in the datum.
+     */
+    bool        m_isinline : 1;
+
+    /*!
+     * The length of the variable-length value of the datum if it is stored
+     * inline. This is only valid when m_isinline == true.
+     */
+    uint8_t     m_inline_size;
+
+    /*!
+     * The first two bytes of an inline variable-length value. The remaining
+     * bytes are stored in m_size and m_val.
+     */
+    uint16_t    m_inline_head;
+
     /*!
      * The length of the variable-length value of the datum. This is only valid
-     * when m_isvarlen == true.
+     * when m_isvarlen == true and m_isinline == false.
      */
     uint32_t    m_size;
 
@@ -706,6 +808,9 @@ private:
     friend class NullableDatumRef;
 };
 
+/* Inline variable-length values must not increase the size of Datum. */
+static_assert(sizeof(Datum) == 16, "Datum must be 16 bytes");
+
 namespace datum_impl {
 
 template<class DatumImpl>
@@ -17,16 +17,49 @@ namespace taco {
  * This struct is the data actually passed to an fmgr function. In addition to
  * the arguments, we also need to pass the type parameters, unless it is known
  * that the function does not care about the type parameter.
+ *
+ * The arguments are stored in an array owned by the caller (usually on its
+ * stack, see FunctionCallWithTypparam()), so that a function call does not
+ * need any dynamic memory allocation.
  */
 struct FunctionCallInfo
 {
-    std::vector<NullableDatumRef> args;
-    uint64_t                      typparam;
+    const NullableDatumRef  *args;
+    uint32_t                nargs;
+    uint64_t                typparam;
 };
 
 
 typedef Datum (*FunctionPtr)(FunctionCallInfo &fcinfo);
 
+/*!
+ * This struct is the data passed to a vectorized fmgr function, which
+ * evaluates a built-in function over a batch of `n' rows in one call. The
+ * i^th argument is passed as a column vector args[i] of `n' values of its
+ * C++ type (absl::string_view for variable-length types), or as a single
+ * value if the i^th bit of `argconst' is set. argnulls[i] is a null bitmap of
+ * the i^th argument where bit j denotes whether row j is null (bit j is in
+ * byte j / 8 at position j % 8), or nullptr if the argument has no null.
+ * A constant argument has a one-bit null bitmap if not nullptr.
+ *
+ * The function writes the `n' results into `result' and sets the null bitmap
+ * `resultnulls' of (n + 7) / 8 bytes. The values in `result' for the null
+ * rows are unspecified.
+ */
+struct VecFunctionCallInfo
+{
+    const void *const       *args;
+    const uint8_t *const    *argnulls;
+    uint32_t                argconst;
+    uint32_t                nargs;
+    uint32_t                n;
+    void                    *result;
+    uint8_t                 *resultnulls;
+    uint64_t                typparam;
+};
+
+typedef void (*VecFunctionPtr)(VecFunctionCallInfo &vfcinfo);
+
 /*!
  * An FMGR managed function should be declared as
  *
@@ -44,18 +77,22 @@ typedef Datum (*FunctionPtr)(FunctionCallInfo &fcinfo);
  * supplied by the caller (in which case the caller is responsible for checking
  * whether the return value is null).
  *
- * FunctionInfo can be implicitly cast to a bool, to indicate whether it is
- * valid and callable.
+ * FunctionInfo is a plain function pointer, so it may be freely copied and
+ * cached by the callers. It can be implicitly cast to a bool, to indicate
+ * whether it is valid and callable.
  */
-typedef std::function<Datum(FunctionCallInfo&)> FunctionInfo;
+typedef FunctionPtr FunctionInfo;
 
 /* Standard parameter list for fmgr-compatible functions */
 #define FMGR_FUNCTION_ARGS    ::taco::FunctionCallInfo &fcinfo_
 
+/* Standard parameter list for vectorized fmgr-compatible functions */
+#define FMGR_VECFUNCTION_ARGS ::taco::VecFunctionCallInfo &vfcinfo_
+
 /*!
  * Get number of arguments passed to the function.
  */
-#define FMGR_NARGS() (fcinfo_.args.size())
+#define FMGR_NARGS() (fcinfo_.nargs)
 
 /*!
  * Get the n^th argument passed to the function.
@@ -74,35 +111,51 @@ typedef std::function<Datum(FunctionCallInfo&)> FunctionInfo;
  */
 #define FMGR_RETURN_VOID()     return Datum::From(0)
 
-/*!
- * Call a function without passing any type parameter for the return type.
+/*
+ * Call a function with a type parameter for the return type.
+ *
+ * The arguments are passed in an array of NullableDatumRef on the stack of
+ * the caller.
  */
 template<class ...Args>
-Datum
-FunctionCall(const FunctionInfo &func, Args&& ...args) {
+inline Datum
+FunctionCallWithTypparam(FunctionInfo func,
+                         uint64_t typparam,
+                         Args&& ...args) {
+    const NullableDatumRef argv[] = {
+        NullableDatumRef(std::forward<Args>(args))...
+    };
     FunctionCallInfo flinfo {
-        .args = std::vector<NullableDatumRef>{std::forward<Args>(args)...},
-        .typparam = 0
+        .args = argv,
+        .nargs = (uint32_t) sizeof...(Args),
+        .typparam = typparam,
     };
 
     return func(flinfo);
 }
 
 /*
- * Call a function with a type parameter for the return type.
+ * Call a function with no argument with a type parameter for the return type.
  */
-template<class ...Args>
-Datum
-FunctionCallWithTypparam(const FunctionInfo &func,
-                         uint64_t typparam,
-                         Args&& ...args) {
+inline Datum
+FunctionCallWithTypparam(FunctionInfo func, uint64_t typparam) {
     FunctionCallInfo flinfo {
-        .args = std::vector<NullableDatumRef>{std::forward<Args>(args)...},
+        .args = nullptr,
+        .nargs = 0,
         .typparam = typparam,
     };
 
     return func(flinfo);
 }
 
+/*!
+ * Call a function without passing any type parameter for the return type.
+ */
+template<class ...Args>
+inline Datum
+FunctionCall(FunctionInfo func, Args&& ...args) {
+    return FunctionCallWithTypparam(func, 0, std::forward<Args>(args)...);
+}
+
 }   // namespace taco
 
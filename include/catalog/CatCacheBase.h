@@ -4,11 +4,20 @@
 #include "tdb.h"
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/container/node_hash_map.h>
+#include <absl/hash/hash.h>
+#include <absl/strings/ascii.h>
+#include <mutex>
+#include <tuple>
 
 #include "catalog/TableDesc.h"
 #include "catalog/IndexDesc.h"
 #include "catalog/systables.h"
 #include "storage/Record.h"
+#include "query/expr/optypes.h"
+#include "utils/builtin_funcs.h"
+#include "utils/EpochManager.h"
+#include "utils/hash.h"
 
 namespace taco {
 
@@ -30,6 +39,318 @@ struct CCLookupTableEntry {
     std::shared_ptr<void>   m_systable_struct;
 };
 
+/*!
+ * This is an internal data structure of the catalog cache for an in-memory
+ * hash index over a system table. The catalog cache builds one for each index
+ * declared with DEFINE_SYSTABLE_INDEX() when the catalog is loaded, and keeps
+ * it up to date on catalog insertions.
+ *
+ * It maps the hash value of each prefix of the index key to the record IDs
+ * of the catalog entries with that key prefix, so that a lookup over any
+ * prefix of the index key (e.g., all the columns of a table through the
+ * index on Column(coltabid, colid)) is a single hash table probe followed by
+ * a recheck of the few candidates. The candidates are not ordered by the
+ * remaining key columns.
+ *
+ * A key column is hashed with the hash function of its type, except that a
+ * VARCHAR column is always hashed case-insensitively, which is consistent with
+ * both the case-sensitive and the case-insensitive string equality used by the
+ * catalog lookups.
+ */
+struct CCIndex {
+    CCIndex(Oid idxid,
+            Oid tabid,
+            std::vector<FieldId> tabcolids,
+            std::vector<FunctionInfo> hashfuncs):
+        m_idxid(idxid),
+        m_tabid(tabid),
+        m_tabcolids(std::move(tabcolids)),
+        m_hashfuncs(std::move(hashfuncs)),
+        m_prefix_map(m_tabcolids.size()) {
+        ASSERT(m_tabcolids.size() == m_hashfuncs.size());
+    }
+
+    /*!
+     * Returns whether a lookup over the table \p tabid with equality
+     * predicates on the \p npreds columns \p tabcolids can use this index,
+     * i.e., they are a prefix of the index key.
+     */
+    bool
+    CanLookup(Oid tabid, size_t npreds, const FieldId *tabcolids) const {
+        if (tabid != m_tabid || npreds == 0 || npreds > m_tabcolids.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < npreds; ++i) {
+            if (tabcolids[i] != m_tabcolids[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*!
+     * Combines the hash value \p h of the first \p i key columns with the
+     * hash value of the \p i-th key column value \p value.
+     */
+    uint64_t
+    HashKeyColumn(uint64_t h, size_t i, const Datum &value) const {
+        uint64_t colhash = value.isnull() ? NullHashValue :
+            FunctionCall(m_hashfuncs[i], value).GetUInt64();
+        return HashCombine(h, colhash);
+    }
+
+    /*!
+     * Adds the catalog entry \p recdata with the record ID \p recid into the
+     * index.
+     */
+    void
+    Insert(const std::vector<Datum> &recdata, RecordId recid) {
+        uint64_t h = 0;
+        for (size_t i = 0; i < m_tabcolids.size(); ++i) {
+            h = HashKeyColumn(h, i, recdata[m_tabcolids[i]]);
+            m_prefix_map[i][h].push_back(recid);
+        }
+    }
+
+    /*!
+     * Returns the record IDs of the candidate entries whose first \p npreds
+     * key columns have the hash value \p h, or nullptr if there is none.
+     */
+    const std::vector<RecordId>*
+    Find(size_t npreds, uint64_t h) const {
+        ASSERT(npreds > 0 && npreds <= m_prefix_map.size());
+        auto iter = m_prefix_map[npreds - 1].find(h);
+        if (iter == m_prefix_map[npreds - 1].end()) {
+            return nullptr;
+        }
+        return &iter->second;
+    }
+
+    Oid                         m_idxid;
+    Oid                         m_tabid;
+    std::vector<FieldId>        m_tabcolids;
+    std::vector<FunctionInfo>   m_hashfuncs;
+
+    /*!
+     * m_prefix_map[i] maps the hash values of the first i + 1 key columns to
+     * the record IDs of the entries.
+     */
+    std::vector<absl::flat_hash_map<uint64_t, std::vector<RecordId>>>
+                                m_prefix_map;
+};
+
+/*!
+ * This is an internal data structure of the catalog cache for a read-mostly
+ * hash map that can be searched without any lock. It is an open addressing
+ * hash table with linear probing over an array of atomic pointers to
+ * immutable nodes. An insertion publishes a new node into an empty slot with
+ * a single release store, and an update publishes a new node into the slot of
+ * the old one and retires the old one through the epoch manager. The slot
+ * array is never filled more than half. Once it would be, the node pointers
+ * are rehashed into a new array of twice the size, which is published in
+ * place of the old array, and the old array is retired. So an insertion is
+ * amortized O(1), and the nodes are never copied.
+ *
+ * Find() must be called in a read-side critical section of the epoch manager
+ * passed to Insert() and InsertOrAssign(), and the returned pointer is only
+ * valid within that critical section. The writers are serialized by a latch
+ * of the map, so they may run concurrently with each other and with the
+ * readers. A reader racing with a writer may miss the key being inserted.
+ */
+template<class K, class V>
+class CCConcurrentMap {
+public:
+    CCConcurrentMap():
+        m_table(new Table(InitialCapacity)),
+        m_size(0) {}
+
+    ~CCConcurrentMap() {
+        const Table *table = m_table.load(memory_order_relaxed);
+        for (size_t i = 0; i <= table->m_mask; ++i) {
+            delete table->m_slots[i].load(memory_order_relaxed);
+        }
+        delete table;
+    }
+
+    CCConcurrentMap(const CCConcurrentMap&) = delete;
+    CCConcurrentMap &operator=(const CCConcurrentMap&) = delete;
+
+    /*!
+     * Returns the value of \p key, or nullptr if it is not found.
+     */
+    const V*
+    Find(const K &key) const {
+        const Table *table = m_table.load(memory_order_acquire);
+        const Node *node;
+        FindSlot(table, key, &node);
+        if (!node) {
+            return nullptr;
+        }
+        return &node->m_value;
+    }
+
+    /*!
+     * Inserts \p key with \p value if it does not exist yet. Returns whether
+     * it is inserted.
+     */
+    bool
+    Insert(EpochManager *epoch, const K &key, V value) {
+        std::lock_guard<std::mutex> guard(m_write_latch);
+        const Node *old_node;
+        atomic<const Node*> *slot = FindSlotForInsert(epoch, key, &old_node);
+        if (old_node) {
+            return false;
+        }
+        slot->store(new Node{key, std::move(value)}, memory_order_release);
+        ++m_size;
+        return true;
+    }
+
+    /*!
+     * Inserts \p key with \p value, or replaces the value of \p key if it
+     * already exists.
+     */
+    void
+    InsertOrAssign(EpochManager *epoch, const K &key, V value) {
+        std::lock_guard<std::mutex> guard(m_write_latch);
+        const Node *old_node;
+        atomic<const Node*> *slot = FindSlotForInsert(epoch, key, &old_node);
+        slot->store(new Node{key, std::move(value)}, memory_order_release);
+        if (old_node) {
+            epoch->Retire(old_node);
+        } else {
+            ++m_size;
+        }
+    }
+
+private:
+    static constexpr size_t InitialCapacity = 64;
+
+    struct Node {
+        K   m_key;
+        V   m_value;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity):
+            m_mask(capacity - 1),
+            m_slots(new atomic<const Node*>[capacity]) {
+            for (size_t i = 0; i < capacity; ++i) {
+                m_slots[i].store(nullptr, memory_order_relaxed);
+            }
+        }
+
+        size_t                                  m_mask;
+        std::unique_ptr<atomic<const Node*>[]>  m_slots;
+    };
+
+    /*!
+     * Returns the slot of \p key in \p table, or the empty slot where it
+     * would be inserted if it is not found. The node in the slot is returned
+     * in \p p_node, which is nullptr for an empty slot. The caller must not
+     * load the slot again to find the node, as a writer may insert another
+     * key into an empty slot at any time.
+     */
+    static atomic<const Node*>*
+    FindSlot(const Table *table, const K &key, const Node **p_node) {
+        size_t i = absl::Hash<K>()(key) & table->m_mask;
+        for (;;) {
+            const Node *node = table->m_slots[i].load(memory_order_acquire);
+            if (!node || node->m_key == key) {
+                *p_node = node;
+                return &table->m_slots[i];
+            }
+            i = (i + 1) & table->m_mask;
+        }
+    }
+
+    /*!
+     * Same as FindSlot() on the current table, except that it first grows
+     * the table if it is half full. The caller must hold m_write_latch.
+     */
+    atomic<const Node*>*
+    FindSlotForInsert(EpochManager *epoch, const K &key,
+                      const Node **p_node) {
+        const Table *table = m_table.load(memory_order_relaxed);
+        if ((m_size + 1) * 2 > table->m_mask + 1) {
+            Table *new_table = new Table((table->m_mask + 1) * 2);
+            for (size_t i = 0; i <= table->m_mask; ++i) {
+                const Node *node =
+                    table->m_slots[i].load(memory_order_relaxed);
+                if (node) {
+                    const Node *dummy;
+                    FindSlot(new_table, node->m_key, &dummy)->store(
+                        node, memory_order_relaxed);
+                }
+            }
+            m_table.store(new_table, memory_order_release);
+            epoch->Retire(table);
+            table = new_table;
+        }
+        return FindSlot(table, key, p_node);
+    }
+
+    atomic<const Table*>    m_table;
+
+    std::mutex              m_write_latch;
+
+    //! The number of keys in the map. Guarded by m_write_latch.
+    size_t                  m_size;
+};
+
+/*!
+ * This is an internal data structure of the catalog cache for resolving
+ * operators to their functions. It maps the operator type and the two operand
+ * types to the operator function ID and its function pointers. Its size is
+ * linear in the number of operators.
+ *
+ * The catalog cache fills it with all the operators in the Operator systable
+ * once, and then adds each new operator when it is inserted, so a key not
+ * found in a complete operator cache means there is no such operator. The
+ * lookups are lock-free and follow the same rules as CCConcurrentMap.
+ */
+class CCOperatorCache {
+public:
+    struct Entry {
+        Oid             m_opfuncid;
+        FunctionInfo    m_func;
+        VecFunctionPtr  m_vecfunc;
+    };
+
+    /*!
+     * Adds the operator \p optype over \p oparg0typid and \p oparg1typid
+     * with the function \p opfuncid if it is not in the cache yet.
+     */
+    void
+    Add(EpochManager *epoch, OpType optype, Oid oparg0typid, Oid oparg1typid,
+        Oid opfuncid) {
+        m_map.Insert(epoch, Key(optype, oparg0typid, oparg1typid),
+                     Entry{opfuncid, FindBuiltinFunction(opfuncid),
+                           FindBuiltinVecFunction(opfuncid)});
+    }
+
+    /*!
+     * Returns the entry for the operator \p optype over \p oparg0typid and
+     * \p oparg1typid (InvalidOid for the missing operand of a unary
+     * operator), or one with m_opfuncid == InvalidOid if it is not found.
+     */
+    Entry
+    Find(OpType optype, Oid oparg0typid, Oid oparg1typid) const {
+        const Entry *entry =
+            m_map.Find(Key(optype, oparg0typid, oparg1typid));
+        if (!entry) {
+            return Entry{InvalidOid, nullptr, nullptr};
+        }
+        return *entry;
+    }
+
+private:
+    //! (optype, oparg0typid, oparg1typid)
+    typedef std::tuple<OpType, Oid, Oid> Key;
+
+    CCConcurrentMap<Key, Entry> m_map;
+};
+
 /*!
  * Some internal functions of catalog cache implementations. This is a friend
  * class of all SysTable_xxx structs so that it can provide access to members
@@ -98,12 +419,21 @@ protected:
  * and `PersistentCatCache' which provides file accsess to the regular files
  * managed by the file manager. See these two classes for a list of required
  * file access functions.
+ *
+ * The catalog cache is thread-safe. All the lookups first search a few
+ * lock-free concurrent maps (see CCConcurrentMap) of the entries found
+ * earlier, so that concurrent readers do not contend with each other once the
+ * cache is warm. Only the cache misses and the catalog updates are serialized
+ * by a latch. The catalog entries and descriptors returned are owned by the
+ * catalog cache and are valid until it is destructed.
  */
 template<class CatCacheCls>
 class CatCacheBase: public CatCacheInternalAccess {
 public:
     CatCacheBase();
 
+    ~CatCacheBase();
+
     /*!
      * Initializes the catalog cache from the existing data.
      */
@@ -115,6 +445,30 @@ public:
      */
     void InitializeFromInitData(const std::string &init_datafile);
 
+    /*!
+     * Creates the catalog from a catalog image file \p init_imagefile and
+     * initializes the catalog cache. This is the same as
+     * InitializeFromInitData(init_datafile) except that the catalog records
+     * are copied from the image instead of being parsed from the init data
+     * file.
+     *
+     * Returns false without creating anything if the image file does not
+     * exist, is corrupted, or was not created from \p init_datafile. The
+     * caller should fall back to InitializeFromInitData() in that case.
+     */
+    bool InitializeFromInitImage(const std::string &init_imagefile,
+                                 const std::string &init_datafile);
+
+    /*!
+     * Writes the catalog records of a catalog cache that has just been
+     * created with InitializeFromInitData(\p init_datafile) into a catalog
+     * image file \p init_imagefile. The image file may only be used by the
+     * same build of the program, as it stores the record payloads as they
+     * are.
+     */
+    void WriteInitImage(const std::string &init_imagefile,
+                        const std::string &init_datafile);
+
     /*!
      * Returns if the catalog cache has been initialized.
      */
@@ -123,7 +477,7 @@ public:
         return m_initialized;
     }
 
-    inline std::shared_ptr<const SysTable_Table>
+    inline const SysTable_Table*
     FindTable(Oid tabid) {
         auto entry =
             SearchForCatalogEntryByOid(initoids::TAB_Table,
@@ -133,8 +487,7 @@ public:
         if (!entry) {
             return nullptr;
         }
-        return static_pointer_cast<const SysTable_Table>(
-            entry->m_systable_struct);
+        return (const SysTable_Table*) entry->m_systable_struct.get();
     }
 
     inline Oid
@@ -151,9 +504,9 @@ public:
             ->tabid();
     }
 
-    std::shared_ptr<const TableDesc> FindTableDesc(Oid tabid);
+    const TableDesc *FindTableDesc(Oid tabid);
 
-    inline std::shared_ptr<const SysTable_Type>
+    inline const SysTable_Type*
     FindType(Oid typid) {
         auto entry =
             SearchForCatalogEntryByOid(initoids::TAB_Type,
@@ -163,11 +516,10 @@ public:
         if (!entry) {
             return nullptr;
         }
-        return static_pointer_cast<const SysTable_Type>(
-            entry->m_systable_struct);
+        return (const SysTable_Type*) entry->m_systable_struct.get();
     }
 
-    inline std::shared_ptr<const SysTable_Function>
+    inline const SysTable_Function*
     FindFunction(Oid funcid) {
         auto entry =
             SearchForCatalogEntryByOid(initoids::TAB_Function,
@@ -177,8 +529,7 @@ public:
         if (!entry) {
             return nullptr;
         }
-        return static_pointer_cast<const SysTable_Function>(
-            entry->m_systable_struct);
+        return (const SysTable_Function*) entry->m_systable_struct.get();
     }
 
     inline Oid
@@ -195,8 +546,20 @@ public:
             ->funcid();
     }
 
-    inline std::shared_ptr<const SysTable_FunctionArgs>
+    inline const SysTable_FunctionArgs*
     FindFunctionArgs(Oid funcid, int16_t funcargid) {
+        FunctionArgsLookupKey key(funcid, funcargid);
+        {
+            EpochGuard epoch_guard(&m_epoch);
+            CCLookupTableEntry *const *entry =
+                m_funcargs_lookup_table.Find(key);
+            if (entry) {
+                return (const SysTable_FunctionArgs*)
+                    (*entry)->m_systable_struct.get();
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> guard(m_latch);
         auto entry = SearchForCatalogEntry<true, 2, false>::Call(
             this, initoids::TAB_FunctionArgs,
             initoids::IDX_FunctionArgs_funcid_funcargid,
@@ -207,11 +570,13 @@ public:
         if (!entry) {
             return nullptr;
         }
-        return static_pointer_cast<const SysTable_FunctionArgs>(
-            entry->m_systable_struct);
+        if (m_initialized) {
+            m_funcargs_lookup_table.Insert(&m_epoch, key, entry);
+        }
+        return (const SysTable_FunctionArgs*) entry->m_systable_struct.get();
     }
 
-    inline std::shared_ptr<const SysTable_Index>
+    inline const SysTable_Index*
     FindIndex(Oid idxid) {
         auto entry =
             SearchForCatalogEntryByOid(initoids::TAB_Index,
@@ -221,15 +586,14 @@ public:
         if (!entry) {
             return nullptr;
         }
-        return static_pointer_cast<const SysTable_Index>(
-            entry->m_systable_struct);
+        return (const SysTable_Index*) entry->m_systable_struct.get();
     }
 
     inline Oid
     FindIndexByName(absl::string_view idxname) {
         auto entry =
             SearchForCatalogEntryByName(initoids::TAB_Index,
-                                        InvalidOid,
+                                        initoids::IDX_Index_idxname,
                                         SysTable_Index::idxname_colid(),
                                         idxname);
         if (!entry) {
@@ -239,8 +603,25 @@ public:
             ->idxid();
     }
 
+    /*!
+     * Returns the IDs of all the indexes over the table \p idxtabid. The
+     * result is remembered after the catalog cache is initialized, and is
+     * kept up to date when a new index is added.
+     */
     inline std::vector<Oid>
     FindAllIndexesOfTable(Oid idxtabid) {
+        {
+            EpochGuard epoch_guard(&m_epoch);
+            const std::vector<Oid> *idxids =
+                m_table_indexes_lookup_table.Find(idxtabid);
+            if (idxids) {
+                return *idxids;
+            }
+        }
+
+        // Holds the latch until the result is remembered, so that it can't
+        // miss an index added in between.
+        std::lock_guard<std::recursive_mutex> guard(m_latch);
         auto entries = SearchForCatalogEntry<false, 1, false>::Call(
             this, initoids::TAB_Index, initoids::IDX_Index_idxtabid, 0,
             {SysTable_Index::idxtabid_colid()}, {initoids::FUNC_OID_eq},
@@ -251,10 +632,13 @@ public:
             ret.push_back(
                 ((SysTable_Index*) entry->m_systable_struct.get())->idxid());
         }
+        if (m_initialized) {
+            m_table_indexes_lookup_table.Insert(&m_epoch, idxtabid, ret);
+        }
         return ret;
     }
 
-    std::shared_ptr<const IndexDesc> FindIndexDesc(Oid idxid);
+    const IndexDesc *FindIndexDesc(Oid idxid);
 
     /*!
      * Returns the operator function id of the one with the specific operand
@@ -263,15 +647,39 @@ public:
      * It is an error if the operand types are not fully specified (e.g., only
      * one side specified for a binary operator). TODO Use FindOperators()
      * instead to find operators that partially match the operand types.
+     *
+     * A cast (OPTYPE(CAST) or OPTYPE(IMPLICIT_CAST)) is found by its source
+     * type in \p oparg0typid and its target type in \p oparg1typid.
+     *
+     * The operators are resolved through an operator cache (see
+     * CCOperatorCache) without any lock once the catalog cache is
+     * initialized, including the ones that do not exist.
      */
     Oid FindOperator(OpType optype, Oid oparg0typid, Oid oparg1typid);
 
+    /*!
+     * Same as FindOperator(), except that it returns the function pointer of
+     * the operator function, or nullptr if the operator does not exist or its
+     * function is not a built-in function. The operator function ID is
+     * returned in \p p_opfuncid if it is not nullptr, and the vectorized
+     * variant of the function in \p p_vecfunc if it is not nullptr.
+     */
+    FunctionInfo FindOperatorFunction(OpType optype,
+                                      Oid oparg0typid,
+                                      Oid oparg1typid,
+                                      Oid *p_opfuncid = nullptr,
+                                      VecFunctionPtr *p_vecfunc = nullptr);
+
     /*!
      * Searches for the systable entry with ID \p recid in the given systable
      * \p systabid.
      *
      * This assumes that there is only one record matching the oid. Otherwise,
      * it will return the first one it finds.
+     *
+     * The entries found are remembered in a lock-free concurrent map after
+     * the catalog cache is initialized, so that later lookups of them do not
+     * acquire the latch.
      */
     inline CCLookupTableEntry*
     SearchForCatalogEntryByOid(
@@ -279,9 +687,23 @@ public:
         Oid idxid_hint,
         FieldId oid_colid,
         Oid oid) {
-        return SearchForCatalogEntry<true, 1, false>::Call(
+        OidLookupKey key(systabid, oid_colid, oid);
+        {
+            EpochGuard epoch_guard(&m_epoch);
+            CCLookupTableEntry *const *entry = m_oid_lookup_table.Find(key);
+            if (entry) {
+                return *entry;
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> guard(m_latch);
+        CCLookupTableEntry *entry = SearchForCatalogEntry<true, 1, false>::Call(
             this, systabid, idxid_hint,
             {oid_colid}, {initoids::FUNC_OID_eq}, oid);
+        if (entry && m_initialized) {
+            m_oid_lookup_table.Insert(&m_epoch, key, entry);
+        }
+        return entry;
     }
 
     /*!
@@ -290,6 +712,10 @@ public:
      *
      * This assumes there is only one record matching the name. Otherwise, it
      * will return the first one it finds.
+     *
+     * The entries found are remembered by their lowercased names in the same
+     * way as SearchForCatalogEntryByOid(), since the names are compared
+     * case-insensitively.
      */
     inline CCLookupTableEntry*
     SearchForCatalogEntryByName(
@@ -297,9 +723,23 @@ public:
         Oid idxid_hint,
         FieldId name_colid,
         absl::string_view name) {
-        return SearchForCatalogEntry<true, 1, false>::Call(
-            this, systabid, InvalidOid, {name_colid},
+        NameLookupKey key(systabid, name_colid, absl::AsciiStrToLower(name));
+        {
+            EpochGuard epoch_guard(&m_epoch);
+            CCLookupTableEntry *const *entry = m_name_lookup_table.Find(key);
+            if (entry) {
+                return *entry;
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> guard(m_latch);
+        CCLookupTableEntry *entry = SearchForCatalogEntry<true, 1, false>::Call(
+            this, systabid, idxid_hint, {name_colid},
             {initoids::FUNC_VARCHAR___STRING_eq_ci}, name);
+        if (entry && m_initialized) {
+            m_name_lookup_table.Insert(&m_epoch, std::move(key), entry);
+        }
+        return entry;
     }
 
     template<bool expect_unique, size_t NPreds, bool no_cache>
@@ -378,15 +818,37 @@ public:
      * for the type (e.g., case insensitive string comparison). Any InvalidOid
      * or missing values in idxcolltfuncids and idxcoleqfuncids are looked up
      * from the catalog.
+     *
+     * The columns in idxinclcolids are stored in the index entries after the
+     * key columns as INCLUDE columns, so that a scan that only needs the key
+     * columns and these may be answered from the index alone. They are not
+     * part of the key and need no operator.
      */
     Oid AddIndex(absl::string_view idxname,
                  Oid idxtabid,
                  IdxType idxtyp,
                  bool idxunique,
                  std::vector<FieldId> idxcoltabcolids,
+                 std::vector<FieldId> idxinclcolids,
                  FileId idxfid,
                  std::vector<Oid> idxcolltfuncids,
                  std::vector<Oid> idxcoleqfuncids);
+
+protected:
+    /*!
+     * Reads the catalog image file \p init_imagefile into memory and checks
+     * if it is valid and created from \p init_datafile. Returns the image
+     * or nullptr if the image may not be used.
+     */
+    static unique_malloced_ptr ReadInitImage(const std::string &init_imagefile,
+                                             const std::string &init_datafile);
+
+    /*!
+     * Creates the catalog from a catalog image returned by ReadInitImage()
+     * and initializes the catalog cache.
+     */
+    void LoadInitImage(const char *image);
+
 private:
     /*!
      * Creates and initializes the database meta file. This must be called
@@ -417,18 +879,37 @@ private:
     void LoadMinCache(BootstrapCatCache *catcache);
 
     /*!
-     * Checks if any of the catalog indexes need to be initialized and/or
-     * rebuilt. If \p init is true, it will go over all the entries in the
-     * Index systable; update them; initialize and load the new indexes.
+     * Builds the in-memory hash indexes (see CCIndex) for all the indexes over
+     * the system tables in the Index systable, and enables the catalog
+     * lookups to use them. They are never stored on disk so they are always
+     * rebuilt regardless of \p init.
      *
-     * Its behavior is also affected by `g_test_no_index` and
-     * `g_test_catcache_use_volatiletree`. See documents for those two global
-     * variables for details.
+     * No index is built if `g_test_no_index` is true, in which case all the
+     * catalog lookups fall back to table scans.
      */
     void CheckIndexes(bool init);
 
+    /*!
+     * Builds the in-memory hash index for the index \p idxid over a system
+     * table by scanning the table.
+     */
     void BuildIndex(bool init, Oid idxid);
 
+    /*!
+     * Looks up the operator \p optype over \p oparg0typid and \p
+     * oparg1typid in the operator cache, or in the Operator systable if the
+     * operator cache has not been built yet.
+     */
+    CCOperatorCache::Entry LookupOperator(OpType optype,
+                                          Oid oparg0typid,
+                                          Oid oparg1typid);
+
+    /*!
+     * Fills the operator cache with all the operators in the Operator
+     * systable and marks it complete.
+     */
+    void BuildOperatorCache();
+
     /*!
      * Allocates an object ID. Returns a valid Oid that will never be returned
      * again unless it is deallocated on success. Otherwise, it returns
@@ -460,10 +941,62 @@ private:
 
     bool m_initialized;
     bool m_use_index;
-    //absl::flat_hash_map<Oid, CCLookupTableEntry> m_oid_lookup_table;
-    absl::flat_hash_map<RecordId, CCLookupTableEntry> m_recid_lookup_table;
-    absl::flat_hash_map<Oid, std::shared_ptr<TableDesc>> m_table_desc;
-    absl::flat_hash_map<Oid, std::shared_ptr<IndexDesc>> m_index_desc;
+
+    /*!
+     * Serializes the catalog updates and the lookups that can't be answered
+     * from the concurrent maps. It is recursive because a lookup may need to
+     * look up the descriptors of the system tables.
+     */
+    std::recursive_mutex m_latch;
+
+    /*!
+     * The epoch manager for the concurrent maps.
+     */
+    EpochManager m_epoch;
+
+    //! (systabid, oid_colid, oid)
+    typedef std::tuple<Oid, FieldId, Oid> OidLookupKey;
+    CCConcurrentMap<OidLookupKey, CCLookupTableEntry*> m_oid_lookup_table;
+
+    //! (systabid, name_colid, lowercased name)
+    typedef std::tuple<Oid, FieldId, std::string> NameLookupKey;
+    CCConcurrentMap<NameLookupKey, CCLookupTableEntry*> m_name_lookup_table;
+
+    //! (funcid, funcargid)
+    typedef std::tuple<Oid, int16_t> FunctionArgsLookupKey;
+    CCConcurrentMap<FunctionArgsLookupKey, CCLookupTableEntry*>
+        m_funcargs_lookup_table;
+
+    /*!
+     * The index IDs of the tables found by FindAllIndexesOfTable(), keyed by
+     * idxtabid. InsertCatalogEntries() appends the new indexes to them.
+     */
+    CCConcurrentMap<Oid, std::vector<Oid>> m_table_indexes_lookup_table;
+
+    /*!
+     * The cached catalog entries keyed by their record ids. This needs to be
+     * a node hash map because the lookups hand out pointers to the entries
+     * while still inserting new ones.
+     */
+    absl::node_hash_map<RecordId, CCLookupTableEntry> m_recid_lookup_table;
+    std::vector<std::unique_ptr<TableDesc>> m_table_desc;
+    CCConcurrentMap<Oid, const TableDesc*> m_table_desc_lookup_table;
+    std::vector<std::unique_ptr<IndexDesc>> m_index_desc;
+    CCConcurrentMap<Oid, const IndexDesc*> m_index_desc_lookup_table;
+
+    /*!
+     * The operator cache, which may only be used for lookups after
+     * m_operator_cache_complete is set. InsertCatalogEntries() adds the new
+     * operators to it.
+     */
+    CCOperatorCache m_operator_cache;
+    atomic<bool> m_operator_cache_complete;
+
+    /*! The in-memory hash indexes over the system tables, keyed by idxid. */
+    absl::flat_hash_map<Oid, std::unique_ptr<CCIndex>> m_cc_index;
+
+    /*! The in-memory hash indexes over each system table. */
+    absl::flat_hash_map<Oid, std::vector<CCIndex*>> m_systable_cc_index;
 };
 
 }   // namespace taco
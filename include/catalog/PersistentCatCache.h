@@ -0,0 +1,275 @@
+#ifndef CATALOG_PERSISTENT_CATCACHE_H
+#define CATALOG_PERSISTENT_CATCACHE_H
+
+#include "tdb.h"
+
+#include "catalog/CatCacheBase.h"
+#include "storage/FileManager.h"
+#include "storage/Record.h"
+
+namespace taco {
+
+/*!
+ * PersistentCatCache stores the catalog files on disk in the database
+ * directory, so that the catalog survives a restart and can be loaded with
+ * InitializeFromExistingData() instead of being rebuilt from the init data
+ * file.
+ *
+ * We don't have a heap file or a buffer manager yet, so the catalog files
+ * are catalog-private page files under `<db path>/catalog', named by their
+ * file IDs. A heap catalog file is a sequence of slotted pages. All the
+ * pages are read into memory when the catalog is opened (the catalog is
+ * small), and a page is written back to its file as soon as it is modified,
+ * except that a new catalog is written back only once it is fully created.
+ * The DB meta file is a single page file and is written back on
+ * MarkPageDirty(). The file writes are followed by fsync(2) only if
+ * FORCE_FSYNC is defined.
+ *
+ * The record IDs of the catalog entries are unique across all the catalog
+ * files: the page number of a record ID encodes the file ID in its high
+ * bits, as the catalog cache identifies the cached entries by their record
+ * IDs only.
+ */
+class PersistentCatCache: public CatCacheBase<PersistentCatCache> {
+public:
+    PersistentCatCache();
+
+    ~PersistentCatCache();
+
+    /*!
+     * Creates the catalog files in the database directory from an init data
+     * file and initializes the catalog cache.
+     */
+    void InitializeFromInitData(const std::string &init_datafile);
+
+    /*!
+     * Creates the catalog files in the database directory from a catalog
+     * image file and initializes the catalog cache. See
+     * CatCacheBase::InitializeFromInitImage().
+     */
+    bool InitializeFromInitImage(const std::string &init_imagefile,
+                                 const std::string &init_datafile);
+
+    /*!
+     * Loads the catalog files from the database directory and initializes
+     * the catalog cache.
+     */
+    void InitializeFromExistingData();
+
+private:
+    /*!
+     * The header of a page in a heap catalog file. The slot array is at the
+     * end of the page and grows backwards, while the records are appended
+     * after the header. A slot with an offset of 0 is a deleted record.
+     */
+    struct CatPageHeader {
+        //! Kept so that the page layout is compatible with the FileManager.
+        //! Unused.
+        PageHeaderData  m_ph;
+        uint16_t        m_nslots;
+        uint16_t        m_free_offset;
+    };
+
+    struct CatSlot {
+        uint16_t        m_offset;
+        uint16_t        m_length;
+    };
+
+    struct CatFile {
+        int                             m_fd;
+        bool                            m_is_heapfile;
+        std::vector<unique_malloced_ptr> m_pages;
+    };
+
+    /*!
+     * The number of bits in a page number of a record ID for the page
+     * number within a file. The remaining high bits are the file ID.
+     */
+    static constexpr int PageNumberBits = 20;
+
+    /*!
+     * The largest file ID of a catalog file, which must fit in the remaining
+     * high bits of a page number.
+     */
+    static constexpr FileId MaxCatFileId =
+        (((FileId) 1) << (sizeof(PageNumber) * 8 - PageNumberBits)) - 1;
+
+    /*!
+     * An opaque handle for iterating a catalog file. The iterator does not
+     * return the records appended after it is created.
+     */
+    struct CatFileIterator {
+        FileId      m_fid;
+        PageNumber  m_pageno;
+        SlotId      m_sid;
+        PageNumber  m_end_pageno;
+        SlotId      m_end_nslots;
+    };
+
+    /*!
+     * Creates a new catalog file in the database directory and returns its
+     * file ID. If \p format_heapfile is true, the opened file will be
+     * accessed through the following record and iterator iterfaces.
+     * Otherwise, it is accessed as an unformatted file consisting of pages,
+     * which should initially have just one page. The second argument is
+     * unused and is only kept for compatibility.
+     *
+     * The first file ever allocated through this function is assumed to have
+     * file ID 1.
+     */
+    FileId CreateCatalogFile(bool format_heapfile, FieldOffset /*unused*/ = 0);
+
+    /*!
+     * An opaque handle for a catalog file. The files do not need to be
+     * closed, so we just use the file ID as the handle.
+     */
+    typedef FileId FileHandle;
+
+    /*!
+     * Opens a catalog file for access. The second argument \p tabdesc is
+     * unused.
+     */
+    FileHandle OpenCatalogFile(FileId fid, const TableDesc *tabdesc);
+
+    /*!
+     * Closes a catalog file pointed by the file handle. This does nothing
+     * except for setting fh to INVALID_FID.
+     */
+    void CloseCatalogFile(FileHandle &fh);
+
+    /*!
+     * An opaque handle for a data page in an unformatted catalog file.
+     */
+    typedef int PageHandle;
+
+    /*!
+     * Returns a handle to the first page in the unformatted catalog file
+     * with its in-memory copy in \p pagebuf. One may only invoke this on the
+     * DB meta file.
+     */
+    PageHandle GetFirstPage(FileHandle &fh, char **pagebuf);
+
+    /*!
+     * Marks a page pointed by the page handle as dirty, which writes it back
+     * to the file.
+     */
+    void MarkPageDirty(PageHandle &pghandle);
+
+    /*!
+     * Releases the page pointed by the page handle. This does nothing.
+     */
+    void ReleasePage(PageHandle &pghandle);
+
+    /*!
+     * Appends a record to the catalog file specified by the file ID. This also
+     * updates the `rec.GetRecordID()' to the record ID of the newly inserted
+     * record.
+     */
+    void AppendRecord(FileHandle &fh, Record &rec);
+
+    /*!
+     * Creates an iterator over the catalog file specified by the file ID.
+     */
+    CatFileIterator IterateCatEntry(FileHandle &fh);
+
+    /*!
+     * Creates an iterator that starts at \p rid. The iterator may or may not
+     * return additional records after the first one if \p rid exists.
+     */
+    CatFileIterator IterateCatEntryFrom(FileHandle &fh, RecordId rid);
+
+    /*!
+     * Tries to move the iterator to the next row and returns whether such
+     * a row exists.
+     */
+    bool NextCatEntry(CatFileIterator &iter);
+
+    /*!
+     * Returns the current catalog entry pointed by the iterator as a buffer
+     * pointer. It is undefined if a NextCatEntry has not been called or a
+     * previous call returns `false'.
+     */
+    const char *GetCurrentCatEntry(CatFileIterator &iter);
+
+    /*!
+     * Returns the current catalog entry's record ID.  It is undefined if a
+     * NextCatEntry has not been called or a previous call returns `false'.
+     */
+    RecordId GetCurrentCatEntryRecordId(CatFileIterator &iter);
+
+    /*!
+     * Updates the current catalog entry pointed by the iterator with the
+     * record \p rec. The record is updated in place if it fits in the old
+     * one. Otherwise, the old one is deleted and the new one is appended to
+     * the file, which will not be returned by the same iterator.
+     */
+    void UpdateCurrentCatEntry(CatFileIterator &iter, Record &rec);
+
+    /*!
+     * Releses any resource associated with the catalog file iterator. This
+     * does nothing except for invalidating the iterator.
+     */
+    void EndIterateCatEntry(CatFileIterator &iter);
+
+    /*!
+     * Creates the catalog directory `<db path>/catalog', which must not
+     * exist yet.
+     */
+    void CreateCatalogDir();
+
+    /*!
+     * Returns the catalog file \p fid.
+     */
+    CatFile *GetCatFile(FileId fid);
+
+    /*!
+     * Returns the path of the catalog file \p fid.
+     */
+    std::string GetCatFilePath(FileId fid) const;
+
+    /*!
+     * Writes the page \p pageno of the catalog file \p f back to disk.
+     */
+    void WritePage(FileId fid, CatFile *f, PageNumber pageno);
+
+    /*!
+     * Appends a new empty heap page to the catalog file \p f.
+     */
+    void AppendHeapPage(FileId fid, CatFile *f);
+
+    /*!
+     * Writes all the pages of all the catalog files back to disk, and turns
+     * off m_defer_writes.
+     */
+    void FlushDeferredWrites();
+
+    /*!
+     * The catalog directory, `<db path>/catalog'.
+     */
+    std::string     m_catalog_dir;
+
+    /*!
+     * The catalog files. The index into this vector is file ID - 1.
+     */
+    std::vector<std::unique_ptr<CatFile>> m_files;
+
+    /*!
+     * Whether WritePage() is deferred until FlushDeferredWrites(). This is
+     * only turned on while creating a new catalog, which is not usable
+     * until it is done anyway, so that each page is written once rather
+     * than once per record.
+     */
+    bool            m_defer_writes;
+
+    friend class CatCacheBase<PersistentCatCache>;
+};
+
+/*!
+ * Declare explicit instantiation of the base class of PersistentCatCache,
+ * which will be defined in catalog/PersistentCatCache.cpp.
+ */
+extern template class CatCacheBase<PersistentCatCache>;
+
+}    // namespace taco
+
+#endif      // CATALOG_PERSISTENT_CATCACHE_H
@@ -57,6 +57,18 @@ private:
         /*! The type parameter of this field. */
         uint64_t        m_typparam;
 
+        /*!
+         * Cached normalized key encoder of the type, or nullptr if the type
+         * does not have one. Not set if layout is not computed.
+         */
+        FunctionPtr     m_nkeyfunc;
+
+        /*!
+         * Cached hash function of the type, or nullptr if the type does not
+         * have one. Not set if layout is not computed.
+         */
+        FunctionPtr     m_hashfunc;
+
         /*!
          * Stores about the null bit of this field in the payload layout.
          * Possible values:
@@ -260,6 +272,63 @@ public:
      */
     std::vector<Datum> DissemblePayload(const char *payload) const;
 
+    /*!
+     * Returns whether all the fields in this schema have a normalized key
+     * encoder (see utils/typsupp/nkey.h).
+     */
+    bool HasNormalizedKey() const;
+
+    /*!
+     * See Schema::WriteNormalizedKeyImpl().
+     */
+    void WriteNormalizedKey(const std::vector<Datum> &data,
+                            std::string &buf,
+                            const std::vector<FunctionPtr> *nkeyfuncs = nullptr)
+        const;
+
+    /*!
+     * See Schema::WriteNormalizedKeyImpl().
+     */
+    void WriteNormalizedKey(const std::vector<DatumRef> &data,
+                            std::string &buf,
+                            const std::vector<FunctionPtr> *nkeyfuncs = nullptr)
+        const;
+
+    /*!
+     * See Schema::WriteNormalizedKeyImpl().
+     */
+    void WriteNormalizedKey(const std::vector<NullableDatumRef> &data,
+                            std::string &buf,
+                            const std::vector<FunctionPtr> *nkeyfuncs = nullptr)
+        const;
+
+    /*!
+     * Returns whether all the fields in this schema have a hash function
+     * (see utils/hash.h).
+     */
+    bool HasHashFunction() const;
+
+    /*!
+     * See Schema::ComputeHashImpl().
+     */
+    uint64_t ComputeHash(const std::vector<Datum> &data,
+                         const std::vector<FunctionPtr> *hashfuncs = nullptr)
+        const;
+
+    /*!
+     * See Schema::ComputeHashImpl().
+     */
+    uint64_t ComputeHash(const std::vector<DatumRef> &data,
+                         const std::vector<FunctionPtr> *hashfuncs = nullptr)
+        const;
+
+    /*!
+     * See Schema::ComputeHashImpl().
+     */
+    uint64_t ComputeHash(const std::vector<NullableDatumRef> &data,
+                         const std::vector<FunctionPtr> *hashfuncs = nullptr)
+        const;
+
 
 private:
     /*!
@@ -282,6 +351,50 @@ private:
     FieldOffset WritePayloadToBufferImpl(const std::vector<SomeDatum> &data,
                                          maxaligned_char_buf &buf) const;
 
+    /*!
+     * Appends the normalized key of the record \p data to \p buf without
+     * clearing it first. The normalized key is the concatenation of the
+     * normalized keys of the fields in the field order, where a nullable field
+     * is prefixed by NKeyNotNullByte, or replaced by a single NKeyNullByte if
+     * it is null. Comparing two such keys written with the same schema using
+     * memcmp(3) (and then their lengths) gives the same order as comparing the
+     * records field by field with the < operators of the field types, with
+     * NULLs sorted before all the non-null values.
+     *
+     * \p nkeyfuncs may be nullptr, or a vector of GetNumFields() function
+     * pointers, where a non-null one overrides the default normalized key
+     * encoder of the field type, e.g., VARCHAR_nkey_ci for a case-insensitive
+     * key.
+     *
+     * It is an error if a field without an encoder is encountered, or a
+     * non-nullable field is null. It is undefined if the size of data is not
+     * the same as `GetNumFields()`.
+     */
+    template<class SomeDatum>
+    void WriteNormalizedKeyImpl(const std::vector<SomeDatum> &data,
+                                std::string &buf,
+                                const std::vector<FunctionPtr> *nkeyfuncs)
+        const;
+
+    /*!
+     * Returns the hash value of the record \p data, which combines the hash
+     * values of the fields in the field order with HashCombine(). A null
+     * field is hashed as NullHashValue. Two records that are equal field by
+     * field under the = operators of the field types have the same hash
+     * value, so it may be used for hash joins, hash aggregation and hash
+     * indexes.
+     *
+     * \p hashfuncs may be nullptr, or a vector of GetNumFields() function
+     * pointers, where a non-null one overrides the default hash function of
+     * the field type, e.g., VARCHAR_hash_ci for a case-insensitive key.
+     *
+     * It is an error if a field without a hash function is encountered. It is
+     * undefined if the size of data is not the same as `GetNumFields()`.
+     */
+    template<class SomeDatum>
+    uint64_t ComputeHashImpl(const std::vector<SomeDatum> &data,
+                             const std::vector<FunctionPtr> *hashfuncs) const;
+
     /*! whether the layout has been computed */
     bool m_layout_computed;
 
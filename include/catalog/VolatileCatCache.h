@@ -21,20 +21,72 @@ public:
     }
 
 private:
+    /*!
+     * The size of an arena chunk of an in-memory file. It must be large
+     * enough for any record, whose length fits in a FieldOffset.
+     */
+    static constexpr size_t ChunkSize = 64 * 1024;
+    static_assert(ChunkSize >= (size_t) std::numeric_limits<FieldOffset>::max()
+                  + 1, "a record may not fit in a chunk");
+
+    /*!
+     * An in-memory file is compacted when at least this many bytes in its
+     * chunks are unused and they are at least half of its chunks.
+     */
+    static constexpr size_t CompactionMinFreeBytes = 4 * ChunkSize;
+
+    /*!
+     * The number of bits in a page number of a record ID for the page
+     * number within a file. The remaining high bits are the file ID. A slot
+     * ID in a file is mapped to a page number and a slot ID in the page with
+     * up to MaxSlotId slots per page.
+     */
+    static constexpr int PageNumberBits = 20;
+
+    /*!
+     * A record in an in-memory file. The slot of a record never changes
+     * once it is appended, even if it is updated and moved to a different
+     * place in the arena.
+     */
+    struct InmemSlot {
+        char        *m_data;
+        uint32_t    m_length;
+        uint32_t    m_capacity;
+    };
+
+    /*!
+     * An in-memory file stores its records in an arena of ChunkSize chunks,
+     * with a 32-bit slot ID for each. The records are allocated
+     * consecutively in the chunks in the order they are appended, so that a
+     * scan reads the memory sequentially. The space of a record moved by an
+     * update is reused by the records of the same MAXALIGN'd length, and the
+     * file is compacted in slot order when there is too much unused space.
+     */
     struct InmemFile {
-        std::vector<bool>       m_valid;
-        std::vector<size_t>     m_offsets;
-        std::vector<char>       m_bytes;
+        std::vector<InmemSlot>          m_slots;
+        std::vector<unique_malloced_ptr> m_chunks;
+
+        //! The number of bytes allocated in the last chunk.
+        size_t                          m_chunk_used = 0;
+
+        //! The free lists of the unused space in the chunks, indexed by their
+        //! lengths divided by MAXALIGN_OF.
+        std::vector<std::vector<char*>> m_free_space;
+
+        //! The number of unused bytes in the chunks, excluding the unallocated
+        //! space in the last chunk.
+        size_t                          m_free_bytes = 0;
     };
 
     /*!
      * An opaque handle for iterating a catalog file. It must be automatically
-     * ended if it goes out of scope.
+     * ended if it goes out of scope. The iterator does not return the
+     * records appended after it is created.
      */
     struct CatFileIterator {
         FileId      m_fid;
-        uint16_t    m_nextidx;
-        uint16_t    m_endidx;
+        uint32_t    m_nextidx;
+        uint32_t    m_endidx;
     };
 
     /*!
@@ -150,6 +202,10 @@ private:
      * This is intended to be used for updating either a single entry (and then
      * ending the iteration), or for performing initialization in the catalog
      * initializer.
+     *
+     * In VolatileCatCache, the updated record keeps its record ID and thus
+     * is not returned again. The update may compact the file, which
+     * invalidates all the pointers returned by GetCurrentCatEntry() on it.
      */
     void UpdateCurrentCatEntry(CatFileIterator &iter, Record &rec);
 
@@ -160,6 +216,43 @@ private:
      */
     void EndIterateCatEntry(CatFileIterator &iter);
 
+    /*!
+     * Returns the in-memory file \p fid, which must be a heap file.
+     */
+    InmemFile *GetInmemFile(FileId fid);
+
+    /*!
+     * Allocates \p capacity bytes in the arena of the in-memory file \p f.
+     * \p capacity must be MAXALIGN'd.
+     */
+    static char *AllocateSpace(InmemFile *f, uint32_t capacity);
+
+    /*!
+     * Returns \p capacity bytes at \p data to the free space of the
+     * in-memory file \p f.
+     */
+    static void FreeSpace(InmemFile *f, char *data, uint32_t capacity);
+
+    /*!
+     * Compacts the in-memory file \p f if it has too much unused space. This
+     * invalidates all the pointers returned by GetCurrentCatEntry() on the
+     * file.
+     */
+    static void MaybeCompact(InmemFile *f);
+
+    /*!
+     * Returns the record ID of the slot \p idx in the file \p fid.
+     */
+    static RecordId
+    MakeRecordId(FileId fid, uint32_t idx) {
+        RecordId rid;
+        rid.pid = (((PageNumber) fid) << PageNumberBits) |
+                  (PageNumber)(idx / MaxSlotId);
+        rid.sid = (SlotId)(idx % MaxSlotId + MinSlotId);
+        rid.reserved = 0;
+        return rid;
+    }
+
     /*!
      * This vector stores all our in-memory only files. The index into
      * this file is file ID - 2.
@@ -172,6 +265,9 @@ private:
     unique_malloced_ptr m_dbmeta_page;
 
     friend class CatCacheBase<VolatileCatCache>;
+
+    //! The unit test of the in-memory files.
+    friend class BasicTestVolatileCatCache;
 };
 
 /*!
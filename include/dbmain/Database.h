@@ -39,7 +39,7 @@ extern bool g_test_no_catcache;
 /*!
  * Set this to true if you don't want the Database to disallow building any
  * index (including the catalog tables). This will force the catalog cache to
- * fall back to table scans to find records.
+ * fall back to table scans to find records. Default: false.
  */
 extern bool g_test_no_index;
 
@@ -138,6 +138,16 @@ public:
      * Createa an index named ``idxname'' and inserts into the catalog.
      * If ``idxname'' is an empty string, a default name will be generated.
      *
+     * Not available yet: building an index requires scanning the table,
+     * which needs the heap file, so this always raises a fatal error for
+     * now. Until then, an index over a table is created with
+     * CatCacheBase::AddIndex() and filled through Index::BulkLoad() with the
+     * pairs supplied by the caller.
+     *
+     * The columns in \p idxinclcolids are stored in the index as INCLUDE
+     * columns, see CatCacheBase::AddIndex(). The parameters are in the same
+     * order as those of CatCacheBase::AddIndex(), less the file ID.
+     *
      * The caller may optionally provide non-default < and = operators, as
      * specified in CatCacheBase::AddIndex(). Both \p idxcolltfuncids and \p
      * idxcoleqfuncids may be shorter than \p idxcoltabcolids and may have
@@ -149,6 +159,7 @@ public:
                      IdxType idxtyp,
                      bool idxunique,
                      std::vector<FieldId> idxcoltabcolids,
+                     std::vector<FieldId> idxinclcolids = {},
                      std::vector<Oid> idxcolltfuncids = {},
                      std::vector<Oid> idxcoleqfuncids = {});
 
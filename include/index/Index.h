@@ -0,0 +1,349 @@
+#ifndef INDEX_INDEX_H
+#define INDEX_INDEX_H
+
+#include "tdb.h"
+
+#include "catalog/IndexDesc.h"
+#include "index/IndexKey.h"
+#include "storage/Record.h"
+
+namespace taco {
+
+/*!
+ * Index is the interface of all the index implementations. An index maps
+ * index keys to record IDs, and the (key, record ID) pairs in an index are
+ * unique. If the index is unique, there may be at most one record ID for
+ * each index key without any null, while the keys with any null are never
+ * considered equal to each other.
+ *
+ * The index keys are ordered by the less-than and the equality functions
+ * recorded in the IndexColumn systable for each key column, where a null is
+ * smaller than any non-null value.
+ *
+ * An index may also have INCLUDE columns after the key columns, whose values
+ * are stored in the index entries along with the keys in the layout of the
+ * extended key schema, but are never compared. A scan that only references
+ * the key columns and the INCLUDE columns may be answered from the index
+ * alone without fetching the indexed records (see IndexOnlyIterator).
+ */
+class Index {
+public:
+    /*!
+     * An iterator over the (key, record ID) pairs in an index.
+     */
+    class Iterator {
+    public:
+        virtual ~Iterator() {}
+
+        /*!
+         * Moves the iterator to the next item and returns whether such an
+         * item exists.
+         */
+        virtual bool Next() = 0;
+
+        /*!
+         * Returns whether the iterator is at a valid item, i.e., the last
+         * Next() call returned true.
+         */
+        virtual bool IsAtValidItem() = 0;
+
+        /*!
+         * Returns the current item as a record, whose payload is the index
+         * key followed by the INCLUDE columns if any in the layout of the
+         * key schema, and whose record ID is the indexed record ID. The
+         * returned record is valid until the next call to Next() or
+         * EndScan().
+         */
+        virtual const Record &GetCurrentItem() = 0;
+
+        /*!
+         * Returns the record ID of the current item.
+         */
+        virtual RecordId GetCurrentRecordId() = 0;
+
+        /*!
+         * Ends the scan and releases any resource held by the iterator.
+         */
+        virtual void EndScan() = 0;
+    };
+
+    /*!
+     * An index-only scan, which returns the values of a list of table
+     * columns directly from the index entries, all of which must be stored
+     * in the index as key or INCLUDE columns. See Index::CoversColumns().
+     */
+    class IndexOnlyIterator {
+    public:
+        IndexOnlyIterator(const Index *index,
+                          std::unique_ptr<Iterator> iter,
+                          std::vector<FieldId> fields):
+            m_key_schema(index->m_key_schema),
+            m_iter(std::move(iter)),
+            m_fields(std::move(fields)) {}
+
+        bool
+        Next() {
+            return m_iter->Next();
+        }
+
+        bool
+        IsAtValidItem() {
+            return m_iter->IsAtValidItem();
+        }
+
+        /*!
+         * Returns the value of the \p i-th requested table column of the
+         * current item, which references the index entry and is valid until
+         * the next call to Next() or EndScan().
+         */
+        Datum
+        GetField(FieldId i) {
+            ASSERT((size_t) i < m_fields.size());
+            return m_key_schema->GetField(
+                m_fields[i], m_iter->GetCurrentItem().GetData());
+        }
+
+        RecordId
+        GetCurrentRecordId() {
+            return m_iter->GetCurrentRecordId();
+        }
+
+        void
+        EndScan() {
+            m_iter->EndScan();
+        }
+
+    private:
+        const Schema                *m_key_schema;
+
+        std::unique_ptr<Iterator>   m_iter;
+
+        //! The fields in the key schema of the requested table columns.
+        std::vector<FieldId>        m_fields;
+    };
+
+    /*!
+     * A source of the (key, record ID) pairs to be loaded into an index,
+     * e.g., a scan over the indexed table.
+     */
+    class BulkLoadSource {
+    public:
+        virtual ~BulkLoadSource() {}
+
+        /*!
+         * Moves to the next pair and returns whether such a pair exists.
+         */
+        virtual bool Next() = 0;
+
+        /*!
+         * Returns the key of the current pair, which is valid until the next
+         * call to Next().
+         */
+        virtual const IndexKey *GetCurrentKey() = 0;
+
+        /*!
+         * Returns the record ID of the current pair.
+         */
+        virtual RecordId GetCurrentRecordId() = 0;
+    };
+
+    /*!
+     * Creates a new empty index of the type recorded in the index descriptor
+     * \p idxdesc. The index descriptor is not owned by the index and must
+     * outlive it.
+     */
+    static std::unique_ptr<Index> Create(const IndexDesc *idxdesc);
+
+    virtual ~Index();
+
+    const IndexDesc*
+    GetIndexDesc() const {
+        return m_idxdesc;
+    }
+
+    /*!
+     * Returns the number of key columns.
+     */
+    FieldId
+    GetNumKeyColumns() const {
+        return m_nkeys;
+    }
+
+    /*!
+     * Returns the number of INCLUDE columns.
+     */
+    FieldId
+    GetNumIncludeColumns() const {
+        return m_ninclcols;
+    }
+
+    /*!
+     * Returns the field in the key schema that stores the table column \p
+     * tabcolid, or InvalidFieldId if it is not stored in the index.
+     */
+    FieldId GetKeySchemaFieldOfColumn(FieldId tabcolid) const;
+
+    /*!
+     * Returns whether all the table columns in \p tabcolids are stored in
+     * the index as key or INCLUDE columns, in which case a scan that only
+     * references these columns may be answered with StartIndexOnlyScan().
+     */
+    bool CoversColumns(const std::vector<FieldId> &tabcolids) const;
+
+    /*!
+     * Inserts the (key, record ID) pair \p key and \p recid, where \p key
+     * has the values of the INCLUDE columns if any after the key columns.
+     * Returns false without inserting anything if the pair already exists,
+     * or if the index is unique and \p key without any null in the key
+     * columns already exists in the index.
+     */
+    virtual bool InsertKey(const IndexKey *key, RecordId recid) = 0;
+
+    /*!
+     * Deletes the (key, record ID) pair \p key and \p recid. If \p recid is
+     * invalid, it deletes an arbitrary pair with the key \p key and sets
+     * \p recid to its record ID. Returns whether a pair is deleted. \p key
+     * may or may not have the values of the INCLUDE columns, which are
+     * ignored.
+     */
+    virtual bool DeleteKey(const IndexKey *key, RecordId &recid) = 0;
+
+    /*!
+     * Inserts all the pairs from \p src into the index, which is usually
+     * empty and is being built over an existing table. Raises an error if
+     * any pair may not be inserted, in which case the index is left with an
+     * arbitrary subset of the pairs.
+     *
+     * The default implementation inserts the pairs one at a time. An index
+     * may override it with a faster one.
+     */
+    virtual void BulkLoad(BulkLoadSource *src);
+
+    /*!
+     * Starts a scan over the pairs with keys in the range between \p lower
+     * and \p upper in the key order. A null \p lower or \p upper means the
+     * range is unbounded on that side. The bounds may be prefix keys, and
+     * they are excluded from the range if \p lower_isstrict or \p
+     * upper_isstrict is true, respectively. The bounds are not copied and
+     * must be alive until the scan ends.
+     */
+    virtual std::unique_ptr<Iterator> StartScan(const IndexKey *lower,
+                                                bool lower_isstrict,
+                                                const IndexKey *upper,
+                                                bool upper_isstrict) = 0;
+
+    /*!
+     * Starts an index-only scan over the same range as StartScan() that
+     * returns the values of the table columns \p tabcolids, which must all
+     * be covered by the index.
+     */
+    std::unique_ptr<IndexOnlyIterator> StartIndexOnlyScan(
+        const IndexKey *lower,
+        bool lower_isstrict,
+        const IndexKey *upper,
+        bool upper_isstrict,
+        const std::vector<FieldId> &tabcolids);
+
+protected:
+    Index(const IndexDesc *idxdesc);
+
+    /*!
+     * Compares the first \p nkeys columns of \p key with the ones of a key
+     * payload \p payload in the key schema. Returns a negative number, 0 or
+     * a positive number if \p key is smaller than, equal to or larger than
+     * the payload respectively.
+     */
+    int CompareKeyWithPayload(const IndexKey *key,
+                              const char *payload,
+                              FieldId nkeys) const;
+
+    /*!
+     * Compares two key payloads \p payload1 and \p payload2 in the key
+     * schema.
+     */
+    int ComparePayloads(const char *payload1, const char *payload2) const;
+
+    /*!
+     * Returns whether any of the key columns of \p key is null.
+     */
+    bool
+    KeyHasAnyNull(const IndexKey *key) const {
+        if (!key->HasAnyNull()) {
+            return false;
+        }
+        for (FieldId i = 0; i < m_nkeys; ++i) {
+            if (key->IsNull(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*!
+     * Writes the normalized key of \p key into \p buf and returns true if
+     * the index uses normalized keys and \p key is a full key that may be
+     * encoded. Returns false otherwise.
+     */
+    bool GetSearchNormalizedKey(const IndexKey *key, std::string &buf) const;
+
+    /*!
+     * Writes the normalized key of the full key \p data into \p buf, where
+     * the values of the INCLUDE columns in \p data if any are ignored. The
+     * index must use normalized keys.
+     */
+    void WriteNormalizedKey(const std::vector<NullableDatumRef> &data,
+                            std::string &buf) const;
+
+    /*!
+     * Writes the normalized key of the key payload \p payload into \p buf.
+     * The index must use normalized keys.
+     */
+    void GetPayloadNormalizedKey(const char *payload, std::string &buf) const;
+
+    /*!
+     * Compares two non-null datums of the key column \p keyid.
+     */
+    int
+    CompareDatums(FieldId keyid,
+                  const NullableDatumRef &d1,
+                  const NullableDatumRef &d2) const {
+        if (FunctionCall(m_lt_funcs[keyid], d1, d2).GetBool()) {
+            return -1;
+        }
+        if (FunctionCall(m_eq_funcs[keyid], d1, d2).GetBool()) {
+            return 0;
+        }
+        return 1;
+    }
+
+    const IndexDesc             *m_idxdesc;
+
+    //! The key schema of the index, which is extended with the INCLUDE
+    //! columns if any.
+    const Schema                *m_key_schema;
+
+    //! The schema of the key columns alone, which is m_key_schema if there's
+    //! no INCLUDE column.
+    const Schema                *m_keycol_schema;
+
+    std::unique_ptr<Schema>     m_keycol_schema_owned;
+
+    FieldId                     m_nkeys;
+
+    FieldId                     m_ninclcols;
+
+    std::vector<FunctionInfo>   m_lt_funcs;
+    std::vector<FunctionInfo>   m_eq_funcs;
+
+    //! Whether the normalized keys of the index keys (see
+    //! utils/typsupp/nkey.h) order the same way as the comparison functions.
+    bool                        m_use_nkey;
+
+    //! The normalized key encoders that override the default ones of the
+    //! key column types, e.g., VARCHAR_nkey_ci.
+    std::vector<FunctionPtr>    m_nkey_funcs;
+};
+
+}   // namespace taco
+
+#endif      // INDEX_INDEX_H
@@ -0,0 +1,67 @@
+#ifndef INDEX_INDEXKEY_H
+#define INDEX_INDEXKEY_H
+
+#include "tdb.h"
+
+namespace taco {
+
+/*!
+ * An IndexKey is a search key or an index key to be inserted into or deleted
+ * from an index, which is a list of (nullable) datums in the order of the
+ * index key columns. A search key may have fewer datums than the number of
+ * key columns, in which case it is a prefix key that matches all the keys
+ * with the same prefix.
+ *
+ * IndexKey does not own the referenced datums, which must be alive while the
+ * key is in use.
+ */
+class IndexKey {
+public:
+    IndexKey(const NullableDatumRef *keys, FieldId nkeys):
+        m_keys(keys),
+        m_nkeys(nkeys),
+        m_hasnull(false) {
+        for (FieldId i = 0; i < nkeys; ++i) {
+            if (keys[i].isnull()) {
+                m_hasnull = true;
+                break;
+            }
+        }
+    }
+
+    IndexKey(const std::vector<NullableDatumRef> &keys):
+        IndexKey(keys.data(), (FieldId) keys.size()) {}
+
+    constexpr FieldId
+    GetNumKeys() const {
+        return m_nkeys;
+    }
+
+    const NullableDatumRef&
+    GetKey(FieldId keyid) const {
+        ASSERT(keyid < m_nkeys);
+        return m_keys[keyid];
+    }
+
+    bool
+    IsNull(FieldId keyid) const {
+        return GetKey(keyid).isnull();
+    }
+
+    /*!
+     * Returns whether any of the datums in the key is null.
+     */
+    constexpr bool
+    HasAnyNull() const {
+        return m_hasnull;
+    }
+
+private:
+    const NullableDatumRef  *m_keys;
+    FieldId                 m_nkeys;
+    bool                    m_hasnull;
+};
+
+}   // namespace taco
+
+#endif      // INDEX_INDEXKEY_H
@@ -0,0 +1,582 @@
+#ifndef INDEX_BTREE_BTREE_H
+#define INDEX_BTREE_BTREE_H
+
+#include "tdb.h"
+
+#include <mutex>
+
+#include "index/Index.h"
+#include "storage/FileManager.h"
+
+namespace taco {
+
+/*!
+ * BTree is a page-based B+-tree index. The internal pages and the leaf pages
+ * are slotted pages of PAGE_SIZE bytes. A leaf page stores the (key, record
+ * ID) pairs in the key order, and is linked with its siblings on the same
+ * level in both directions, so that a range scan only descends the tree
+ * once. An internal page stores a list of (separator, child page number)
+ * pairs, where the separator of the first child is treated as negative
+ * infinity.
+ *
+ * The entries are ordered by the (key, record ID) pairs rather than by the
+ * keys only, so that every entry is unique and can be located by a single
+ * descent regardless of the number of duplicate keys. The separators are
+ * thus (key, record ID) pairs as well.
+ *
+ * The index keys are stored in the layout of the key schema of the index.
+ * Pages are never merged: a deletion only removes the entry from its leaf
+ * page, and the space is reclaimed by the later insertions into the page.
+ *
+ * If the key columns are all compared with the default < operators of their
+ * types, which have normalized key encoders (see utils/typsupp/nkey.h), the
+ * BTree also maintains the normalized keys in a compressed form to avoid
+ * calling the comparison functions during the searches. Every page stores
+ * the common prefix (up to MaxPrefixLength bytes) of the normalized keys of
+ * its entries right after the page header, and every slot is followed by
+ * the next 4 bytes of the normalized key of its entry after the prefix as a
+ * fixed-width head. A search within a page compares the normalized search
+ * key with the prefix, and then does a branchless binary search over the
+ * heads in the slot array. The keys are only compared by the comparison
+ * functions among the few entries with the same head as the search key.
+ * The prefix and the heads take space away from the entries, so they are
+ * only present on the pages of a BTree that uses normalized keys, and the
+ * pages of any other BTree have 4-byte slots right after the page header.
+ *
+ * The BTree is thread-safe and uses optimistic lock coupling. Every page has
+ * a version lock in its header. Readers never latch a page: they remember
+ * the version of a page before reading it, read the entries by copying them
+ * out of the page, and restart from the root if the version has changed
+ * since. An insertion or a deletion descends the tree in the same way, and
+ * only write-locks the leaf page it modifies. There is at most one entry
+ * with a key without any null in a unique index, so an insertion into one
+ * only needs to compare the key with the neighbors of the new entry on the
+ * leaf page, or on its siblings (see FindEqualKeyNeighbor()). An insertion
+ * splits any internal page on the way down that might not have the space
+ * for one more separator, so that a split only write-locks the page being
+ * split, its parent and its right sibling. Since pages are never freed, a
+ * reader may always safely read a page that is concurrently being modified.
+ *
+ * We don't have a buffer manager yet, so the pages are allocated in memory
+ * by the BTree and addressed through their page numbers, which is the only
+ * place that needs to change for the buffer manager.
+ */
+class BTree: public Index {
+public:
+    static std::unique_ptr<BTree> Create(const IndexDesc *idxdesc);
+
+    ~BTree() override;
+
+    bool InsertKey(const IndexKey *key, RecordId recid) override;
+
+    bool DeleteKey(const IndexKey *key, RecordId &recid) override;
+
+    std::unique_ptr<Index::Iterator> StartScan(const IndexKey *lower,
+                                               bool lower_isstrict,
+                                               const IndexKey *upper,
+                                               bool upper_isstrict) override;
+
+    /*!
+     * Builds the BTree bottom-up from the pairs in \p src. The pairs are
+     * first sorted with an external sort. The leaf pages are then filled up
+     * to --btree_fillfactor percent of their space in the sorted order, and
+     * each internal page is built as soon as its children are filled, so
+     * that the pages are written in the order they are allocated.
+     *
+     * The new tree is built in newly allocated pages, and the root is only
+     * switched to its root after all the pairs have been loaded. If an error
+     * is raised, the BTree stays empty, and the pages built so far are left
+     * unreachable until the BTree is destroyed.
+     *
+     * The BTree must be empty, and must not be accessed by any other thread
+     * during the bulk load.
+     */
+    void BulkLoad(BulkLoadSource *src) override;
+
+    /*!
+     * Returns the height of the tree, i.e., the number of levels.
+     */
+    uint32_t GetTreeHeight() const;
+
+    /*!
+     * Returns the maximum length of a key payload that may be inserted into
+     * the BTree. A page must be able to hold at least 4 entries, so that a
+     * split always leaves enough space for a new entry on either side. The
+     * limit is computed for the page layout with the prefix and the heads,
+     * so that it does not depend on whether the BTree uses normalized keys.
+     */
+    static constexpr FieldOffset
+    GetMaxKeyLength() {
+        return (FieldOffset)(
+            MAXALIGN_DOWN((PAGE_SIZE - MAXALIGN(sizeof(BTreePageHeader)) -
+                           MAXALIGN(sizeof(BTreePagePrefix))) / 4
+                          - sizeof(BTreeSlot) - sizeof(uint32_t)) -
+            MAXALIGN(sizeof(BTreeInternalEntryHeader)));
+    }
+
+private:
+    class Iterator;
+
+    //! The maximum length of the common prefix of the normalized keys
+    //! stored on a page.
+    static constexpr uint16_t MaxPrefixLength = 30;
+
+    /*!
+     * The header of a BTree page. The slot array grows from the end of the
+     * header, or from the end of the page prefix if the BTree uses
+     * normalized keys, and the entries grow from the end of the page.
+     */
+    struct BTreePageHeader {
+        //! Kept so that the page layout is compatible with the FileManager.
+        //! Unused.
+        PageHeaderData  m_ph;
+
+        //! The version lock of the page. The lowest bit is set while the
+        //! page is write-locked, and the version is advanced every time the
+        //! page is unlocked.
+        atomic_uint64_t m_version;
+
+        //! The level of the page, where the leaf pages are on level 0.
+        uint16_t        m_level;
+        uint16_t        m_nslots;
+
+        //! The lowest offset of the entries in the page.
+        uint16_t        m_free_end;
+
+        //! The total length of the unused space between the entries left by
+        //! the deletions.
+        uint16_t        m_nholes;
+
+        PageNumber      m_prev_pid;
+        PageNumber      m_next_pid;
+    };
+
+    /*!
+     * A common prefix of the normalized keys of all the entries on the page,
+     * excluding the first entry on an internal page. It follows the page
+     * header only if the BTree uses normalized keys.
+     */
+    struct BTreePagePrefix {
+        uint16_t        m_len;
+        char            m_bytes[MaxPrefixLength];
+    };
+
+    /*!
+     * A slot in the slot array. If the BTree uses normalized keys, every
+     * slot is followed by the head of its entry: the 4 bytes of the
+     * normalized key of the entry right after the page prefix, padded with
+     * 0s, as a big-endian integer.
+     */
+    struct BTreeSlot {
+        uint16_t        m_offset;
+        uint16_t        m_length;
+    };
+
+    /*!
+     * The header of an entry on a leaf page, which is followed by the key
+     * payload.
+     */
+    struct BTreeLeafEntryHeader {
+        RecordId        m_recid;
+    };
+
+    /*!
+     * The header of an entry on an internal page, which is followed by the
+     * key payload of the separator.
+     */
+    struct BTreeInternalEntryHeader {
+        RecordId        m_recid;
+        PageNumber      m_child_pid;
+        uint32_t        m_reserved;
+    };
+
+    /*!
+     * A search key to be compared with the (key, record ID) pairs in the
+     * BTree. The first \p m_nkeys columns of the key are compared first, and
+     * then the record IDs if \p m_recid is valid. If they are all equal, the
+     * search key is smaller than the entry if \p m_tie is negative, larger
+     * than the entry if \p m_tie is positive, or equal to the entry if \p
+     * m_tie is 0.
+     *
+     * \p m_nkey is the normalized key of the full key if \p m_nkeys is the
+     * number of key columns and the BTree uses normalized keys, or nullptr
+     * otherwise.
+     */
+    struct BTreeSearchKey {
+        const IndexKey  *m_key;
+        FieldId         m_nkeys;
+        RecordId        m_recid;
+        int             m_tie;
+        const char      *m_nkey;
+        size_t          m_nkey_len;
+    };
+
+    //! An upper bound of the length of any entry including its header.
+    static constexpr size_t MaxEntryLength = PAGE_SIZE / 4;
+
+    static constexpr uint32_t PageDirChunkBits = 12;
+    static constexpr uint32_t PageDirChunkSize = 1u << PageDirChunkBits;
+    static constexpr uint32_t MaxNumPageDirChunks = 256;
+
+    BTree(const IndexDesc *idxdesc);
+
+    /*!
+     * Returns the space needed by an internal page for a new separator of
+     * the maximum length.
+     */
+    size_t
+    GetMaxEntrySpace() const {
+        return MAXALIGN(sizeof(BTreeInternalEntryHeader) + GetMaxKeyLength())
+            + m_slot_size;
+    }
+
+    /*!
+     * Returns the maximum number of slots on a page.
+     */
+    uint16_t
+    GetMaxNumSlots() const {
+        return (PAGE_SIZE - m_slots_offset) / m_slot_size;
+    }
+
+    /*!
+     * Allocates a new empty page on \p level and returns its page number.
+     * The page is not visible to any other thread until its page number is
+     * published.
+     */
+    PageNumber AllocatePage(uint16_t level);
+
+    char*
+    GetPage(PageNumber pid) const {
+        ASSERT(pid != INVALID_PID &&
+               pid <= m_npages.load(memory_order_relaxed));
+        return (char*) m_page_dir[(pid - 1) >> PageDirChunkBits]
+            [(pid - 1) & (PageDirChunkSize - 1)].get();
+    }
+
+    static BTreePageHeader*
+    GetPageHeader(char *page) {
+        return (BTreePageHeader*) page;
+    }
+
+    BTreePagePrefix*
+    GetPagePrefix(char *page) const {
+        ASSERT(m_use_nkey);
+        return (BTreePagePrefix*)(page + MAXALIGN(sizeof(BTreePageHeader)));
+    }
+
+    BTreeSlot*
+    GetSlot(char *page, uint16_t sid) const {
+        return (BTreeSlot*)(page + m_slots_offset + sid * m_slot_size);
+    }
+
+    uint32_t&
+    GetSlotHead(char *page, uint16_t sid) const {
+        ASSERT(m_use_nkey);
+        return *(uint32_t*)(page + m_slots_offset + sid * m_slot_size +
+                            sizeof(BTreeSlot));
+    }
+
+    /*!
+     * Returns the offset of the free space right after the slot array on a
+     * page with \p nslots slots.
+     */
+    size_t
+    GetSlotArrayEnd(uint16_t nslots) const {
+        return m_slots_offset + (size_t) nslots * m_slot_size;
+    }
+
+    static size_t
+    GetEntryHeaderSize(const char *page) {
+        return ((const BTreePageHeader*) page)->m_level == 0 ?
+            MAXALIGN(sizeof(BTreeLeafEntryHeader)) :
+            MAXALIGN(sizeof(BTreeInternalEntryHeader));
+    }
+
+    const char*
+    GetEntry(char *page, uint16_t sid) const {
+        return page + GetSlot(page, sid)->m_offset;
+    }
+
+    static RecordId
+    GetEntryRecordId(const char *entry) {
+        return ((const BTreeLeafEntryHeader*) entry)->m_recid;
+    }
+
+    static PageNumber
+    GetEntryChild(const char *entry) {
+        return ((const BTreeInternalEntryHeader*) entry)->m_child_pid;
+    }
+
+    /*!
+     * Waits until the page is not write-locked and returns its version.
+     */
+    static uint64_t ReadLockPage(char *page);
+
+    /*!
+     * Returns whether the page is still at \p version, i.e., all the reads
+     * from the page since its version was read are consistent.
+     */
+    static bool ValidatePage(char *page, uint64_t version);
+
+    /*!
+     * Write-locks the page if it is still at \p version. Returns false
+     * otherwise.
+     */
+    static bool UpgradePageLock(char *page, uint64_t version);
+
+    /*!
+     * Write-locks the page if it is not write-locked by any other thread.
+     * Returns false otherwise.
+     */
+    static bool TryWriteLockPage(char *page);
+
+    static void WriteUnlockPage(char *page);
+
+    /*!
+     * Returns the number of bytes that may be used for a new entry and its
+     * slot in the page, including the holes.
+     */
+    size_t GetFreeSpace(char *page) const;
+
+    /*!
+     * Copies up to \p buflen bytes of the entry \p sid on \p page into \p
+     * buf, and sets \p len to the length of the entry if it is not null.
+     * Returns false if the page is no longer at \p version.
+     */
+    bool CopyEntry(char *page,
+                   uint64_t version,
+                   uint16_t sid,
+                   char *buf,
+                   size_t buflen,
+                   uint16_t *len) const;
+
+    /*!
+     * Returns the head of the normalized key \p nkey after a prefix of \p
+     * prefix_len bytes.
+     */
+    static uint32_t ComputeHead(const char *nkey,
+                                size_t nkey_len,
+                                size_t prefix_len);
+
+    /*!
+     * Returns the first slot of the entries with a key prefix on the page,
+     * i.e., 1 on an internal page and 0 on a leaf page.
+     */
+    static uint16_t
+    GetFirstKeyedSlot(const char *page) {
+        return ((const BTreePageHeader*) page)->m_level == 0 ? 0 : 1;
+    }
+
+    /*!
+     * Narrows down the slots [\p lo, \p hi) on \p page to the ones that
+     * can't be ordered against \p skey by the page prefix and the heads.
+     * Upon return, all the entries in the slots before the new \p lo are
+     * smaller than \p skey, and all the entries in the slots starting from
+     * the new \p hi are larger than \p skey. The page may be read without
+     * a lock, so the caller must validate the page version afterwards.
+     */
+    void NarrowByHeads(const BTreeSearchKey &skey,
+                       char *page,
+                       uint16_t &lo,
+                       uint16_t &hi) const;
+
+    /*!
+     * Recomputes the prefix and the heads on the page if the common prefix
+     * of its entries has become longer, e.g., after the page is split. The
+     * page must be write-locked or not yet published.
+     */
+    void RecomputePagePrefix(char *page) const;
+
+    /*!
+     * Compares the search key \p skey with an entry whose header has \p
+     * hdr_size bytes. The entry must not be the first entry on an internal
+     * page.
+     */
+    int CompareWithEntry(const BTreeSearchKey &skey,
+                         const char *entry,
+                         size_t hdr_size) const;
+
+    /*!
+     * Compares the search key \p skey with the entry \p sid on \p page and
+     * sets \p res to the result. Returns false if the page is no longer at
+     * \p version.
+     */
+    bool CompareWithEntry(const BTreeSearchKey &skey,
+                          char *page,
+                          uint64_t version,
+                          uint16_t sid,
+                          int &res) const;
+
+    /*!
+     * Sets \p sid to the first slot on the leaf page \p page with an entry
+     * not smaller than \p skey, or the number of slots if there's none.
+     * Returns false if the page is no longer at \p version.
+     */
+    bool LeafLowerBound(const BTreeSearchKey &skey,
+                        char *page,
+                        uint64_t version,
+                        uint16_t &sid) const;
+
+    /*!
+     * Sets \p child to the child on the internal page \p page whose subtree
+     * may contain the first entry not smaller than \p skey. Returns false if
+     * the page is no longer at \p version.
+     */
+    bool FindChild(const BTreeSearchKey &skey,
+                   char *page,
+                   uint64_t version,
+                   PageNumber &child) const;
+
+    /*!
+     * Descends from the root to the leaf page whose range contains \p skey,
+     * and sets \p pid and \p version to the leaf page and the version it was
+     * read at. Returns false if the descent has to be restarted.
+     */
+    bool FindLeafPage(const BTreeSearchKey &skey,
+                      PageNumber &pid,
+                      uint64_t &version) const;
+
+    /*!
+     * Finds the first entry not smaller than \p skey, skipping any empty
+     * leaf page, and sets \p pid, \p sid and \p version to its leaf page,
+     * its slot and the version of the leaf page. \p pid is set to
+     * INVALID_PID if there is none. Returns false if the search has to be
+     * restarted.
+     */
+    bool FindFirstEntry(const BTreeSearchKey &skey,
+                        PageNumber &pid,
+                        uint16_t &sid,
+                        uint64_t &version) const;
+
+    /*!
+     * Writes an entry with the entry header \p hdr and the key payload \p
+     * payload at \p sid of the page, shifting the slots after it. Returns
+     * false without changing the page if there is not enough space. The
+     * page must be write-locked or not yet published.
+     *
+     * \p nkey is the normalized key of the payload, which is used for
+     * shortening the page prefix if necessary and computing the head of the
+     * entry. It is nullptr if the BTree does not use normalized keys, and is
+     * ignored for the first entry on an internal page. The caller sets the
+     * head of the entry instead if \p nkey is nullptr and the BTree uses
+     * normalized keys.
+     */
+    bool InsertEntryToPage(char *page,
+                           uint16_t sid,
+                           const char *hdr,
+                           const char *payload,
+                           FieldOffset payload_len,
+                           const char *nkey,
+                           size_t nkey_len);
+
+    /*!
+     * Removes the entry at \p sid of the write-locked page.
+     */
+    void RemoveEntryFromPage(char *page, uint16_t sid);
+
+    /*!
+     * Moves all the entries of the write-locked page to the end of the page
+     * so that there's no hole between the entries.
+     */
+    void CompactPage(char *page) const;
+
+    /*!
+     * Splits the page \p pid into two halves and inserts the separator into
+     * \p parent, or into a new root if \p parent is null. The page and its
+     * parent must be write-locked, and the parent must have the space for
+     * the separator. Returns false without changing anything if its right
+     * sibling is locked by another thread.
+     */
+    bool SplitPage(PageNumber pid, char *page, char *parent);
+
+    /*!
+     * Compares two leaf entries by their (key, record ID) pairs.
+     */
+    int CompareLeafEntries(const char *entry1, const char *entry2) const;
+
+    /*!
+     * Returns whether any key column in the key payload \p payload is null.
+     */
+    bool PayloadHasAnyNull(const char *payload) const;
+
+    /*!
+     * Appends an entry to the rightmost page on \p level during a bulk load,
+     * where \p rightmost_pids are the rightmost pages on each level. If the
+     * page is filled up to \p fill_limit bytes, a new rightmost page is
+     * allocated for the entry, and the separator of the new page is
+     * appended to the level above, which is created if necessary.
+     */
+    void BulkLoadAppendEntry(std::vector<PageNumber> &rightmost_pids,
+                             uint16_t level,
+                             const char *hdr,
+                             const char *payload,
+                             FieldOffset payload_len,
+                             const char *nkey,
+                             size_t nkey_len,
+                             size_t fill_limit);
+
+    /*!
+     * Sets \p found to whether the entry right before or at \p sid of the
+     * write-locked leaf page \p page has the same key as \p skey, which
+     * are the neighbors of \p skey if it were inserted at \p sid. The
+     * neighbors are looked up on the siblings if \p sid is at either end
+     * of the page, skipping any empty page. Returns false if the check has
+     * to be restarted, in which case the caller must unlock the page.
+     *
+     * The right siblings are write-locked in turn while the page is locked,
+     * and the left siblings are read without locking them. So an insertion
+     * of an equal key into a sibling either finishes before the check, or
+     * sees the new entry in its own check.
+     */
+    bool FindEqualKeyNeighbor(const BTreeSearchKey &skey,
+                              char *page,
+                              uint16_t sid,
+                              bool &found);
+
+    /*!
+     * Tries to insert an entry for \p skey into its leaf page, splitting the
+     * pages on the way down if necessary. Returns false if the insertion
+     * has to be restarted. Otherwise, sets \p inserted to whether the entry
+     * is inserted, i.e., it did not exist in the BTree, and either \p
+     * check_unique is false or there's no entry with the same key.
+     */
+    bool TryInsertEntry(const BTreeSearchKey &skey,
+                        const char *payload,
+                        FieldOffset payload_len,
+                        bool check_unique,
+                        bool &inserted);
+
+    /*!
+     * Tries to delete the entry for \p key and \p recid, where \p nkey is
+     * the normalized key of \p key or nullptr. See BTree::TryInsertEntry()
+     * for the meaning of the return value.
+     */
+    bool TryDeleteEntry(const IndexKey *key,
+                        const std::string *nkey,
+                        RecordId &recid,
+                        bool &deleted);
+
+    //! The pages, in chunks of PageDirChunkSize pages. Chunks are never
+    //! moved or freed once allocated, so that they may be read without
+    //! latching.
+    std::unique_ptr<unique_malloced_ptr[]> m_page_dir[MaxNumPageDirChunks];
+
+    std::atomic<PageNumber> m_npages;
+
+    //! The offset of the slot array on a page, which is after the page
+    //! prefix if the BTree uses normalized keys.
+    const uint16_t          m_slots_offset;
+
+    //! The size of a slot in the slot array, including its head if the BTree
+    //! uses normalized keys.
+    const uint16_t          m_slot_size;
+
+    //! Protects the page allocation.
+    std::mutex              m_alloc_latch;
+
+    std::atomic<PageNumber> m_root_pid;
+};
+
+}   // namespace taco
+
+#endif      // INDEX_BTREE_BTREE_H
@@ -0,0 +1,389 @@
+#ifndef INDEX_HASH_HASHINDEX_H
+#define INDEX_HASH_HASHINDEX_H
+
+#include "tdb.h"
+
+#include <mutex>
+
+#include "index/Index.h"
+#include "storage/FileManager.h"
+
+namespace taco {
+
+/*!
+ * HashIndex is a page-based linear hashing index, which only supports
+ * equality lookups. It only needs the = operators of the key columns and
+ * the hash functions of their types (see utils/hash.h), and a lookup
+ * only reads one bucket regardless of the size of the index.
+ *
+ * The index has 2^L + n buckets at level L with the split pointer n. A key
+ * with hash value h is in bucket h mod 2^L if that is not smaller than n,
+ * or in bucket h mod 2^(L+1) otherwise. A bucket is a chain of slotted
+ * pages of PAGE_SIZE bytes, starting from its primary page. Whenever an
+ * insertion has to append an overflow page to a bucket, the bucket at the
+ * split pointer (not necessarily the same one) is split into itself and
+ * bucket n + 2^L, and the split pointer advances. Overflow pages are reused
+ * by the later insertions into the same bucket, and the pages of a bucket
+ * are only recycled for new pages after the bucket is split.
+ *
+ * Every slot stores the higher 32 bits of the hash value of its entry, so
+ * that a lookup only copies and compares the entries that are likely to
+ * match. An entry stores the full hash value for splitting, followed by the
+ * record ID and the key payload in the layout of the key schema.
+ *
+ * The HashIndex is thread-safe. The version lock in the header of the
+ * primary page of a bucket protects the whole bucket. A writer write-locks
+ * the bucket it modifies, while a reader never latches anything: it copies
+ * the candidate entries out of the bucket, and retries if the version of
+ * the primary page or the level and the split pointer have changed since.
+ *
+ * A split builds two new chains aside from a copy of the bucket being
+ * split: one with the entries that stay and one with the entries of the new
+ * bucket. It then write-locks the bucket only if it has not changed since
+ * the copy, and publishes both chains by replacing the primary pages in the
+ * bucket directory and advancing the split pointer before unlocking. So
+ * the insertions into the bucket are only blocked for a few stores, and a
+ * split never blocks the readers of the other buckets or waits for any
+ * reader. The pages of the old chain are then recycled for new pages, but a
+ * recycled page is write-locked while it is reset and filled, and its
+ * version never goes back. The readers and the writers of the old chain
+ * only rely on it after validating the primary page, so a stale one fails
+ * its validation or its check of the primary page instead of using the new
+ * content, and it may safely read the page until then since the pages are
+ * never deallocated.
+ *
+ * We don't have a buffer manager yet, so the pages are allocated in memory
+ * in the same way as BTree.
+ */
+class HashIndex: public Index {
+public:
+    static std::unique_ptr<HashIndex> Create(const IndexDesc *idxdesc);
+
+    ~HashIndex() override;
+
+    bool InsertKey(const IndexKey *key, RecordId recid) override;
+
+    bool DeleteKey(const IndexKey *key, RecordId &recid) override;
+
+    /*!
+     * Starts a lookup of the key \p lower, which must be a full key equal to
+     * \p upper, and neither bound may be strict. The order of the pairs with
+     * the key is unspecified.
+     */
+    std::unique_ptr<Index::Iterator> StartScan(const IndexKey *lower,
+                                               bool lower_isstrict,
+                                               const IndexKey *upper,
+                                               bool upper_isstrict) override;
+
+    /*!
+     * Returns the number of buckets.
+     */
+    uint64_t GetNumBuckets() const;
+
+    /*!
+     * Returns the maximum length of a key payload that may be inserted into
+     * the HashIndex. A page must be able to hold at least 2 entries.
+     */
+    static constexpr FieldOffset
+    GetMaxKeyLength() {
+        return (FieldOffset)(
+            MAXALIGN_DOWN((PAGE_SIZE - MAXALIGN(sizeof(HashPageHeader))) / 2
+                          - sizeof(HashSlot)) -
+            MAXALIGN(sizeof(HashEntryHeader)));
+    }
+
+private:
+    class Iterator;
+
+    struct HashPageHeader {
+        //! Kept so that the page layout is compatible with the FileManager.
+        //! Unused.
+        PageHeaderData  m_ph;
+
+        //! The version lock of the bucket, only used on a primary page. See
+        //! BTree::BTreePageHeader::m_version. It is never reset, and a
+        //! recycled page is write-locked until it is filled again.
+        atomic_uint64_t m_version;
+
+        //! The next overflow page in the bucket.
+        PageNumber      m_next_pid;
+
+        uint16_t        m_nslots;
+
+        //! The lowest offset of the entries in the page.
+        uint16_t        m_free_end;
+
+        //! The total length of the unused space between the entries left by
+        //! the deletions.
+        uint16_t        m_nholes;
+    };
+
+    struct HashSlot {
+        uint16_t        m_offset;
+        uint16_t        m_length;
+
+        //! The higher 32 bits of the hash value of the entry.
+        uint32_t        m_tag;
+    };
+
+    /*!
+     * The header of an entry, which is followed by the key payload.
+     */
+    struct HashEntryHeader {
+        uint64_t        m_hash;
+        RecordId        m_recid;
+    };
+
+    //! The offsets and the lengths of the entries copied into a buffer.
+    typedef std::vector<std::pair<size_t, uint16_t>> EntryList;
+
+    //! An upper bound of the length of any entry including its header.
+    static constexpr size_t MaxEntryLength = PAGE_SIZE / 2;
+
+    static constexpr uint32_t PageDirChunkBits = 12;
+    static constexpr uint32_t PageDirChunkSize = 1u << PageDirChunkBits;
+    static constexpr uint32_t MaxNumPageDirChunks = 4096;
+
+    static constexpr uint32_t BucketDirChunkBits = 12;
+    static constexpr uint32_t BucketDirChunkSize = 1u << BucketDirChunkBits;
+    static constexpr uint32_t MaxNumBucketDirChunks = 4096;
+
+    HashIndex(const IndexDesc *idxdesc);
+
+    static uint32_t
+    GetLevel(uint64_t state) {
+        return (uint32_t)(state >> 32);
+    }
+
+    static uint64_t
+    GetSplitPointer(uint64_t state) {
+        return state & 0xffffffffu;
+    }
+
+    /*!
+     * Returns the bucket of the hash value \p hash in the state \p state of
+     * the level and the split pointer.
+     */
+    static uint64_t
+    GetBucket(uint64_t hash, uint64_t state) {
+        uint64_t mask = (((uint64_t) 1) << GetLevel(state)) - 1;
+        uint64_t bucket = hash & mask;
+        if (bucket < GetSplitPointer(state)) {
+            bucket = hash & ((mask << 1) | 1);
+        }
+        return bucket;
+    }
+
+    static uint32_t
+    GetTag(uint64_t hash) {
+        return (uint32_t)(hash >> 32);
+    }
+
+    /*!
+     * Returns the hash value of \p key.
+     */
+    uint64_t ComputeKeyHash(const IndexKey *key) const;
+
+    /*!
+     * Returns whether \p key is equal to the key payload \p payload, where
+     * nulls are equal to each other.
+     */
+    bool KeyEqualsPayload(const IndexKey *key, const char *payload) const;
+
+    /*!
+     * Allocates a new empty page and returns its page number. The page is
+     * not visible to any other thread until its page number is published,
+     * but a recycled one may still be read by a stale reader. So the page is
+     * returned write-locked, and the caller must unlock it with
+     * WriteUnlockPage() after filling it.
+     */
+    PageNumber AllocatePage();
+
+    char*
+    GetPage(PageNumber pid) const {
+        ASSERT(pid != INVALID_PID &&
+               pid <= m_npages.load(memory_order_relaxed));
+        return (char*) m_page_dir[(pid - 1) >> PageDirChunkBits]
+            [(pid - 1) & (PageDirChunkSize - 1)].get();
+    }
+
+    PageNumber
+    GetBucketPageNumber(uint64_t bucket) const {
+        return m_bucket_dir[bucket >> BucketDirChunkBits]
+            [bucket & (BucketDirChunkSize - 1)].load(memory_order_acquire);
+    }
+
+    /*!
+     * Recycles the pages of the chain starting from \p pid for later
+     * allocations. The chain must not be reachable from the bucket
+     * directory.
+     */
+    void FreeChain(PageNumber pid);
+
+    /*!
+     * Sets the primary page of a bucket.
+     */
+    void SetBucketPageNumber(uint64_t bucket, PageNumber pid);
+
+    static HashPageHeader*
+    GetPageHeader(char *page) {
+        return (HashPageHeader*) page;
+    }
+
+    static HashSlot*
+    GetSlots(char *page) {
+        return (HashSlot*)(page + MAXALIGN(sizeof(HashPageHeader)));
+    }
+
+    static const char*
+    GetEntry(char *page, uint16_t sid) {
+        return page + GetSlots(page)[sid].m_offset;
+    }
+
+    static const HashEntryHeader*
+    GetEntryHeader(const char *entry) {
+        return (const HashEntryHeader*) entry;
+    }
+
+    static const char*
+    GetEntryPayload(const char *entry) {
+        return entry + MAXALIGN(sizeof(HashEntryHeader));
+    }
+
+    /*!
+     * Returns the maximum number of slots on a page.
+     */
+    static constexpr uint16_t
+    GetMaxNumSlots() {
+        return (PAGE_SIZE - MAXALIGN(sizeof(HashPageHeader))) /
+            sizeof(HashSlot);
+    }
+
+    /*!
+     * See BTree::ReadLockPage() and the other page lock functions.
+     */
+    static uint64_t ReadLockPage(char *page);
+
+    static bool ValidatePage(char *page, uint64_t version);
+
+    static bool UpgradePageLock(char *page, uint64_t version);
+
+    /*!
+     * Write-locks \p page, waiting for the current writer if there's one.
+     */
+    static void WriteLockPage(char *page);
+
+    static void WriteUnlockPage(char *page);
+
+    /*!
+     * Write-locks the bucket of \p hash and returns its primary page. The
+     * bucket may not be split until it is unlocked.
+     */
+    char *LockBucket(uint64_t hash);
+
+    /*!
+     * Returns the number of bytes that may be used for a new entry and its
+     * slot in the page, including the holes.
+     */
+    static size_t GetFreeSpace(char *page);
+
+    /*!
+     * Appends the entry \p entry of \p len bytes to \p page if it has
+     * enough space.
+     */
+    static bool AppendEntryToPage(char *page, const char *entry, uint16_t len);
+
+    /*!
+     * Appends the entry \p entry of \p len bytes to the first page with
+     * enough space in the write-locked bucket with the primary page \p
+     * bucket_page, or to a new overflow page at the end of the bucket.
+     * Returns whether a new overflow page is appended.
+     */
+    bool AppendEntryToBucket(char *bucket_page,
+                             const char *entry,
+                             uint16_t len);
+
+    static void RemoveEntryFromPage(char *page, uint16_t sid);
+
+    static void CompactPage(char *page);
+
+    /*!
+     * Copies the entries in the chain starting from \p bucket_page into \p
+     * buf, or only the ones with the tag \p tag if \p match_tag is true,
+     * and appends their offsets in \p buf and their lengths to \p entries.
+     * The chain may be read without a lock. Returns false if the chain is
+     * found to be inconsistent, in which case the caller must retry, and
+     * otherwise the caller must still validate the version of \p
+     * bucket_page if it is not write-locked.
+     */
+    bool CopyChainEntries(char *bucket_page,
+                          bool match_tag,
+                          uint32_t tag,
+                          maxaligned_char_buf &buf,
+                          EntryList &entries) const;
+
+    /*!
+     * Copies the entries in the bucket of \p hash whose tag matches the one
+     * of \p hash into \p buf, and appends their offsets in \p buf and
+     * their lengths to \p entries. Returns false if the copies may be
+     * inconsistent and the read has to be retried.
+     */
+    bool TryCopyBucketEntries(uint64_t hash,
+                              maxaligned_char_buf &buf,
+                              EntryList &entries) const;
+
+    /*!
+     * Finds the entry with the key \p key and the hash value \p hash in the
+     * write-locked bucket with the primary page \p bucket_page. If \p recid
+     * is valid, the entry must also have the record ID \p recid. Returns the
+     * page and the slot of the entry, or nullptr if there's none.
+     */
+    char *FindEntryInBucket(char *bucket_page,
+                            const IndexKey *key,
+                            uint64_t hash,
+                            RecordId recid,
+                            uint16_t &sid) const;
+
+    /*!
+     * Splits the bucket at the split pointer and advances the split
+     * pointer.
+     */
+    void SplitBucket();
+
+    //! The number of times a split tries to copy the bucket without locking
+    //! it before it copies the bucket under the lock.
+    static constexpr uint32_t MaxOptimisticSplitAttempts = 3;
+
+    //! The pages, in chunks of PageDirChunkSize pages. Chunks are never
+    //! moved or freed once allocated, so that they may be read without
+    //! latching.
+    std::unique_ptr<unique_malloced_ptr[]> m_page_dir[MaxNumPageDirChunks];
+
+    std::atomic<PageNumber> m_npages;
+
+    //! Protects the page allocation.
+    std::mutex              m_alloc_latch;
+
+    //! The recycled pages, which are reused before allocating new ones.
+    std::vector<PageNumber> m_free_pids;
+
+    //! The primary pages of the buckets, in chunks of BucketDirChunkSize
+    //! buckets, which are never moved or freed once allocated.
+    std::unique_ptr<std::atomic<PageNumber>[]>
+                            m_bucket_dir[MaxNumBucketDirChunks];
+
+    //! The level in the higher 32 bits and the split pointer in the lower
+    //! 32 bits, so that a reader always sees a consistent pair.
+    std::atomic<uint64_t>   m_state;
+
+    //! Serializes the splits.
+    std::mutex              m_split_latch;
+
+    //! The hash functions that override the default ones of the key column
+    //! types, e.g., VARCHAR_hash_ci.
+    std::vector<FunctionPtr> m_hash_funcs;
+};
+
+}   // namespace taco
+
+#endif      // INDEX_HASH_HASHINDEX_H
@@ -4,8 +4,9 @@
 #define IDXTYP_INVALID 0
 #define IDXTYP_VOLATILETREE 1
 #define IDXTYP_BTREE 2
+#define IDXTYP_HASH 3
 
-#define NUM_IDXTYPS 2
+#define NUM_IDXTYPS 3
 
 #ifdef IDXTYP_CONSTANT_ONLY
 #define IDXTYP(indextype) CONCAT(IDXTYP_, indextype)
@@ -28,6 +29,7 @@ absl::string_view IdxTypeGetName(IdxType idx);
 bool IdxTypeIsVolatile(IdxType idx);
 bool IdxTypeNeedsEqualOperator(IdxType idx);
 bool IdxTypeNeedsLessOperator(IdxType idx);
+bool IdxTypeNeedsHashFunction(IdxType idx);
 
 }   // namespace taco
 
@@ -0,0 +1,323 @@
+#ifndef INDEX_VOLATILETREE_VOLATILETREE_H
+#define INDEX_VOLATILETREE_VOLATILETREE_H
+
+#include "tdb.h"
+
+#include <mutex>
+
+#include "index/Index.h"
+#include "utils/EpochManager.h"
+
+namespace taco {
+
+/*!
+ * VolatileTree is an in-memory B+-tree index for the data that do not need
+ * to survive a restart, e.g., the catalog caches and the temporary tables.
+ * Unlike BTree, it is not page-based: the nodes are allocated in memory and
+ * linked directly by pointers.
+ *
+ * The nodes are cache-conscious. A node stores up to NodeFanout entries (or
+ * separators). The 8-byte heads of their normalized keys, taken right after
+ * the prefix shared by all of them, are laid out contiguously in the first
+ * cache lines of the node, so that a search within a node only compares the
+ * integer heads in most cases. The entries themselves are allocated
+ * separately and pointed to by the nodes, with the key payload in the key
+ * schema, the record ID and the full normalized key. If the index does not
+ * use normalized keys (see Index::m_use_nkey), the heads are all 0 and the
+ * keys are compared with the comparison functions. Like BTree, the entries
+ * are ordered by the (key, record ID) pairs.
+ *
+ * The VolatileTree is thread-safe. The readers are lock-free: the nodes are
+ * never updated once published, and a writer copies the nodes on the path
+ * from the root to the leaf it modifies, and then publishes the new root
+ * (see EpochManager). The writers are serialized by a latch. An iterator
+ * copies the entries of one leaf at a time out of the tree, so a scan sees
+ * a consistent snapshot of each leaf but not necessarily of the whole tree.
+ */
+class VolatileTree: public Index {
+public:
+    static std::unique_ptr<VolatileTree> Create(const IndexDesc *idxdesc);
+
+    ~VolatileTree() override;
+
+    bool InsertKey(const IndexKey *key, RecordId recid) override;
+
+    bool DeleteKey(const IndexKey *key, RecordId &recid) override;
+
+    /*!
+     * Builds the VolatileTree bottom-up from the pairs in \p src, with all
+     * the nodes filled. The VolatileTree must be empty.
+     */
+    void BulkLoad(BulkLoadSource *src) override;
+
+    std::unique_ptr<Index::Iterator> StartScan(const IndexKey *lower,
+                                               bool lower_isstrict,
+                                               const IndexKey *upper,
+                                               bool upper_isstrict) override;
+
+    /*!
+     * Returns the height of the tree, i.e., the number of levels.
+     */
+    uint32_t GetTreeHeight() const;
+
+private:
+    class Iterator;
+
+    //! The maximum number of entries on a leaf, or separators on an
+    //! internal node, so that the node header and the heads fit in two
+    //! cache lines.
+    static constexpr uint32_t NodeFanout =
+        (2 * CACHELINE_SIZE - 2 * sizeof(uint16_t) - sizeof(uint32_t)) /
+        sizeof(uint64_t);
+
+    //! The maximum length of the prefix stored on a node, so that a search
+    //! does not need to read an entry to compare with the prefix.
+    static constexpr uint32_t MaxPrefixLength = 32;
+
+    /*!
+     * An entry on a leaf or a separator on an internal node. It is followed
+     * by the key payload at MAXALIGN(sizeof(Entry)), and then the normalized
+     * key of m_nkey_len bytes. An entry is never changed once created, and
+     * a separator is a copy of a leaf entry owned by its internal node.
+     */
+    struct Entry {
+        RecordId        m_recid;
+        FieldOffset     m_payload_len;
+        uint32_t        m_nkey_len;
+
+        const char*
+        GetPayload() const {
+            return ((const char*) this) + MAXALIGN(sizeof(Entry));
+        }
+
+        const char*
+        GetNormalizedKey() const {
+            return GetPayload() + MAXALIGN(m_payload_len);
+        }
+    };
+
+    /*!
+     * The common header of the leaves and the internal nodes. m_prefix is a
+     * common prefix of the normalized keys of all the entries on the node,
+     * up to MaxPrefixLength bytes, and the heads are the next 8 bytes of them
+     * after the prefix in big-endian, padded with zeros. An internal node with
+     * m_nkeys separators has
+     * m_nkeys + 1 children, where the child i covers the entries in
+     * [m_entries[i - 1], m_entries[i]). Only the root may be an empty leaf,
+     * while an internal node always has at least one child.
+     */
+    struct Node {
+        uint16_t        m_level;
+        uint16_t        m_nkeys;
+        uint32_t        m_prefix_len;
+        uint64_t        m_heads[NodeFanout];
+        char            m_prefix[MaxPrefixLength];
+        const Entry     *m_entries[NodeFanout];
+    };
+
+    struct InternalNode: public Node {
+        Node            *m_children[NodeFanout + 1];
+    };
+
+    /*!
+     * A search key to be compared with the entries. See
+     * BTree::BTreeSearchKey for the meaning of the fields.
+     */
+    struct SearchKey {
+        const IndexKey  *m_key;
+        FieldId         m_nkeys;
+        RecordId        m_recid;
+        int             m_tie;
+        const char      *m_nkey;
+        size_t          m_nkey_len;
+    };
+
+    /*!
+     * A position on a leaf, along with the internal nodes on the path from
+     * the root and the child index taken on each of them. It is only valid
+     * within the read-side critical section it was found in.
+     */
+    struct Cursor {
+        std::vector<std::pair<const Node*, uint32_t>> m_path;
+        const Node      *m_leaf;
+        uint32_t        m_pos;
+    };
+
+    /*!
+     * The result of inserting into a subtree: the new copy of the root of
+     * the subtree, and the new right sibling and its separator if the copy
+     * has been split. m_node is null if nothing is inserted.
+     */
+    struct ModifyResult {
+        Node            *m_node;
+        Node            *m_right;
+        const Entry     *m_sep;
+    };
+
+    /*!
+     * The nodes replaced and the entries (or separators) removed by a write,
+     * which are retired together once the write is published.
+     */
+    struct Garbage {
+        std::vector<Node*>          m_nodes;
+        std::vector<const Entry*>   m_entries;
+
+        ~Garbage();
+    };
+
+    VolatileTree(const IndexDesc *idxdesc);
+
+    /*!
+     * Returns the head of the normalized key \p nkey after the first \p
+     * prefix_len bytes.
+     */
+    static uint64_t ComputeHead(const char *nkey,
+                                size_t nkey_len,
+                                size_t prefix_len);
+
+    /*!
+     * Recomputes the prefix and the heads of \p node from its entries.
+     */
+    static void ComputeNodeHeads(Node *node);
+
+    /*!
+     * Creates an entry for the key payload \p payload and the record ID \p
+     * recid, with its normalized key \p nkey if the index uses normalized
+     * keys.
+     */
+    const Entry *CreateEntry(const char *payload,
+                             FieldOffset payload_len,
+                             RecordId recid,
+                             const char *nkey,
+                             size_t nkey_len) const;
+
+    /*!
+     * Creates a copy of \p entry to be used as a separator.
+     */
+    static const Entry *CopyEntry(const Entry *entry);
+
+    static void FreeEntry(void *entry);
+
+    static Node *AllocateNode(uint16_t level);
+
+    static Node *CopyNode(const Node *node);
+
+    static void FreeNode(void *node);
+
+    /*!
+     * Frees all the nodes, the entries and the separators in the subtree
+     * rooted at \p node.
+     */
+    static void FreeSubtree(Node *node);
+
+    /*!
+     * Sets the entries (or separators) of a new \p node to \p entries, and
+     * its children to \p children if it is an internal node.
+     */
+    static void FillNode(Node *node,
+                         const Entry *const *entries,
+                         uint16_t nentries,
+                         Node *const *children);
+
+    /*!
+     * Initializes a search key for the first \p nkeys columns of \p key,
+     * with its normalized key written into \p nkey_buf if it may be used.
+     */
+    void MakeSearchKey(SearchKey &skey,
+                       const IndexKey *key,
+                       FieldId nkeys,
+                       RecordId recid,
+                       int tie,
+                       std::string &nkey_buf) const;
+
+    /*!
+     * Compares the search key \p skey with \p entry.
+     */
+    int CompareWithEntry(const SearchKey &skey, const Entry *entry) const;
+
+    /*!
+     * Returns the number of entries (or separators) on \p node that are
+     * smaller than \p skey, or not larger than \p skey if \p upper is
+     * true.
+     */
+    uint32_t SearchNode(const SearchKey &skey,
+                        const Node *node,
+                        bool upper) const;
+
+    /*!
+     * Positions \p cursor at the first entry that is not smaller than \p
+     * skey. Returns false if there's none. The caller must be in a
+     * read-side critical section or hold the write latch.
+     */
+    bool Seek(const SearchKey &skey, Cursor &cursor) const;
+
+    /*!
+     * Moves \p cursor to the first entry on the next leaf. Returns false if
+     * it is on the last leaf.
+     */
+    static bool MoveToNextLeaf(Cursor &cursor);
+
+    /*!
+     * Returns the first entry with the same key as \p skey that is not
+     * smaller than \p skey, or nullptr if there's none. The caller must be
+     * in a read-side critical section or hold the write latch.
+     */
+    const Entry *FindEntry(const SearchKey &skey) const;
+
+    /*!
+     * Returns a new node with \p entry inserted into \p node as the \p
+     * pos-th entry (or separator), or the two halves of it if it overflows.
+     * On an internal node, the child at \p pos is replaced by \p
+     * left_child and \p right_child is inserted after it.
+     */
+    static ModifyResult InsertIntoNode(const Node *node,
+                                       uint32_t pos,
+                                       const Entry *entry,
+                                       Node *left_child,
+                                       Node *right_child);
+
+    /*!
+     * Inserts \p entry for \p skey into the subtree rooted at \p node with
+     * path copying, and adds the replaced nodes to \p garbage.
+     */
+    ModifyResult InsertRecursive(const SearchKey &skey,
+                                 const Entry *entry,
+                                 Node *node,
+                                 Garbage &garbage);
+
+    /*!
+     * Deletes the entry that matches \p skey from the subtree rooted at \p
+     * node with path copying, and adds the replaced nodes and the removed
+     * entry and separators to \p garbage. Sets \p new_node to the new copy
+     * of \p node, or nullptr if it becomes empty. Returns false if there's
+     * no such entry.
+     */
+    bool DeleteRecursive(const SearchKey &skey,
+                         Node *node,
+                         Node *&new_node,
+                         Garbage &garbage);
+
+    bool PayloadHasAnyNull(const char *payload) const;
+
+    /*!
+     * Appends \p entry (or a separator with the right child \p
+     * right_child) to the rightmost node on \p level during a bulk load,
+     * where \p rightmost are the rightmost nodes on each level.
+     */
+    static void BulkLoadAppendEntry(std::vector<Node*> &rightmost,
+                                    uint16_t level,
+                                    const Entry *entry,
+                                    Node *right_child);
+
+    //! The root of the tree, which is never null.
+    atomic<Node*>               m_root;
+
+    //! Serializes the writers.
+    std::mutex                  m_write_latch;
+
+    mutable EpochManager        m_epoch;
+};
+
+}   // namespace taco
+
+#endif      // INDEX_VOLATILETREE_VOLATILETREE_H
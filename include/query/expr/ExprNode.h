@@ -0,0 +1,213 @@
+#ifndef QUERY_EXPR_EXPRNODE_H
+#define QUERY_EXPR_EXPRNODE_H
+
+#include "tdb.h"
+
+#include "catalog/Schema.h"
+#include "query/expr/optypes.h"
+
+namespace taco {
+
+enum class ExprKind {
+    Column,
+    Constant,
+    Operator,
+};
+
+/*!
+ * ExprNode is a node of an expression tree over the fields of a record. A
+ * node is either a column reference, a constant, or an operator in
+ * query/expr/optypes.h over one or two child expressions.
+ *
+ * An expression tree is built bottom-up with the Create functions, and then
+ * bound to the schema of the records with Bind(), which resolves the types of
+ * all the nodes and looks up the operator functions in the catalog once.
+ * Bind() also folds the operators over constants into constants, so that
+ * they are evaluated only once rather than on every record. A
+ * bound expression is compiled into an ExprProgram for evaluation (see
+ * query/expr/ExprProgram.h), and must outlive the programs compiled from it.
+ */
+class ExprNode {
+public:
+    /*!
+     * Creates a reference to the field \p field of the records.
+     */
+    static std::unique_ptr<ExprNode> CreateColumn(FieldId field);
+
+    /*!
+     * Creates a constant \p value of the type \p typid with the type
+     * parameter \p typparam. The value is copied if it references any
+     * external memory.
+     */
+    static std::unique_ptr<ExprNode> CreateConstant(Datum value,
+                                                    Oid typid,
+                                                    uint64_t typparam = 0);
+
+    /*!
+     * Creates an operator \p optype over \p arg0 and \p arg1, where \p arg1
+     * must be null if the operator is unary. Use CreateCast() for the casts.
+     */
+    static std::unique_ptr<ExprNode> CreateOperator(
+        OpType optype,
+        std::unique_ptr<ExprNode> arg0,
+        std::unique_ptr<ExprNode> arg1 = nullptr);
+
+    /*!
+     * Creates a cast of \p arg to the type \p typid with the type parameter
+     * \p typparam.
+     */
+    static std::unique_ptr<ExprNode> CreateCast(std::unique_ptr<ExprNode> arg,
+                                                Oid typid,
+                                                uint64_t typparam = 0);
+
+    ~ExprNode();
+
+    /*!
+     * Binds the expression to the records of the schema \p schema. Raises an
+     * error if a field is out of bound or an operator is not defined over
+     * the types of its operands.
+     *
+     * An operator whose operands are all constants is evaluated here and
+     * replaced by a constant of its result, as is an AND (resp. OR) with a
+     * false (resp. true) constant operand. An AND (resp. OR) with a true
+     * (resp. false) constant operand is replaced by its other operand.
+     * Hence, a node may become a constant or another kind of node after it
+     * is bound. Any error raised by an operator function on the constants is
+     * raised by Bind().
+     */
+    void Bind(const Schema *schema);
+
+    /*!
+     * Returns whether this expression and \p other are the same expression,
+     * i.e., they always evaluate to the same value on the same record. Both
+     * expressions must be bound.
+     */
+    bool Equals(const ExprNode *other) const;
+
+    ExprKind
+    GetKind() const {
+        return m_kind;
+    }
+
+    bool
+    IsBound() const {
+        return m_bound;
+    }
+
+    /*!
+     * Returns the type of the expression, which is only valid after it is
+     * bound, except for a constant or a cast.
+     */
+    Oid
+    GetTypeId() const {
+        return m_typid;
+    }
+
+    uint64_t
+    GetTypeParam() const {
+        return m_typparam;
+    }
+
+    /*!
+     * Returns the referenced field of a column.
+     */
+    FieldId
+    GetField() const {
+        ASSERT(m_kind == ExprKind::Column);
+        return m_field;
+    }
+
+    /*!
+     * Returns the value of a constant.
+     */
+    const Datum&
+    GetValue() const {
+        ASSERT(m_kind == ExprKind::Constant);
+        return m_value;
+    }
+
+    OpType
+    GetOpType() const {
+        ASSERT(m_kind == ExprKind::Operator);
+        return m_optype;
+    }
+
+    size_t
+    GetNumArgs() const {
+        return m_args.size();
+    }
+
+    const ExprNode*
+    GetArg(size_t i) const {
+        ASSERT(i < m_args.size());
+        return m_args[i].get();
+    }
+
+    /*!
+     * Returns the operator function of a bound operator, or nullptr if the
+     * operator is a cast to the type and the type parameter of its operand,
+     * which is a no-op.
+     */
+    FunctionInfo
+    GetFunction() const {
+        ASSERT(m_kind == ExprKind::Operator && m_bound);
+        return m_func;
+    }
+
+    Oid
+    GetFunctionId() const {
+        ASSERT(m_kind == ExprKind::Operator && m_bound);
+        return m_funcid;
+    }
+
+private:
+    ExprNode(ExprKind kind);
+
+    void BindOperator();
+
+    /*!
+     * Folds this bound operator into a constant, or replaces it with one of
+     * its operands, if it can be evaluated without any record. See Bind().
+     */
+    void FoldConstants();
+
+    /*!
+     * Evaluates this bound operator over its operands, which must all be
+     * constants.
+     */
+    Datum EvalConstantOperator();
+
+    /*!
+     * Turns this node into a constant \p value of the same type.
+     */
+    void MakeConstant(Datum value);
+
+    /*!
+     * Turns this node into \p node, which must not be this node.
+     */
+    void ReplaceWith(std::unique_ptr<ExprNode> node);
+
+    ExprKind                m_kind;
+
+    bool                    m_bound;
+
+    Oid                     m_typid;
+
+    uint64_t                m_typparam;
+
+    FieldId                 m_field;
+
+    Datum                   m_value;
+
+    OpType                  m_optype;
+
+    std::vector<std::unique_ptr<ExprNode>> m_args;
+
+    Oid                     m_funcid;
+
+    FunctionInfo            m_func;
+};
+
+}   // namespace taco
+
+#endif      // QUERY_EXPR_EXPRNODE_H
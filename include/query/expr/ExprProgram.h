@@ -0,0 +1,288 @@
+#ifndef QUERY_EXPR_EXPRPROGRAM_H
+#define QUERY_EXPR_EXPRPROGRAM_H
+
+#include "tdb.h"
+
+#include "catalog/Schema.h"
+#include "query/expr/ExprNode.h"
+#include "utils/MemoryContext.h"
+
+namespace taco {
+
+/*!
+ * ExprProgram is a bound expression compiled into a flat sequence of
+ * instructions over a register file, so that evaluating the expression on a
+ * record is a single loop over the instructions, instead of a recursive
+ * walk of the expression tree.
+ *
+ * Each node of the expression that is not a constant has its own register,
+ * while the constants are read in place from the expression tree. The
+ * compiler fuses the following patterns into single instructions:
+ *
+ * - a binary operator over a column and a constant (in either order) reads
+ *   the field from the record and calls the operator function without
+ *   loading the field into a register;
+ * - an AND over such comparisons is evaluated by one instruction that loops
+ *   over the comparisons and stops at the first false one.
+ *
+ * All the operator functions other than AND and OR return null if any of
+ * their operands is null, so an instruction sets its result to null without
+ * calling the function if any operand is null. AND, OR and NOT are
+ * evaluated directly in the three-valued logic, and AND and OR skip the rest
+ * of their operands as soon as the result is known. A program compiled by
+ * CompileFilter() additionally stops at the first null operand of the top
+ * AND, since a filter only passes a record on true.
+ *
+ * The compiler also eliminates the common subexpressions (see
+ * ExprNode::Equals()): a subexpression is computed only once per record if
+ * it appears more than once in the expression, or in the qualification and
+ * the target list of a program compiled by CompileQuery(). A value computed
+ * in an operand of AND or OR that may be skipped is only reused within the
+ * rest of that AND or OR.
+ *
+ * A program owns a per-query memory context that lives as long as the
+ * program, and a per-tuple child context that is the current memory context
+ * while the program runs. The operator functions allocate their
+ * variable-length results in the per-tuple context (see
+ * CreateVarlenDatum()), which is reset at the start of every evaluation, so
+ * that these results are freed all at once rather than one by one.
+ *
+ * An ExprProgram is not thread-safe as the registers are in the program.
+ * Each thread should compile its own.
+ */
+class ExprProgram {
+public:
+    /*!
+     * Compiles the bound expression \p expr over the records of the schema
+     * \p schema. The expression must outlive the program.
+     */
+    static std::unique_ptr<ExprProgram> Compile(const ExprNode *expr,
+                                                const Schema *schema);
+
+    /*!
+     * Same as Compile(), except that the program may only be evaluated with
+     * EvalFilter().
+     */
+    static std::unique_ptr<ExprProgram> CompileFilter(const ExprNode *expr,
+                                                      const Schema *schema);
+
+    /*!
+     * Compiles the bound qualification \p qual and the bound target list
+     * \p targets over the records of the schema \p schema into a single
+     * program, where the targets are only evaluated on the records that
+     * pass the qualification. \p qual may be null if there's no
+     * qualification. The expressions must outlive the program.
+     */
+    static std::unique_ptr<ExprProgram> CompileQuery(
+        const ExprNode *qual,
+        const std::vector<const ExprNode*> &targets,
+        const Schema *schema);
+
+    ~ExprProgram();
+
+    /*!
+     * Evaluates the expression on the record payload \p payload. The
+     * returned value is valid until the next evaluation or the program is
+     * destructed.
+     */
+    NullableDatumRef Eval(const char *payload);
+
+    /*!
+     * Returns whether the boolean expression evaluates to true on the record
+     * payload \p payload.
+     */
+    bool EvalFilter(const char *payload);
+
+    /*!
+     * Returns whether the record payload \p payload passes the
+     * qualification of a program compiled by CompileQuery(), and evaluates
+     * the targets on it if so.
+     */
+    bool EvalQuery(const char *payload);
+
+    size_t
+    GetNumTargets() const {
+        return m_targets.size();
+    }
+
+    /*!
+     * Returns the value of the target \p i on the last record, which must
+     * have passed EvalQuery(). The returned value is valid until the next
+     * evaluation or the program is destructed.
+     */
+    NullableDatumRef
+    GetTarget(size_t i) const {
+        ASSERT(i < m_targets.size());
+        return NullableDatumRef(*m_targets[i]);
+    }
+
+    /*!
+     * Returns the number of instructions in the program.
+     */
+    size_t
+    GetNumInstructions() const {
+        return m_code.size();
+    }
+
+    /*!
+     * Returns the per-query memory context of the program, in which the
+     * caller may allocate anything that has to be kept across records.
+     */
+    MemoryContext*
+    GetQueryMemoryContext() {
+        return &m_query_mctx;
+    }
+
+    /*!
+     * Returns the per-tuple memory context of the program, which is reset at
+     * the start of every evaluation.
+     */
+    MemoryContext*
+    GetTupleMemoryContext() {
+        return &m_tuple_mctx;
+    }
+
+private:
+    enum class Opcode: uint8_t {
+        //! r[dst] = field m_field of the record
+        LoadField,
+        //! r[dst] = m_func(*arg0)
+        Call1,
+        //! r[dst] = m_func(*arg0, *arg1)
+        Call2,
+        //! r[dst] = m_func(field m_field, *arg1), or with the operands
+        //! swapped if m_swapped
+        CallFieldConst,
+        //! r[dst] = NOT *arg0
+        Not,
+        //! r[dst] = m_bool
+        SetBool,
+        //! r[dst] = r[dst] AND *arg0, jumping to m_target if r[dst] becomes
+        //! false
+        AndStep,
+        //! r[dst] = r[dst] OR *arg0, jumping to m_target if r[dst] becomes
+        //! true
+        OrStep,
+        //! r[dst] = r[dst] AND (the comparisons in m_terms[m_first_term,
+        //! m_first_term + m_nterms)), jumping to m_target if r[dst] becomes
+        //! false
+        AndFieldConst,
+        //! jumps to m_target unless *arg0 is true
+        ExitUnlessTrue,
+    };
+
+    struct Instruction {
+        Opcode          m_opcode;
+
+        //! Whether an AND step also jumps to m_target on a null operand.
+        bool            m_null_exits;
+
+        bool            m_swapped;
+
+        bool            m_bool;
+
+        FieldId         m_field;
+
+        uint32_t        m_dst;
+
+        uint32_t        m_target;
+
+        uint32_t        m_first_term;
+
+        uint32_t        m_nterms;
+
+        const Datum     *m_args[2];
+
+        FunctionInfo    m_func;
+
+        //! The type parameter of the result passed to m_func.
+        uint64_t        m_typparam;
+    };
+
+    //! A comparison of a field with a constant in an AndFieldConst
+    //! instruction.
+    struct FieldConstTerm {
+        FieldId         m_field;
+
+        bool            m_swapped;
+
+        const Datum     *m_value;
+
+        FunctionInfo    m_func;
+    };
+
+    ExprProgram(const Schema *schema);
+
+    /*!
+     * Allocates enough registers for the expressions in \p roots.
+     */
+    void AllocateRegisters(const std::vector<const ExprNode*> &roots);
+
+    /*!
+     * Emits the code of \p node and returns where its value is, which is
+     * either a register or a constant in the expression tree. The code is
+     * only emitted if \p node is not a common subexpression already
+     * computed.
+     */
+    const Datum *CompileNode(const ExprNode *node, bool is_filter_root);
+
+    const Datum *CompileOperator(const ExprNode *node, bool is_filter_root);
+
+    const Datum *CompileAndOr(const ExprNode *node, bool is_filter_root);
+
+    /*!
+     * Returns whether \p node is a binary operator over a column and a
+     * constant, and sets \p field, \p value and \p swapped if so.
+     */
+    static bool IsFieldConstOperator(const ExprNode *node,
+                                     FieldId &field,
+                                     const Datum *&value,
+                                     bool &swapped);
+
+    uint32_t
+    AllocateRegister() {
+        ASSERT(m_nregs_used < m_regs.size());
+        return m_nregs_used++;
+    }
+
+    Instruction &EmitInstruction(Opcode opcode, uint32_t dst);
+
+    /*!
+     * Runs the program on the record payload \p payload.
+     */
+    void Run(const char *payload);
+
+    const Schema                *m_schema;
+
+    std::vector<Instruction>    m_code;
+
+    std::vector<FieldConstTerm> m_terms;
+
+    //! The registers, which are allocated before the compilation so that
+    //! the instructions may point to them.
+    std::vector<Datum>          m_regs;
+
+    uint32_t                    m_nregs_used;
+
+    //! The subexpressions that are computed whenever the code being
+    //! compiled is run, and where their values are.
+    std::vector<std::pair<const ExprNode*, const Datum*>> m_cse;
+
+    //! Where the result of the expression or the qualification is, or null
+    //! if a query has no qualification.
+    const Datum                 *m_result;
+
+    //! Where the values of the targets of a query are.
+    std::vector<const Datum*>   m_targets;
+
+    bool                        m_is_filter;
+
+    MemoryContext               m_query_mctx;
+
+    //! A child of m_query_mctx, so it must be declared after it.
+    MemoryContext               m_tuple_mctx;
+};
+
+}   // namespace taco
+
+#endif      // QUERY_EXPR_EXPRPROGRAM_H
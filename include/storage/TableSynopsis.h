@@ -0,0 +1,217 @@
+#ifndef STORAGE_TABLESYNOPSIS_H
+#define STORAGE_TABLESYNOPSIS_H
+
+#include "tdb.h"
+
+#include <absl/container/flat_hash_map.h>
+
+#include <mutex>
+
+#include "catalog/Schema.h"
+#include "query/expr/optypes.h"
+#include "storage/Record.h"
+
+namespace taco {
+
+/*!
+ * TableSynopsis is a lightweight side structure of a table that summarizes
+ * the records on each range of pages, so that a scan with a selective
+ * predicate may skip the ranges that can't have any matching record without
+ * reading them.
+ *
+ * The pages are grouped into ranges of `--synopsis_pages_per_range' pages by
+ * their page numbers. For each range and each column, the synopsis keeps
+ * the minimum and the maximum non-null values by the < operator of the
+ * column type (the zone map), and the number of nulls. Optionally, it also
+ * keeps a blocked Bloom filter of `--synopsis_bloom_bytes' bytes for each
+ * range on some chosen columns, for the equality predicates that the zone
+ * maps can't prune, e.g., on a column whose values are not clustered.
+ *
+ * There is no heap file yet, so the synopsis is not maintained
+ * automatically. The caller that inserts records into a table must call
+ * InsertRecord() for each of them, and a scan must call RangeMayMatch()
+ * itself to decide whether to skip a range. Deletions are not reflected, so
+ * the synopsis of a range may be wider than necessary but never misses a
+ * record. The synopsis is kept in memory and written as a whole to its side
+ * file on Flush(), and the side file is followed by fsync(2) only if
+ * FORCE_FSYNC is defined.
+ *
+ * The TableSynopsis is thread-safe.
+ */
+class TableSynopsis {
+public:
+    /*!
+     * Creates an empty synopsis for a table with the schema \p schema, with
+     * Bloom filters on the columns \p bloom_fields, which must have hash
+     * functions. The side file at \p path is created on the first Flush().
+     */
+    static std::unique_ptr<TableSynopsis> Create(
+        const Schema *schema,
+        std::vector<FieldId> bloom_fields,
+        std::string path);
+
+    /*!
+     * Loads the synopsis of a table with the schema \p schema from the side
+     * file at \p path, which was written by Flush().
+     */
+    static std::unique_ptr<TableSynopsis> Open(const Schema *schema,
+                                               std::string path);
+
+    ~TableSynopsis();
+
+    /*!
+     * Adds the record \p rec to the synopsis of the range of its page.
+     * `rec.GetRecordId()' must be valid.
+     */
+    void InsertRecord(const Record &rec);
+
+    /*!
+     * Returns the range that the page \p pid belongs to.
+     */
+    uint64_t
+    GetRangeOfPage(PageNumber pid) const {
+        return pid / m_pages_per_range;
+    }
+
+    /*!
+     * Returns the number of pages in a range.
+     */
+    uint32_t
+    GetPagesPerRange() const {
+        return m_pages_per_range;
+    }
+
+    /*!
+     * Returns whether any record in the range \p range may satisfy the
+     * predicate `field <optype> value', where \p value is of the type of the
+     * column. A predicate with a null \p value is never satisfied. Only
+     * OPTYPE(EQ), OPTYPE(NE), OPTYPE(LT), OPTYPE(LE), OPTYPE(GT) and
+     * OPTYPE(GE) are pruned, and it returns true for any other \p optype.
+     */
+    bool RangeMayMatch(uint64_t range,
+                       FieldId field,
+                       OpType optype,
+                       const NullableDatumRef &value) const;
+
+    /*!
+     * Returns whether any record in the range \p range may have a null in
+     * the column \p field.
+     */
+    bool RangeMayHaveNull(uint64_t range, FieldId field) const;
+
+    /*!
+     * Returns the number of records inserted into the range \p range.
+     */
+    uint64_t GetNumRecordsInRange(uint64_t range) const;
+
+    /*!
+     * Writes the synopsis to its side file, replacing the old one if any.
+     */
+    void Flush();
+
+private:
+    //! The number of bytes in a Bloom filter block. All the bits set for a
+    //! value are in the same block, so that a probe reads one cache line.
+    static constexpr size_t BloomBlockSize = 32;
+
+    struct RangeSynopsis {
+        uint64_t                m_nrecs;
+
+        //! The minimum and maximum non-null values of each column, which are
+        //! null if there's none or if the column type can't be ordered.
+        std::vector<Datum>      m_min;
+        std::vector<Datum>      m_max;
+
+        std::vector<uint64_t>   m_nnulls;
+
+        //! The Bloom filters of the columns in m_bloom_fields, one after
+        //! another.
+        std::vector<uint32_t>   m_bloom;
+    };
+
+    TableSynopsis(const Schema *schema,
+                  std::vector<FieldId> bloom_fields,
+                  std::string path,
+                  uint32_t pages_per_range,
+                  uint32_t bloom_bytes);
+
+    /*!
+     * Returns the synopsis of the range \p range, or nullptr if there's no
+     * record in it. The caller must hold m_latch.
+     */
+    const RangeSynopsis *FindRange(uint64_t range) const;
+
+    RangeSynopsis *GetOrCreateRange(uint64_t range);
+
+    /*!
+     * Returns the \p i-th Bloom filter in \p rsyn.
+     */
+    uint32_t*
+    GetBloomFilter(RangeSynopsis *rsyn, size_t i) const {
+        return rsyn->m_bloom.data() + i * (m_bloom_bytes / sizeof(uint32_t));
+    }
+
+    const uint32_t*
+    GetBloomFilter(const RangeSynopsis *rsyn, size_t i) const {
+        return rsyn->m_bloom.data() + i * (m_bloom_bytes / sizeof(uint32_t));
+    }
+
+    /*!
+     * Sets the bits of the hash value \p hash in the Bloom filter \p
+     * filter.
+     */
+    void BloomInsert(uint32_t *filter, uint64_t hash) const;
+
+    /*!
+     * Returns whether the hash value \p hash may be in the Bloom filter \p
+     * filter.
+     */
+    bool BloomMayContain(const uint32_t *filter, uint64_t hash) const;
+
+    /*!
+     * Serializes the ranges into \p body, which is the side file without
+     * its header. The caller must hold m_latch.
+     */
+    void SerializeRanges(maxaligned_char_buf &body) const;
+
+    /*!
+     * Loads \p nranges ranges from \p body of \p len bytes, which is the
+     * side file without its header. Returns false if it is malformed.
+     */
+    bool DeserializeRanges(const char *body, size_t len, uint64_t nranges);
+
+    const Schema            *m_schema;
+
+    //! The schema for writing the minimum and maximum values of a range as
+    //! payloads, which is the table schema with all columns nullable.
+    std::unique_ptr<Schema> m_bound_schema;
+
+    //! The < and = operators of the column types. The < operator is null if
+    //! the column type has none, in which case the column has no zone map.
+    std::vector<FunctionInfo> m_lt_funcs;
+    std::vector<FunctionInfo> m_eq_funcs;
+
+    std::vector<FieldId>    m_bloom_fields;
+
+    //! The hash functions of m_bloom_fields.
+    std::vector<FunctionInfo> m_hash_funcs;
+
+    //! The index into m_bloom_fields of each column, or -1 if it has no
+    //! Bloom filter.
+    std::vector<int>        m_bloom_idx;
+
+    std::string             m_path;
+
+    uint32_t                m_pages_per_range;
+
+    uint32_t                m_bloom_bytes;
+
+    //! Protects m_ranges.
+    mutable std::mutex      m_latch;
+
+    absl::flat_hash_map<uint64_t, std::unique_ptr<RangeSynopsis>> m_ranges;
+};
+
+}   // namespace taco
+
+#endif      // STORAGE_TABLESYNOPSIS_H
@@ -0,0 +1,177 @@
+#ifndef UTILS_EPOCHMANAGER_H
+#define UTILS_EPOCHMANAGER_H
+
+#include "tdb.h"
+
+#include <mutex>
+
+namespace taco {
+
+/*!
+ * EpochManager implements epoch-based reclamation for read-mostly data
+ * structures with lock-free readers, in the style of RCU: a writer never
+ * updates a published object in place, but instead publishes a new version
+ * through an atomic pointer and retires the old one. A retired object is
+ * freed once no reader may still be reading it.
+ *
+ * A reader must access the published objects only within a read-side
+ * critical section, i.e., while holding an EpochGuard on the manager. A
+ * read-side critical section only stores into a slot owned by the current
+ * thread, so readers on different threads never write to the same cache
+ * line. Read-side critical sections may be nested and should be short, as
+ * a reader that stays in one blocks the reclamation of everything retired
+ * after it entered.
+ *
+ * Each thread that enters a read-side critical section is assigned a thread
+ * slot on first use, which is released when the thread exits. There may be
+ * at most MaxThreads threads using epoch managers at the same time.
+ *
+ * Retire() and Reclaim() are thread-safe. The destructor frees all the
+ * retired objects and must not be called while there is a reader.
+ */
+class EpochManager {
+public:
+    static constexpr size_t MaxThreads = 256;
+
+    EpochManager();
+
+    ~EpochManager();
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager &operator=(const EpochManager&) = delete;
+
+    /*!
+     * Enters a read-side critical section on the current thread. Use
+     * EpochGuard instead of directly calling Enter() and Leave().
+     */
+    void
+    Enter() {
+        Slot &slot = m_slots[GetThreadSlotIndex()];
+        if (slot.m_nesting++ == 0) {
+            slot.m_epoch.store(m_global_epoch.load(memory_order_acquire),
+                               memory_order_relaxed);
+            // Pairs with the fence in Reclaim(): either the reclaimer sees
+            // our epoch, or we see the pointers it unlinked before that.
+            std::atomic_thread_fence(memory_order_seq_cst);
+        }
+    }
+
+    /*!
+     * Leaves a read-side critical section on the current thread.
+     */
+    void
+    Leave() {
+        Slot &slot = m_slots[GetThreadSlotIndex()];
+        ASSERT(slot.m_nesting > 0);
+        if (--slot.m_nesting == 0) {
+            slot.m_epoch.store(InactiveEpoch, memory_order_release);
+        }
+    }
+
+    /*!
+     * Retires an object \p p that has been unlinked from the data structure,
+     * so that \p deleter(p) is called once all the readers that might have
+     * seen it leave their read-side critical sections.
+     */
+    void Retire(void *p, void (*deleter)(void*));
+
+    template<class T>
+    void
+    Retire(const T *p) {
+        Retire((void*) p, [](void *q) { delete (T*) q; });
+    }
+
+    /*!
+     * Frees the retired objects that are no longer reachable by any reader.
+     * This is also done opportunistically in Retire(), once every
+     * ReclaimInterval retired objects.
+     */
+    void Reclaim();
+
+    /*!
+     * Returns the number of retired objects that are not freed yet.
+     */
+    size_t GetNumRetired();
+
+private:
+    constexpr static uint64_t InactiveEpoch = ~(uint64_t) 0;
+
+    constexpr static size_t ReclaimInterval = 32;
+
+    /*!
+     * A thread slot, padded to a cache line so that the readers on different
+     * threads do not write to the same cache line. alignas() is not used here
+     * because the epoch manager may be allocated with operator new, which
+     * does not respect extended alignments in C++11.
+     */
+    struct Slot {
+        //! The epoch when the owner entered, or InactiveEpoch if it is not
+        //! in a read-side critical section.
+        atomic<uint64_t>    m_epoch;
+
+        //! Only accessed by the owner thread of the slot.
+        uint32_t            m_nesting;
+
+        char                m_padding[CACHELINE_SIZE - sizeof(uint64_t) -
+                                      sizeof(uint32_t)];
+    };
+
+    struct RetiredObject {
+        void    *m_ptr;
+        void    (*m_deleter)(void*);
+        uint64_t m_epoch;
+    };
+
+    /*!
+     * Returns the index of the thread slot of the current thread, which is
+     * assigned on first call.
+     */
+    static size_t
+    GetThreadSlotIndex() {
+        if (t_thread_slot_index != InvalidThreadSlotIndex) {
+            return t_thread_slot_index;
+        }
+        return AssignThreadSlotIndex();
+    }
+
+    static size_t AssignThreadSlotIndex();
+
+    constexpr static size_t InvalidThreadSlotIndex = ~(size_t) 0;
+
+    static thread_local size_t t_thread_slot_index;
+
+    Slot                        m_slots[MaxThreads];
+
+    char                        m_padding[CACHELINE_SIZE];
+
+    atomic<uint64_t>            m_global_epoch;
+
+    std::mutex                  m_retire_latch;
+    std::vector<RetiredObject>  m_retired;
+};
+
+/*!
+ * EpochGuard keeps the current thread in a read-side critical section of an
+ * EpochManager within its scope.
+ */
+class EpochGuard {
+public:
+    explicit EpochGuard(EpochManager *epoch):
+        m_epoch(epoch) {
+        m_epoch->Enter();
+    }
+
+    ~EpochGuard() {
+        m_epoch->Leave();
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard &operator=(const EpochGuard&) = delete;
+
+private:
+    EpochManager    *m_epoch;
+};
+
+}   // namespace taco
+
+#endif      // UTILS_EPOCHMANAGER_H
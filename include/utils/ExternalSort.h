@@ -0,0 +1,222 @@
+#ifndef UTILS_EXTERNALSORT_H
+#define UTILS_EXTERNALSORT_H
+
+#include "tdb.h"
+
+#include <functional>
+
+namespace taco {
+
+/*!
+ * ExternalSort sorts a sequence of variable-length items that may not fit in
+ * memory. The items are buffered in memory up to the memory limit, less the
+ * space of a run buffer. Every time the buffer is full, the buffered items
+ * are sorted and written sequentially to a temporary file as a sorted run.
+ *
+ * If no run has been written when the input ends, the items are returned
+ * from the buffer. Otherwise, the remaining items are written as the last
+ * run and the buffer is freed. A merge reads each of its input runs through
+ * a buffer of RunBufferSize bytes and writes its output through another
+ * one, so at most mem_limit / RunBufferSize - 1 runs are merged at a time.
+ * While there are more runs than that, the oldest ones are merged into a new
+ * run, and the final merge of the remaining runs happens as the items are
+ * read back. A run holds no memory when it is not being read or written.
+ *
+ * The temporary files are created in the directory given by --sort_tmpdir,
+ * and are unlinked right after they are created, so that they are always
+ * removed when the sort ends.
+ *
+ * The items returned by the sort are always MAXALIGN'd.
+ */
+class ExternalSort {
+public:
+    /*!
+     * Compares two items, and returns a negative number, 0 or a positive
+     * number if the first item is smaller than, equal to or larger than the
+     * second one respectively.
+     */
+    typedef std::function<int(const char *item1, const char *item2)>
+        Comparator;
+
+    /*!
+     * Returns the default memory limit set by --sort_mem.
+     */
+    static size_t GetDefaultMemLimit();
+
+    ExternalSort(Comparator cmp, size_t mem_limit);
+
+    ~ExternalSort();
+
+    ExternalSort(const ExternalSort&) = delete;
+    ExternalSort &operator=(const ExternalSort&) = delete;
+
+    /*!
+     * Adds an item of \p len bytes. It may not be called after Sort().
+     */
+    void AddItem(const char *item, uint32_t len);
+
+    /*!
+     * Ends the input, after which the items may be read in the sorted order
+     * with Next().
+     */
+    void Sort();
+
+    /*!
+     * Moves to the next item in the sorted order and returns whether there
+     * is one.
+     */
+    bool Next();
+
+    /*!
+     * Returns the current item, which is valid until the next call to
+     * Next().
+     */
+    const char*
+    GetCurrentItem() const {
+        return m_cur_item;
+    }
+
+    uint32_t
+    GetCurrentItemLength() const {
+        return m_cur_item_len;
+    }
+
+    /*!
+     * Returns the number of runs written to the temporary files before any
+     * merge.
+     */
+    size_t
+    GetNumRuns() const {
+        return m_num_runs;
+    }
+
+    /*!
+     * Returns the number of merges that wrote their output to a new run.
+     * Only valid after Sort().
+     */
+    size_t
+    GetNumIntermediateMerges() const {
+        return m_num_intermediate_merges;
+    }
+
+    /*!
+     * Returns the maximum number of runs merged at a time.
+     */
+    size_t
+    GetMaxMergeFanIn() const {
+        return m_max_fan_in;
+    }
+
+    //! The size of the buffer through which a run is read or written.
+    static constexpr size_t RunBufferSize = 256 * 1024;
+
+private:
+    /*!
+     * An input run of a merge, which is read through its own buffer.
+     */
+    struct RunReader {
+        int                 m_fd;
+        maxaligned_char_buf m_buf;
+        size_t              m_pos;
+        size_t              m_end;
+        maxaligned_char_buf m_item;
+        uint32_t            m_item_len;
+    };
+
+    /*!
+     * Sorts the items in the buffer.
+     */
+    void SortBuffer();
+
+    /*!
+     * Sorts the items in the buffer and writes them as a new run.
+     */
+    void WriteRun();
+
+    /*!
+     * Creates an unlinked temporary file for a new run and returns its file
+     * descriptor.
+     */
+    static int CreateRunFile();
+
+    /*!
+     * Appends \p len bytes at \p data to the run \p fd through the write
+     * buffer.
+     */
+    void WriteToRun(int fd, const void *data, size_t len);
+
+    /*!
+     * Writes out the write buffer to the run \p fd.
+     */
+    void FlushRun(int fd);
+
+    /*!
+     * Reads \p len bytes from the run of \p reader into \p data. Returns
+     * false if the run ends before any byte is read.
+     */
+    static bool ReadFromRun(RunReader &reader, void *data, size_t len);
+
+    /*!
+     * Reads the next item of the run of \p reader into its item buffer.
+     * Returns false if there is none.
+     */
+    static bool ReadNextItem(RunReader &reader);
+
+    /*!
+     * Starts a merge of the first \p n runs in m_runs.
+     */
+    void StartMerge(size_t n);
+
+    /*!
+     * Moves to the next item of the current merge, and sets \p item and \p
+     * len to it. Returns false if there is none.
+     */
+    bool NextMergedItem(const char *&item, uint32_t &len);
+
+    /*!
+     * Ends the current merge and closes its input runs.
+     */
+    void EndMerge();
+
+    Comparator              m_cmp;
+    size_t                  m_mem_limit;
+
+    //! The maximum number of runs merged at a time.
+    size_t                  m_max_fan_in;
+
+    //! The items in the buffer. Each item is prefixed with its length, and
+    //! is MAXALIGN'd.
+    maxaligned_char_buf     m_buf;
+
+    //! The offsets of the items in m_buf.
+    std::vector<size_t>     m_offsets;
+
+    //! The next item to return from the buffer.
+    size_t                  m_next_offset_idx;
+
+    //! The file descriptors of the runs not yet merged, from the oldest to
+    //! the newest.
+    std::vector<int>        m_runs;
+
+    //! The buffer of the run being written.
+    maxaligned_char_buf     m_write_buf;
+
+    size_t                  m_num_runs;
+    size_t                  m_num_intermediate_merges;
+
+    //! The inputs of the current merge.
+    std::vector<RunReader>  m_inputs;
+
+    //! A min-heap of the inputs of the current merge that still have items.
+    std::vector<size_t>     m_heap;
+
+    bool                    m_sorted;
+    bool                    m_merge_started;
+
+    const char              *m_cur_item;
+    uint32_t                m_cur_item_len;
+};
+
+}   // namespace taco
+
+#endif      // UTILS_EXTERNALSORT_H
@@ -0,0 +1,207 @@
+#ifndef UTILS_MEMORYCONTEXT_H
+#define UTILS_MEMORYCONTEXT_H
+
+#include "tdb.h"
+
+namespace taco {
+
+/*!
+ * A MemoryContext is a region (arena) allocator. Memory is carved out of
+ * large blocks by bumping a pointer, and is never individually freed.
+ * Instead, all the memory allocated in a context is reclaimed at once when it
+ * is reset or destructed. This is similar to the memory contexts in
+ * PostgreSQL.
+ *
+ * Memory contexts may form a tree: resetting a context also resets all its
+ * descendants. A typical usage is to have a per-query context with a
+ * per-tuple child context that is reset after each tuple is processed.
+ *
+ * A thread may designate one memory context as its current memory context
+ * (see ScopedMemoryContext). The built-in functions that produce
+ * variable-length values allocate their results in the current memory
+ * context if there is one (see CreateVarlenDatum()), so that they do not
+ * incur one malloc(3)/free(3) pair per value. The Datums returned in that case
+ * do not own their bytes, and must not be read after the memory context is
+ * reset. Use Datum::DeepCopy() to retain such a value longer than that.
+ *
+ * A MemoryContext is not thread-safe.
+ */
+class MemoryContext {
+public:
+    /*!
+     * Creates a new memory context. If \p parent is not null, the new context
+     * becomes a child of \p parent and must be destructed before its parent.
+     */
+    explicit MemoryContext(MemoryContext *parent = nullptr,
+                           size_t init_block_size = DefaultInitBlockSize,
+                           size_t max_block_size = DefaultMaxBlockSize);
+
+    ~MemoryContext();
+
+    MemoryContext(const MemoryContext&) = delete;
+    MemoryContext &operator=(const MemoryContext&) = delete;
+
+    /*!
+     * Allocates \p size bytes in this memory context. The returned memory is
+     * aligned to MAXALIGN_OF bytes and is never nullptr.
+     */
+    void*
+    Allocate(size_t size) {
+        size = MAXALIGN(size);
+        if (size <= (size_t)(m_end - m_free)) {
+            char *ret = m_free;
+            m_free += size;
+            return ret;
+        }
+        return AllocateSlow(size);
+    }
+
+    /*!
+     * Reclaims all the memory allocated in this memory context and all of its
+     * descendants. The first block of each context is retained for later
+     * use.
+     */
+    void Reset();
+
+    /*!
+     * Returns the parent of this memory context, or nullptr if it is a root.
+     */
+    MemoryContext*
+    GetParent() const {
+        return m_parent;
+    }
+
+    /*!
+     * Returns the total number of bytes in the blocks currently held by this
+     * memory context (excluding its descendants).
+     */
+    size_t
+    GetTotalBlockSize() const {
+        return m_total_block_size;
+    }
+
+    static constexpr size_t DefaultInitBlockSize = 8 * 1024;
+    static constexpr size_t DefaultMaxBlockSize = 1024 * 1024;
+
+private:
+    struct Block {
+        Block   *m_next;
+        size_t  m_size;
+    };
+
+    static constexpr size_t BlockHeaderSize = MAXALIGN(sizeof(Block));
+
+    void *AllocateSlow(size_t size);
+
+    Block *NewBlock(size_t size);
+
+    MemoryContext   *m_parent;
+    MemoryContext   *m_first_child;
+    MemoryContext   *m_next_sibling;
+
+    /*!
+     * The list of blocks in this context. The first one in the list is the
+     * one we are currently allocating from.
+     */
+    Block           *m_blocks;
+
+    /*!
+     * The block allocated at construction time that is kept across resets.
+     */
+    Block           *m_keeper;
+    char            *m_free;
+    char            *m_end;
+    size_t          m_next_block_size;
+    const size_t    m_init_block_size;
+    const size_t    m_max_block_size;
+    size_t          m_total_block_size;
+};
+
+/*!
+ * The current memory context of this thread, or nullptr if there is none.
+ * Use GetCurrentMemoryContext() and ScopedMemoryContext instead of directly
+ * accessing it.
+ */
+extern thread_local MemoryContext *g_cur_mctx;
+
+/*!
+ * Returns the current memory context of this thread, or nullptr if there is
+ * none.
+ */
+inline MemoryContext*
+GetCurrentMemoryContext() {
+    return g_cur_mctx;
+}
+
+/*!
+ * Switches the current memory context of this thread to a given one (which
+ * may be nullptr), and switches it back to the previous one when it goes out
+ * of scope.
+ */
+class ScopedMemoryContext {
+public:
+    explicit ScopedMemoryContext(MemoryContext *mctx):
+        m_saved_mctx(g_cur_mctx) {
+        g_cur_mctx = mctx;
+    }
+
+    ~ScopedMemoryContext() {
+        g_cur_mctx = m_saved_mctx;
+    }
+
+    ScopedMemoryContext(const ScopedMemoryContext&) = delete;
+    ScopedMemoryContext &operator=(const ScopedMemoryContext&) = delete;
+
+private:
+    MemoryContext   *m_saved_mctx;
+};
+
+/*!
+ * Creates a variable-length datum of \p size bytes, and calls \p fill with
+ * a writable pointer to its bytes so that the caller may fill in the value.
+ * A value of at most Datum::MaxInlineVarlenSize bytes is stored inline in the
+ * returned datum. Otherwise, the bytes are allocated in the current memory
+ * context if there is one, in which case the returned datum does not own
+ * them, or with malloc(3) and owned by the returned datum.
+ *
+ * \p fill must not retain the pointer passed to it.
+ */
+template<class Filler>
+Datum
+CreateVarlenDatum(uint32_t size, Filler &&fill) {
+    if (size <= Datum::MaxInlineVarlenSize) {
+        char buf[Datum::MaxInlineVarlenSize];
+        fill(buf);
+        return Datum::FromInlineVarlenBytes(buf, size);
+    }
+
+    MemoryContext *mctx = GetCurrentMemoryContext();
+    if (mctx) {
+        char *bytes = (char*) mctx->Allocate(size);
+        fill(bytes);
+        return Datum::FromVarlenBytes(bytes, size);
+    }
+
+    unique_malloced_ptr bytes = unique_malloc(size);
+    fill((char*) bytes.get());
+    return Datum::FromVarlenBytes(std::move(bytes), size);
+}
+
+/*!
+ * Creates a variable-length datum with a copy of the \p size bytes at \p
+ * bytes. See CreateVarlenDatum(uint32_t, Filler&&) for where the copy is
+ * allocated.
+ */
+inline Datum
+CreateVarlenDatum(const char *bytes, uint32_t size) {
+    if (size <= Datum::MaxInlineVarlenSize) {
+        return Datum::FromInlineVarlenBytes(bytes, size);
+    }
+    return CreateVarlenDatum(size, [bytes, size](char *buf) {
+        memcpy(buf, bytes, size);
+    });
+}
+
+}   // namespace taco
+
+#endif      // UTILS_MEMORYCONTEXT_H
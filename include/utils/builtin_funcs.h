@@ -31,27 +31,46 @@ namespace taco {
  *
  * You'd also need to add the file that contains the builtin function to the
  * list FILES_WITH_BUILTIN_FUNCS in src/utils/CMakeLists.txt.
+ *
+ * A builtin function may additionally have a vectorized variant that
+ * evaluates it over a batch of rows (see VecFunctionCallInfo in base/fmgr.h).
+ * It is defined with BUILTIN_VECFUNC at the beginning of a line in one of the
+ * files in FILES_WITH_BUILTIN_FUNCS, and its argument must be the name of a
+ * builtin function defined with BUILTIN_FUNC. For instance,
+ *
+ * BUILTIN_VECFUNC(f)
+ * {
+ *  // vectorized implementation of f, see utils/typsupp/vecfuncs.h for
+ *  // the helper templates
+ * }
  */
 #define BUILTIN_RETTYPE(...)
 #define BUILTIN_FUNC(func_name, ...) \
     ::taco::Datum func_name (FMGR_FUNCTION_ARGS)
 #define BUILTIN_ARGTYPE(...)
 #define BUILTIN_OPR(...)
+#define BUILTIN_VECFUNC(func_name) \
+    void CONCAT(func_name, _vec) (FMGR_VECFUNCTION_ARGS)
 
 /*!
- * Initializes the lookup table for built-in functions registered in the system
- * catalog.
+ * Looks up the function pointer of a built-in function registered in the
+ * system catalog. The returned pointer stays valid for the lifetime of the
+ * process, so it may be cached by the caller. The lookup is an indexed load
+ * from a dispatch table generated at build time, and does not require any
+ * initialization.
+ *
+ * @returns the function pointer if found, or nullptr if not found
  */
-void InitBuiltinFunctions();
+FunctionPtr FindBuiltinFunction(Oid oid);
 
 /*!
- * Looks up the callable function info for a built-in function registered in
- * the system catalog.
+ * Looks up the vectorized variant of a built-in function registered in the
+ * system catalog.
  *
- * @returns a valid FunctionInfo if found, or an invalid FunctionInfo if not
- * found
+ * @returns the function pointer if the function \p oid has a vectorized
+ * variant, or nullptr otherwise
  */
-FunctionInfo FindBuiltinFunction(Oid oid);
+VecFunctionPtr FindBuiltinVecFunction(Oid oid);
 
 }   // namespace taco
 
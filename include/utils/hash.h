@@ -0,0 +1,143 @@
+#ifndef UTILS_HASH_H
+#define UTILS_HASH_H
+
+#include "tdb.h"
+
+namespace taco {
+
+/*!
+ * @file
+ *
+ * Hash functions for in-memory hash tables (hash joins, hash aggregation and
+ * hash indexes). HashBytes() and HashInteger() are wyhash-style hash
+ * functions: they are fast, have good avalanche behavior, and are stable
+ * across runs and platforms, but they are not cryptographically secure.
+ * CRC32C() computes the Castagnoli CRC, with the SSE 4.2 crc32 instructions
+ * if the CPU supports them, and is mostly for checksums and cheap hash
+ * partitioning.
+ *
+ * The hash functions of the built-in types are registered in the Type
+ * catalog as typhashfunc, and take a value of the type and return its hash
+ * value as a UINT8. Equal values (under the = operator of the type) always
+ * have equal hash values, and so do equal values of different numeric types
+ * (see HashInteger() and HashDouble()). Schema::ComputeHash() combines the
+ * hash values of the fields of a record into a single one.
+ */
+
+/*!
+ * The hash value of a NULL, which is combined into the hash value of a
+ * record when a field is NULL.
+ */
+constexpr uint64_t NullHashValue = 0x9e3779b97f4a7c15ull;
+
+namespace hash_impl {
+
+constexpr uint64_t P0 = 0xa0761d6478bd642full;
+constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+
+/*!
+ * Multiplies \p a and \p b as 128-bit integers and folds the product into
+ * 64 bits.
+ */
+inline uint64_t
+Mum(uint64_t a, uint64_t b) {
+    __uint128_t r = (__uint128_t) a * b;
+    return ((uint64_t) r) ^ ((uint64_t)(r >> 64));
+}
+
+}   // namespace hash_impl
+
+/*!
+ * Returns the hash value of the \p len bytes at \p data.
+ */
+uint64_t HashBytes(const void *data, size_t len, uint64_t seed = 0);
+
+inline uint64_t
+HashBytes(absl::string_view str, uint64_t seed = 0) {
+    return HashBytes(str.data(), str.size(), seed);
+}
+
+/*!
+ * Returns the hash value of \p str with all the ASCII upper case letters
+ * folded into lower case, so that strings that are equal under
+ * string_equal_ci() have the same hash value.
+ */
+uint64_t HashBytesCI(absl::string_view str, uint64_t seed = 0);
+
+/*!
+ * Returns the hash value of a 64-bit integer. Narrower integers should be
+ * sign- or zero-extended to 64 bits first, so that equal values of different
+ * integer types have the same hash value.
+ */
+inline uint64_t
+HashInteger(uint64_t val, uint64_t seed = 0) {
+    using namespace hash_impl;
+    return Mum(Mum(val ^ P0, seed ^ P1) ^ P2, val ^ P3);
+}
+
+/*!
+ * Returns the hash value of a floating point number. An integral value in
+ * the range of INT8 or UINT8 is hashed as the equal integer with
+ * HashInteger(), so that equal values of the integer and floating point
+ * types have the same hash value (and -0.0 has the same hash value as 0.0).
+ * All NaNs have the same hash value. A float is hashed as the equal double.
+ */
+inline uint64_t
+HashDouble(double val, uint64_t seed = 0) {
+    // 2^63 and 2^64
+    constexpr double Two63 = 9223372036854775808.0;
+    constexpr double Two64 = 18446744073709551616.0;
+    if (val >= -Two63 && val < Two63) {
+        int64_t ival = (int64_t) val;
+        if ((double) ival == val) {
+            return HashInteger((uint64_t) ival, seed);
+        }
+    } else if (val >= Two63 && val < Two64) {
+        // Any double in this range is an integer.
+        return HashInteger((uint64_t) val, seed);
+    } else if (val != val) {
+        return HashInteger(0x7ff8000000000000ull, seed);
+    }
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return HashInteger(bits, seed);
+}
+
+/*!
+ * Combines a hash value \p h computed so far with the hash value \p val of
+ * the next component of a composite key. The result depends on the order of
+ * the components.
+ */
+inline uint64_t
+HashCombine(uint64_t h, uint64_t val) {
+    using namespace hash_impl;
+    return Mum(h ^ P0, val ^ P1);
+}
+
+/*!
+ * Combines the hash values \p colhashes of the next column of a batch of \p
+ * n composite keys into their hash values computed so far in \p hashes. A row
+ * is hashed as NullHashValue if it is set in the null bitmap \p colnulls,
+ * which may be nullptr if none of them is null. If \p first is true, \p
+ * hashes is initialized as if it were all zeros.
+ *
+ * \p colhashes and \p colnulls are usually the result of the vectorized
+ * variant of a typhashfunc.
+ */
+void HashCombineBatch(uint64_t *hashes,
+                      const uint64_t *colhashes,
+                      const uint8_t *colnulls,
+                      uint32_t n,
+                      bool first);
+
+/*!
+ * Updates the CRC32C (Castagnoli) checksum \p crc with the \p len bytes at
+ * \p data. Pass 0 as \p crc for the first chunk.
+ */
+uint32_t CRC32C(uint32_t crc, const void *data, size_t len);
+
+}   // namespace taco
+
+#endif      // UTILS_HASH_H
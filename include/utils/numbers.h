@@ -3,6 +3,7 @@
 
 #include <limits>
 #include <type_traits>
+#include <cstddef>
 #include <cstdint>
 
 #include <absl/strings/numbers.h>
@@ -10,8 +11,120 @@
 
 namespace taco {
 
+/*!
+ * The minimum size of the buffer passed to FormatInteger(). The longest 64-bit
+ * integer is 20 characters long including the sign.
+ */
+constexpr size_t IntegerFormatBufLen = 20;
+
+/*!
+ * The minimum size of the buffer passed to FormatDouble() and FormatFloat().
+ */
+constexpr size_t FloatFormatBufLen = 32;
+
+/*!
+ * Parses \p n decimal digits at \p p into \p out. \p n must be at most 19
+ * so that the result never overflows. Returns false if any of the characters
+ * is not a decimal digit.
+ */
+bool ParseDecimalDigits(const char *p, size_t n, std::uint64_t *out);
+
+/*!
+ * Writes the decimal representation of \p val into \p buf, which must have
+ * at least IntegerFormatBufLen bytes. The result is not null-terminated.
+ *
+ * @returns the length of the result
+ */
+size_t FormatUInt64(char *buf, std::uint64_t val);
+
+/*!
+ * Signed version of FormatUInt64().
+ */
+size_t FormatInt64(char *buf, std::int64_t val);
+
+/*!
+ * Writes the shortest decimal representation of \p val that reads back as
+ * the same value into \p buf, which must have at least FloatFormatBufLen
+ * bytes. The digits are generated with Grisu3, which falls back to a slower
+ * search for the about 0.5% of the values where it can't prove its result
+ * to be the shortest. The result is in the form of "%.<prec>g" with prec
+ * being the number of digits but at least DBL_DIG, e.g., 0.1, 100, 1e+20 or
+ * 5e-324. It is null-terminated, but the null terminator is not counted in
+ * the returned length.
+ *
+ * @returns the length of the result
+ */
+size_t FormatDouble(char *buf, double val);
+
+/*!
+ * Single-precision version of FormatDouble(), where prec is at least
+ * FLT_DIG.
+ */
+size_t FormatFloat(char *buf, float val);
+
+/*!
+ * Writes the decimal representation of an integer \p val of any size into
+ * \p buf. See FormatUInt64() for details.
+ */
+template<class IntType>
+inline size_t
+FormatInteger(char *buf, IntType val) {
+    static_assert(std::is_integral<IntType>::value, "");
+    if (std::is_signed<IntType>::value) {
+        return FormatInt64(buf, (std::int64_t) val);
+    }
+    return FormatUInt64(buf, (std::uint64_t) val);
+}
+
 namespace utils_numbers_impl {
 
+/*!
+ * The fast path of SimpleAtoiWrapper() for the common case of an optionally
+ * signed decimal number without any white space. Returns 1 if \p str is
+ * parsed, 0 if it is out of the range of \p IntType, or -1 if \p str is
+ * not in the simple form and should be parsed by absl::SimpleAtoi().
+ */
+template<class IntType>
+inline int
+FastAtoi(absl::string_view str, IntType *out) {
+    const char *p = str.data();
+    const char *end = p + str.size();
+    bool neg = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    size_t ndigits = end - p;
+    if (ndigits == 0 || ndigits > 19) {
+        return -1;
+    }
+    if (neg && !std::is_signed<IntType>::value) {
+        return -1;
+    }
+
+    std::uint64_t val;
+    if (!ParseDecimalDigits(p, ndigits, &val)) {
+        return -1;
+    }
+
+    const std::uint64_t max_val =
+        (std::uint64_t) std::numeric_limits<IntType>::max();
+    if (neg) {
+        if (val > max_val + 1) {
+            return 0;
+        }
+        *out = (IntType)(std::int64_t)(0 - val);
+    } else {
+        if (val > max_val) {
+            return 0;
+        }
+        *out = (IntType) val;
+    }
+    return 1;
+}
+
+
 template<class IntType, class = void>
 struct SimpleAtoiWrapperImpl{
     static inline bool call(absl::string_view str, IntType *out) {
@@ -48,9 +161,15 @@ struct SimpleAtoiWrapperImpl<IntType,
 
 /*!
  * A wrapper version of absl::SimpleAtoi that supports 1/2/4/8-byte integers.
+ * Plain decimal numbers are parsed with a SWAR (SIMD within a register) fast
+ * path that converts 8 digits at a time.
  */
 template<class IntType>
 inline bool SimpleAtoiWrapper(absl::string_view str, IntType *out) {
+    int res = utils_numbers_impl::FastAtoi(str, out);
+    if (res >= 0) {
+        return res == 1;
+    }
     return utils_numbers_impl::SimpleAtoiWrapperImpl<IntType>::call(str, out);
 }
 
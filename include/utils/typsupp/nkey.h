@@ -0,0 +1,128 @@
+#ifndef UTILS_TYPSUPP_NKEY_H
+#define UTILS_TYPSUPP_NKEY_H
+
+#include "tdb.h"
+
+#include <type_traits>
+
+namespace taco {
+
+/*!
+ * A normalized key of a value is a byte string such that comparing the
+ * normalized keys of two values of the same type with memcmp(3) (and then
+ * their lengths) gives the same order as the < operator of the type. A type
+ * provides its normalized key encoder through typnkeyfunc in the Type
+ * catalog, which takes a value of the type and returns its normalized key as
+ * a __STRING. The normalized keys of a sequence of fields may be
+ * concatenated to form a normalized key of the record, see
+ * Schema::WriteNormalizedKey().
+ *
+ * The encodings are:
+ *
+ * - unsigned integers: big-endian;
+ * - signed integers: big-endian with the sign bit flipped;
+ * - floating point numbers: big-endian IEEE 754 bits with the sign bit
+ *   flipped for a non-negative number, or all the bits flipped for a
+ *   negative number. -0.0 is encoded as 0.0 and all NaNs as the same
+ *   positive quiet NaN;
+ * - strings: every byte as is except that 0x00 is escaped as 0x00 0xFF, and
+ *   terminated by 0x00 0x00. The terminator makes the string keys
+ *   self-delimiting so that they can be concatenated.
+ */
+
+/*!
+ * The byte written before the normalized key of a nullable field if the
+ * field is not null. A null field is encoded as the single byte
+ * NKeyNullByte, which sorts before all the non-null values.
+ */
+constexpr char NKeyNullByte = 0x00;
+constexpr char NKeyNotNullByte = 0x01;
+
+/*!
+ * Writes the normalized key of an integer \p val into the sizeof(IntType)
+ * bytes at \p buf.
+ */
+template<class IntType>
+inline void
+NKeyStoreInteger(char *buf, IntType val) {
+    static_assert(std::is_integral<IntType>::value, "");
+    typedef typename std::make_unsigned<IntType>::type UIntType;
+    UIntType uval = (UIntType) val;
+    if (std::is_signed<IntType>::value) {
+        uval ^= ((UIntType) 1) << (sizeof(UIntType) * 8 - 1);
+    }
+    for (size_t i = sizeof(UIntType); i > 0; --i) {
+        buf[i - 1] = (char)(uint8_t) uval;
+        uval >>= 8;
+    }
+}
+
+/*!
+ * Returns the bits of the floating point number \p val that order the same
+ * way as \p val when compared as an unsigned integer.
+ */
+inline uint64_t
+NKeyFloatingPointBits(double val) {
+    if (val == 0) {
+        val = 0.0;
+    } else if (val != val) {
+        return 0xfff8000000000000ull;
+    }
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return (bits >> 63) ? ~bits : (bits | (1ull << 63));
+}
+
+inline uint32_t
+NKeyFloatingPointBits(float val) {
+    if (val == 0) {
+        val = 0.0f;
+    } else if (val != val) {
+        return 0xffc00000u;
+    }
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return (bits >> 31) ? ~bits : (bits | (1u << 31));
+}
+
+/*!
+ * Returns the length of the normalized key of the string \p str.
+ */
+inline size_t
+NKeyStringLength(absl::string_view str) {
+    size_t n = str.size() + 2;
+    for (char c : str) {
+        n += (c == 0);
+    }
+    return n;
+}
+
+/*!
+ * Writes the normalized key of the string \p str into \p buf, which must
+ * have at least NKeyStringLength(str) bytes. If \p fold_case is true, ASCII
+ * upper case letters are written as the lower case ones, so that the key
+ * orders the same way as string_compare_ci().
+ *
+ * @returns the number of bytes written
+ */
+inline size_t
+NKeyStoreString(char *buf, absl::string_view str, bool fold_case) {
+    char *p = buf;
+    for (char c : str) {
+        if (c == 0) {
+            *p++ = 0;
+            *p++ = (char) 0xff;
+        } else if (fold_case && c >= 'A' && c <= 'Z') {
+            *p++ = c + ('a' - 'A');
+        } else {
+            *p++ = c;
+        }
+    }
+    *p++ = 0;
+    *p++ = 0;
+    return p - buf;
+}
+
+}   // namespace taco
+
+#endif      // UTILS_TYPSUPP_NKEY_H
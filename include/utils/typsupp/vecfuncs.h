@@ -0,0 +1,167 @@
+#ifndef UTILS_TYPSUPP_VECFUNCS_H
+#define UTILS_TYPSUPP_VECFUNCS_H
+
+#include "tdb.h"
+
+namespace taco {
+
+/*!
+ * Returns the number of bytes in a null bitmap of \p n rows.
+ */
+constexpr size_t
+VecNullBitmapSize(uint32_t n) {
+    return (n + 7) >> 3;
+}
+
+/*!
+ * Returns whether row \p i is null in the null bitmap \p nulls. \p nulls may
+ * be nullptr, in which case no row is null.
+ */
+inline bool
+VecNullBitmapIsNull(const uint8_t *nulls, uint32_t i) {
+    return nulls && (nulls[i >> 3] & (1 << (i & 7)));
+}
+
+/*!
+ * Computes the result null bitmap of a strict vectorized function, i.e., a
+ * row in the result is null iff any of the arguments of that row is null.
+ */
+inline void
+VecFuncSetStrictResultNulls(VecFunctionCallInfo &vfcinfo) {
+    size_t nbytes = VecNullBitmapSize(vfcinfo.n);
+    uint8_t *__restrict resnulls = vfcinfo.resultnulls;
+    memset(resnulls, 0, nbytes);
+    for (uint32_t argno = 0; argno < vfcinfo.nargs; ++argno) {
+        const uint8_t *__restrict argnulls = vfcinfo.argnulls[argno];
+        if (!argnulls) {
+            continue;
+        }
+        if (vfcinfo.argconst & (1u << argno)) {
+            if (argnulls[0] & 1) {
+                memset(resnulls, 0xff, nbytes);
+                return;
+            }
+            continue;
+        }
+        for (size_t i = 0; i < nbytes; ++i) {
+            resnulls[i] |= argnulls[i];
+        }
+    }
+}
+
+/*!
+ * Implements a strict unary vectorized function that applies \p op to each
+ * row of an argument of C++ type \p T0 and produces a result of C++ type \p
+ * R.
+ */
+template<class T0, class R, class Op>
+inline void
+VecFuncUnary(VecFunctionCallInfo &vfcinfo, Op op) {
+    VecFuncSetStrictResultNulls(vfcinfo);
+
+    const T0 *__restrict arg0 = (const T0 *) vfcinfo.args[0];
+    R *__restrict res = (R *) vfcinfo.result;
+    const uint32_t n = vfcinfo.n;
+    if (vfcinfo.argconst & 1u) {
+        R r = op(arg0[0]);
+        for (uint32_t i = 0; i < n; ++i) {
+            res[i] = r;
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        res[i] = op(arg0[i]);
+    }
+}
+
+namespace vecfuncs_impl {
+
+/*!
+ * Computes the result values of a binary vectorized function without
+ * touching the result null bitmap. Each loop here is simple enough to be
+ * auto-vectorized by the compiler for arithmetic and comparison operators.
+ */
+template<class T0, class T1, class R, class Op>
+inline void
+BinaryValues(VecFunctionCallInfo &vfcinfo, Op op) {
+    const T0 *__restrict arg0 = (const T0 *) vfcinfo.args[0];
+    const T1 *__restrict arg1 = (const T1 *) vfcinfo.args[1];
+    R *__restrict res = (R *) vfcinfo.result;
+    const uint32_t n = vfcinfo.n;
+    switch (vfcinfo.argconst & 3u) {
+    case 0:
+        for (uint32_t i = 0; i < n; ++i) {
+            res[i] = op(arg0[i], arg1[i]);
+        }
+        break;
+    case 1:
+        {
+            const T0 c0 = arg0[0];
+            for (uint32_t i = 0; i < n; ++i) {
+                res[i] = op(c0, arg1[i]);
+            }
+        }
+        break;
+    case 2:
+        {
+            const T1 c1 = arg1[0];
+            for (uint32_t i = 0; i < n; ++i) {
+                res[i] = op(arg0[i], c1);
+            }
+        }
+        break;
+    default:
+        {
+            R r = op(arg0[0], arg1[0]);
+            for (uint32_t i = 0; i < n; ++i) {
+                res[i] = r;
+            }
+        }
+    }
+}
+
+}   // namespace vecfuncs_impl
+
+/*!
+ * Implements a strict binary vectorized function that applies \p op to each
+ * row of two arguments of C++ types \p T0 and \p T1, and produces a result of
+ * C++ type \p R.
+ */
+template<class T0, class T1, class R, class Op>
+inline void
+VecFuncBinary(VecFunctionCallInfo &vfcinfo, Op op) {
+    VecFuncSetStrictResultNulls(vfcinfo);
+    vecfuncs_impl::BinaryValues<T0, T1, R>(vfcinfo, op);
+}
+
+/*!
+ * Same as VecFuncBinary(), except that it raises a division by zero error if
+ * the second argument of any non-null row is zero. \p T1 must be an integral
+ * type.
+ */
+template<class T0, class T1, class R, class Op>
+inline void
+VecFuncBinaryNonZeroDivisor(VecFunctionCallInfo &vfcinfo, Op op) {
+    VecFuncSetStrictResultNulls(vfcinfo);
+
+    const T1 *__restrict arg1 = (const T1 *) vfcinfo.args[1];
+    const uint8_t *__restrict resnulls = vfcinfo.resultnulls;
+    const bool arg1_isconst = vfcinfo.argconst & 2u;
+    for (uint32_t i = 0; i < vfcinfo.n; ++i) {
+        if (arg1[arg1_isconst ? 0 : i] == 0 &&
+                !VecNullBitmapIsNull(resnulls, i)) {
+            LOG(kError, "division by zero");
+        }
+    }
+
+    // The null rows may still have a zero divisor, which is replaced by 1
+    // here so that the loop does not trap.
+    vecfuncs_impl::BinaryValues<T0, T1, R>(vfcinfo,
+        [&op](T0 a0, T1 a1) -> R {
+            return op(a0, (T1)(a1 + (a1 == 0)));
+        });
+}
+
+}   // namespace taco
+
+#endif      // UTILS_TYPSUPP_VECFUNCS_H
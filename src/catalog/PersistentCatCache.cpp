@@ -0,0 +1,403 @@
+#include "catalog/PersistentCatCache.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dbmain/Database.h"
+#include "utils/fsutils.h"
+
+// include the private implementations of the CatCacheBase
+#include "CatCacheBase_private.inc"
+
+namespace taco {
+
+// explicit instantiation of the base class of PersistentCatCache
+template class CatCacheBase<PersistentCatCache>;
+
+constexpr int PersistentCatCache::PageNumberBits;
+constexpr FileId PersistentCatCache::MaxCatFileId;
+
+PersistentCatCache::PersistentCatCache():
+    m_defer_writes(false) {}
+
+PersistentCatCache::~PersistentCatCache() {
+    for (std::unique_ptr<CatFile> &f : m_files) {
+        if (f->m_fd >= 0) {
+            close(f->m_fd);
+        }
+    }
+}
+
+void
+PersistentCatCache::InitializeFromInitData(const std::string &init_datafile) {
+    CreateCatalogDir();
+    m_defer_writes = true;
+    CatCacheBase::InitializeFromInitData(init_datafile);
+    FlushDeferredWrites();
+}
+
+bool
+PersistentCatCache::InitializeFromInitImage(const std::string &init_imagefile,
+                                            const std::string &init_datafile) {
+    unique_malloced_ptr image = ReadInitImage(init_imagefile, init_datafile);
+    if (!image) {
+        return false;
+    }
+    CreateCatalogDir();
+    m_defer_writes = true;
+    LoadInitImage((const char*) image.get());
+    FlushDeferredWrites();
+    return true;
+}
+
+void
+PersistentCatCache::CreateCatalogDir() {
+    const std::string &db_path = g_db->GetLastDBPath();
+    if (db_path.empty()) {
+        LOG(kError, "persistent catalog requires a database directory");
+    }
+    m_catalog_dir = db_path + "/catalog";
+    if (file_exists(m_catalog_dir.c_str())) {
+        LOG(kError, "catalog directory %s already exists", m_catalog_dir);
+    }
+    std::string catalog_dir = m_catalog_dir;
+    if (pg_mkdir_p(&catalog_dir[0], 0700)) {
+        char *errstr = strerror(errno);
+        LOG(kError, "unable to create catalog directory %s: %s",
+                    m_catalog_dir, errstr);
+    }
+}
+
+void
+PersistentCatCache::InitializeFromExistingData() {
+    const std::string &db_path = g_db->GetLastDBPath();
+    if (db_path.empty()) {
+        LOG(kError, "persistent catalog requires a database directory");
+    }
+    m_catalog_dir = db_path + "/catalog";
+    if (!dir_exists(m_catalog_dir.c_str())) {
+        LOG(kError, "catalog directory %s does not exist", m_catalog_dir);
+    }
+
+    // The catalog files are numbered from 1 without any gap. Each one is read
+    // into memory with a single read.
+    for (FileId fid = 1;; ++fid) {
+        std::string path = GetCatFilePath(fid);
+        int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0) {
+            if (errno == ENOENT && fid > 1) {
+                break;
+            }
+            char *errstr = strerror(errno);
+            LOG(kFatal, "unable to open catalog file %s: %s", path, errstr);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st)) {
+            char *errstr = strerror(errno);
+            LOG(kFatal, "unable to stat catalog file %s: %s", path, errstr);
+        }
+        if (st.st_size == 0 || st.st_size % PAGE_SIZE != 0) {
+            LOG(kFatal, "catalog file %s has an invalid size %ld",
+                        path, (long) st.st_size);
+        }
+        size_t npages = st.st_size / PAGE_SIZE;
+        unique_malloced_ptr bytes = unique_aligned_alloc(512, st.st_size);
+        ssize_t nread = pread(fd, bytes.get(), st.st_size, 0);
+        if (nread != st.st_size) {
+            LOG(kFatal, "unable to read catalog file %s", path);
+        }
+
+        m_files.emplace_back(absl::make_unique<CatFile>());
+        CatFile *f = m_files.back().get();
+        f->m_fd = fd;
+        f->m_is_heapfile = (fid != DBMETA_FID);
+        f->m_pages.reserve(npages);
+        for (size_t i = 0; i < npages; ++i) {
+            f->m_pages.emplace_back(unique_aligned_alloc(512, PAGE_SIZE));
+            memcpy(f->m_pages.back().get(),
+                   ((char*) bytes.get()) + i * PAGE_SIZE, PAGE_SIZE);
+        }
+    }
+
+    CatCacheBase::InitializeFromExistingData();
+}
+
+std::string
+PersistentCatCache::GetCatFilePath(FileId fid) const {
+    return absl::StrCat(m_catalog_dir, "/", fid);
+}
+
+PersistentCatCache::CatFile*
+PersistentCatCache::GetCatFile(FileId fid) {
+    if (fid == INVALID_FID || fid > m_files.size()) {
+        LOG(kFatal, "not a valid catalog file ID " FILEID_FORMAT, fid);
+    }
+    return m_files[fid - 1].get();
+}
+
+void
+PersistentCatCache::WritePage(FileId fid, CatFile *f, PageNumber pageno) {
+    if (m_defer_writes) {
+        return ;
+    }
+    ssize_t nwritten = pwrite(f->m_fd, f->m_pages[pageno].get(), PAGE_SIZE,
+                              (off_t) pageno * PAGE_SIZE);
+    if (nwritten != (ssize_t) PAGE_SIZE) {
+        char *errstr = strerror(errno);
+        LOG(kFatal, "unable to write page " PAGENUMBER_FORMAT " of catalog "
+                    "file " FILEID_FORMAT ": %s", pageno, fid, errstr);
+    }
+#ifdef FORCE_FSYNC
+    if (fsync(f->m_fd)) {
+        char *errstr = strerror(errno);
+        LOG(kFatal, "unable to fsync catalog file " FILEID_FORMAT ": %s",
+                    fid, errstr);
+    }
+#endif
+}
+
+void
+PersistentCatCache::FlushDeferredWrites() {
+    m_defer_writes = false;
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        CatFile *f = m_files[i].get();
+        FileId fid = (FileId)(i + 1);
+        for (PageNumber pageno = 0; pageno < f->m_pages.size(); ++pageno) {
+            ssize_t nwritten = pwrite(f->m_fd, f->m_pages[pageno].get(),
+                                      PAGE_SIZE, (off_t) pageno * PAGE_SIZE);
+            if (nwritten != (ssize_t) PAGE_SIZE) {
+                char *errstr = strerror(errno);
+                LOG(kFatal, "unable to write page " PAGENUMBER_FORMAT
+                            " of catalog file " FILEID_FORMAT ": %s",
+                            pageno, fid, errstr);
+            }
+        }
+#ifdef FORCE_FSYNC
+        if (fsync(f->m_fd)) {
+            char *errstr = strerror(errno);
+            LOG(kFatal, "unable to fsync catalog file " FILEID_FORMAT ": %s",
+                        fid, errstr);
+        }
+#endif
+    }
+}
+
+void
+PersistentCatCache::AppendHeapPage(FileId fid, CatFile *f) {
+    if (f->m_pages.size() >= ((size_t) 1) << PageNumberBits) {
+        LOG(kFatal, "too many pages in catalog file " FILEID_FORMAT, fid);
+    }
+    f->m_pages.emplace_back(unique_aligned_alloc(512, PAGE_SIZE));
+    char *page = (char*) f->m_pages.back().get();
+    memset(page, 0, PAGE_SIZE);
+    CatPageHeader *hdr = (CatPageHeader*) page;
+    hdr->m_nslots = 0;
+    hdr->m_free_offset = MAXALIGN(sizeof(CatPageHeader));
+    WritePage(fid, f, f->m_pages.size() - 1);
+}
+
+FileId
+PersistentCatCache::CreateCatalogFile(bool format_heapfile,
+                                      FieldOffset /*unused*/) {
+    FileId fid = (FileId)(m_files.size() + 1);
+    if (fid > MaxCatFileId) {
+        LOG(kFatal, "too many catalog files");
+    }
+    if (!format_heapfile && fid != DBMETA_FID) {
+        LOG(kFatal, "PersistentCatCache does not support more than "
+                    "1 non-heapfile");
+    }
+
+    std::string path = GetCatFilePath(fid);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        char *errstr = strerror(errno);
+        LOG(kFatal, "unable to create catalog file %s: %s", path, errstr);
+    }
+
+    m_files.emplace_back(absl::make_unique<CatFile>());
+    CatFile *f = m_files.back().get();
+    f->m_fd = fd;
+    f->m_is_heapfile = format_heapfile;
+    if (format_heapfile) {
+        AppendHeapPage(fid, f);
+    } else {
+        f->m_pages.emplace_back(unique_aligned_alloc(512, PAGE_SIZE));
+        memset(f->m_pages.back().get(), 0, PAGE_SIZE);
+        WritePage(fid, f, 0);
+    }
+    return fid;
+}
+
+PersistentCatCache::FileHandle
+PersistentCatCache::OpenCatalogFile(FileId fid, const TableDesc*) {
+    (void) GetCatFile(fid);
+    return fid;
+}
+
+void
+PersistentCatCache::CloseCatalogFile(FileHandle &fh) {
+    fh = INVALID_FID;
+}
+
+PersistentCatCache::PageHandle
+PersistentCatCache::GetFirstPage(FileHandle &fh, char **pagebuf) {
+    if (fh != DBMETA_FID) {
+        LOG(kFatal, "can't access a heapfile catalog file as a non-heapfile in "
+                    "PersistentCatCache");
+    }
+    *pagebuf = (char*) GetCatFile(DBMETA_FID)->m_pages[0].get();
+    return 1;
+}
+
+void
+PersistentCatCache::MarkPageDirty(PageHandle &pghandle) {
+    if (pghandle != 1) {
+        LOG(kFatal, "invalid page handle in PersistentCatCache: %d",
+                    pghandle);
+    }
+    WritePage(DBMETA_FID, GetCatFile(DBMETA_FID), 0);
+}
+
+void
+PersistentCatCache::ReleasePage(PageHandle &pghandle) {
+    if (pghandle != 1) {
+        LOG(kFatal, "invalid page handle in PersistentCatCache: %d",
+                    pghandle);
+    }
+    pghandle = 0;
+}
+
+void
+PersistentCatCache::AppendRecord(FileHandle &fh, Record &rec) {
+    CatFile *f = GetCatFile(fh);
+    if (!f->m_is_heapfile) {
+        LOG(kFatal, "invalid heapfile handle in PersistentCatCache: "
+                    FILEID_FORMAT, fh);
+    }
+
+    const size_t reclen = MAXALIGN(rec.GetLength());
+    if (reclen + MAXALIGN(sizeof(CatPageHeader)) + sizeof(CatSlot) >
+            PAGE_SIZE) {
+        LOG(kError, "catalog entry of length %lu is too long",
+                    (size_t) rec.GetLength());
+    }
+
+    PageNumber pageno = f->m_pages.size() - 1;
+    CatPageHeader *hdr = (CatPageHeader*) f->m_pages[pageno].get();
+    size_t slot_begin = PAGE_SIZE - (hdr->m_nslots + 1) * sizeof(CatSlot);
+    if (hdr->m_free_offset + reclen > slot_begin ||
+        hdr->m_nslots >= MaxSlotId) {
+        AppendHeapPage(fh, f);
+        ++pageno;
+        hdr = (CatPageHeader*) f->m_pages[pageno].get();
+        slot_begin = PAGE_SIZE - sizeof(CatSlot);
+    }
+
+    char *page = (char*) hdr;
+    CatSlot *slot = (CatSlot*)(page + slot_begin);
+    slot->m_offset = hdr->m_free_offset;
+    slot->m_length = rec.GetLength();
+    memcpy(page + hdr->m_free_offset, rec.GetData(), rec.GetLength());
+    hdr->m_free_offset += reclen;
+    ++hdr->m_nslots;
+    WritePage(fh, f, pageno);
+
+    rec.GetRecordId().pid = (((PageNumber) fh) << PageNumberBits) | pageno;
+    rec.GetRecordId().sid = hdr->m_nslots;
+}
+
+PersistentCatCache::CatFileIterator
+PersistentCatCache::IterateCatEntry(FileHandle &fh) {
+    CatFile *f = GetCatFile(fh);
+    ASSERT(f->m_is_heapfile);
+    PageNumber end_pageno = f->m_pages.size() - 1;
+    SlotId end_nslots =
+        ((CatPageHeader*) f->m_pages[end_pageno].get())->m_nslots;
+    return CatFileIterator{fh, 0, INVALID_SID, end_pageno, end_nslots};
+}
+
+PersistentCatCache::CatFileIterator
+PersistentCatCache::IterateCatEntryFrom(FileHandle &fh, RecordId rid) {
+    CatFileIterator iter = IterateCatEntry(fh);
+    ASSERT((FileId)(rid.pid >> PageNumberBits) == fh);
+    iter.m_pageno = rid.pid & ((((PageNumber) 1) << PageNumberBits) - 1);
+    // NextCatEntry() starts from the slot after m_sid
+    iter.m_sid = rid.sid - 1;
+    return iter;
+}
+
+bool
+PersistentCatCache::NextCatEntry(CatFileIterator &iter) {
+    CatFile *f = GetCatFile(iter.m_fid);
+    while (iter.m_pageno <= iter.m_end_pageno) {
+        const char *page = (const char*) f->m_pages[iter.m_pageno].get();
+        SlotId nslots = (iter.m_pageno == iter.m_end_pageno) ?
+            iter.m_end_nslots : ((const CatPageHeader*) page)->m_nslots;
+        while (iter.m_sid < nslots) {
+            ++iter.m_sid;
+            const CatSlot *slot = (const CatSlot*)
+                (page + PAGE_SIZE - iter.m_sid * sizeof(CatSlot));
+            if (slot->m_offset != 0) {
+                return true;
+            }
+        }
+        ++iter.m_pageno;
+        iter.m_sid = INVALID_SID;
+    }
+    return false;
+}
+
+const char*
+PersistentCatCache::GetCurrentCatEntry(CatFileIterator &iter) {
+    CatFile *f = GetCatFile(iter.m_fid);
+    const char *page = (const char*) f->m_pages[iter.m_pageno].get();
+    const CatSlot *slot = (const CatSlot*)
+        (page + PAGE_SIZE - iter.m_sid * sizeof(CatSlot));
+    ASSERT(slot->m_offset != 0);
+    return page + slot->m_offset;
+}
+
+RecordId
+PersistentCatCache::GetCurrentCatEntryRecordId(CatFileIterator &iter) {
+    RecordId recid;
+    recid.pid = (((PageNumber) iter.m_fid) << PageNumberBits) | iter.m_pageno;
+    recid.sid = iter.m_sid;
+    return recid;
+}
+
+void
+PersistentCatCache::UpdateCurrentCatEntry(CatFileIterator &iter,
+                                          Record &rec) {
+    CatFile *f = GetCatFile(iter.m_fid);
+    char *page = (char*) f->m_pages[iter.m_pageno].get();
+    CatSlot *slot = (CatSlot*)
+        (page + PAGE_SIZE - iter.m_sid * sizeof(CatSlot));
+    ASSERT(slot->m_offset != 0);
+    if (MAXALIGN(rec.GetLength()) <= MAXALIGN(slot->m_length)) {
+        // in place update
+        memcpy(page + slot->m_offset, rec.GetData(), rec.GetLength());
+        slot->m_length = rec.GetLength();
+        WritePage(iter.m_fid, f, iter.m_pageno);
+        rec.GetRecordId() = GetCurrentCatEntryRecordId(iter);
+    } else {
+        // Append the updated record before deleting the current one, so
+        // that a failure in between leaves at least one copy on disk rather
+        // than none. AppendRecord() never moves the existing pages, so
+        // the slot is still valid afterwards.
+        FileHandle fh = iter.m_fid;
+        AppendRecord(fh, rec);
+        slot->m_offset = 0;
+        WritePage(iter.m_fid, f, iter.m_pageno);
+    }
+}
+
+void
+PersistentCatCache::EndIterateCatEntry(CatFileIterator &iter) {
+    iter.m_fid = 0;
+}
+
+}   // namespace taco
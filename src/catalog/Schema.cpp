@@ -5,6 +5,8 @@
 #include "catalog/BootstrapCatCache.h"
 #include "catalog/systables.h"
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/typsupp/nkey.h"
 
 namespace taco {
 
@@ -48,6 +50,8 @@ Schema::Schema(const std::vector<Oid> &typid,
         m_field[i].m_typparam = typparam[i];
         m_field[i].m_nullbit_id = nullable[i] ? 0 : -1;
         m_field[i].m_offset = 0;
+        m_field[i].m_nkeyfunc = nullptr;
+        m_field[i].m_hashfunc = nullptr;
     }
 }
 
@@ -99,12 +103,19 @@ Schema::ComputeLayoutImpl(CCache *catcache) {
     // here.
     for (FieldId i = 0; i < num_fields; ++i) {
         Oid typid = m_field[i].m_typid;
-        // Must use auto to declare the type here:
-        // BootstrapCatCache returns const SysTable_Type* while the regular
-        // catalog cache returns std::shared_ptr<const SysTable_Type>.
-        auto typ = catcache->FindType(typid);
+        const SysTable_Type *typ = catcache->FindType(typid);
         m_field[i].m_typlen = typ->typlen();
         m_field[i].m_typalign = typ->typalign();
+        if (typ->typnkeyfunc() != InvalidOid) {
+            m_field[i].m_nkeyfunc = FindBuiltinFunction(typ->typnkeyfunc());
+        } else {
+            m_field[i].m_nkeyfunc = nullptr;
+        }
+        if (typ->typhashfunc() != InvalidOid) {
+            m_field[i].m_hashfunc = FindBuiltinFunction(typ->typhashfunc());
+        } else {
+            m_field[i].m_hashfunc = nullptr;
+        }
         if (typ->typisvarlen()) {
 
             // Variable-length field:
@@ -515,4 +526,127 @@ Schema::GetFieldIdFromFieldName(absl::string_view field_name) const {
     return InvalidFieldId;
 }
 
+bool
+Schema::HasNormalizedKey() const {
+    EnsureLayoutComputed();
+    for (const FieldInfo &finfo : m_field) {
+        if (!finfo.m_nkeyfunc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+Schema::WriteNormalizedKey(const std::vector<Datum> &data,
+                           std::string &buf,
+                           const std::vector<FunctionPtr> *nkeyfuncs) const {
+    WriteNormalizedKeyImpl(data, buf, nkeyfuncs);
+}
+
+void
+Schema::WriteNormalizedKey(const std::vector<DatumRef> &data,
+                           std::string &buf,
+                           const std::vector<FunctionPtr> *nkeyfuncs) const {
+    WriteNormalizedKeyImpl(data, buf, nkeyfuncs);
+}
+
+void
+Schema::WriteNormalizedKey(const std::vector<NullableDatumRef> &data,
+                           std::string &buf,
+                           const std::vector<FunctionPtr> *nkeyfuncs) const {
+    WriteNormalizedKeyImpl(data, buf, nkeyfuncs);
+}
+
+template<class SomeDatum>
+void
+Schema::WriteNormalizedKeyImpl(const std::vector<SomeDatum> &data,
+                               std::string &buf,
+                               const std::vector<FunctionPtr> *nkeyfuncs)
+    const {
+    EnsureLayoutComputed();
+    ASSERT(data.size() == m_field.size());
+    ASSERT(!nkeyfuncs || nkeyfuncs->size() == m_field.size());
+
+    for (FieldId i = 0; i < GetNumFields(); ++i) {
+        if (FieldIsNullable(i)) {
+            if (data[i].isnull()) {
+                buf.push_back(NKeyNullByte);
+                continue;
+            }
+            buf.push_back(NKeyNotNullByte);
+        } else if (data[i].isnull()) {
+            LOG(kError, "non-nullable field " FIELDID_FORMAT " is null", i);
+        }
+
+        FunctionPtr nkeyfunc = (nkeyfuncs && (*nkeyfuncs)[i]) ?
+            (*nkeyfuncs)[i] : m_field[i].m_nkeyfunc;
+        if (!nkeyfunc) {
+            LOG(kError, "type " OID_FORMAT " of field " FIELDID_FORMAT
+                        " does not have a normalized key encoder",
+                        m_field[i].m_typid, i);
+        }
+        Datum key = FunctionCall(nkeyfunc, data[i]);
+        ASSERT(!key.isnull());
+        absl::string_view keybytes = key.GetVarlenAsStringView();
+        buf.append(keybytes.data(), keybytes.size());
+    }
+}
+
+bool
+Schema::HasHashFunction() const {
+    EnsureLayoutComputed();
+    for (const FieldInfo &finfo : m_field) {
+        if (!finfo.m_hashfunc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t
+Schema::ComputeHash(const std::vector<Datum> &data,
+                    const std::vector<FunctionPtr> *hashfuncs) const {
+    return ComputeHashImpl(data, hashfuncs);
+}
+
+uint64_t
+Schema::ComputeHash(const std::vector<DatumRef> &data,
+                    const std::vector<FunctionPtr> *hashfuncs) const {
+    return ComputeHashImpl(data, hashfuncs);
+}
+
+uint64_t
+Schema::ComputeHash(const std::vector<NullableDatumRef> &data,
+                    const std::vector<FunctionPtr> *hashfuncs) const {
+    return ComputeHashImpl(data, hashfuncs);
+}
+
+template<class SomeDatum>
+uint64_t
+Schema::ComputeHashImpl(const std::vector<SomeDatum> &data,
+                        const std::vector<FunctionPtr> *hashfuncs) const {
+    EnsureLayoutComputed();
+    ASSERT(data.size() == m_field.size());
+    ASSERT(!hashfuncs || hashfuncs->size() == m_field.size());
+
+    uint64_t h = 0;
+    for (FieldId i = 0; i < GetNumFields(); ++i) {
+        if (data[i].isnull()) {
+            h = HashCombine(h, NullHashValue);
+            continue;
+        }
+
+        FunctionPtr hashfunc = (hashfuncs && (*hashfuncs)[i]) ?
+            (*hashfuncs)[i] : m_field[i].m_hashfunc;
+        if (!hashfunc) {
+            LOG(kError, "type " OID_FORMAT " of field " FIELDID_FORMAT
+                        " does not have a hash function",
+                        m_field[i].m_typid, i);
+        }
+        h = HashCombine(h, FunctionCall(hashfunc, data[i]).GetUInt64());
+    }
+    return h;
+}
+
 }   // namespace taco
@@ -68,120 +68,176 @@ VolatileCatCache::ReleasePage(PageHandle &pghandle) {
     pghandle = 0;
 }
 
+constexpr size_t VolatileCatCache::ChunkSize;
+constexpr size_t VolatileCatCache::CompactionMinFreeBytes;
+constexpr int VolatileCatCache::PageNumberBits;
+
+VolatileCatCache::InmemFile*
+VolatileCatCache::GetInmemFile(FileId fid) {
+    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
+    return m_systables[fid - 2].get();
+}
+
+char*
+VolatileCatCache::AllocateSpace(InmemFile *f, uint32_t capacity) {
+    ASSERT(MAXALIGN(capacity) == capacity && capacity <= ChunkSize);
+    size_t cls = capacity / MAXALIGN_OF;
+    if (cls < f->m_free_space.size() && !f->m_free_space[cls].empty()) {
+        char *data = f->m_free_space[cls].back();
+        f->m_free_space[cls].pop_back();
+        f->m_free_bytes -= capacity;
+        return data;
+    }
+
+    if (f->m_chunks.empty() || f->m_chunk_used + capacity > ChunkSize) {
+        if (!f->m_chunks.empty()) {
+            // the rest of the last chunk is never used
+            f->m_free_bytes += ChunkSize - f->m_chunk_used;
+        }
+        f->m_chunks.emplace_back(unique_aligned_alloc(CACHELINE_SIZE,
+                                                      ChunkSize));
+        f->m_chunk_used = 0;
+    }
+    char *data = ((char*) f->m_chunks.back().get()) + f->m_chunk_used;
+    f->m_chunk_used += capacity;
+    return data;
+}
+
+void
+VolatileCatCache::FreeSpace(InmemFile *f, char *data, uint32_t capacity) {
+    size_t cls = capacity / MAXALIGN_OF;
+    if (cls >= f->m_free_space.size()) {
+        f->m_free_space.resize(cls + 1);
+    }
+    f->m_free_space[cls].push_back(data);
+    f->m_free_bytes += capacity;
+}
+
+void
+VolatileCatCache::MaybeCompact(InmemFile *f) {
+    if (f->m_free_bytes < CompactionMinFreeBytes ||
+        f->m_free_bytes * 2 < f->m_chunks.size() * ChunkSize) {
+        return ;
+    }
+
+    // Copy the records into new chunks in the slot order and release the
+    // old ones.
+    std::vector<unique_malloced_ptr> old_chunks = std::move(f->m_chunks);
+    f->m_chunks.clear();
+    f->m_chunk_used = 0;
+    f->m_free_space.clear();
+    f->m_free_bytes = 0;
+    for (InmemSlot &slot : f->m_slots) {
+        uint32_t capacity = MAXALIGN(slot.m_length);
+        char *data = AllocateSpace(f, capacity);
+        memcpy(data, slot.m_data, slot.m_length);
+        slot.m_data = data;
+        slot.m_capacity = capacity;
+    }
+}
+
 void
 VolatileCatCache::AppendRecord(FileHandle &fh, Record &rec) {
     if (fh <= 1 || fh > m_systables.size() + 1) {
         LOG(kFatal, "invalid heapfile handle in VolatileCatCache: "
                     FILEID_FORMAT, fh);
     }
+    if (fh >= ((FileId) 1) << (sizeof(PageNumber) * 8 - PageNumberBits)) {
+        LOG(kFatal, "too many catalog files in VolatileCatCache");
+    }
 
     InmemFile *f = m_systables[fh - 2].get();
-    if (f->m_offsets.size() >=
-            (size_t) std::numeric_limits<uint16_t>::max() - 1) {
+    if (f->m_slots.size() >= (size_t) std::numeric_limits<uint32_t>::max()) {
         LOG(kFatal, "no more than %u records supported in a catalog file of "
                     "VolatileCatCache",
-                    std::numeric_limits<uint16_t>::max() - 1);
+                    std::numeric_limits<uint32_t>::max());
     }
 
-    size_t offset = f->m_bytes.size();
-    ASSERT(MAXALIGN(offset) == offset);
-    size_t new_bytes_size = MAXALIGN(offset + rec.GetLength());
-    f->m_valid.push_back(true);
-    f->m_offsets.push_back(offset);
-    f->m_bytes.resize(new_bytes_size);
-    memcpy(f->m_bytes.data() + offset, rec.GetData(), rec.GetLength());
+    uint32_t capacity = MAXALIGN(rec.GetLength());
+    char *data = AllocateSpace(f, capacity);
+    memcpy(data, rec.GetData(), rec.GetLength());
+    f->m_slots.push_back(InmemSlot{data, (uint32_t) rec.GetLength(),
+                                   capacity});
 
-    rec.GetRecordId().pid = fh;
-    rec.GetRecordId().sid = f->m_offsets.size() - 1;
+    rec.GetRecordId() = MakeRecordId(fh, f->m_slots.size() - 1);
 }
 
 VolatileCatCache::CatFileIterator
 VolatileCatCache::IterateCatEntry(FileHandle &fh) {
     FileId fid = fh;
-    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
-    InmemFile *f = m_systables[fid - 2].get();
-    return CatFileIterator{fh, 0, (uint16_t) f->m_offsets.size()};
+    InmemFile *f = GetInmemFile(fid);
+    return CatFileIterator{fh, 0, (uint32_t) f->m_slots.size()};
 }
 
 VolatileCatCache::CatFileIterator
 VolatileCatCache::IterateCatEntryFrom(FileHandle &fh, RecordId rid) {
     FileId fid = fh;
-    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
-    ASSERT(fid == (FileId) rid.pid);
-    InmemFile *f = m_systables[fid - 2].get();
-    return CatFileIterator{fh, (uint16_t) rid.sid,
-                               (uint16_t) f->m_offsets.size()};
+    InmemFile *f = GetInmemFile(fid);
+    ASSERT(fid == (FileId)(rid.pid >> PageNumberBits));
+    ASSERT(rid.sid >= MinSlotId && rid.sid <= MaxSlotId);
+    uint64_t idx =
+        ((uint64_t)(rid.pid & ((((PageNumber) 1) << PageNumberBits) - 1))) *
+        MaxSlotId + (rid.sid - MinSlotId);
+    uint32_t nslots = f->m_slots.size();
+    return CatFileIterator{fh, (uint32_t) std::min(idx, (uint64_t) nslots),
+                           nslots};
 }
 
 bool
 VolatileCatCache::NextCatEntry(CatFileIterator &iter) {
-    const FileId fid = iter.m_fid;
-    uint16_t next_idx = iter.m_nextidx;
-    const uint16_t end_idx = iter.m_endidx;
-
-    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
-    InmemFile *f = m_systables[fid - 2].get();
-    ASSERT(end_idx <= f->m_offsets.size());
-    while (next_idx < end_idx) {
-        if (f->m_valid[next_idx]) {
-            iter.m_nextidx = next_idx + 1;
-            return true;
-        }
-        ++next_idx;
+    // Records are never deleted, so every slot has a record.
+    ASSERT(iter.m_endidx <= GetInmemFile(iter.m_fid)->m_slots.size());
+    if (iter.m_nextidx < iter.m_endidx) {
+        ++iter.m_nextidx;
+        return true;
     }
-    iter.m_nextidx = end_idx + 1;
     return false;
 }
 
 const char*
 VolatileCatCache::GetCurrentCatEntry(CatFileIterator &iter) {
-    const FileId fid = iter.m_fid;
-    uint16_t cur_idx = iter.m_nextidx - 1;
-
-    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
-    InmemFile *f = m_systables[fid - 2].get();
-    ASSERT(f->m_valid[cur_idx]);
-    ASSERT(cur_idx < f->m_offsets.size());
-    return f->m_bytes.data() + f->m_offsets[cur_idx];
+    InmemFile *f = GetInmemFile(iter.m_fid);
+    uint32_t cur_idx = iter.m_nextidx - 1;
+    ASSERT(cur_idx < f->m_slots.size());
+    return f->m_slots[cur_idx].m_data;
 }
 
 RecordId
 VolatileCatCache::GetCurrentCatEntryRecordId(CatFileIterator &iter) {
-    const FileId fid = iter.m_fid;
-    uint16_t cur_idx = iter.m_nextidx - 1;
-    RecordId recid;
-    recid.pid = fid;
-    recid.sid = cur_idx;
-    return recid;
+    return MakeRecordId(iter.m_fid, iter.m_nextidx - 1);
 }
 
 void
 VolatileCatCache::UpdateCurrentCatEntry(CatFileIterator &iter,
                                         Record &rec) {
     const FileId fid = iter.m_fid;
-    uint16_t cur_idx = iter.m_nextidx - 1;
-
-    ASSERT(fid > 1 && fid <= m_systables.size() + 1);
-    InmemFile *f = m_systables[fid - 2].get();
-    ASSERT(f->m_valid[cur_idx]);
-    ASSERT(cur_idx < f->m_offsets.size());
-    size_t len = (cur_idx == f->m_offsets.size() - 1) ?
-        (f->m_bytes.size() - f->m_offsets[cur_idx]) :
-        (f->m_offsets[cur_idx + 1] - f->m_offsets[cur_idx]);
-    if ((size_t) rec.GetLength() <= len) {
-        // in place update
-        memcpy(f->m_bytes.data() + f->m_offsets[cur_idx],
-               rec.GetData(), rec.GetLength());
-
-        // We reuse these two fields to save the record ID in the virtual file.
-        rec.GetRecordId().pid = fid;
-        rec.GetRecordId().sid = cur_idx;
-    } else {
-        // invalidate the current record and append the updated one
-        f->m_valid[cur_idx] = false;
-        FileHandle fh = fid;
-        AppendRecord(fh, rec);
+    uint32_t cur_idx = iter.m_nextidx - 1;
+
+    InmemFile *f = GetInmemFile(fid);
+    ASSERT(cur_idx < f->m_slots.size());
+    InmemSlot &slot = f->m_slots[cur_idx];
+    uint32_t capacity = MAXALIGN(rec.GetLength());
+    if (capacity > slot.m_capacity) {
+        char *chunk_end = ((char*) f->m_chunks.back().get()) +
+                          f->m_chunk_used;
+        if (slot.m_data + slot.m_capacity == chunk_end &&
+            f->m_chunk_used + (capacity - slot.m_capacity) <= ChunkSize) {
+            // grow in place at the end of the last chunk
+            f->m_chunk_used += capacity - slot.m_capacity;
+        } else {
+            char *data = AllocateSpace(f, capacity);
+            FreeSpace(f, slot.m_data, slot.m_capacity);
+            slot.m_data = data;
+        }
+        slot.m_capacity = capacity;
     }
+    memcpy(slot.m_data, rec.GetData(), rec.GetLength());
+    slot.m_length = rec.GetLength();
+
+    // We reuse these two fields to save the record ID in the virtual file.
+    rec.GetRecordId() = MakeRecordId(fid, cur_idx);
+
+    MaybeCompact(f);
 }
 
 void
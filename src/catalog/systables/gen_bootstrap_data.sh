@@ -70,11 +70,12 @@ with open('$OUTHDR', 'a') as f:
 
 for tname in bootstrap_typnames:
     t = typlist[typname2idx[tname]]
-    print('BEGIN_BRACKET {}, {}, {}, {}, {}, \"{}\", {}, {}, {}'.format(
+    print('BEGIN_BRACKET {}, {}, {}, {}, {}, \"{}\", {}, {}, {}, {}, {}'.format(
         t[typid], t[typlen], (t[typisvarlen] and 'true' or 'false'),
         (t[typbyref] and 'true' or 'false'),
         t[typalign], t[typname],
-        t[typinfunc], t[typoutfunc], t[typlenfunc]) + \"},\")
+        t[typinfunc], t[typoutfunc], t[typlenfunc], t[typnkeyfunc],
+        t[typhashfunc]) + \"},\")
 
 " | ${CXX} -E - | ${PYTHON3} | grep '},$'
     )"'
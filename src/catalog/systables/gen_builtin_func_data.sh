@@ -122,9 +122,13 @@ for func in func_list:
         funcargid += 1
     if 'optypes' in func:
         for optype in func['optypes']:
+            if optype in (OPTYPE(IMPLICIT_CAST), OPTYPE(CAST)):
+                oparg1typid = func[funcrettypid]
+            else:
+                oparg1typid = (len(func['funcargs']) > 1 and func['funcargs'][1] or 0)
             opout.write('\n{{\n    optype: {}, opfuncid: {}, oparg0typid: {}, oparg1typid: {}\n}},\n'.format(
                 optype, func[funcid], (len(func['funcargs']) > 0 and func['funcargs'][0] or 0),
-                (len(func['funcargs']) > 1 and func['funcargs'][1] or 0)))
+                oparg1typid))
 argsout.close()
 opout.close()
 
@@ -132,52 +136,107 @@ opout.close()
     > "${OUTDIR}/Function.dat"
 [ $? -ne 0 ] && exit $?
 
-echo "create builtin_func_table.h"
-echo \
-'
-#ifndef CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H
-#define CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H
-
-#include "tdb.h"
+echo "create builtin_func_table.h and builtin_func_table.cpp"
+echo "
+#include \"init_systable_gen.py.inc\"
 
-namespace taco {
+#define TABLEDEF \"Function.inc\"
+#define TABLEDATA \"Function.dat\"
+#include \"load_table.py.inc\"
 
-constexpr uint32_t num_builtin_funcs = '\
-$(grep '=' "${OUTDIR}/FunctionMapping.py.inc" | wc -l)';
+max_funcid = max(d[funcid] for d in datalist)
+
+hout = open('""${OUTDIR}""/builtin_func_table.h', 'w')
+hout.write('#ifndef CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H\n')
+hout.write('#define CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H\n\n')
+hout.write('#include \"tdb.h\"\n\n')
+hout.write('namespace taco {\n\n')
+hout.write('constexpr uint32_t num_builtin_funcs = {};\n\n'.format(
+    len(datalist)))
+hout.write('constexpr Oid builtin_func_dispatch_table_size = {};\n\n'.format(
+    max_funcid + 1))
+hout.write('extern const FunctionPtr\n')
+hout.write('builtin_func_dispatch_table[builtin_func_dispatch_table_size];\n\n')
+hout.write('}   // namespace taco\n\n')
+hout.write('#endif      //CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H\n')
+hout.close()
+
+funcs = [None] * (max_funcid + 1)
+for d in datalist:
+    funcs[d[funcid]] = d[funcname]
 
-extern std::pair<Oid, FunctionPtr> builtin_func_table[num_builtin_funcs];
+print('#include \"catalog/systables/builtin_func_table.h\"')
+print()
+print('namespace taco {')
+print()
+for d in datalist:
+    print('Datum {}(FMGR_FUNCTION_ARGS);'.format(d[funcname]))
+print()
+print('const FunctionPtr')
+print('builtin_func_dispatch_table[builtin_func_dispatch_table_size] = {')
+for f in funcs:
+    print('    {},'.format(f if f is not None else 'nullptr'))
+print('};')
+print()
+print('}    // namespace taco')
+" | $CXX -E ${INCLUDE} -I${OUTDIR} - | grep -v "^#" | ${PYTHON3} \
+    > "${OUTDIR}/builtin_func_table.cpp"
+[ $? -ne 0 ] && exit $?
 
-}   // namespace taco
+ALL_BUILTIN_VECFUNC_DEFFILE=`mktemp`
+cat $@ | \
+    grep "^\(BUILTIN_VECFUNC\|[#]if\|[#]endif\)" > "$ALL_BUILTIN_VECFUNC_DEFFILE"
 
-#endif      //CATALOG_SYSTABLE_BUILTIN_FUNC_TABLE_H
-' > "${OUTDIR}/builtin_func_table.h"
-[ $? -ne 0 ] && exit $?
+echo "create builtin_vecfunc_table.h and builtin_vecfunc_table.cpp"
+echo "
+#include \"config.h\"
+#define INCLUDE_MACROS_ONLY
+#include \"utils/misc.h\"
+#define BUILTIN_VECFUNC(funcname) (funcname, STRINGIFY(funcname)),
 
-echo "create builtin_func_table.cpp"
-echo \
-'
-#include "init_systable_gen.py.inc"
+#include \"FunctionMapping.py.inc\"
 
-#define TABLEDEF "Function.inc"
-#define TABLEDATA "Function.dat"
-#include "load_table.py.inc"
+vecfunc_list = [
+#include \""$ALL_BUILTIN_VECFUNC_DEFFILE"\"
+]
 
-print('"'"'#include "catalog/systables/builtin_func_table.h"'"'"')
+hout = open('""${OUTDIR}""/builtin_vecfunc_table.h', 'w')
+hout.write('#ifndef CATALOG_SYSTABLE_BUILTIN_VECFUNC_TABLE_H\n')
+hout.write('#define CATALOG_SYSTABLE_BUILTIN_VECFUNC_TABLE_H\n\n')
+hout.write('#include \"tdb.h\"\n\n')
+hout.write('namespace taco {\n\n')
+max_vecfuncid = max([f[0] for f in vecfunc_list] + [0])
+hout.write('constexpr uint32_t num_builtin_vecfuncs = {};\n\n'.format(
+    len(vecfunc_list)))
+hout.write('constexpr Oid builtin_vecfunc_dispatch_table_size = {};\n\n'.format(
+    max_vecfuncid + 1))
+hout.write('extern const VecFunctionPtr\n')
+hout.write('builtin_vecfunc_dispatch_table[builtin_vecfunc_dispatch_table_size];\n\n')
+hout.write('}   // namespace taco\n\n')
+hout.write('#endif      //CATALOG_SYSTABLE_BUILTIN_VECFUNC_TABLE_H\n')
+hout.close()
+
+vecfuncs = [None] * (max_vecfuncid + 1)
+for f in vecfunc_list:
+    vecfuncs[f[0]] = f[1]
+
+print('#include \"catalog/systables/builtin_vecfunc_table.h\"')
 print()
-print('"'"'namespace taco {'"'"')
+print('namespace taco {')
 print()
-for d in datalist:
-    print('"'"'Datum {}(FMGR_FUNCTION_ARGS);'"'"'.format(d[funcname]))
+for f in vecfunc_list:
+    print('void {}_vec(FMGR_VECFUNCTION_ARGS);'.format(f[1]))
 print()
-print('"'"'std::pair<Oid, FunctionPtr> builtin_func_table[] = {'"'"')
-for d in datalist:
-    print('"'"'    {{{}, {}}},'"'"'.format(d[funcid], d[funcname]))
-print('"'"'};'"'"')
+print('const VecFunctionPtr')
+print('builtin_vecfunc_dispatch_table[builtin_vecfunc_dispatch_table_size] = {')
+for f in vecfuncs:
+    print('    {},'.format(f + '_vec' if f is not None else 'nullptr'))
+print('};')
 print()
-print('"'"'}    // namespace taco'"'"')
-' | $CXX -E ${INCLUDE} -I${OUTDIR} - | ${PYTHON3} \
-    > "${OUTDIR}/builtin_func_table.cpp"
+print('}    // namespace taco')
+" | $CXX -E -I${OUTDIR} - | grep -v "^#" | ${PYTHON3} \
+    > "${OUTDIR}/builtin_vecfunc_table.cpp"
 [ $? -ne 0 ] && exit $?
 
-rm -f "$ALL_BUILTIN_DEFFILE"
+rm -f "$ALL_BUILTIN_DEFFILE" "$ALL_BUILTIN_VECFUNC_DEFFILE"
     
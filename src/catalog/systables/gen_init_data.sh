@@ -224,7 +224,7 @@ for idx in idx_list:
     // we set idxtyp to IDXTYP_INVALID(0) here so that the catalog cache
     // decide which type of index to build, depending on the test target
     // The idxcoleqfuncid and idxcolltfuncid are also left for the catalog cache to fill in.
-    print('\n{{\n    idxid: {}, idxtabid: {}, idxtyp: 0, idxfid: 0, idxunique: {}, idxncols: {},\n    idxname: \"{}\"\n}},'.format(
+    print('\n{{\n    idxid: {}, idxtabid: {}, idxtyp: 0, idxfid: 0, idxunique: {}, idxncols: {},\n    idxninclcols: 0, idxname: \"{}\"\n}},'.format(
         idxid, idxtabid, idxunique and 'True' or 'False', idxncols, idxname))
     for idxcolid in range(idxncols):
         idxcolinfo = tabid_colname2colinfo[(idxtabid, idxtabcolnames[idxcolid])]
@@ -0,0 +1,53 @@
+// catalog/systables/gen_init_image.cpp
+//
+// Builds the catalog image file init.img from init.dat. A new database is
+// created by copying the catalog records from the image, which avoids
+// parsing init.dat and fixing up the Table systable every time. See
+// CatCacheBase::WriteInitImage().
+//
+// usage: gen_init_image <init.dat> <init.img>
+
+#include "tdb.h"
+
+#include <absl/flags/declare.h>
+#include <absl/flags/flag.h>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "utils/fsutils.h"
+
+ABSL_DECLARE_FLAG(std::string, init_data);
+ABSL_DECLARE_FLAG(std::string, init_image);
+
+using namespace taco;
+
+int
+main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <init.dat> <init.img>\n", argv[0]);
+        return 1;
+    }
+    std::string init_datafile = argv[1];
+    std::string init_imagefile = argv[2];
+
+    // The persistent catalog cache needs a database directory, which is
+    // removed once the image is written.
+    std::string db_path = init_imagefile + ".tmpdb";
+    int ret = 0;
+    try {
+        Database::init_global();
+        absl::SetFlag(&FLAGS_init_data, init_datafile);
+        absl::SetFlag(&FLAGS_init_image, "");
+        g_db->open(db_path, 0, true, true);
+        g_db->catcache()->WriteInitImage(init_imagefile, init_datafile);
+        g_db->close();
+    } catch (const TDBError &e) {
+        fprintf(stderr, "%s\n", e.GetMessage().c_str());
+        ret = 1;
+    }
+
+    if (dir_exists(db_path.c_str())) {
+        remove_dir(db_path.c_str());
+    }
+    return ret;
+}
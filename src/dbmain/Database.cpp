@@ -6,13 +6,19 @@
 
 #include "catalog/CatCache.h"
 #include "query/expr/optypes.h"
-#include "utils/builtin_funcs.h"
 #include "utils/fsutils.h"
 
 ABSL_FLAG(std::string, init_data,
           BUILDDIR "/generated_source/catalog/systables/init.dat",
           "The path to the init data file init.dat");
 
+ABSL_FLAG(std::string, init_image,
+          BUILDDIR "/generated_source/catalog/systables/init.img",
+          "The path to the catalog image file init.img built from init.dat. "
+          "It is used in place of init.dat to create a new database if it "
+          "exists and is built from the init data file given by --init_data. "
+          "Set it to an empty string to always load init.dat.");
+
 namespace taco {
 
 static Database s_db_instance;
@@ -22,7 +28,7 @@ static bool s_init_global_called = false;
 bool g_test_no_bufman = false;
 bool g_test_no_catcache = false;
 
-bool g_test_no_index = true;
+bool g_test_no_index = false;
 
 bool g_test_catcache_use_volatiletree = false;
 
@@ -33,7 +39,6 @@ Database::init_global() {
             "taco::Database::init_global() must not be called more than once");
     }
     s_init_global_called = true;
-    InitBuiltinFunctions();
     InitOpTypes();
 }
 
@@ -53,11 +58,26 @@ Database::open(const std::string &path,
 
     m_db_path = path;
 
+    // A new database may be created in an existing empty directory. A
+    // non-empty one is refused, unless allow_overwrite is set, in which case
+    // the directory and everything in it are removed first.
+    if (create && !m_db_path.empty() && dir_exists(m_db_path.c_str()) &&
+        !dir_empty(m_db_path.c_str())) {
+        if (!allow_overwrite) {
+            LOG(kError, "database %s already exists", m_db_path);
+        }
+        remove_dir(m_db_path.c_str());
+    }
+
     if (!g_test_no_catcache) {
         m_catcache = new CatCache();
         if (create) {
             std::string init_data = absl::GetFlag(FLAGS_init_data);
-            m_catcache->InitializeFromInitData(init_data);
+            std::string init_image = absl::GetFlag(FLAGS_init_image);
+            if (init_image.empty() ||
+                !m_catcache->InitializeFromInitImage(init_image, init_data)) {
+                m_catcache->InitializeFromInitData(init_data);
+            }
         } else {
             m_catcache->InitializeFromExistingData();
         }
@@ -97,9 +117,10 @@ Database::CreateIndex(absl::string_view idxname,
                       IdxType idxtyp,
                       bool idxunique,
                       std::vector<FieldId> idxcoltabcolids,
+                      std::vector<FieldId> idxinclcolids,
                       std::vector<Oid> idxcolltfuncids,
                       std::vector<Oid> idxcoleqfuncids) {
-    LOG(kFatal, "not available until btree project");
+    LOG(kFatal, "not available until heap file is implemented");
 }
 
 }   // namespace taco
@@ -0,0 +1,244 @@
+#include "index/Index.h"
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+#include "index/btree/BTree.h"
+#include "index/hash/HashIndex.h"
+#include "index/volatiletree/VolatileTree.h"
+#include "query/expr/optypes.h"
+#include "utils/builtin_funcs.h"
+
+namespace taco {
+
+std::unique_ptr<Index>
+Index::Create(const IndexDesc *idxdesc) {
+    IdxType idxtyp = idxdesc->GetIndexEntry()->idxtyp();
+    switch (idxtyp) {
+    case IDXTYP(BTREE):
+        return BTree::Create(idxdesc);
+    case IDXTYP(VOLATILETREE):
+        return VolatileTree::Create(idxdesc);
+    case IDXTYP(HASH):
+        return HashIndex::Create(idxdesc);
+    }
+
+    LOG(kFatal, "unknown index type: %d", (int) idxtyp);
+    return nullptr;
+}
+
+Index::Index(const IndexDesc *idxdesc):
+    m_idxdesc(idxdesc),
+    m_key_schema(idxdesc->GetKeySchema()),
+    m_keycol_schema(m_key_schema),
+    m_nkeys(idxdesc->GetIndexEntry()->idxncols()),
+    m_ninclcols(idxdesc->GetIndexEntry()->idxninclcols()) {
+    // An index type that does not order the keys, e.g., a hash index, may
+    // not have the < operators.
+    const bool needs_lt =
+        IdxTypeNeedsLessOperator(idxdesc->GetIndexEntry()->idxtyp());
+    m_lt_funcs.reserve(m_nkeys);
+    m_eq_funcs.reserve(m_nkeys);
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        const SysTable_IndexColumn *idxcol =
+            idxdesc->GetIndexColumnEntry(i);
+        FunctionInfo lt_func =
+            FindBuiltinFunction(idxcol->idxcolltfuncid());
+        FunctionInfo eq_func =
+            FindBuiltinFunction(idxcol->idxcoleqfuncid());
+        if ((needs_lt && !lt_func) || !eq_func) {
+            LOG(kFatal, "missing comparison function for key column %d of "
+                        "index %s", (int) i,
+                        idxdesc->GetIndexEntry()->idxname());
+        }
+        m_lt_funcs.push_back(lt_func);
+        m_eq_funcs.push_back(eq_func);
+    }
+
+    // The normalized keys and the hash values are only computed over the key
+    // columns.
+    if (m_ninclcols > 0) {
+        std::vector<Oid> typid;
+        std::vector<uint64_t> typparam;
+        std::vector<bool> isnullable;
+        typid.reserve(m_nkeys);
+        typparam.reserve(m_nkeys);
+        isnullable.reserve(m_nkeys);
+        for (FieldId i = 0; i < m_nkeys; ++i) {
+            typid.push_back(m_key_schema->GetFieldTypeId(i));
+            typparam.push_back(m_key_schema->GetFieldTypeParam(i));
+            isnullable.push_back(m_key_schema->FieldIsNullable(i));
+        }
+        m_keycol_schema_owned.reset(
+            Schema::Create(typid, typparam, isnullable));
+        m_keycol_schema_owned->ComputeLayout();
+        m_keycol_schema = m_keycol_schema_owned.get();
+    }
+
+    // The normalized keys of a column are only useful if they order the
+    // same way as the < operator of the column, which is either the default
+    // one of its type, or a case-insensitive string comparison that has its
+    // own encoder.
+    m_use_nkey = needs_lt && m_keycol_schema->HasNormalizedKey();
+    m_nkey_funcs.resize(m_nkeys, nullptr);
+    for (FieldId i = 0; m_use_nkey && i < m_nkeys; ++i) {
+        const SysTable_IndexColumn *idxcol =
+            idxdesc->GetIndexColumnEntry(i);
+        Oid typid = idxcol->idxcoltypid();
+        Oid ltfuncid = idxcol->idxcolltfuncid();
+        if (ltfuncid == initoids::FUNC_VARCHAR_lt_ci) {
+            m_nkey_funcs[i] =
+                FindBuiltinFunction(initoids::FUNC_VARCHAR_nkey_ci);
+        } else if (ltfuncid == initoids::FUNC_CHAR_lt_ci) {
+            m_nkey_funcs[i] = FindBuiltinFunction(initoids::FUNC_CHAR_nkey_ci);
+        } else if (ltfuncid !=
+                   g_catcache->FindOperator(OPTYPE(LT), typid, typid)) {
+            m_use_nkey = false;
+        }
+    }
+}
+
+Index::~Index() {}
+
+FieldId
+Index::GetKeySchemaFieldOfColumn(FieldId tabcolid) const {
+    for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+        if (m_idxdesc->GetIndexColumnEntry(i)->idxcoltabcolid() == tabcolid) {
+            return i;
+        }
+    }
+    return InvalidFieldId;
+}
+
+bool
+Index::CoversColumns(const std::vector<FieldId> &tabcolids) const {
+    for (FieldId tabcolid : tabcolids) {
+        if (GetKeySchemaFieldOfColumn(tabcolid) == InvalidFieldId) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<Index::IndexOnlyIterator>
+Index::StartIndexOnlyScan(const IndexKey *lower,
+                          bool lower_isstrict,
+                          const IndexKey *upper,
+                          bool upper_isstrict,
+                          const std::vector<FieldId> &tabcolids) {
+    std::vector<FieldId> fields;
+    fields.reserve(tabcolids.size());
+    for (FieldId tabcolid : tabcolids) {
+        FieldId field = GetKeySchemaFieldOfColumn(tabcolid);
+        if (field == InvalidFieldId) {
+            LOG(kError, "column " FIELDID_FORMAT " is not covered by index %s",
+                        tabcolid, m_idxdesc->GetIndexEntry()->idxname());
+        }
+        fields.push_back(field);
+    }
+
+    std::unique_ptr<Iterator> iter =
+        StartScan(lower, lower_isstrict, upper, upper_isstrict);
+    return absl::make_unique<IndexOnlyIterator>(this, std::move(iter),
+                                                std::move(fields));
+}
+
+void
+Index::BulkLoad(BulkLoadSource *src) {
+    while (src->Next()) {
+        if (!InsertKey(src->GetCurrentKey(), src->GetCurrentRecordId())) {
+            LOG(kError, "duplicate key in index %s",
+                        m_idxdesc->GetIndexEntry()->idxname());
+        }
+    }
+}
+
+void
+Index::WriteNormalizedKey(const std::vector<NullableDatumRef> &data,
+                          std::string &buf) const {
+    ASSERT(m_use_nkey);
+    buf.clear();
+    if (data.size() == (size_t) m_nkeys) {
+        m_keycol_schema->WriteNormalizedKey(data, buf, &m_nkey_funcs);
+        return;
+    }
+    ASSERT(data.size() == (size_t)(m_nkeys + m_ninclcols));
+    std::vector<NullableDatumRef> keydata(data.begin(),
+                                          data.begin() + m_nkeys);
+    m_keycol_schema->WriteNormalizedKey(keydata, buf, &m_nkey_funcs);
+}
+
+bool
+Index::GetSearchNormalizedKey(const IndexKey *key, std::string &buf) const {
+    if (!m_use_nkey || key->GetNumKeys() < m_nkeys) {
+        return false;
+    }
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys);
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        if (key->IsNull(i) && !m_key_schema->FieldIsNullable(i)) {
+            // can't be encoded, but no entry can match it anyway
+            return false;
+        }
+        data.push_back(key->GetKey(i));
+    }
+    WriteNormalizedKey(data, buf);
+    return true;
+}
+
+void
+Index::GetPayloadNormalizedKey(const char *payload, std::string &buf) const {
+    ASSERT(m_use_nkey);
+    std::vector<Datum> data = m_key_schema->DissemblePayload(payload);
+    data.erase(data.begin() + m_nkeys, data.end());
+    buf.clear();
+    m_keycol_schema->WriteNormalizedKey(data, buf, &m_nkey_funcs);
+}
+
+int
+Index::CompareKeyWithPayload(const IndexKey *key,
+                             const char *payload,
+                             FieldId nkeys) const {
+    ASSERT(nkeys <= key->GetNumKeys() && nkeys <= m_nkeys);
+    for (FieldId i = 0; i < nkeys; ++i) {
+        bool isnull = m_key_schema->FieldIsNull(i, payload);
+        if (key->IsNull(i)) {
+            if (!isnull) {
+                return -1;
+            }
+            continue;
+        }
+        if (isnull) {
+            return 1;
+        }
+        Datum d = m_key_schema->GetField(i, payload);
+        int res = CompareDatums(i, key->GetKey(i), d);
+        if (res != 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+int
+Index::ComparePayloads(const char *payload1, const char *payload2) const {
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        bool isnull1 = m_key_schema->FieldIsNull(i, payload1);
+        bool isnull2 = m_key_schema->FieldIsNull(i, payload2);
+        if (isnull1 || isnull2) {
+            if (isnull1 != isnull2) {
+                return isnull1 ? -1 : 1;
+            }
+            continue;
+        }
+        Datum d1 = m_key_schema->GetField(i, payload1);
+        Datum d2 = m_key_schema->GetField(i, payload2);
+        int res = CompareDatums(i, d1, d2);
+        if (res != 0) {
+            return res;
+        }
+    }
+    return 0;
+}
+
+}   // namespace taco
@@ -0,0 +1,1327 @@
+#include "index/btree/BTree.h"
+
+#include <absl/flags/flag.h>
+
+#include <thread>
+
+#include "utils/ExternalSort.h"
+
+ABSL_FLAG(int32_t, btree_fillfactor, 90,
+          "The percentage of the space filled on each page when a B+-tree "
+          "is bulk loaded, between 10 and 100");
+
+namespace taco {
+
+constexpr uint16_t BTree::MaxPrefixLength;
+constexpr size_t BTree::MaxEntryLength;
+constexpr uint32_t BTree::PageDirChunkBits;
+constexpr uint32_t BTree::PageDirChunkSize;
+constexpr uint32_t BTree::MaxNumPageDirChunks;
+
+class BTree::Iterator: public Index::Iterator {
+public:
+    Iterator(BTree *btree,
+             const IndexKey *lower,
+             bool lower_isstrict,
+             const IndexKey *upper,
+             bool upper_isstrict):
+        m_btree(btree),
+        m_pid(INVALID_PID),
+        m_next_sid(0),
+        m_version(0),
+        m_positioned(false),
+        m_lower(lower ? *lower : IndexKey(nullptr, 0)),
+        m_lower_isstrict(lower && lower_isstrict),
+        m_has_upper(upper != nullptr),
+        m_upper(upper ? *upper : IndexKey(nullptr, 0)),
+        m_upper_isstrict(upper_isstrict),
+        m_cur_buf(0),
+        m_valid(false) {}
+
+    bool Next() override;
+
+    bool
+    IsAtValidItem() override {
+        return m_valid;
+    }
+
+    const Record&
+    GetCurrentItem() override {
+        ASSERT(m_valid);
+        return m_item;
+    }
+
+    RecordId
+    GetCurrentRecordId() override {
+        ASSERT(m_valid);
+        return m_item.GetRecordId();
+    }
+
+    void
+    EndScan() override {
+        m_positioned = true;
+        m_pid = INVALID_PID;
+        m_valid = false;
+    }
+
+private:
+    /*!
+     * Finds the position right after the current item, or the first
+     * position in the range if there's no current item yet.
+     */
+    void Reposition();
+
+    BTree           *m_btree;
+
+    //! The leaf page of the next item.
+    PageNumber      m_pid;
+
+    //! The slot of the next item on m_pid.
+    uint16_t        m_next_sid;
+
+    //! The version of m_pid at which m_next_sid is the next item.
+    uint64_t        m_version;
+
+    bool            m_positioned;
+
+    IndexKey        m_lower;
+    bool            m_lower_isstrict;
+    bool            m_has_upper;
+    IndexKey        m_upper;
+    bool            m_upper_isstrict;
+
+    //! The items are copied out of the pages. The current item is in
+    //! m_buf[m_cur_buf] and the next item is copied into the other one, so
+    //! that a failed copy never overwrites the current item.
+    alignas(MAXALIGN_OF) char m_buf[2][MaxEntryLength];
+    int             m_cur_buf;
+
+    bool            m_valid;
+    Record          m_item;
+};
+
+void
+BTree::Iterator::Reposition() {
+    BTreeSearchKey skey;
+    std::vector<Datum> data;
+    std::vector<NullableDatumRef> data_ref;
+    IndexKey last_key(nullptr, 0);
+    std::string nkey;
+    if (m_valid) {
+        data = m_btree->m_key_schema->DissemblePayload(m_item.GetData());
+        data_ref.reserve(data.size());
+        for (const Datum &d : data) {
+            data_ref.emplace_back(d);
+        }
+        last_key = IndexKey(data_ref);
+        skey = BTreeSearchKey{&last_key, m_btree->m_nkeys,
+                              m_item.GetRecordId(), 1, nullptr, 0};
+    } else {
+        RecordId recid;
+        recid.SetInvalid();
+        skey = BTreeSearchKey{&m_lower, m_lower.GetNumKeys(), recid,
+                              m_lower_isstrict ? 1 : -1, nullptr, 0};
+    }
+    if (m_btree->GetSearchNormalizedKey(skey.m_key, nkey)) {
+        skey.m_nkey = nkey.data();
+        skey.m_nkey_len = nkey.size();
+    }
+
+    while (!m_btree->FindFirstEntry(skey, m_pid, m_next_sid, m_version));
+    m_positioned = true;
+}
+
+bool
+BTree::Iterator::Next() {
+    if (!m_positioned) {
+        Reposition();
+    }
+
+    for (;;) {
+        if (m_pid == INVALID_PID) {
+            m_valid = false;
+            return false;
+        }
+
+        char *page = m_btree->GetPage(m_pid);
+        uint16_t nslots = GetPageHeader(page)->m_nslots;
+        PageNumber next_pid = GetPageHeader(page)->m_next_pid;
+        size_t hdr_size = GetEntryHeaderSize(page);
+        if (!ValidatePage(page, m_version)) {
+            Reposition();
+            continue;
+        }
+
+        if (m_next_sid >= nslots) {
+            m_pid = next_pid;
+            m_next_sid = 0;
+            if (m_pid != INVALID_PID) {
+                m_version = ReadLockPage(m_btree->GetPage(m_pid));
+            }
+            continue;
+        }
+
+        char *buf = m_buf[m_cur_buf ^ 1];
+        uint16_t len;
+        if (!m_btree->CopyEntry(page, m_version, m_next_sid, buf,
+                                MaxEntryLength, &len)) {
+            Reposition();
+            continue;
+        }
+
+        const char *payload = buf + hdr_size;
+        if (m_has_upper) {
+            int res = m_btree->CompareKeyWithPayload(&m_upper, payload,
+                                                     m_upper.GetNumKeys());
+            if (res < 0 || (res == 0 && m_upper_isstrict)) {
+                m_pid = INVALID_PID;
+                m_valid = false;
+                return false;
+            }
+        }
+
+        m_cur_buf ^= 1;
+        m_item = Record(payload, (FieldOffset)(len - hdr_size));
+        m_item.GetRecordId() = GetEntryRecordId(buf);
+        ++m_next_sid;
+        m_valid = true;
+        return true;
+    }
+}
+
+std::unique_ptr<BTree>
+BTree::Create(const IndexDesc *idxdesc) {
+    return std::unique_ptr<BTree>(new BTree(idxdesc));
+}
+
+BTree::BTree(const IndexDesc *idxdesc):
+    Index(idxdesc),
+    m_npages(0),
+    m_slots_offset(MAXALIGN(sizeof(BTreePageHeader)) +
+                   (m_use_nkey ? MAXALIGN(sizeof(BTreePagePrefix)) : 0)),
+    m_slot_size(sizeof(BTreeSlot) + (m_use_nkey ? sizeof(uint32_t) : 0)) {
+    static_assert(MAXALIGN(sizeof(BTreeInternalEntryHeader)) +
+                  GetMaxKeyLength() <= MaxEntryLength,
+                  "MaxEntryLength is too small");
+    m_root_pid.store(AllocatePage(0), memory_order_release);
+}
+
+BTree::~BTree() {}
+
+uint32_t
+BTree::GetTreeHeight() const {
+    for (;;) {
+        char *page = GetPage(m_root_pid.load(memory_order_acquire));
+        uint64_t version = ReadLockPage(page);
+        uint32_t level = GetPageHeader(page)->m_level;
+        if (ValidatePage(page, version)) {
+            return level + 1;
+        }
+    }
+}
+
+PageNumber
+BTree::AllocatePage(uint16_t level) {
+    std::lock_guard<std::mutex> guard(m_alloc_latch);
+    PageNumber pid = m_npages.load(memory_order_relaxed) + 1;
+    if (pid > (PageNumber) PageDirChunkSize * MaxNumPageDirChunks) {
+        LOG(kError, "too many pages in the btree");
+    }
+
+    uint32_t chunk = (pid - 1) >> PageDirChunkBits;
+    if (!m_page_dir[chunk]) {
+        m_page_dir[chunk].reset(new unique_malloced_ptr[PageDirChunkSize]);
+    }
+    unique_malloced_ptr &page_ptr =
+        m_page_dir[chunk][(pid - 1) & (PageDirChunkSize - 1)];
+    page_ptr = unique_aligned_alloc(512, PAGE_SIZE);
+    char *page = (char*) page_ptr.get();
+    memset(page, 0, PAGE_SIZE);
+    BTreePageHeader *hdr = GetPageHeader(page);
+    hdr->m_version.store(0, memory_order_relaxed);
+    hdr->m_level = level;
+    hdr->m_nslots = 0;
+    hdr->m_free_end = PAGE_SIZE;
+    hdr->m_nholes = 0;
+    hdr->m_prev_pid = INVALID_PID;
+    hdr->m_next_pid = INVALID_PID;
+    m_npages.store(pid, memory_order_release);
+    return pid;
+}
+
+uint64_t
+BTree::ReadLockPage(char *page) {
+    uint64_t version =
+        GetPageHeader(page)->m_version.load(memory_order_acquire);
+    while (version & 1) {
+        std::this_thread::yield();
+        version = GetPageHeader(page)->m_version.load(memory_order_acquire);
+    }
+    return version;
+}
+
+bool
+BTree::ValidatePage(char *page, uint64_t version) {
+    // Orders the reads from the page before the reread of the version.
+    std::atomic_thread_fence(memory_order_acquire);
+    return GetPageHeader(page)->m_version.load(memory_order_relaxed) ==
+        version;
+}
+
+bool
+BTree::UpgradePageLock(char *page, uint64_t version) {
+    ASSERT(!(version & 1));
+    return GetPageHeader(page)->m_version.compare_exchange_strong(
+        version, version + 1, memory_order_acq_rel);
+}
+
+bool
+BTree::TryWriteLockPage(char *page) {
+    uint64_t version =
+        GetPageHeader(page)->m_version.load(memory_order_acquire);
+    return !(version & 1) && UpgradePageLock(page, version);
+}
+
+void
+BTree::WriteUnlockPage(char *page) {
+    ASSERT(GetPageHeader(page)->m_version.load(memory_order_relaxed) & 1);
+    GetPageHeader(page)->m_version.fetch_add(1, memory_order_release);
+}
+
+size_t
+BTree::GetFreeSpace(char *page) const {
+    BTreePageHeader *hdr = GetPageHeader(page);
+    size_t free_start = GetSlotArrayEnd(hdr->m_nslots);
+    if (hdr->m_free_end < free_start) {
+        // only possible in an inconsistent read
+        return 0;
+    }
+    return hdr->m_free_end - free_start + hdr->m_nholes;
+}
+
+bool
+BTree::CopyEntry(char *page,
+                 uint64_t version,
+                 uint16_t sid,
+                 char *buf,
+                 size_t buflen,
+                 uint16_t *len) const {
+    // The slot may be garbage if the page is being modified, so we must not
+    // read outside the page before validating the version.
+    if (sid >= GetMaxNumSlots()) {
+        return false;
+    }
+    BTreeSlot slot = *GetSlot(page, sid);
+    if (slot.m_length > MaxEntryLength ||
+        (size_t) slot.m_offset + slot.m_length > PAGE_SIZE) {
+        return false;
+    }
+    memcpy(buf, page + slot.m_offset, std::min((size_t) slot.m_length,
+                                               buflen));
+    if (!ValidatePage(page, version)) {
+        return false;
+    }
+    if (len) {
+        *len = slot.m_length;
+    }
+    return true;
+}
+
+uint32_t
+BTree::ComputeHead(const char *nkey, size_t nkey_len, size_t prefix_len) {
+    uint32_t head = 0;
+    for (size_t i = prefix_len; i < prefix_len + 4; ++i) {
+        head = (head << 8) | (i < nkey_len ? (uint8_t) nkey[i] : 0);
+    }
+    return head;
+}
+
+void
+BTree::NarrowByHeads(const BTreeSearchKey &skey,
+                     char *page,
+                     uint16_t &lo,
+                     uint16_t &hi) const {
+    if (!skey.m_nkey || lo >= hi) {
+        return;
+    }
+
+    // The prefix may be garbage in an inconsistent read.
+    const BTreePagePrefix *prefix = GetPagePrefix(page);
+    size_t prefix_len = prefix->m_len;
+    if (prefix_len > MaxPrefixLength) {
+        return;
+    }
+    size_t len = std::min(prefix_len, skey.m_nkey_len);
+    int res = memcmp(skey.m_nkey, prefix->m_bytes, len);
+    if (res != 0) {
+        if (res < 0) {
+            hi = lo;
+        } else {
+            lo = hi;
+        }
+        return;
+    }
+    if (len < prefix_len) {
+        // A full normalized key is never a proper prefix of another one.
+        return;
+    }
+
+    // Branchless lower bound and upper bound of the search key's head. A
+    // full normalized key is never a proper prefix of another one either, so
+    // the entries with a smaller head are smaller than the search key, and
+    // the ones with a larger head are larger than it.
+    const uint32_t head = ComputeHead(skey.m_nkey, skey.m_nkey_len,
+                                      prefix_len);
+    uint16_t base = lo;
+    uint16_t n = hi - lo;
+    while (n > 1) {
+        uint16_t half = n >> 1;
+        base = (GetSlotHead(page, base + half - 1) < head) ? base + half : base;
+        n -= half;
+    }
+    uint16_t new_lo = base + (GetSlotHead(page, base) < head);
+
+    base = new_lo;
+    n = hi - new_lo;
+    if (n > 0) {
+        while (n > 1) {
+            uint16_t half = n >> 1;
+            base = (GetSlotHead(page, base + half - 1) <= head) ?
+                base + half : base;
+            n -= half;
+        }
+        hi = base + (GetSlotHead(page, base) <= head);
+    }
+    lo = new_lo;
+}
+
+void
+BTree::RecomputePagePrefix(char *page) const {
+    if (!m_use_nkey) {
+        return;
+    }
+    BTreePageHeader *phdr = GetPageHeader(page);
+    uint16_t first_sid = GetFirstKeyedSlot(page);
+    if (phdr->m_nslots <= first_sid) {
+        return;
+    }
+
+    size_t hdr_size = GetEntryHeaderSize(page);
+    std::string first_nkey;
+    std::string last_nkey;
+    GetPayloadNormalizedKey(GetEntry(page, first_sid) + hdr_size, first_nkey);
+    GetPayloadNormalizedKey(GetEntry(page, phdr->m_nslots - 1) + hdr_size,
+                            last_nkey);
+    size_t max_len = std::min(std::min(first_nkey.size(), last_nkey.size()),
+                              (size_t) MaxPrefixLength);
+    size_t prefix_len = 0;
+    while (prefix_len < max_len &&
+           first_nkey[prefix_len] == last_nkey[prefix_len]) {
+        ++prefix_len;
+    }
+    BTreePagePrefix *prefix = GetPagePrefix(page);
+    if (prefix_len <= prefix->m_len) {
+        // All the entries are between the first and the last ones, so the
+        // current prefix can't be any longer.
+        return;
+    }
+
+    memcpy(prefix->m_bytes, first_nkey.data(), prefix_len);
+    prefix->m_len = (uint16_t) prefix_len;
+    std::string nkey;
+    for (uint16_t sid = first_sid; sid < phdr->m_nslots; ++sid) {
+        GetPayloadNormalizedKey(GetEntry(page, sid) + hdr_size, nkey);
+        GetSlotHead(page, sid) =
+            ComputeHead(nkey.data(), nkey.size(), prefix_len);
+    }
+}
+
+int
+BTree::CompareWithEntry(const BTreeSearchKey &skey,
+                        const char *entry,
+                        size_t hdr_size) const {
+    int res = CompareKeyWithPayload(skey.m_key, entry + hdr_size,
+                                    skey.m_nkeys);
+    if (res != 0) {
+        return res;
+    }
+    if (skey.m_recid.IsValid()) {
+        RecordId recid = GetEntryRecordId(entry);
+        if (skey.m_recid < recid) {
+            return -1;
+        }
+        if (skey.m_recid != recid) {
+            return 1;
+        }
+    }
+    return skey.m_tie;
+}
+
+bool
+BTree::CompareWithEntry(const BTreeSearchKey &skey,
+                        char *page,
+                        uint64_t version,
+                        uint16_t sid,
+                        int &res) const {
+    alignas(MAXALIGN_OF) char buf[MaxEntryLength];
+    size_t hdr_size = GetEntryHeaderSize(page);
+    if (!CopyEntry(page, version, sid, buf, MaxEntryLength, nullptr)) {
+        return false;
+    }
+    res = CompareWithEntry(skey, buf, hdr_size);
+    return true;
+}
+
+bool
+BTree::LeafLowerBound(const BTreeSearchKey &skey,
+                      char *page,
+                      uint64_t version,
+                      uint16_t &sid) const {
+    uint16_t lo = 0;
+    uint16_t hi = GetPageHeader(page)->m_nslots;
+    if (hi > GetMaxNumSlots()) {
+        return false;
+    }
+    NarrowByHeads(skey, page, lo, hi);
+    while (lo < hi) {
+        uint16_t mid = lo + ((hi - lo) >> 1);
+        int res;
+        if (!CompareWithEntry(skey, page, version, mid, res)) {
+            return false;
+        }
+        if (res > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    sid = lo;
+    return ValidatePage(page, version);
+}
+
+bool
+BTree::FindChild(const BTreeSearchKey &skey,
+                 char *page,
+                 uint64_t version,
+                 PageNumber &child) const {
+    // The first separator is negative infinity, so we find the last one not
+    // larger than skey among the rest.
+    uint16_t lo = 1;
+    uint16_t hi = GetPageHeader(page)->m_nslots;
+    if (hi > GetMaxNumSlots()) {
+        return false;
+    }
+    NarrowByHeads(skey, page, lo, hi);
+    while (lo < hi) {
+        uint16_t mid = lo + ((hi - lo) >> 1);
+        int res;
+        if (!CompareWithEntry(skey, page, version, mid, res)) {
+            return false;
+        }
+        if (res >= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    alignas(MAXALIGN_OF) char buf[sizeof(BTreeInternalEntryHeader)];
+    if (!CopyEntry(page, version, lo - 1, buf, sizeof(buf), nullptr)) {
+        return false;
+    }
+    child = GetEntryChild(buf);
+    return true;
+}
+
+bool
+BTree::FindLeafPage(const BTreeSearchKey &skey,
+                    PageNumber &pid,
+                    uint64_t &version) const {
+    pid = m_root_pid.load(memory_order_acquire);
+    char *page = GetPage(pid);
+    version = ReadLockPage(page);
+    if (pid != m_root_pid.load(memory_order_acquire)) {
+        // the root has been split
+        return false;
+    }
+
+    while (GetPageHeader(page)->m_level > 0) {
+        PageNumber child;
+        if (!FindChild(skey, page, version, child)) {
+            return false;
+        }
+        char *parent = page;
+        uint64_t parent_version = version;
+        pid = child;
+        page = GetPage(pid);
+        version = ReadLockPage(page);
+
+        // The child may have been split after we read its page number but
+        // before we read its version.
+        if (!ValidatePage(parent, parent_version)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+BTree::FindFirstEntry(const BTreeSearchKey &skey,
+                      PageNumber &pid,
+                      uint16_t &sid,
+                      uint64_t &version) const {
+    if (!FindLeafPage(skey, pid, version)) {
+        return false;
+    }
+    char *page = GetPage(pid);
+    if (!LeafLowerBound(skey, page, version, sid)) {
+        return false;
+    }
+
+    // All the entries on the right siblings are larger than skey.
+    for (;;) {
+        uint16_t nslots = GetPageHeader(page)->m_nslots;
+        PageNumber next_pid = GetPageHeader(page)->m_next_pid;
+        if (!ValidatePage(page, version)) {
+            return false;
+        }
+        if (sid < nslots) {
+            return true;
+        }
+        pid = next_pid;
+        if (pid == INVALID_PID) {
+            return true;
+        }
+        page = GetPage(pid);
+        version = ReadLockPage(page);
+        sid = 0;
+    }
+}
+
+bool
+BTree::InsertEntryToPage(char *page,
+                         uint16_t sid,
+                         const char *hdr,
+                         const char *payload,
+                         FieldOffset payload_len,
+                         const char *nkey,
+                         size_t nkey_len) {
+    BTreePageHeader *phdr = GetPageHeader(page);
+    ASSERT(sid <= phdr->m_nslots);
+    size_t hdr_size = GetEntryHeaderSize(page);
+    size_t len = hdr_size + payload_len;
+    size_t space_needed = MAXALIGN(len) + m_slot_size;
+    if (GetFreeSpace(page) < space_needed) {
+        return false;
+    }
+
+    uint32_t head = 0;
+    uint16_t first_sid = GetFirstKeyedSlot(page);
+    if (nkey && sid >= first_sid) {
+        BTreePagePrefix *prefix = GetPagePrefix(page);
+        if (phdr->m_nslots <= first_sid) {
+            // the first entry with a key on the page
+            prefix->m_len =
+                (uint16_t) std::min(nkey_len, (size_t) MaxPrefixLength);
+            memcpy(prefix->m_bytes, nkey, prefix->m_len);
+        } else {
+            size_t prefix_len = 0;
+            size_t max_len = std::min(nkey_len, (size_t) prefix->m_len);
+            while (prefix_len < max_len &&
+                   nkey[prefix_len] == prefix->m_bytes[prefix_len]) {
+                ++prefix_len;
+            }
+            if (prefix_len < prefix->m_len) {
+                // Shortens the prefix. The new head of an entry is the
+                // removed part of the prefix followed by its old head.
+                for (uint16_t i = first_sid; i < phdr->m_nslots; ++i) {
+                    uint32_t old_head = GetSlotHead(page, i);
+                    uint32_t new_head = 0;
+                    for (size_t j = prefix_len; j < prefix_len + 4; ++j) {
+                        uint8_t byte;
+                        if (j < prefix->m_len) {
+                            byte = (uint8_t) prefix->m_bytes[j];
+                        } else {
+                            byte = (uint8_t)(old_head >>
+                                (8 * (3 - (j - prefix->m_len))));
+                        }
+                        new_head = (new_head << 8) | byte;
+                    }
+                    GetSlotHead(page, i) = new_head;
+                }
+                prefix->m_len = (uint16_t) prefix_len;
+            }
+        }
+        head = ComputeHead(nkey, nkey_len, prefix->m_len);
+    }
+
+    size_t free_start = GetSlotArrayEnd(phdr->m_nslots);
+    if (phdr->m_free_end - free_start < space_needed) {
+        CompactPage(page);
+    }
+
+    phdr->m_free_end -= MAXALIGN(len);
+    memcpy(page + phdr->m_free_end, hdr, hdr_size);
+    memcpy(page + phdr->m_free_end + hdr_size, payload, payload_len);
+
+    BTreeSlot *slot = GetSlot(page, sid);
+    memmove(GetSlot(page, sid + 1), slot,
+            (phdr->m_nslots - sid) * m_slot_size);
+    slot->m_offset = phdr->m_free_end;
+    slot->m_length = (uint16_t) len;
+    if (m_use_nkey) {
+        GetSlotHead(page, sid) = head;
+    }
+    ++phdr->m_nslots;
+    return true;
+}
+
+void
+BTree::RemoveEntryFromPage(char *page, uint16_t sid) {
+    BTreePageHeader *phdr = GetPageHeader(page);
+    ASSERT(sid < phdr->m_nslots);
+    BTreeSlot *slot = GetSlot(page, sid);
+    if (slot->m_offset == phdr->m_free_end) {
+        phdr->m_free_end += MAXALIGN(slot->m_length);
+    } else {
+        phdr->m_nholes += MAXALIGN(slot->m_length);
+    }
+    memmove(slot, GetSlot(page, sid + 1),
+            (phdr->m_nslots - sid - 1) * m_slot_size);
+    --phdr->m_nslots;
+}
+
+void
+BTree::CompactPage(char *page) const {
+    alignas(MAXALIGN_OF) char buf[PAGE_SIZE];
+    memcpy(buf, page, PAGE_SIZE);
+
+    BTreePageHeader *phdr = GetPageHeader(page);
+    uint16_t offset = PAGE_SIZE;
+    for (uint16_t i = 0; i < phdr->m_nslots; ++i) {
+        BTreeSlot *slot = GetSlot(page, i);
+        offset -= MAXALIGN(slot->m_length);
+        memcpy(page + offset, buf + slot->m_offset, slot->m_length);
+        slot->m_offset = offset;
+    }
+    phdr->m_free_end = offset;
+    phdr->m_nholes = 0;
+}
+
+bool
+BTree::SplitPage(PageNumber pid, char *page, char *parent) {
+    BTreePageHeader *phdr = GetPageHeader(page);
+    char *next_page = nullptr;
+    if (phdr->m_next_pid != INVALID_PID) {
+        // needed for updating its m_prev_pid
+        next_page = GetPage(phdr->m_next_pid);
+        if (!TryWriteLockPage(next_page)) {
+            return false;
+        }
+    }
+
+    // The entries are divided by their total length, and the ones in the
+    // upper half are moved to a new right sibling.
+    const size_t hdr_size = GetEntryHeaderSize(page);
+    const uint16_t level = phdr->m_level;
+    const uint16_t nslots = phdr->m_nslots;
+    ASSERT(nslots >= 2);
+    alignas(MAXALIGN_OF) char old_page[PAGE_SIZE];
+    memcpy(old_page, page, PAGE_SIZE);
+
+    size_t total_len = 0;
+    for (uint16_t i = 0; i < nslots; ++i) {
+        total_len += MAXALIGN(GetSlot(old_page, i)->m_length) + m_slot_size;
+    }
+    size_t left_len = 0;
+    uint16_t nleft = 0;
+    while (nleft < nslots - 1 && left_len < total_len / 2) {
+        left_len += MAXALIGN(GetSlot(old_page, nleft)->m_length) +
+                    m_slot_size;
+        ++nleft;
+    }
+    if (nleft == 0) {
+        nleft = 1;
+    }
+
+    PageNumber right_pid = AllocatePage(level);
+    char *right_page = GetPage(right_pid);
+    BTreePageHeader *right_phdr = GetPageHeader(right_page);
+
+    // Both halves start with the prefix of the old page, which is then
+    // extended to the common prefix of their own entries.
+    phdr->m_nslots = 0;
+    phdr->m_free_end = PAGE_SIZE;
+    phdr->m_nholes = 0;
+    if (m_use_nkey) {
+        memcpy(GetPagePrefix(right_page), GetPagePrefix(page),
+               sizeof(BTreePagePrefix));
+    }
+    for (uint16_t i = 0; i < nslots; ++i) {
+        char *target = (i < nleft) ? page : right_page;
+        uint16_t target_sid = GetPageHeader(target)->m_nslots;
+        const BTreeSlot *old_slot = GetSlot(old_page, i);
+        const char *entry = old_page + old_slot->m_offset;
+        bool ok = InsertEntryToPage(target, target_sid,
+                                    entry, entry + hdr_size,
+                                    (FieldOffset)(old_slot->m_length -
+                                                  hdr_size),
+                                    nullptr, 0);
+        ASSERT(ok);
+        (void) ok;
+        if (m_use_nkey) {
+            GetSlotHead(target, target_sid) = GetSlotHead(old_page, i);
+        }
+    }
+    RecomputePagePrefix(page);
+    RecomputePagePrefix(right_page);
+
+    right_phdr->m_next_pid = phdr->m_next_pid;
+    right_phdr->m_prev_pid = pid;
+    if (next_page) {
+        GetPageHeader(next_page)->m_prev_pid = right_pid;
+    }
+    phdr->m_next_pid = right_pid;
+
+    // The first entry on the right page is the separator in the parent.
+    // Its key is no longer used on an internal right page.
+    const BTreeSlot *sep_slot = GetSlot(old_page, nleft);
+    const char *sep_entry = old_page + sep_slot->m_offset;
+    BTreeInternalEntryHeader sep_hdr;
+    memset(&sep_hdr, 0, sizeof(sep_hdr));
+    sep_hdr.m_recid = GetEntryRecordId(sep_entry);
+    sep_hdr.m_child_pid = right_pid;
+    const char *sep_payload = sep_entry + hdr_size;
+    FieldOffset sep_payload_len =
+        (FieldOffset)(sep_slot->m_length - hdr_size);
+    std::string sep_nkey;
+    if (m_use_nkey) {
+        GetPayloadNormalizedKey(sep_payload, sep_nkey);
+    }
+    const char *sep_nkey_ptr = m_use_nkey ? sep_nkey.data() : nullptr;
+
+    if (parent) {
+        uint16_t parent_nslots = GetPageHeader(parent)->m_nslots;
+        uint16_t sid = 0;
+        while (sid < parent_nslots &&
+               GetEntryChild(GetEntry(parent, sid)) != pid) {
+            ++sid;
+        }
+        ASSERT(sid < parent_nslots);
+        bool ok = InsertEntryToPage(parent, sid + 1, (const char*) &sep_hdr,
+                                    sep_payload, sep_payload_len,
+                                    sep_nkey_ptr, sep_nkey.size());
+        ASSERT(ok);
+        (void) ok;
+    } else {
+        // Splitting the root. The new root has the old root and the new
+        // right page as its children, and is published before the old root
+        // is unlocked.
+        PageNumber new_root_pid = AllocatePage(level + 1);
+        char *new_root = GetPage(new_root_pid);
+        BTreeInternalEntryHeader first_hdr;
+        memset(&first_hdr, 0, sizeof(first_hdr));
+        first_hdr.m_recid.SetInvalid();
+        first_hdr.m_child_pid = pid;
+        bool ok = InsertEntryToPage(new_root, 0, (const char*) &first_hdr,
+                                    nullptr, 0, nullptr, 0) &&
+            InsertEntryToPage(new_root, 1, (const char*) &sep_hdr,
+                              sep_payload, sep_payload_len,
+                              sep_nkey_ptr, sep_nkey.size());
+        ASSERT(ok);
+        (void) ok;
+        m_root_pid.store(new_root_pid, memory_order_release);
+    }
+
+    if (next_page) {
+        WriteUnlockPage(next_page);
+    }
+    return true;
+}
+
+bool
+BTree::FindEqualKeyNeighbor(const BTreeSearchKey &skey,
+                            char *page,
+                            uint16_t sid,
+                            bool &found) {
+    RecordId invalid_recid;
+    invalid_recid.SetInvalid();
+    const BTreeSearchKey key_only{skey.m_key, m_nkeys, invalid_recid, 0,
+                                  nullptr, 0};
+    const size_t hdr_size = GetEntryHeaderSize(page);
+    const BTreePageHeader *phdr = GetPageHeader(page);
+    found = false;
+
+    // The successor. The right siblings are write-locked one at a time
+    // until a non-empty one, so that an insertion into them that has
+    // already checked its predecessor can't finish in the meantime.
+    if (sid < phdr->m_nslots) {
+        found =
+            (CompareWithEntry(key_only, GetEntry(page, sid), hdr_size) == 0);
+    } else {
+        char *locked_page = nullptr;
+        PageNumber next_pid = phdr->m_next_pid;
+        while (next_pid != INVALID_PID) {
+            char *next_page = GetPage(next_pid);
+            if (!TryWriteLockPage(next_page)) {
+                if (locked_page) {
+                    WriteUnlockPage(locked_page);
+                }
+                return false;
+            }
+            if (locked_page) {
+                WriteUnlockPage(locked_page);
+            }
+            locked_page = next_page;
+            if (GetPageHeader(next_page)->m_nslots > 0) {
+                found = (CompareWithEntry(key_only, GetEntry(next_page, 0),
+                                          hdr_size) == 0);
+                break;
+            }
+            next_pid = GetPageHeader(next_page)->m_next_pid;
+        }
+        if (locked_page) {
+            WriteUnlockPage(locked_page);
+        }
+    }
+    if (found) {
+        return true;
+    }
+
+    // The predecessor. The left siblings are only read, since an insertion
+    // into them has to write-lock this page to check its successor.
+    if (sid > 0) {
+        found = (CompareWithEntry(key_only, GetEntry(page, sid - 1),
+                                  hdr_size) == 0);
+        return true;
+    }
+    PageNumber prev_pid = phdr->m_prev_pid;
+    while (prev_pid != INVALID_PID) {
+        char *prev_page = GetPage(prev_pid);
+        uint64_t prev_version = ReadLockPage(prev_page);
+        uint16_t prev_nslots = GetPageHeader(prev_page)->m_nslots;
+        PageNumber prev_prev_pid = GetPageHeader(prev_page)->m_prev_pid;
+        if (!ValidatePage(prev_page, prev_version)) {
+            return false;
+        }
+        if (prev_nslots > 0) {
+            int res;
+            if (!CompareWithEntry(key_only, prev_page, prev_version,
+                                  prev_nslots - 1, res)) {
+                return false;
+            }
+            found = (res == 0);
+            return true;
+        }
+        prev_pid = prev_prev_pid;
+    }
+    return true;
+}
+
+bool
+BTree::TryInsertEntry(const BTreeSearchKey &skey,
+                      const char *payload,
+                      FieldOffset payload_len,
+                      bool check_unique,
+                      bool &inserted) {
+    const size_t leaf_space_needed =
+        MAXALIGN(sizeof(BTreeLeafEntryHeader) + payload_len) + m_slot_size;
+
+    char *parent = nullptr;
+    uint64_t parent_version = 0;
+    PageNumber pid = m_root_pid.load(memory_order_acquire);
+    char *page = GetPage(pid);
+    uint64_t version = ReadLockPage(page);
+    if (pid != m_root_pid.load(memory_order_acquire)) {
+        return false;
+    }
+
+    for (;;) {
+        bool is_leaf = GetPageHeader(page)->m_level == 0;
+        size_t space_needed = is_leaf ? leaf_space_needed :
+                                        GetMaxEntrySpace();
+        if (GetFreeSpace(page) < space_needed) {
+            // Split the page eagerly, so that its parent never needs to be
+            // split at the same time.
+            if (parent && !UpgradePageLock(parent, parent_version)) {
+                return false;
+            }
+            if (!UpgradePageLock(page, version)) {
+                if (parent) {
+                    WriteUnlockPage(parent);
+                }
+                return false;
+            }
+            SplitPage(pid, page, parent);
+            WriteUnlockPage(page);
+            if (parent) {
+                WriteUnlockPage(parent);
+            }
+            return false;
+        }
+
+        if (is_leaf) {
+            break;
+        }
+
+        PageNumber child;
+        if (!FindChild(skey, page, version, child)) {
+            return false;
+        }
+        parent = page;
+        parent_version = version;
+        pid = child;
+        page = GetPage(pid);
+        version = ReadLockPage(page);
+        if (!ValidatePage(parent, parent_version)) {
+            return false;
+        }
+    }
+
+    if (!UpgradePageLock(page, version)) {
+        return false;
+    }
+    ++version;
+
+    uint16_t sid;
+    bool ok = LeafLowerBound(skey, page, version, sid);
+    ASSERT(ok);
+    int res = 1;
+    if (sid < GetPageHeader(page)->m_nslots) {
+        ok = CompareWithEntry(skey, page, version, sid, res);
+        ASSERT(ok);
+    }
+    if (res == 0) {
+        inserted = false;
+    } else if (check_unique) {
+        bool found;
+        if (!FindEqualKeyNeighbor(skey, page, sid, found)) {
+            WriteUnlockPage(page);
+            return false;
+        }
+        inserted = !found;
+    } else {
+        inserted = true;
+    }
+    if (inserted) {
+        BTreeLeafEntryHeader hdr;
+        hdr.m_recid = skey.m_recid;
+        ok = InsertEntryToPage(page, sid, (const char*) &hdr, payload,
+                               payload_len, skey.m_nkey, skey.m_nkey_len);
+        ASSERT(ok);
+    }
+    (void) ok;
+    WriteUnlockPage(page);
+    return true;
+}
+
+bool
+BTree::InsertKey(const IndexKey *key, RecordId recid) {
+    if (key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key and INCLUDE columns but got %d",
+                    (int)(m_nkeys + m_ninclcols), (int) key->GetNumKeys());
+    }
+    if (!recid.IsValid()) {
+        LOG(kError, "cannot insert an invalid record ID into an index");
+    }
+
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys + m_ninclcols);
+    for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+        data.push_back(key->GetKey(i));
+    }
+    maxaligned_char_buf buf;
+    FieldOffset len = m_key_schema->WritePayloadToBuffer(data, buf);
+    if (len == -1) {
+        LOG(kError, "unable to serialize the index key");
+    }
+    if (len > GetMaxKeyLength()) {
+        LOG(kError, "index key is too long: %d > %d", (int) len,
+                    (int) GetMaxKeyLength());
+    }
+
+    const bool check_unique =
+        m_idxdesc->GetIndexEntry()->idxunique() && !KeyHasAnyNull(key);
+
+    // Unlike a search key, the key to insert must be encoded if the BTree
+    // uses normalized keys.
+    std::string nkey;
+    if (m_use_nkey) {
+        WriteNormalizedKey(data, nkey);
+    }
+    BTreeSearchKey skey{key, m_nkeys, recid, 0,
+                        m_use_nkey ? nkey.data() : nullptr, nkey.size()};
+    bool inserted;
+    while (!TryInsertEntry(skey, buf.data(), len, check_unique, inserted));
+    return inserted;
+}
+
+bool
+BTree::TryDeleteEntry(const IndexKey *key,
+                      const std::string *nkey,
+                      RecordId &recid,
+                      bool &deleted) {
+    RecordId invalid_recid;
+    invalid_recid.SetInvalid();
+    const char *nkey_data = nkey ? nkey->data() : nullptr;
+    size_t nkey_len = nkey ? nkey->size() : 0;
+    BTreeSearchKey skey = recid.IsValid() ?
+        BTreeSearchKey{key, m_nkeys, recid, 0, nkey_data, nkey_len} :
+        BTreeSearchKey{key, m_nkeys, invalid_recid, -1, nkey_data, nkey_len};
+    PageNumber pid;
+    uint64_t version;
+    if (!FindLeafPage(skey, pid, version)) {
+        return false;
+    }
+    char *page = GetPage(pid);
+    if (!UpgradePageLock(page, version)) {
+        return false;
+    }
+    ++version;
+
+    for (;;) {
+        uint16_t sid;
+        bool ok = LeafLowerBound(skey, page, version, sid);
+        ASSERT(ok);
+        if (sid < GetPageHeader(page)->m_nslots) {
+            int res;
+            ok = CompareWithEntry(
+                BTreeSearchKey{key, m_nkeys, skey.m_recid, 0, nullptr, 0},
+                page, version, sid, res);
+            ASSERT(ok);
+            deleted = (res == 0);
+            if (deleted) {
+                recid = GetEntryRecordId(GetEntry(page, sid));
+                RemoveEntryFromPage(page, sid);
+            }
+            WriteUnlockPage(page);
+            return true;
+        }
+        (void) ok;
+
+        // An exact match must be on this page, but the first entry with the
+        // key may be on one of its right siblings.
+        PageNumber next_pid = GetPageHeader(page)->m_next_pid;
+        if (recid.IsValid() || next_pid == INVALID_PID) {
+            deleted = false;
+            WriteUnlockPage(page);
+            return true;
+        }
+        char *next_page = GetPage(next_pid);
+        if (!TryWriteLockPage(next_page)) {
+            WriteUnlockPage(page);
+            return false;
+        }
+        WriteUnlockPage(page);
+        page = next_page;
+        version = GetPageHeader(page)->m_version.load(memory_order_relaxed);
+    }
+}
+
+bool
+BTree::DeleteKey(const IndexKey *key, RecordId &recid) {
+    if (key->GetNumKeys() != m_nkeys &&
+        key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key columns but got %d", (int) m_nkeys,
+                    (int) key->GetNumKeys());
+    }
+
+    std::string nkey;
+    bool has_nkey = GetSearchNormalizedKey(key, nkey);
+    bool deleted;
+    while (!TryDeleteEntry(key, has_nkey ? &nkey : nullptr, recid, deleted));
+    return deleted;
+}
+
+int
+BTree::CompareLeafEntries(const char *entry1, const char *entry2) const {
+    const size_t hdr_size = MAXALIGN(sizeof(BTreeLeafEntryHeader));
+    int res = ComparePayloads(entry1 + hdr_size, entry2 + hdr_size);
+    if (res != 0) {
+        return res;
+    }
+    RecordId recid1 = GetEntryRecordId(entry1);
+    RecordId recid2 = GetEntryRecordId(entry2);
+    if (recid1 < recid2) {
+        return -1;
+    }
+    return (recid1 == recid2) ? 0 : 1;
+}
+
+bool
+BTree::PayloadHasAnyNull(const char *payload) const {
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        if (m_key_schema->FieldIsNull(i, payload)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+BTree::BulkLoadAppendEntry(std::vector<PageNumber> &rightmost_pids,
+                           uint16_t level,
+                           const char *hdr,
+                           const char *payload,
+                           FieldOffset payload_len,
+                           const char *nkey,
+                           size_t nkey_len,
+                           size_t fill_limit) {
+    const size_t usable_space = PAGE_SIZE - m_slots_offset;
+    char *page = GetPage(rightmost_pids[level]);
+    size_t space_needed = MAXALIGN(GetEntryHeaderSize(page) + payload_len) +
+                          m_slot_size;
+    size_t free_space = GetFreeSpace(page);
+    if (GetPageHeader(page)->m_nslots > 0 &&
+        (usable_space - free_space + space_needed > fill_limit ||
+         free_space < space_needed)) {
+        PageNumber new_pid = AllocatePage(level);
+        char *new_page = GetPage(new_pid);
+        GetPageHeader(page)->m_next_pid = new_pid;
+        GetPageHeader(new_page)->m_prev_pid = rightmost_pids[level];
+
+        if (level + 1u == rightmost_pids.size()) {
+            // The page was the root so far. The new root starts with the
+            // negative infinity pointing to it.
+            PageNumber parent_pid = AllocatePage(level + 1);
+            BTreeInternalEntryHeader first_hdr;
+            memset(&first_hdr, 0, sizeof(first_hdr));
+            first_hdr.m_recid.SetInvalid();
+            first_hdr.m_child_pid = rightmost_pids[level];
+            bool ok = InsertEntryToPage(GetPage(parent_pid), 0,
+                                        (const char*) &first_hdr, nullptr, 0,
+                                        nullptr, 0);
+            ASSERT(ok);
+            (void) ok;
+            rightmost_pids.push_back(parent_pid);
+        }
+
+        BTreeInternalEntryHeader sep_hdr;
+        memset(&sep_hdr, 0, sizeof(sep_hdr));
+        sep_hdr.m_recid = GetEntryRecordId(hdr);
+        sep_hdr.m_child_pid = new_pid;
+        BulkLoadAppendEntry(rightmost_pids, level + 1,
+                            (const char*) &sep_hdr, payload, payload_len,
+                            nkey, nkey_len, fill_limit);
+
+        rightmost_pids[level] = new_pid;
+        page = new_page;
+    }
+
+    bool ok = InsertEntryToPage(page, GetPageHeader(page)->m_nslots, hdr,
+                                payload, payload_len, nkey, nkey_len);
+    ASSERT(ok);
+    (void) ok;
+}
+
+void
+BTree::BulkLoad(BulkLoadSource *src) {
+    int32_t fillfactor = absl::GetFlag(FLAGS_btree_fillfactor);
+    if (fillfactor < 10 || fillfactor > 100) {
+        LOG(kError, "invalid btree fill factor %d", fillfactor);
+    }
+
+    PageNumber root_pid = m_root_pid.load(memory_order_relaxed);
+    char *root = GetPage(root_pid);
+    if (GetPageHeader(root)->m_level != 0 ||
+        GetPageHeader(root)->m_nslots != 0) {
+        LOG(kError, "cannot bulk load into a non-empty btree");
+    }
+
+    // The sorted items are the leaf entries.
+    const size_t hdr_size = MAXALIGN(sizeof(BTreeLeafEntryHeader));
+    ExternalSort sorter(
+        [this](const char *entry1, const char *entry2) -> int {
+            return CompareLeafEntries(entry1, entry2);
+        }, ExternalSort::GetDefaultMemLimit());
+    maxaligned_char_buf buf;
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys + m_ninclcols);
+    while (src->Next()) {
+        const IndexKey *key = src->GetCurrentKey();
+        RecordId recid = src->GetCurrentRecordId();
+        if (key->GetNumKeys() != m_nkeys + m_ninclcols) {
+            LOG(kError, "expecting %d key and INCLUDE columns but got %d",
+                        (int)(m_nkeys + m_ninclcols), (int) key->GetNumKeys());
+        }
+        if (!recid.IsValid()) {
+            LOG(kError, "cannot insert an invalid record ID into an index");
+        }
+
+        buf.clear();
+        buf.resize(hdr_size);
+        ((BTreeLeafEntryHeader*) buf.data())->m_recid = recid;
+        data.clear();
+        for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+            data.push_back(key->GetKey(i));
+        }
+        FieldOffset len = m_key_schema->WritePayloadToBuffer(data, buf);
+        if (len == -1) {
+            LOG(kError, "unable to serialize the index key");
+        }
+        if (len > GetMaxKeyLength()) {
+            LOG(kError, "index key is too long: %d > %d", (int) len,
+                        (int) GetMaxKeyLength());
+        }
+        sorter.AddItem(buf.data(), (uint32_t)(hdr_size + len));
+    }
+    sorter.Sort();
+
+    const size_t fill_limit =
+        (PAGE_SIZE - m_slots_offset) * fillfactor / 100;
+    const bool unique = m_idxdesc->GetIndexEntry()->idxunique();
+    std::vector<PageNumber> rightmost_pids;
+    rightmost_pids.push_back(AllocatePage(0));
+    std::string nkey;
+    while (sorter.Next()) {
+        const char *entry = sorter.GetCurrentItem();
+        FieldOffset payload_len =
+            (FieldOffset)(sorter.GetCurrentItemLength() - hdr_size);
+
+        // The previous entry is always the last one on the rightmost leaf.
+        char *leaf = GetPage(rightmost_pids[0]);
+        uint16_t nslots = GetPageHeader(leaf)->m_nslots;
+        if (nslots > 0) {
+            const char *last_entry = GetEntry(leaf, nslots - 1);
+            int res = ComparePayloads(last_entry + hdr_size,
+                                      entry + hdr_size);
+            if (res == 0) {
+                if (GetEntryRecordId(last_entry) == GetEntryRecordId(entry)) {
+                    LOG(kError, "duplicate (key, record ID) pair in index %s",
+                                m_idxdesc->GetIndexEntry()->idxname());
+                }
+                if (unique && !PayloadHasAnyNull(entry + hdr_size)) {
+                    LOG(kError, "duplicate key in unique index %s",
+                                m_idxdesc->GetIndexEntry()->idxname());
+                }
+            }
+        }
+
+        if (m_use_nkey) {
+            GetPayloadNormalizedKey(entry + hdr_size, nkey);
+        }
+        BulkLoadAppendEntry(rightmost_pids, 0, entry, entry + hdr_size,
+                            payload_len, m_use_nkey ? nkey.data() : nullptr,
+                            nkey.size(), fill_limit);
+    }
+
+    // Only a fully built tree is published. The old root is an empty leaf
+    // page and is simply left unused.
+    m_root_pid.store(rightmost_pids.back(), memory_order_release);
+}
+
+std::unique_ptr<Index::Iterator>
+BTree::StartScan(const IndexKey *lower,
+                 bool lower_isstrict,
+                 const IndexKey *upper,
+                 bool upper_isstrict) {
+    if ((lower && lower->GetNumKeys() > m_nkeys) ||
+        (upper && upper->GetNumKeys() > m_nkeys)) {
+        LOG(kError, "too many key columns in the scan bounds");
+    }
+
+    return std::unique_ptr<Index::Iterator>(
+        new Iterator(this, lower, lower_isstrict, upper, upper_isstrict));
+}
+
+}   // namespace taco
@@ -0,0 +1,684 @@
+#include "index/hash/HashIndex.h"
+
+#include <thread>
+
+#include "catalog/CatCache.h"
+#include "query/expr/optypes.h"
+#include "utils/builtin_funcs.h"
+
+namespace taco {
+
+constexpr size_t HashIndex::MaxEntryLength;
+constexpr uint32_t HashIndex::PageDirChunkBits;
+constexpr uint32_t HashIndex::PageDirChunkSize;
+constexpr uint32_t HashIndex::MaxNumPageDirChunks;
+constexpr uint32_t HashIndex::BucketDirChunkBits;
+constexpr uint32_t HashIndex::BucketDirChunkSize;
+constexpr uint32_t HashIndex::MaxNumBucketDirChunks;
+constexpr uint32_t HashIndex::MaxOptimisticSplitAttempts;
+
+class HashIndex::Iterator: public Index::Iterator {
+public:
+    Iterator(HashIndex *index, const IndexKey *key):
+        m_index(index),
+        m_key(key),
+        m_positioned(false),
+        m_next(0),
+        m_valid(false) {}
+
+    bool Next() override;
+
+    bool
+    IsAtValidItem() override {
+        return m_valid;
+    }
+
+    const Record&
+    GetCurrentItem() override {
+        ASSERT(m_valid);
+        return m_item;
+    }
+
+    RecordId
+    GetCurrentRecordId() override {
+        ASSERT(m_valid);
+        return m_item.GetRecordId();
+    }
+
+    void
+    EndScan() override {
+        m_positioned = true;
+        m_entries.clear();
+        m_valid = false;
+    }
+
+private:
+    /*!
+     * Copies all the matching entries out of the index.
+     */
+    void FetchEntries();
+
+    HashIndex       *m_index;
+
+    const IndexKey  *m_key;
+
+    bool            m_positioned;
+
+    //! The matching entries copied into m_buf.
+    maxaligned_char_buf m_buf;
+    EntryList       m_entries;
+
+    //! The index of the next item in m_entries.
+    size_t          m_next;
+
+    bool            m_valid;
+    Record          m_item;
+};
+
+void
+HashIndex::Iterator::FetchEntries() {
+    const uint64_t hash = m_index->ComputeKeyHash(m_key);
+    EntryList candidates;
+    for (;;) {
+        m_buf.clear();
+        candidates.clear();
+        if (m_index->TryCopyBucketEntries(hash, m_buf, candidates)) {
+            break;
+        }
+    }
+
+    // Only the entries with the same tag are copied, so most of them match.
+    for (const auto &e : candidates) {
+        const char *entry = m_buf.data() + e.first;
+        if (GetEntryHeader(entry)->m_hash == hash &&
+            m_index->KeyEqualsPayload(m_key, GetEntryPayload(entry))) {
+            m_entries.push_back(e);
+        }
+    }
+    m_positioned = true;
+}
+
+bool
+HashIndex::Iterator::Next() {
+    if (!m_positioned) {
+        FetchEntries();
+    }
+
+    if (m_next >= m_entries.size()) {
+        m_valid = false;
+        return false;
+    }
+
+    const char *entry = m_buf.data() + m_entries[m_next].first;
+    const size_t hdr_size = MAXALIGN(sizeof(HashEntryHeader));
+    m_item = Record(GetEntryPayload(entry),
+                    (FieldOffset)(m_entries[m_next].second - hdr_size));
+    m_item.GetRecordId() = GetEntryHeader(entry)->m_recid;
+    ++m_next;
+    m_valid = true;
+    return true;
+}
+
+std::unique_ptr<HashIndex>
+HashIndex::Create(const IndexDesc *idxdesc) {
+    return std::unique_ptr<HashIndex>(new HashIndex(idxdesc));
+}
+
+HashIndex::HashIndex(const IndexDesc *idxdesc):
+    Index(idxdesc),
+    m_npages(0),
+    m_state(0) {
+    static_assert(MAXALIGN(sizeof(HashEntryHeader)) + GetMaxKeyLength() <=
+                  MaxEntryLength, "MaxEntryLength is too small");
+
+    // The hash functions must agree with the = operators, which are either
+    // the default ones of the types, or the case-insensitive string
+    // comparisons with their own hash functions.
+    m_hash_funcs.resize(m_nkeys, nullptr);
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        const SysTable_IndexColumn *idxcol =
+            idxdesc->GetIndexColumnEntry(i);
+        Oid typid = idxcol->idxcoltypid();
+        Oid eqfuncid = idxcol->idxcoleqfuncid();
+        if (eqfuncid == initoids::FUNC_VARCHAR_eq_ci) {
+            m_hash_funcs[i] =
+                FindBuiltinFunction(initoids::FUNC_VARCHAR_hash_ci);
+        } else if (eqfuncid == initoids::FUNC_CHAR_eq_ci) {
+            m_hash_funcs[i] = FindBuiltinFunction(initoids::FUNC_CHAR_hash_ci);
+        } else if (eqfuncid !=
+                   g_catcache->FindOperator(OPTYPE(EQ), typid, typid)) {
+            LOG(kError, "no hash function is known to agree with the = "
+                        "operator of key column %d of index %s", (int) i,
+                        idxdesc->GetIndexEntry()->idxname());
+        }
+    }
+    if (!m_keycol_schema->HasHashFunction()) {
+        LOG(kError, "some key column of index %s does not have a hash "
+                    "function", idxdesc->GetIndexEntry()->idxname());
+    }
+
+    PageNumber pid = AllocatePage();
+    WriteUnlockPage(GetPage(pid));
+    SetBucketPageNumber(0, pid);
+}
+
+HashIndex::~HashIndex() {}
+
+uint64_t
+HashIndex::GetNumBuckets() const {
+    uint64_t state = m_state.load(memory_order_acquire);
+    return (((uint64_t) 1) << GetLevel(state)) + GetSplitPointer(state);
+}
+
+uint64_t
+HashIndex::ComputeKeyHash(const IndexKey *key) const {
+    ASSERT(key->GetNumKeys() >= m_nkeys);
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys);
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        data.push_back(key->GetKey(i));
+    }
+    return m_keycol_schema->ComputeHash(data, &m_hash_funcs);
+}
+
+bool
+HashIndex::KeyEqualsPayload(const IndexKey *key, const char *payload) const {
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        bool isnull = m_key_schema->FieldIsNull(i, payload);
+        if (key->IsNull(i) || isnull) {
+            if (key->IsNull(i) != isnull) {
+                return false;
+            }
+            continue;
+        }
+        Datum d = m_key_schema->GetField(i, payload);
+        if (!FunctionCall(m_eq_funcs[i], key->GetKey(i), d).GetBool()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PageNumber
+HashIndex::AllocatePage() {
+    std::unique_lock<std::mutex> guard(m_alloc_latch);
+    if (!m_free_pids.empty()) {
+        PageNumber pid = m_free_pids.back();
+        m_free_pids.pop_back();
+        guard.unlock();
+
+        // A stale reader or writer of the old chain may still be on the
+        // page, so it is reset and filled under the lock, which keeps its
+        // version increasing.
+        char *page = GetPage(pid);
+        WriteLockPage(page);
+        HashPageHeader *hdr = GetPageHeader(page);
+        hdr->m_next_pid = INVALID_PID;
+        hdr->m_nslots = 0;
+        hdr->m_free_end = PAGE_SIZE;
+        hdr->m_nholes = 0;
+        return pid;
+    }
+
+    PageNumber pid = m_npages.load(memory_order_relaxed) + 1;
+    if (pid > (PageNumber) PageDirChunkSize * MaxNumPageDirChunks) {
+        LOG(kError, "too many pages in the hash index");
+    }
+
+    uint32_t chunk = (pid - 1) >> PageDirChunkBits;
+    if (!m_page_dir[chunk]) {
+        m_page_dir[chunk].reset(new unique_malloced_ptr[PageDirChunkSize]);
+    }
+    unique_malloced_ptr &page_ptr =
+        m_page_dir[chunk][(pid - 1) & (PageDirChunkSize - 1)];
+    page_ptr = unique_aligned_alloc(512, PAGE_SIZE);
+    char *page = (char*) page_ptr.get();
+    memset(page, 0, PAGE_SIZE);
+    HashPageHeader *hdr = GetPageHeader(page);
+    hdr->m_version.store(1, memory_order_relaxed);
+    hdr->m_next_pid = INVALID_PID;
+    hdr->m_nslots = 0;
+    hdr->m_free_end = PAGE_SIZE;
+    hdr->m_nholes = 0;
+    m_npages.store(pid, memory_order_release);
+    return pid;
+}
+
+void
+HashIndex::FreeChain(PageNumber pid) {
+    std::lock_guard<std::mutex> guard(m_alloc_latch);
+    while (pid != INVALID_PID) {
+        m_free_pids.push_back(pid);
+        pid = GetPageHeader(GetPage(pid))->m_next_pid;
+    }
+}
+
+void
+HashIndex::SetBucketPageNumber(uint64_t bucket, PageNumber pid) {
+    uint64_t chunk = bucket >> BucketDirChunkBits;
+    ASSERT(chunk < MaxNumBucketDirChunks);
+    if (!m_bucket_dir[chunk]) {
+        m_bucket_dir[chunk].reset(
+            new std::atomic<PageNumber>[BucketDirChunkSize]);
+    }
+    m_bucket_dir[chunk][bucket & (BucketDirChunkSize - 1)].store(
+        pid, memory_order_release);
+}
+
+uint64_t
+HashIndex::ReadLockPage(char *page) {
+    uint64_t version =
+        GetPageHeader(page)->m_version.load(memory_order_acquire);
+    while (version & 1) {
+        std::this_thread::yield();
+        version = GetPageHeader(page)->m_version.load(memory_order_acquire);
+    }
+    return version;
+}
+
+bool
+HashIndex::ValidatePage(char *page, uint64_t version) {
+    // Orders the reads from the page before the reread of the version.
+    std::atomic_thread_fence(memory_order_acquire);
+    return GetPageHeader(page)->m_version.load(memory_order_relaxed) ==
+        version;
+}
+
+bool
+HashIndex::UpgradePageLock(char *page, uint64_t version) {
+    ASSERT(!(version & 1));
+    return GetPageHeader(page)->m_version.compare_exchange_strong(
+        version, version + 1, memory_order_acq_rel);
+}
+
+void
+HashIndex::WriteLockPage(char *page) {
+    while (!UpgradePageLock(page, ReadLockPage(page)));
+}
+
+void
+HashIndex::WriteUnlockPage(char *page) {
+    ASSERT(GetPageHeader(page)->m_version.load(memory_order_relaxed) & 1);
+    GetPageHeader(page)->m_version.fetch_add(1, memory_order_release);
+}
+
+char*
+HashIndex::LockBucket(uint64_t hash) {
+    for (;;) {
+        uint64_t bucket = GetBucket(hash, m_state.load(memory_order_acquire));
+        PageNumber pid = GetBucketPageNumber(bucket);
+        char *page = GetPage(pid);
+        WriteLockPage(page);
+
+        // The bucket may have been split before we locked it, in which case
+        // the hash value may belong to the new bucket now, and the bucket
+        // has a new primary page anyway.
+        if (GetBucket(hash, m_state.load(memory_order_acquire)) == bucket &&
+            GetBucketPageNumber(bucket) == pid) {
+            return page;
+        }
+        WriteUnlockPage(page);
+    }
+}
+
+size_t
+HashIndex::GetFreeSpace(char *page) {
+    HashPageHeader *hdr = GetPageHeader(page);
+    size_t free_start = MAXALIGN(sizeof(HashPageHeader)) +
+                        hdr->m_nslots * sizeof(HashSlot);
+    ASSERT(hdr->m_free_end >= free_start);
+    return hdr->m_free_end - free_start + hdr->m_nholes;
+}
+
+bool
+HashIndex::AppendEntryToPage(char *page, const char *entry, uint16_t len) {
+    HashPageHeader *phdr = GetPageHeader(page);
+    size_t space_needed = MAXALIGN(len) + sizeof(HashSlot);
+    if (GetFreeSpace(page) < space_needed) {
+        return false;
+    }
+
+    size_t free_start = MAXALIGN(sizeof(HashPageHeader)) +
+                        phdr->m_nslots * sizeof(HashSlot);
+    if (phdr->m_free_end - free_start < space_needed) {
+        CompactPage(page);
+    }
+
+    phdr->m_free_end -= MAXALIGN(len);
+    memcpy(page + phdr->m_free_end, entry, len);
+    HashSlot &slot = GetSlots(page)[phdr->m_nslots];
+    slot.m_offset = phdr->m_free_end;
+    slot.m_length = len;
+    slot.m_tag = GetTag(GetEntryHeader(entry)->m_hash);
+    ++phdr->m_nslots;
+    return true;
+}
+
+bool
+HashIndex::AppendEntryToBucket(char *bucket_page,
+                               const char *entry,
+                               uint16_t len) {
+    char *page = bucket_page;
+    for (;;) {
+        if (AppendEntryToPage(page, entry, len)) {
+            return false;
+        }
+        PageNumber next_pid = GetPageHeader(page)->m_next_pid;
+        if (next_pid == INVALID_PID) {
+            break;
+        }
+        page = GetPage(next_pid);
+    }
+
+    // The new page is only reachable from the bucket after it's filled, and
+    // the readers validate the version of the primary page anyway.
+    PageNumber new_pid = AllocatePage();
+    char *new_page = GetPage(new_pid);
+    bool ok = AppendEntryToPage(new_page, entry, len);
+    ASSERT(ok);
+    (void) ok;
+    WriteUnlockPage(new_page);
+    GetPageHeader(page)->m_next_pid = new_pid;
+    return true;
+}
+
+void
+HashIndex::RemoveEntryFromPage(char *page, uint16_t sid) {
+    HashPageHeader *phdr = GetPageHeader(page);
+    ASSERT(sid < phdr->m_nslots);
+    HashSlot *slots = GetSlots(page);
+    if (slots[sid].m_offset == phdr->m_free_end) {
+        phdr->m_free_end += MAXALIGN(slots[sid].m_length);
+    } else {
+        phdr->m_nholes += MAXALIGN(slots[sid].m_length);
+    }
+    // The slots are not ordered, so the last one takes the place.
+    slots[sid] = slots[phdr->m_nslots - 1];
+    --phdr->m_nslots;
+}
+
+void
+HashIndex::CompactPage(char *page) {
+    alignas(MAXALIGN_OF) char buf[PAGE_SIZE];
+    memcpy(buf, page, PAGE_SIZE);
+
+    HashPageHeader *phdr = GetPageHeader(page);
+    HashSlot *slots = GetSlots(page);
+    uint16_t offset = PAGE_SIZE;
+    for (uint16_t i = 0; i < phdr->m_nslots; ++i) {
+        offset -= MAXALIGN(slots[i].m_length);
+        memcpy(page + offset, buf + slots[i].m_offset, slots[i].m_length);
+        slots[i].m_offset = offset;
+    }
+    phdr->m_free_end = offset;
+    phdr->m_nholes = 0;
+}
+
+bool
+HashIndex::CopyChainEntries(char *bucket_page,
+                            bool match_tag,
+                            uint32_t tag,
+                            maxaligned_char_buf &buf,
+                            EntryList &entries) const {
+    // Everything read from the bucket may be garbage until the version is
+    // validated, so we must not read outside the pages or loop forever.
+    const PageNumber npages = m_npages.load(memory_order_acquire);
+    char *page = bucket_page;
+    for (PageNumber i = 0; i < npages; ++i) {
+        const HashPageHeader *phdr = GetPageHeader(page);
+        uint16_t nslots = std::min(phdr->m_nslots, GetMaxNumSlots());
+        const HashSlot *slots = GetSlots(page);
+        for (uint16_t sid = 0; sid < nslots; ++sid) {
+            HashSlot slot = slots[sid];
+            if (match_tag && slot.m_tag != tag) {
+                continue;
+            }
+            if (slot.m_length > MaxEntryLength ||
+                slot.m_length < MAXALIGN(sizeof(HashEntryHeader)) ||
+                (size_t) slot.m_offset + slot.m_length > PAGE_SIZE) {
+                return false;
+            }
+            entries.emplace_back(buf.size(), slot.m_length);
+            buf.resize(buf.size() + MAXALIGN(slot.m_length));
+            memcpy(buf.data() + entries.back().first, page + slot.m_offset,
+                   slot.m_length);
+        }
+
+        PageNumber next_pid = phdr->m_next_pid;
+        if (next_pid == INVALID_PID) {
+            return true;
+        }
+        if (next_pid > npages) {
+            return false;
+        }
+        page = GetPage(next_pid);
+    }
+    return false;
+}
+
+bool
+HashIndex::TryCopyBucketEntries(uint64_t hash,
+                                maxaligned_char_buf &buf,
+                                EntryList &entries) const {
+    const uint64_t state = m_state.load(memory_order_acquire);
+    char *bucket_page =
+        GetPage(GetBucketPageNumber(GetBucket(hash, state)));
+    const uint64_t version = ReadLockPage(bucket_page);
+    if (!CopyChainEntries(bucket_page, true, GetTag(hash), buf, entries)) {
+        return false;
+    }
+
+    // A split of the bucket changes the state before unlocking it.
+    return ValidatePage(bucket_page, version) &&
+        m_state.load(memory_order_relaxed) == state;
+}
+
+char*
+HashIndex::FindEntryInBucket(char *bucket_page,
+                             const IndexKey *key,
+                             uint64_t hash,
+                             RecordId recid,
+                             uint16_t &sid) const {
+    const uint32_t tag = GetTag(hash);
+    char *page = bucket_page;
+    for (;;) {
+        const HashPageHeader *phdr = GetPageHeader(page);
+        const HashSlot *slots = GetSlots(page);
+        for (uint16_t i = 0; i < phdr->m_nslots; ++i) {
+            if (slots[i].m_tag != tag) {
+                continue;
+            }
+            const char *entry = GetEntry(page, i);
+            const HashEntryHeader *ehdr = GetEntryHeader(entry);
+            if (ehdr->m_hash == hash &&
+                (!recid.IsValid() || ehdr->m_recid == recid) &&
+                KeyEqualsPayload(key, GetEntryPayload(entry))) {
+                sid = i;
+                return page;
+            }
+        }
+        if (phdr->m_next_pid == INVALID_PID) {
+            return nullptr;
+        }
+        page = GetPage(phdr->m_next_pid);
+    }
+}
+
+bool
+HashIndex::InsertKey(const IndexKey *key, RecordId recid) {
+    if (key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key and INCLUDE columns but got %d",
+                    (int)(m_nkeys + m_ninclcols), (int) key->GetNumKeys());
+    }
+    if (!recid.IsValid()) {
+        LOG(kError, "cannot insert an invalid record ID into an index");
+    }
+
+    const size_t hdr_size = MAXALIGN(sizeof(HashEntryHeader));
+    const uint64_t hash = ComputeKeyHash(key);
+    maxaligned_char_buf buf;
+    buf.resize(hdr_size);
+    HashEntryHeader *ehdr = (HashEntryHeader*) buf.data();
+    ehdr->m_hash = hash;
+    ehdr->m_recid = recid;
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys + m_ninclcols);
+    for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+        data.push_back(key->GetKey(i));
+    }
+    FieldOffset len = m_key_schema->WritePayloadToBuffer(data, buf);
+    if (len == -1) {
+        LOG(kError, "unable to serialize the index key");
+    }
+    if (len > GetMaxKeyLength()) {
+        LOG(kError, "index key is too long: %d > %d", (int) len,
+                    (int) GetMaxKeyLength());
+    }
+
+    // All the pairs with the key are in the same bucket, so the uniqueness
+    // check only needs the bucket lock.
+    char *bucket_page = LockBucket(hash);
+    RecordId invalid_recid;
+    invalid_recid.SetInvalid();
+    const bool check_key = m_idxdesc->GetIndexEntry()->idxunique() &&
+                           !KeyHasAnyNull(key);
+    uint16_t sid;
+    if (FindEntryInBucket(bucket_page, key, hash,
+                          check_key ? invalid_recid : recid, sid)) {
+        WriteUnlockPage(bucket_page);
+        return false;
+    }
+
+    bool overflowed = AppendEntryToBucket(bucket_page, buf.data(),
+                                          (uint16_t)(hdr_size + len));
+    WriteUnlockPage(bucket_page);
+    if (overflowed) {
+        SplitBucket();
+    }
+    return true;
+}
+
+bool
+HashIndex::DeleteKey(const IndexKey *key, RecordId &recid) {
+    if (key->GetNumKeys() != m_nkeys &&
+        key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key columns but got %d", (int) m_nkeys,
+                    (int) key->GetNumKeys());
+    }
+
+    const uint64_t hash = ComputeKeyHash(key);
+    char *bucket_page = LockBucket(hash);
+    uint16_t sid;
+    char *page = FindEntryInBucket(bucket_page, key, hash, recid, sid);
+    if (page) {
+        recid = GetEntryHeader(GetEntry(page, sid))->m_recid;
+        RemoveEntryFromPage(page, sid);
+    }
+    WriteUnlockPage(bucket_page);
+    return page != nullptr;
+}
+
+void
+HashIndex::SplitBucket() {
+    std::lock_guard<std::mutex> guard(m_split_latch);
+    const uint64_t state = m_state.load(memory_order_relaxed);
+    const uint32_t level = GetLevel(state);
+    const uint64_t old_bucket = GetSplitPointer(state);
+    const uint64_t new_bucket = old_bucket + (((uint64_t) 1) << level);
+    if ((new_bucket >> BucketDirChunkBits) >= MaxNumBucketDirChunks) {
+        // The bucket directory is full. The chains just grow longer.
+        return;
+    }
+
+    // Copies the entries of the old bucket without locking it, and
+    // redistributes them by the next bit of their hash values into two new
+    // chains, which are not reachable until they are published below. The
+    // copy is only used if the bucket has not been modified since, so that
+    // the bucket is only locked for publishing the new chains. If the
+    // bucket keeps being modified, we give up and copy it under the lock.
+    const PageNumber old_pid = GetBucketPageNumber(old_bucket);
+    char *old_page = GetPage(old_pid);
+    const uint64_t split_bit = ((uint64_t) 1) << level;
+    maxaligned_char_buf buf;
+    EntryList entries;
+    PageNumber kept_pid = INVALID_PID;
+    PageNumber moved_pid = INVALID_PID;
+    for (uint32_t attempt = 1;; ++attempt) {
+        const bool locked = attempt > MaxOptimisticSplitAttempts;
+        uint64_t version = 0;
+        if (locked) {
+            WriteLockPage(old_page);
+        } else {
+            version = ReadLockPage(old_page);
+        }
+        buf.clear();
+        entries.clear();
+        if (!CopyChainEntries(old_page, false, 0, buf, entries) ||
+            (!locked && !ValidatePage(old_page, version))) {
+            ASSERT(!locked);
+            continue;
+        }
+
+        if (kept_pid != INVALID_PID) {
+            FreeChain(kept_pid);
+            FreeChain(moved_pid);
+        }
+        kept_pid = AllocatePage();
+        moved_pid = AllocatePage();
+        for (const auto &e : entries) {
+            const char *entry = buf.data() + e.first;
+            PageNumber pid = (GetEntryHeader(entry)->m_hash & split_bit) ?
+                moved_pid : kept_pid;
+            AppendEntryToBucket(GetPage(pid), entry, e.second);
+        }
+        WriteUnlockPage(GetPage(kept_pid));
+        WriteUnlockPage(GetPage(moved_pid));
+
+        if (locked || UpgradePageLock(old_page, version)) {
+            break;
+        }
+    }
+
+    // Any reader that finds the new primary page of the old bucket with the
+    // old state waits until the state is updated, and then retries. Any
+    // reader or writer of the old primary page fails its validation or its
+    // check of the primary page after we unlock it.
+    char *kept_page = GetPage(kept_pid);
+    WriteLockPage(kept_page);
+    SetBucketPageNumber(new_bucket, moved_pid);
+    SetBucketPageNumber(old_bucket, kept_pid);
+    uint64_t new_state = (old_bucket + 1 == split_bit) ?
+        (((uint64_t)(level + 1)) << 32) :
+        (state + 1);
+    m_state.store(new_state, memory_order_release);
+    WriteUnlockPage(kept_page);
+    WriteUnlockPage(old_page);
+    FreeChain(old_pid);
+}
+
+std::unique_ptr<Index::Iterator>
+HashIndex::StartScan(const IndexKey *lower,
+                     bool lower_isstrict,
+                     const IndexKey *upper,
+                     bool upper_isstrict) {
+    if (!lower || !upper || lower_isstrict || upper_isstrict ||
+        lower->GetNumKeys() != m_nkeys || upper->GetNumKeys() != m_nkeys) {
+        LOG(kError, "a hash index only supports scans of a full key");
+    }
+    for (FieldId i = 0; lower != upper && i < m_nkeys; ++i) {
+        if (lower->IsNull(i) || upper->IsNull(i)) {
+            if (lower->IsNull(i) != upper->IsNull(i)) {
+                LOG(kError, "a hash index only supports scans of a full key");
+            }
+            continue;
+        }
+        if (!FunctionCall(m_eq_funcs[i], lower->GetKey(i),
+                          upper->GetKey(i)).GetBool()) {
+            LOG(kError, "a hash index only supports scans of a full key");
+        }
+    }
+
+    return std::unique_ptr<Index::Iterator>(new Iterator(this, lower));
+}
+
+}   // namespace taco
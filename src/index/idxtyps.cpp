@@ -8,6 +8,8 @@ absl::string_view IdxTypeGetName(IdxType idx) {
         return "volatile tree";
     case IDXTYP(BTREE):
         return "b-tree";
+    case IDXTYP(HASH):
+        return "hash";
     }
 
     LOG(kFatal, "unknown index type: %d", (int) idx);
@@ -25,6 +27,7 @@ IdxTypeNeedsEqualOperator(IdxType idx) {
     switch (idx) {
     case IDXTYP(VOLATILETREE):
     case IDXTYP(BTREE):
+    case IDXTYP(HASH):
         return true;
     }
 
@@ -38,6 +41,22 @@ IdxTypeNeedsLessOperator(IdxType idx) {
     case IDXTYP(VOLATILETREE):
     case IDXTYP(BTREE):
         return true;
+    case IDXTYP(HASH):
+        return false;
+    }
+
+    LOG(kFatal, "unknown index type: %d", (int) idx);
+    return false;
+}
+
+bool
+IdxTypeNeedsHashFunction(IdxType idx) {
+    switch (idx) {
+    case IDXTYP(VOLATILETREE):
+    case IDXTYP(BTREE):
+        return false;
+    case IDXTYP(HASH):
+        return true;
     }
 
     LOG(kFatal, "unknown index type: %d", (int) idx);
@@ -0,0 +1,926 @@
+#include "index/volatiletree/VolatileTree.h"
+
+#include <algorithm>
+
+namespace taco {
+
+constexpr uint32_t VolatileTree::NodeFanout;
+constexpr uint32_t VolatileTree::MaxPrefixLength;
+
+class VolatileTree::Iterator: public Index::Iterator {
+public:
+    Iterator(VolatileTree *tree,
+             const IndexKey *lower,
+             bool lower_isstrict,
+             const IndexKey *upper,
+             bool upper_isstrict):
+        m_tree(tree),
+        m_lower(lower ? *lower : IndexKey(nullptr, 0)),
+        m_lower_isstrict(lower && lower_isstrict),
+        m_has_upper(upper != nullptr),
+        m_upper(upper ? *upper : IndexKey(nullptr, 0)),
+        m_upper_isstrict(upper_isstrict),
+        m_same_bounds(lower && lower == upper),
+        m_cur_buf(0),
+        m_next_item(0),
+        m_started(false),
+        m_done(false),
+        m_valid(false) {
+        if (m_has_upper) {
+            // An entry with the same key as the upper bound is smaller than
+            // it unless the bound is strict.
+            RecordId recid;
+            recid.SetInvalid();
+            m_tree->MakeSearchKey(m_upper_skey, &m_upper,
+                                  m_upper.GetNumKeys(), recid,
+                                  m_upper_isstrict ? -1 : 1, m_upper_nkey);
+        }
+    }
+
+    bool Next() override;
+
+    bool
+    IsAtValidItem() override {
+        return m_valid;
+    }
+
+    const Record&
+    GetCurrentItem() override {
+        ASSERT(m_valid);
+        return m_item;
+    }
+
+    RecordId
+    GetCurrentRecordId() override {
+        ASSERT(m_valid);
+        return m_item.GetRecordId();
+    }
+
+    void
+    EndScan() override {
+        m_done = true;
+        m_items.clear();
+        m_next_item = 0;
+        m_valid = false;
+    }
+
+private:
+    struct Item {
+        size_t          m_offset;
+        FieldOffset     m_len;
+        RecordId        m_recid;
+    };
+
+    /*!
+     * Copies the items in the range on the leaf right after the current
+     * item (or the first leaf in the range) into the buffer that is not
+     * holding the current item.
+     */
+    void FetchNextLeaf();
+
+    VolatileTree    *m_tree;
+
+    IndexKey        m_lower;
+    bool            m_lower_isstrict;
+    bool            m_has_upper;
+    IndexKey        m_upper;
+    bool            m_upper_isstrict;
+    SearchKey       m_upper_skey;
+    std::string     m_upper_nkey;
+
+    //! Whether the scan is a point lookup, whose bounds share the same
+    //! normalized key.
+    bool            m_same_bounds;
+
+    //! The payloads of the fetched items are in m_buf[m_cur_buf], while the
+    //! other one still holds the previous batch, so that the current item
+    //! remains valid during a fetch.
+    maxaligned_char_buf m_buf[2];
+    int             m_cur_buf;
+    std::vector<Item> m_items;
+    size_t          m_next_item;
+
+    //! The normalized key of the last fetched item.
+    std::string     m_last_nkey;
+
+    bool            m_started;
+    bool            m_done;
+    bool            m_valid;
+    Record          m_item;
+};
+
+void
+VolatileTree::Iterator::FetchNextLeaf() {
+    SearchKey skey;
+    std::string nkey_buf;
+    std::vector<Datum> data;
+    std::vector<NullableDatumRef> data_ref;
+    IndexKey last_key(nullptr, 0);
+    if (m_started) {
+        // Continue right after the last fetched item.
+        const Item &last = m_items.back();
+        if (m_tree->m_use_nkey) {
+            skey = SearchKey{nullptr, m_tree->m_nkeys, last.m_recid, 1,
+                             m_last_nkey.data(), m_last_nkey.size()};
+        } else {
+            data = m_tree->m_key_schema->DissemblePayload(
+                m_buf[m_cur_buf].data() + last.m_offset);
+            data_ref.reserve(data.size());
+            for (const Datum &d : data) {
+                data_ref.emplace_back(d);
+            }
+            last_key = IndexKey(data_ref);
+            m_tree->MakeSearchKey(skey, &last_key, m_tree->m_nkeys,
+                                  last.m_recid, 1, nkey_buf);
+        }
+    } else if (m_same_bounds) {
+        skey = m_upper_skey;
+        skey.m_tie = m_lower_isstrict ? 1 : -1;
+        m_started = true;
+    } else {
+        RecordId recid;
+        recid.SetInvalid();
+        m_tree->MakeSearchKey(skey, &m_lower, m_lower.GetNumKeys(), recid,
+                              m_lower_isstrict ? 1 : -1, nkey_buf);
+        m_started = true;
+    }
+
+    m_cur_buf ^= 1;
+    maxaligned_char_buf &buf = m_buf[m_cur_buf];
+    buf.clear();
+    m_items.clear();
+    m_items.reserve(NodeFanout);
+    m_next_item = 0;
+
+    EpochGuard guard(&m_tree->m_epoch);
+    Cursor cursor;
+    if (!m_tree->Seek(skey, cursor)) {
+        m_done = true;
+        return;
+    }
+    const Node *leaf = cursor.m_leaf;
+    for (uint32_t i = cursor.m_pos; i < leaf->m_nkeys; ++i) {
+        const Entry *entry = leaf->m_entries[i];
+        if (m_has_upper && m_tree->CompareWithEntry(m_upper_skey, entry) < 0) {
+            m_done = true;
+            break;
+        }
+        size_t offset = buf.size();
+        buf.resize(offset + MAXALIGN(entry->m_payload_len));
+        memcpy(&buf[offset], entry->GetPayload(), entry->m_payload_len);
+        m_items.push_back(Item{offset, entry->m_payload_len,
+                               entry->m_recid});
+        if (i + 1 == leaf->m_nkeys && m_tree->m_use_nkey) {
+            m_last_nkey.assign(entry->GetNormalizedKey(), entry->m_nkey_len);
+        }
+    }
+}
+
+bool
+VolatileTree::Iterator::Next() {
+    if (m_next_item >= m_items.size()) {
+        if (!m_done) {
+            FetchNextLeaf();
+        }
+        if (m_next_item >= m_items.size()) {
+            m_done = true;
+            m_valid = false;
+            return false;
+        }
+    }
+
+    const Item &item = m_items[m_next_item++];
+    m_item = Record(m_buf[m_cur_buf].data() + item.m_offset, item.m_len);
+    m_item.GetRecordId() = item.m_recid;
+    m_valid = true;
+    return true;
+}
+
+std::unique_ptr<VolatileTree>
+VolatileTree::Create(const IndexDesc *idxdesc) {
+    return std::unique_ptr<VolatileTree>(new VolatileTree(idxdesc));
+}
+
+VolatileTree::VolatileTree(const IndexDesc *idxdesc):
+    Index(idxdesc) {
+    static_assert(offsetof(Node, m_heads) + sizeof(uint64_t) * NodeFanout
+                  <= 2 * CACHELINE_SIZE,
+                  "the node header and the heads must fit in two cache "
+                  "lines");
+    m_root.store(AllocateNode(0), memory_order_release);
+}
+
+VolatileTree::Garbage::~Garbage() {
+    for (Node *node : m_nodes) {
+        FreeNode(node);
+    }
+    for (const Entry *entry : m_entries) {
+        FreeEntry((void*) entry);
+    }
+}
+
+VolatileTree::~VolatileTree() {
+    FreeSubtree(m_root.load(memory_order_relaxed));
+}
+
+uint32_t
+VolatileTree::GetTreeHeight() const {
+    EpochGuard guard(&m_epoch);
+    return m_root.load(memory_order_acquire)->m_level + 1;
+}
+
+uint64_t
+VolatileTree::ComputeHead(const char *nkey,
+                          size_t nkey_len,
+                          size_t prefix_len) {
+    uint64_t head = 0;
+    for (size_t i = prefix_len; i < prefix_len + sizeof(uint64_t); ++i) {
+        head = (head << 8) | (i < nkey_len ? (uint8_t) nkey[i] : 0);
+    }
+    return head;
+}
+
+void
+VolatileTree::ComputeNodeHeads(Node *node) {
+    const uint16_t n = node->m_nkeys;
+    if (n == 0) {
+        node->m_prefix_len = 0;
+        return;
+    }
+
+    // All the entries are between the first and the last ones.
+    const Entry *first = node->m_entries[0];
+    const Entry *last = node->m_entries[n - 1];
+    uint32_t max_len = std::min(std::min(first->m_nkey_len, last->m_nkey_len),
+                                MaxPrefixLength);
+    const char *first_nkey = first->GetNormalizedKey();
+    const char *last_nkey = last->GetNormalizedKey();
+    uint32_t prefix_len = 0;
+    while (prefix_len < max_len &&
+           first_nkey[prefix_len] == last_nkey[prefix_len]) {
+        ++prefix_len;
+    }
+    node->m_prefix_len = prefix_len;
+    memcpy(node->m_prefix, first_nkey, prefix_len);
+    for (uint16_t i = 0; i < n; ++i) {
+        node->m_heads[i] = ComputeHead(node->m_entries[i]->GetNormalizedKey(),
+                                       node->m_entries[i]->m_nkey_len,
+                                       prefix_len);
+    }
+}
+
+const VolatileTree::Entry*
+VolatileTree::CreateEntry(const char *payload,
+                          FieldOffset payload_len,
+                          RecordId recid,
+                          const char *nkey,
+                          size_t nkey_len) const {
+    if (nkey_len > std::numeric_limits<uint32_t>::max()) {
+        LOG(kError, "normalized key is too long: %lu", nkey_len);
+    }
+    size_t size = MAXALIGN(sizeof(Entry)) + MAXALIGN(payload_len) + nkey_len;
+    Entry *entry = (Entry*) malloc(size);
+    entry->m_recid = recid;
+    entry->m_payload_len = payload_len;
+    entry->m_nkey_len = (uint32_t) nkey_len;
+    memcpy((char*) entry->GetPayload(), payload, payload_len);
+    if (nkey_len > 0) {
+        memcpy((char*) entry->GetNormalizedKey(), nkey, nkey_len);
+    }
+    return entry;
+}
+
+const VolatileTree::Entry*
+VolatileTree::CopyEntry(const Entry *entry) {
+    size_t size = MAXALIGN(sizeof(Entry)) + MAXALIGN(entry->m_payload_len) +
+                  entry->m_nkey_len;
+    Entry *copy = (Entry*) malloc(size);
+    memcpy(copy, entry, size);
+    return copy;
+}
+
+void
+VolatileTree::FreeEntry(void *entry) {
+    free(entry);
+}
+
+VolatileTree::Node*
+VolatileTree::AllocateNode(uint16_t level) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t size = (level == 0) ? sizeof(Node) : sizeof(InternalNode);
+    size = (size + CACHELINE_SIZE - 1) / CACHELINE_SIZE * CACHELINE_SIZE;
+    Node *node = (Node*) aligned_alloc(CACHELINE_SIZE, size);
+    node->m_level = level;
+    node->m_nkeys = 0;
+    node->m_prefix_len = 0;
+    return node;
+}
+
+VolatileTree::Node*
+VolatileTree::CopyNode(const Node *node) {
+    Node *copy = AllocateNode(node->m_level);
+    memcpy(copy, node, (node->m_level == 0) ? sizeof(Node) :
+                                              sizeof(InternalNode));
+    return copy;
+}
+
+void
+VolatileTree::FreeNode(void *node) {
+    free(node);
+}
+
+void
+VolatileTree::FreeSubtree(Node *node) {
+    if (node->m_level > 0) {
+        InternalNode *inode = (InternalNode*) node;
+        for (uint32_t i = 0; i <= node->m_nkeys; ++i) {
+            FreeSubtree(inode->m_children[i]);
+        }
+    }
+    for (uint32_t i = 0; i < node->m_nkeys; ++i) {
+        FreeEntry((void*) node->m_entries[i]);
+    }
+    FreeNode(node);
+}
+
+void
+VolatileTree::FillNode(Node *node,
+                       const Entry *const *entries,
+                       uint16_t nentries,
+                       Node *const *children) {
+    ASSERT(nentries <= NodeFanout);
+    node->m_nkeys = nentries;
+    memcpy(node->m_entries, entries, sizeof(const Entry*) * nentries);
+    ComputeNodeHeads(node);
+    if (node->m_level > 0) {
+        memcpy(((InternalNode*) node)->m_children, children,
+               sizeof(Node*) * (nentries + 1));
+    }
+}
+
+void
+VolatileTree::MakeSearchKey(SearchKey &skey,
+                            const IndexKey *key,
+                            FieldId nkeys,
+                            RecordId recid,
+                            int tie,
+                            std::string &nkey_buf) const {
+    skey.m_key = key;
+    skey.m_nkeys = nkeys;
+    skey.m_recid = recid;
+    skey.m_tie = tie;
+    if (nkeys == m_nkeys && GetSearchNormalizedKey(key, nkey_buf)) {
+        skey.m_nkey = nkey_buf.data();
+        skey.m_nkey_len = nkey_buf.size();
+    } else {
+        skey.m_nkey = nullptr;
+        skey.m_nkey_len = 0;
+    }
+}
+
+int
+VolatileTree::CompareWithEntry(const SearchKey &skey,
+                               const Entry *entry) const {
+    int res;
+    if (skey.m_nkey) {
+        res = memcmp(skey.m_nkey, entry->GetNormalizedKey(),
+                     std::min(skey.m_nkey_len, (size_t) entry->m_nkey_len));
+        if (res == 0 && skey.m_nkey_len != entry->m_nkey_len) {
+            res = (skey.m_nkey_len < entry->m_nkey_len) ? -1 : 1;
+        }
+    } else {
+        res = CompareKeyWithPayload(skey.m_key, entry->GetPayload(),
+                                    skey.m_nkeys);
+    }
+    if (res != 0) {
+        return res;
+    }
+    if (skey.m_recid.IsValid()) {
+        if (skey.m_recid < entry->m_recid) {
+            return -1;
+        }
+        if (skey.m_recid != entry->m_recid) {
+            return 1;
+        }
+    }
+    return skey.m_tie;
+}
+
+uint32_t
+VolatileTree::SearchNode(const SearchKey &skey,
+                         const Node *node,
+                         bool upper) const {
+    uint32_t lo = 0;
+    uint32_t hi = node->m_nkeys;
+    if (skey.m_nkey && hi > 0) {
+        // A search key that differs from the prefix is smaller or larger
+        // than all the entries. A full normalized key is never a proper
+        // prefix of another one.
+        size_t prefix_len = node->m_prefix_len;
+        int res = memcmp(skey.m_nkey, node->m_prefix,
+                         std::min(prefix_len, skey.m_nkey_len));
+        if (res != 0 || skey.m_nkey_len < prefix_len) {
+            return (res > 0) ? hi : 0;
+        }
+
+        // The heads are order-preserving, so the entries with a smaller
+        // head are smaller than the search key and the ones with a larger
+        // head are larger than it. The loop has no branch and only reads
+        // the cache lines of the heads.
+        const uint64_t head = ComputeHead(skey.m_nkey, skey.m_nkey_len,
+                                          prefix_len);
+        uint32_t nless = 0;
+        uint32_t nleq = 0;
+        for (uint32_t i = 0; i < node->m_nkeys; ++i) {
+            nless += (node->m_heads[i] < head);
+            nleq += (node->m_heads[i] <= head);
+        }
+        lo = nless;
+        hi = nleq;
+    }
+
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) >> 1;
+        int res = CompareWithEntry(skey, node->m_entries[mid]);
+        if (res > 0 || (upper && res == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool
+VolatileTree::Seek(const SearchKey &skey, Cursor &cursor) const {
+    const Node *node = m_root.load(memory_order_acquire);
+    cursor.m_path.clear();
+    cursor.m_path.reserve(node->m_level);
+    while (node->m_level > 0) {
+        uint32_t idx = SearchNode(skey, node, true);
+        cursor.m_path.emplace_back(node, idx);
+        node = ((const InternalNode*) node)->m_children[idx];
+    }
+    cursor.m_leaf = node;
+    cursor.m_pos = SearchNode(skey, node, false);
+    if (cursor.m_pos < node->m_nkeys) {
+        return true;
+    }
+    return MoveToNextLeaf(cursor);
+}
+
+bool
+VolatileTree::MoveToNextLeaf(Cursor &cursor) {
+    while (!cursor.m_path.empty()) {
+        const Node *node = cursor.m_path.back().first;
+        uint32_t idx = cursor.m_path.back().second;
+        if (idx < node->m_nkeys) {
+            ++cursor.m_path.back().second;
+            node = ((const InternalNode*) node)->m_children[idx + 1];
+            while (node->m_level > 0) {
+                cursor.m_path.emplace_back(node, 0);
+                node = ((const InternalNode*) node)->m_children[0];
+            }
+            // Only the root may be an empty leaf.
+            ASSERT(node->m_nkeys > 0);
+            cursor.m_leaf = node;
+            cursor.m_pos = 0;
+            return true;
+        }
+        cursor.m_path.pop_back();
+    }
+    cursor.m_leaf = nullptr;
+    cursor.m_pos = 0;
+    return false;
+}
+
+const VolatileTree::Entry*
+VolatileTree::FindEntry(const SearchKey &skey) const {
+    Cursor cursor;
+    if (!Seek(skey, cursor)) {
+        return nullptr;
+    }
+    const Entry *entry = cursor.m_leaf->m_entries[cursor.m_pos];
+    SearchKey key_only = skey;
+    key_only.m_recid.SetInvalid();
+    key_only.m_tie = 0;
+    if (CompareWithEntry(key_only, entry) != 0) {
+        return nullptr;
+    }
+    return entry;
+}
+
+VolatileTree::ModifyResult
+VolatileTree::InsertIntoNode(const Node *node,
+                             uint32_t pos,
+                             const Entry *entry,
+                             Node *left_child,
+                             Node *right_child) {
+    const Entry *entries[NodeFanout + 1];
+    Node *children[NodeFanout + 2];
+    const uint32_t n = node->m_nkeys;
+    memcpy(entries, node->m_entries, sizeof(const Entry*) * pos);
+    entries[pos] = entry;
+    memcpy(entries + pos + 1, node->m_entries + pos,
+           sizeof(const Entry*) * (n - pos));
+    if (node->m_level > 0) {
+        const InternalNode *inode = (const InternalNode*) node;
+        memcpy(children, inode->m_children, sizeof(Node*) * pos);
+        children[pos] = left_child;
+        children[pos + 1] = right_child;
+        memcpy(children + pos + 2, inode->m_children + pos + 1,
+               sizeof(Node*) * (n - pos));
+    }
+
+    Node *left = AllocateNode(node->m_level);
+    if (n + 1 <= NodeFanout) {
+        FillNode(left, entries, n + 1, children);
+        return ModifyResult{left, nullptr, nullptr};
+    }
+
+    // Split the node in half. A leaf copies its first entry on the right
+    // into the parent as the separator, while an internal node moves its
+    // middle separator up.
+    Node *right = AllocateNode(node->m_level);
+    const uint32_t nleft = (n + 2) / 2;
+    if (node->m_level == 0) {
+        FillNode(left, entries, nleft, nullptr);
+        FillNode(right, entries + nleft, n + 1 - nleft, nullptr);
+        return ModifyResult{left, right, CopyEntry(entries[nleft])};
+    }
+    FillNode(left, entries, nleft - 1, children);
+    FillNode(right, entries + nleft, n + 1 - nleft, children + nleft);
+    return ModifyResult{left, right, entries[nleft - 1]};
+}
+
+VolatileTree::ModifyResult
+VolatileTree::InsertRecursive(const SearchKey &skey,
+                              const Entry *entry,
+                              Node *node,
+                              Garbage &garbage) {
+    if (node->m_level == 0) {
+        uint32_t pos = SearchNode(skey, node, false);
+        if (pos < node->m_nkeys &&
+            CompareWithEntry(skey, node->m_entries[pos]) == 0) {
+            return ModifyResult{nullptr, nullptr, nullptr};
+        }
+        garbage.m_nodes.push_back(node);
+        return InsertIntoNode(node, pos, entry, nullptr, nullptr);
+    }
+
+    // The nodes are only copied once the insertion is known to succeed.
+    InternalNode *inode = (InternalNode*) node;
+    uint32_t idx = SearchNode(skey, node, true);
+    ModifyResult res = InsertRecursive(skey, entry, inode->m_children[idx],
+                                       garbage);
+    if (!res.m_node) {
+        return res;
+    }
+    garbage.m_nodes.push_back(node);
+    if (res.m_right) {
+        return InsertIntoNode(node, idx, res.m_sep, res.m_node, res.m_right);
+    }
+    Node *copy = CopyNode(node);
+    ((InternalNode*) copy)->m_children[idx] = res.m_node;
+    return ModifyResult{copy, nullptr, nullptr};
+}
+
+bool
+VolatileTree::InsertKey(const IndexKey *key, RecordId recid) {
+    if (key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key and INCLUDE columns but got %d",
+                    (int)(m_nkeys + m_ninclcols), (int) key->GetNumKeys());
+    }
+    if (!recid.IsValid()) {
+        LOG(kError, "cannot insert an invalid record ID into an index");
+    }
+
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys + m_ninclcols);
+    for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+        data.push_back(key->GetKey(i));
+    }
+    maxaligned_char_buf buf;
+    FieldOffset len = m_key_schema->WritePayloadToBuffer(data, buf);
+    if (len == -1) {
+        LOG(kError, "unable to serialize the index key");
+    }
+
+    // Unlike a search key, the key to insert must be encoded if the index
+    // uses normalized keys.
+    std::string nkey;
+    SearchKey skey{key, m_nkeys, recid, 0, nullptr, 0};
+    if (m_use_nkey) {
+        WriteNormalizedKey(data, nkey);
+        skey.m_nkey = nkey.data();
+        skey.m_nkey_len = nkey.size();
+    }
+
+    std::lock_guard<std::mutex> guard(m_write_latch);
+    if (m_idxdesc->GetIndexEntry()->idxunique() && !KeyHasAnyNull(key)) {
+        SearchKey first_skey = skey;
+        first_skey.m_recid.SetInvalid();
+        first_skey.m_tie = -1;
+        if (FindEntry(first_skey)) {
+            return false;
+        }
+    }
+
+    const Entry *entry = CreateEntry(buf.data(), len, recid, skey.m_nkey,
+                                     skey.m_nkey_len);
+    std::unique_ptr<Garbage> garbage(new Garbage);
+    Node *root = m_root.load(memory_order_relaxed);
+    ModifyResult res = InsertRecursive(skey, entry, root, *garbage);
+    if (!res.m_node) {
+        FreeEntry((void*) entry);
+        return false;
+    }
+
+    Node *new_root = res.m_node;
+    if (res.m_right) {
+        new_root = AllocateNode(root->m_level + 1);
+        Node *children[2] = {res.m_node, res.m_right};
+        FillNode(new_root, &res.m_sep, 1, children);
+    }
+    m_root.store(new_root, memory_order_release);
+    m_epoch.Retire(garbage.release());
+    return true;
+}
+
+bool
+VolatileTree::DeleteRecursive(const SearchKey &skey,
+                              Node *node,
+                              Node *&new_node,
+                              Garbage &garbage) {
+    const uint32_t n = node->m_nkeys;
+    if (node->m_level == 0) {
+        uint32_t pos = SearchNode(skey, node, false);
+        if (pos >= n || CompareWithEntry(skey, node->m_entries[pos]) != 0) {
+            return false;
+        }
+        garbage.m_nodes.push_back(node);
+        garbage.m_entries.push_back(node->m_entries[pos]);
+        if (n == 1) {
+            new_node = nullptr;
+            return true;
+        }
+        const Entry *entries[NodeFanout];
+        memcpy(entries, node->m_entries, sizeof(const Entry*) * pos);
+        memcpy(entries + pos, node->m_entries + pos + 1,
+               sizeof(const Entry*) * (n - pos - 1));
+        new_node = AllocateNode(0);
+        FillNode(new_node, entries, n - 1, nullptr);
+        return true;
+    }
+
+    InternalNode *inode = (InternalNode*) node;
+    uint32_t idx = SearchNode(skey, node, true);
+    Node *new_child;
+    if (!DeleteRecursive(skey, inode->m_children[idx], new_child, garbage)) {
+        return false;
+    }
+    garbage.m_nodes.push_back(node);
+    if (new_child) {
+        new_node = CopyNode(node);
+        ((InternalNode*) new_node)->m_children[idx] = new_child;
+        return true;
+    }
+    if (n == 0) {
+        new_node = nullptr;
+        return true;
+    }
+
+    // The empty child is removed along with the separator on one of its
+    // sides. Its left sibling then covers its key range, or its right
+    // sibling does if it is the leftmost child. The nodes are never merged
+    // otherwise.
+    uint32_t sep = (idx > 0) ? idx - 1 : 0;
+    garbage.m_entries.push_back(node->m_entries[sep]);
+    const Entry *entries[NodeFanout];
+    Node *children[NodeFanout + 1];
+    memcpy(entries, node->m_entries, sizeof(const Entry*) * sep);
+    memcpy(entries + sep, node->m_entries + sep + 1,
+           sizeof(const Entry*) * (n - sep - 1));
+    memcpy(children, inode->m_children, sizeof(Node*) * idx);
+    memcpy(children + idx, inode->m_children + idx + 1,
+           sizeof(Node*) * (n - idx));
+    new_node = AllocateNode(node->m_level);
+    FillNode(new_node, entries, n - 1, children);
+    return true;
+}
+
+bool
+VolatileTree::DeleteKey(const IndexKey *key, RecordId &recid) {
+    if (key->GetNumKeys() != m_nkeys &&
+        key->GetNumKeys() != m_nkeys + m_ninclcols) {
+        LOG(kError, "expecting %d key columns but got %d", (int) m_nkeys,
+                    (int) key->GetNumKeys());
+    }
+
+    std::string nkey;
+    SearchKey skey;
+    MakeSearchKey(skey, key, m_nkeys, recid, 0, nkey);
+
+    std::lock_guard<std::mutex> guard(m_write_latch);
+    if (!recid.IsValid()) {
+        // Delete the first pair with the key.
+        skey.m_tie = -1;
+        const Entry *entry = FindEntry(skey);
+        if (!entry) {
+            return false;
+        }
+        skey.m_recid = entry->m_recid;
+        skey.m_tie = 0;
+    }
+
+    std::unique_ptr<Garbage> garbage(new Garbage);
+    Node *new_root;
+    if (!DeleteRecursive(skey, m_root.load(memory_order_relaxed), new_root,
+                         *garbage)) {
+        return false;
+    }
+    if (!new_root) {
+        new_root = AllocateNode(0);
+    }
+    if (new_root->m_level > 0 && new_root->m_nkeys == 0) {
+        // Removes the internal nodes without any separator from the top.
+        // Only the new root has never been published. The ones below it are
+        // still reachable by the readers, so they must be retired.
+        Node *child = ((InternalNode*) new_root)->m_children[0];
+        FreeNode(new_root);
+        new_root = child;
+        while (new_root->m_level > 0 && new_root->m_nkeys == 0) {
+            garbage->m_nodes.push_back(new_root);
+            new_root = ((InternalNode*) new_root)->m_children[0];
+        }
+    }
+    m_root.store(new_root, memory_order_release);
+    m_epoch.Retire(garbage.release());
+    recid = skey.m_recid;
+    return true;
+}
+
+void
+VolatileTree::BulkLoadAppendEntry(std::vector<Node*> &rightmost,
+                                  uint16_t level,
+                                  const Entry *entry,
+                                  Node *right_child) {
+    Node *node = rightmost[level];
+    if (node->m_nkeys == NodeFanout) {
+        // The heads of a rightmost node are only computed once it is full
+        // or the bulk load ends.
+        ComputeNodeHeads(node);
+        if (level + 1u == rightmost.size()) {
+            // The node was the root so far.
+            Node *parent = AllocateNode(level + 1);
+            ((InternalNode*) parent)->m_children[0] = node;
+            rightmost.push_back(parent);
+        }
+
+        Node *new_node = AllocateNode(level);
+        if (level == 0) {
+            BulkLoadAppendEntry(rightmost, 1, CopyEntry(entry), new_node);
+            FillNode(new_node, &entry, 1, nullptr);
+        } else {
+            // The separator moves up, and the new node starts with the
+            // right child of it.
+            ((InternalNode*) new_node)->m_children[0] = right_child;
+            BulkLoadAppendEntry(rightmost, level + 1, entry, new_node);
+        }
+        rightmost[level] = new_node;
+        return;
+    }
+
+    uint16_t n = node->m_nkeys;
+    node->m_entries[n] = entry;
+    if (level > 0) {
+        ((InternalNode*) node)->m_children[n + 1] = right_child;
+    }
+    node->m_nkeys = n + 1;
+}
+
+void
+VolatileTree::BulkLoad(BulkLoadSource *src) {
+    // The entries are owned by the vector until they are all in the tree.
+    std::vector<unique_malloced_ptr> entries;
+    maxaligned_char_buf buf;
+    std::vector<NullableDatumRef> data;
+    data.reserve(m_nkeys + m_ninclcols);
+    std::string nkey;
+    while (src->Next()) {
+        const IndexKey *key = src->GetCurrentKey();
+        RecordId recid = src->GetCurrentRecordId();
+        if (key->GetNumKeys() != m_nkeys + m_ninclcols) {
+            LOG(kError, "expecting %d key and INCLUDE columns but got %d",
+                        (int)(m_nkeys + m_ninclcols), (int) key->GetNumKeys());
+        }
+        if (!recid.IsValid()) {
+            LOG(kError, "cannot insert an invalid record ID into an index");
+        }
+
+        buf.clear();
+        data.clear();
+        for (FieldId i = 0; i < m_nkeys + m_ninclcols; ++i) {
+            data.push_back(key->GetKey(i));
+        }
+        FieldOffset len = m_key_schema->WritePayloadToBuffer(data, buf);
+        if (len == -1) {
+            LOG(kError, "unable to serialize the index key");
+        }
+        if (m_use_nkey) {
+            WriteNormalizedKey(data, nkey);
+        }
+        entries.emplace_back((void*) CreateEntry(
+            buf.data(), len, recid, nkey.data(), nkey.size()));
+    }
+
+    // With normalized keys, the entries are sorted by memcmp only.
+    auto cmp_entries = [this](const unique_malloced_ptr &p1,
+                              const unique_malloced_ptr &p2) -> int {
+        const Entry *entry1 = (const Entry*) p1.get();
+        const Entry *entry2 = (const Entry*) p2.get();
+        int res;
+        if (m_use_nkey) {
+            res = memcmp(entry1->GetNormalizedKey(),
+                         entry2->GetNormalizedKey(),
+                         std::min(entry1->m_nkey_len, entry2->m_nkey_len));
+            if (res == 0 && entry1->m_nkey_len != entry2->m_nkey_len) {
+                res = (entry1->m_nkey_len < entry2->m_nkey_len) ? -1 : 1;
+            }
+        } else {
+            res = ComparePayloads(entry1->GetPayload(), entry2->GetPayload());
+        }
+        if (res != 0) {
+            return res;
+        }
+        if (entry1->m_recid < entry2->m_recid) {
+            return -1;
+        }
+        return (entry1->m_recid == entry2->m_recid) ? 0 : 1;
+    };
+    std::sort(entries.begin(), entries.end(),
+        [&](const unique_malloced_ptr &p1,
+            const unique_malloced_ptr &p2) -> bool {
+            return cmp_entries(p1, p2) < 0;
+        });
+
+    const bool unique = m_idxdesc->GetIndexEntry()->idxunique();
+    for (size_t i = 1; i < entries.size(); ++i) {
+        const Entry *prev = (const Entry*) entries[i - 1].get();
+        const Entry *entry = (const Entry*) entries[i].get();
+        if (cmp_entries(entries[i - 1], entries[i]) == 0) {
+            LOG(kError, "duplicate (key, record ID) pair in index %s",
+                        m_idxdesc->GetIndexEntry()->idxname());
+        }
+        if (unique &&
+            ComparePayloads(prev->GetPayload(), entry->GetPayload()) == 0 &&
+            !PayloadHasAnyNull(entry->GetPayload())) {
+            LOG(kError, "duplicate key in unique index %s",
+                        m_idxdesc->GetIndexEntry()->idxname());
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(m_write_latch);
+    Node *root = m_root.load(memory_order_relaxed);
+    if (root->m_level != 0 || root->m_nkeys != 0) {
+        LOG(kError, "cannot bulk load into a non-empty volatile tree");
+    }
+
+    std::vector<Node*> rightmost;
+    rightmost.push_back(AllocateNode(0));
+    for (unique_malloced_ptr &entry : entries) {
+        BulkLoadAppendEntry(rightmost, 0, (const Entry*) entry.release(),
+                            nullptr);
+    }
+    for (Node *node : rightmost) {
+        ComputeNodeHeads(node);
+    }
+    m_root.store(rightmost.back(), memory_order_release);
+    m_epoch.Retire(root, FreeNode);
+}
+
+bool
+VolatileTree::PayloadHasAnyNull(const char *payload) const {
+    for (FieldId i = 0; i < m_nkeys; ++i) {
+        if (m_key_schema->FieldIsNull(i, payload)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<Index::Iterator>
+VolatileTree::StartScan(const IndexKey *lower,
+                        bool lower_isstrict,
+                        const IndexKey *upper,
+                        bool upper_isstrict) {
+    if ((lower && lower->GetNumKeys() > m_nkeys) ||
+        (upper && upper->GetNumKeys() > m_nkeys)) {
+        LOG(kError, "too many key columns in the scan bounds");
+    }
+
+    return std::unique_ptr<Index::Iterator>(
+        new Iterator(this, lower, lower_isstrict, upper, upper_isstrict));
+}
+
+}   // namespace taco
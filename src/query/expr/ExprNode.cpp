@@ -0,0 +1,291 @@
+#include "query/expr/ExprNode.h"
+
+#include "catalog/CatCache.h"
+
+namespace taco {
+
+ExprNode::ExprNode(ExprKind kind):
+    m_kind(kind),
+    m_bound(false),
+    m_typid(InvalidOid),
+    m_typparam(0),
+    m_field(InvalidFieldId),
+    m_value(Datum::FromNull()),
+    m_optype(OPTYPE(INVALID)),
+    m_funcid(InvalidOid),
+    m_func(nullptr) {}
+
+ExprNode::~ExprNode() {}
+
+std::unique_ptr<ExprNode>
+ExprNode::CreateColumn(FieldId field) {
+    std::unique_ptr<ExprNode> node(new ExprNode(ExprKind::Column));
+    node->m_field = field;
+    return node;
+}
+
+std::unique_ptr<ExprNode>
+ExprNode::CreateConstant(Datum value, Oid typid, uint64_t typparam) {
+    std::unique_ptr<ExprNode> node(new ExprNode(ExprKind::Constant));
+    node->m_typid = typid;
+    node->m_typparam = typparam;
+    if (value.HasExternalRef()) {
+        node->m_value = value.DeepCopy();
+    } else {
+        node->m_value = std::move(value);
+    }
+    return node;
+}
+
+std::unique_ptr<ExprNode>
+ExprNode::CreateOperator(OpType optype,
+                         std::unique_ptr<ExprNode> arg0,
+                         std::unique_ptr<ExprNode> arg1) {
+    if (optype == OPTYPE(CAST) || optype == OPTYPE(IMPLICIT_CAST)) {
+        LOG(kError, "use ExprNode::CreateCast() to create a cast");
+    }
+    if (!arg0 || (OpTypeIsUnary(optype) && arg1) ||
+        (OpTypeIsBinary(optype) && !arg1) ||
+        (!OpTypeIsUnary(optype) && !OpTypeIsBinary(optype))) {
+        LOG(kError, "wrong number of operands for operator %d(\"%s\")",
+                    (int) optype, GetOpTypeSymbol(optype));
+    }
+
+    std::unique_ptr<ExprNode> node(new ExprNode(ExprKind::Operator));
+    node->m_optype = optype;
+    node->m_args.emplace_back(std::move(arg0));
+    if (arg1) {
+        node->m_args.emplace_back(std::move(arg1));
+    }
+    return node;
+}
+
+std::unique_ptr<ExprNode>
+ExprNode::CreateCast(std::unique_ptr<ExprNode> arg,
+                     Oid typid,
+                     uint64_t typparam) {
+    if (!arg) {
+        LOG(kError, "missing operand for cast");
+    }
+    std::unique_ptr<ExprNode> node(new ExprNode(ExprKind::Operator));
+    node->m_optype = OPTYPE(CAST);
+    node->m_typid = typid;
+    node->m_typparam = typparam;
+    node->m_args.emplace_back(std::move(arg));
+    return node;
+}
+
+void
+ExprNode::Bind(const Schema *schema) {
+    switch (m_kind) {
+    case ExprKind::Column:
+        if (m_field >= schema->GetNumFields()) {
+            LOG(kError, "field " FIELDID_FORMAT " is out of bound [0, "
+                        FIELDID_FORMAT ")", m_field,
+                        schema->GetNumFields());
+        }
+        m_typid = schema->GetFieldTypeId(m_field);
+        m_typparam = schema->GetFieldTypeParam(m_field);
+        break;
+
+    case ExprKind::Constant:
+        break;
+
+    case ExprKind::Operator:
+        for (std::unique_ptr<ExprNode> &arg : m_args) {
+            arg->Bind(schema);
+        }
+        BindOperator();
+        m_bound = true;
+        FoldConstants();
+        return;
+    }
+    m_bound = true;
+}
+
+void
+ExprNode::BindOperator() {
+    const Oid arg0typid = m_args[0]->GetTypeId();
+    const Oid arg1typid =
+        (m_args.size() > 1) ? m_args[1]->GetTypeId() : InvalidOid;
+
+    if (m_optype == OPTYPE(AND) || m_optype == OPTYPE(OR) ||
+        m_optype == OPTYPE(NOT)) {
+        // These are evaluated by ExprProgram with the three-valued logic
+        // directly, but we still look up their functions for completeness.
+        if (arg0typid != initoids::TYP_BOOL ||
+            (m_args.size() > 1 && arg1typid != initoids::TYP_BOOL)) {
+            LOG(kError, "operands of %s must be BOOL",
+                        GetOpTypeSymbol(m_optype));
+        }
+    }
+
+    if (m_optype == OPTYPE(CAST)) {
+        if (arg0typid == m_typid &&
+            m_args[0]->GetTypeParam() == m_typparam) {
+            // A cast to the same type with the same type parameter is a
+            // no-op, and there's no operator for it.
+            m_funcid = InvalidOid;
+            m_func = nullptr;
+            return;
+        }
+        // The explicit casts include the implicit ones. A cast to the same
+        // type with a different type parameter, e.g., from VARCHAR(10) to
+        // VARCHAR(3), also needs the cast function to resize the value.
+        m_func = g_catcache->FindOperatorFunction(
+            OPTYPE(CAST), arg0typid, m_typid, &m_funcid);
+        if (!m_func) {
+            LOG(kError, "can't cast type " OID_FORMAT " to type " OID_FORMAT,
+                        arg0typid, m_typid);
+        }
+        return;
+    }
+
+    m_func = g_catcache->FindOperatorFunction(m_optype, arg0typid, arg1typid,
+                                              &m_funcid);
+    if (!m_func) {
+        LOG(kError, "operator %s is not defined for types " OID_FORMAT
+                    " and " OID_FORMAT, GetOpTypeSymbol(m_optype),
+                    arg0typid, arg1typid);
+    }
+    m_typid = g_catcache->FindFunction(m_funcid)->funcrettypid();
+    if (m_typid == arg0typid) {
+        m_typparam = m_args[0]->GetTypeParam();
+    } else if (m_args.size() > 1 && m_typid == arg1typid) {
+        m_typparam = m_args[1]->GetTypeParam();
+    } else {
+        m_typparam = 0;
+    }
+}
+
+void
+ExprNode::FoldConstants() {
+    bool all_constants = true;
+    for (const std::unique_ptr<ExprNode> &arg : m_args) {
+        if (arg->m_kind != ExprKind::Constant) {
+            all_constants = false;
+            break;
+        }
+    }
+    if (all_constants) {
+        MakeConstant(EvalConstantOperator());
+        return;
+    }
+
+    if (m_optype == OPTYPE(AND) || m_optype == OPTYPE(OR)) {
+        // x AND false = false and x OR true = true even if x is null, while
+        // x AND true = x and x OR false = x.
+        const bool absorbing = (m_optype == OPTYPE(OR));
+        for (size_t i = 0; i < 2; ++i) {
+            const ExprNode *arg = m_args[i].get();
+            if (arg->m_kind != ExprKind::Constant || arg->m_value.isnull()) {
+                continue;
+            }
+            if (arg->m_value.GetBool() == absorbing) {
+                MakeConstant(Datum::From(absorbing));
+            } else {
+                ReplaceWith(std::move(m_args[1 - i]));
+            }
+            return;
+        }
+    }
+}
+
+Datum
+ExprNode::EvalConstantOperator() {
+    if (!m_func) {
+        // a no-op cast
+        return std::move(m_args[0]->m_value);
+    }
+
+    // All the operator functions other than AND and OR are strict.
+    if (m_optype != OPTYPE(AND) && m_optype != OPTYPE(OR)) {
+        for (const std::unique_ptr<ExprNode> &arg : m_args) {
+            if (arg->m_value.isnull()) {
+                return Datum::FromNull();
+            }
+        }
+    }
+
+    Datum value = (m_args.size() == 1) ?
+        FunctionCallWithTypparam(m_func, m_typparam, m_args[0]->m_value) :
+        FunctionCallWithTypparam(m_func, m_typparam, m_args[0]->m_value,
+                                 m_args[1]->m_value);
+    // The result may reference the operands, which are about to be freed.
+    if (value.HasExternalRef()) {
+        return value.DeepCopy();
+    }
+    return value;
+}
+
+void
+ExprNode::MakeConstant(Datum value) {
+    m_kind = ExprKind::Constant;
+    // Datum's move assignment does not free the old value.
+    Datum old_value(std::move(m_value));
+    m_value = std::move(value);
+    m_optype = OPTYPE(INVALID);
+    m_args.clear();
+    m_funcid = InvalidOid;
+    m_func = nullptr;
+}
+
+void
+ExprNode::ReplaceWith(std::unique_ptr<ExprNode> node) {
+    ASSERT(node.get() != this);
+    m_kind = node->m_kind;
+    m_bound = node->m_bound;
+    m_typid = node->m_typid;
+    m_typparam = node->m_typparam;
+    m_field = node->m_field;
+    Datum old_value(std::move(m_value));
+    m_value = std::move(node->m_value);
+    m_optype = node->m_optype;
+    // The old operands of this node are freed along with node.
+    m_args.swap(node->m_args);
+    m_funcid = node->m_funcid;
+    m_func = node->m_func;
+}
+
+bool
+ExprNode::Equals(const ExprNode *other) const {
+    ASSERT(m_bound && other->m_bound);
+    if (this == other) {
+        return true;
+    }
+    if (m_kind != other->m_kind || m_typid != other->m_typid ||
+        m_typparam != other->m_typparam) {
+        return false;
+    }
+
+    switch (m_kind) {
+    case ExprKind::Column:
+        return m_field == other->m_field;
+
+    case ExprKind::Constant:
+        if (m_value.isnull() || other->m_value.isnull()) {
+            return m_value.isnull() && other->m_value.isnull();
+        }
+        if (g_catcache->FindType(m_typid)->typbyref()) {
+            return m_value.GetVarlenAsStringView() ==
+                   other->m_value.GetVarlenAsStringView();
+        }
+        return m_value.GetUInt64() == other->m_value.GetUInt64();
+
+    case ExprKind::Operator:
+        break;
+    }
+
+    if (m_optype != other->m_optype || m_funcid != other->m_funcid ||
+        m_args.size() != other->m_args.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < m_args.size(); ++i) {
+        if (!m_args[i]->Equals(other->m_args[i].get())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // namespace taco
@@ -0,0 +1,474 @@
+#include "query/expr/ExprProgram.h"
+
+#include "catalog/systables/initoids.h"
+
+namespace taco {
+
+/*!
+ * Replaces the value of the register \p reg with \p value, and frees the
+ * old value if the register owns it.
+ */
+static inline void
+SetRegister(Datum &reg, Datum &&value) {
+    Datum old(std::move(reg));
+    reg = std::move(value);
+}
+
+static inline void
+CallFunction(FunctionInfo func,
+             uint64_t typparam,
+             const NullableDatumRef *argv,
+             uint32_t nargs,
+             Datum &dst) {
+    FunctionCallInfo fcinfo{argv, nargs, typparam};
+    SetRegister(dst, func(fcinfo));
+}
+
+static size_t
+CountNodes(const ExprNode *node) {
+    size_t n = 1;
+    for (size_t i = 0; i < node->GetNumArgs(); ++i) {
+        n += CountNodes(node->GetArg(i));
+    }
+    return n;
+}
+
+ExprProgram::ExprProgram(const Schema *schema):
+    m_schema(schema),
+    m_nregs_used(0),
+    m_result(nullptr),
+    m_is_filter(false),
+    m_query_mctx(),
+    m_tuple_mctx(&m_query_mctx) {}
+
+ExprProgram::~ExprProgram() {}
+
+static void
+CheckBound(const ExprNode *expr) {
+    if (!expr->IsBound()) {
+        LOG(kError, "can't compile an unbound expression");
+    }
+}
+
+std::unique_ptr<ExprProgram>
+ExprProgram::Compile(const ExprNode *expr, const Schema *schema) {
+    CheckBound(expr);
+    std::unique_ptr<ExprProgram> prog(new ExprProgram(schema));
+    prog->AllocateRegisters({expr});
+    prog->m_result = prog->CompileNode(expr, false);
+    return prog;
+}
+
+std::unique_ptr<ExprProgram>
+ExprProgram::CompileFilter(const ExprNode *expr, const Schema *schema) {
+    CheckBound(expr);
+    if (expr->GetTypeId() != initoids::TYP_BOOL) {
+        LOG(kError, "a filter must be a BOOL expression");
+    }
+    std::unique_ptr<ExprProgram> prog(new ExprProgram(schema));
+    prog->AllocateRegisters({expr});
+    prog->m_is_filter = true;
+    prog->m_result = prog->CompileNode(expr, true);
+    return prog;
+}
+
+std::unique_ptr<ExprProgram>
+ExprProgram::CompileQuery(const ExprNode *qual,
+                          const std::vector<const ExprNode*> &targets,
+                          const Schema *schema) {
+    std::vector<const ExprNode*> roots(targets);
+    if (qual) {
+        CheckBound(qual);
+        if (qual->GetTypeId() != initoids::TYP_BOOL) {
+            LOG(kError, "a qualification must be a BOOL expression");
+        }
+        roots.push_back(qual);
+    }
+    for (const ExprNode *target : targets) {
+        CheckBound(target);
+    }
+
+    std::unique_ptr<ExprProgram> prog(new ExprProgram(schema));
+    prog->AllocateRegisters(roots);
+    prog->m_is_filter = true;
+    size_t exit_pc = 0;
+    if (qual) {
+        // The qualification is compiled first so that the targets may reuse
+        // its subexpressions.
+        prog->m_result = prog->CompileNode(qual, true);
+        if (!targets.empty()) {
+            prog->EmitInstruction(Opcode::ExitUnlessTrue, 0).m_args[0] =
+                prog->m_result;
+            exit_pc = prog->m_code.size();
+        }
+    }
+    for (const ExprNode *target : targets) {
+        prog->m_targets.push_back(prog->CompileNode(target, false));
+    }
+    if (exit_pc > 0) {
+        prog->m_code[exit_pc - 1].m_target = (uint32_t) prog->m_code.size();
+    }
+    return prog;
+}
+
+void
+ExprProgram::AllocateRegisters(const std::vector<const ExprNode*> &roots) {
+    // A node needs at most one register.
+    size_t nnodes = 0;
+    for (const ExprNode *root : roots) {
+        nnodes += CountNodes(root);
+    }
+    m_regs.reserve(nnodes);
+    for (size_t i = 0; i < nnodes; ++i) {
+        m_regs.emplace_back(Datum::FromNull());
+    }
+}
+
+ExprProgram::Instruction&
+ExprProgram::EmitInstruction(Opcode opcode, uint32_t dst) {
+    m_code.emplace_back();
+    Instruction &instr = m_code.back();
+    instr.m_opcode = opcode;
+    instr.m_null_exits = false;
+    instr.m_swapped = false;
+    instr.m_bool = false;
+    instr.m_field = InvalidFieldId;
+    instr.m_dst = dst;
+    instr.m_target = 0;
+    instr.m_first_term = 0;
+    instr.m_nterms = 0;
+    instr.m_args[0] = nullptr;
+    instr.m_args[1] = nullptr;
+    instr.m_func = nullptr;
+    instr.m_typparam = 0;
+    return instr;
+}
+
+bool
+ExprProgram::IsFieldConstOperator(const ExprNode *node,
+                                  FieldId &field,
+                                  const Datum *&value,
+                                  bool &swapped) {
+    if (node->GetKind() != ExprKind::Operator || node->GetNumArgs() != 2 ||
+        node->GetOpType() == OPTYPE(AND) || node->GetOpType() == OPTYPE(OR)) {
+        return false;
+    }
+    const ExprNode *arg0 = node->GetArg(0);
+    const ExprNode *arg1 = node->GetArg(1);
+    if (arg0->GetKind() == ExprKind::Column &&
+        arg1->GetKind() == ExprKind::Constant) {
+        field = arg0->GetField();
+        value = &arg1->GetValue();
+        swapped = false;
+        return true;
+    }
+    if (arg0->GetKind() == ExprKind::Constant &&
+        arg1->GetKind() == ExprKind::Column) {
+        field = arg1->GetField();
+        value = &arg0->GetValue();
+        swapped = true;
+        return true;
+    }
+    return false;
+}
+
+const Datum*
+ExprProgram::CompileNode(const ExprNode *node, bool is_filter_root) {
+    if (node->GetKind() == ExprKind::Constant) {
+        return &node->GetValue();
+    }
+
+    // The top AND of a filter may stop at a null operand before it finds a
+    // false one, so its value is not reusable.
+    const bool reusable = !is_filter_root ||
+        node->GetKind() != ExprKind::Operator ||
+        node->GetOpType() != OPTYPE(AND);
+    if (reusable) {
+        for (const auto &cse : m_cse) {
+            if (cse.first->Equals(node)) {
+                return cse.second;
+            }
+        }
+    }
+
+    const Datum *value;
+    if (node->GetKind() == ExprKind::Column) {
+        uint32_t dst = AllocateRegister();
+        EmitInstruction(Opcode::LoadField, dst).m_field = node->GetField();
+        value = &m_regs[dst];
+    } else {
+        value = CompileOperator(node, is_filter_root);
+    }
+    if (reusable) {
+        m_cse.emplace_back(node, value);
+    }
+    return value;
+}
+
+const Datum*
+ExprProgram::CompileOperator(const ExprNode *node, bool is_filter_root) {
+    OpType optype = node->GetOpType();
+    if (optype == OPTYPE(AND) || optype == OPTYPE(OR)) {
+        return CompileAndOr(node, is_filter_root);
+    }
+
+    if (optype == OPTYPE(NOT)) {
+        const Datum *arg0 = CompileNode(node->GetArg(0), false);
+        uint32_t dst = AllocateRegister();
+        EmitInstruction(Opcode::Not, dst).m_args[0] = arg0;
+        return &m_regs[dst];
+    }
+
+    if (!node->GetFunction()) {
+        // a no-op cast
+        return CompileNode(node->GetArg(0), false);
+    }
+
+    FieldId field;
+    const Datum *value;
+    bool swapped;
+    if (IsFieldConstOperator(node, field, value, swapped)) {
+        uint32_t dst = AllocateRegister();
+        Instruction &instr = EmitInstruction(Opcode::CallFieldConst, dst);
+        instr.m_field = field;
+        instr.m_args[1] = value;
+        instr.m_swapped = swapped;
+        instr.m_func = node->GetFunction();
+        instr.m_typparam = node->GetTypeParam();
+        return &m_regs[dst];
+    }
+
+    const Datum *args[2] = {nullptr, nullptr};
+    for (size_t i = 0; i < node->GetNumArgs(); ++i) {
+        args[i] = CompileNode(node->GetArg(i), false);
+    }
+    uint32_t dst = AllocateRegister();
+    Instruction &instr = EmitInstruction(
+        (node->GetNumArgs() == 1) ? Opcode::Call1 : Opcode::Call2, dst);
+    instr.m_args[0] = args[0];
+    instr.m_args[1] = args[1];
+    instr.m_func = node->GetFunction();
+    instr.m_typparam = node->GetTypeParam();
+    return &m_regs[dst];
+}
+
+const Datum*
+ExprProgram::CompileAndOr(const ExprNode *node, bool is_filter_root) {
+    const OpType optype = node->GetOpType();
+    const bool is_and = (optype == OPTYPE(AND));
+
+    // Flatten the nested ANDs or ORs into a list of operands.
+    std::vector<const ExprNode*> operands;
+    std::vector<const ExprNode*> stack{node};
+    while (!stack.empty()) {
+        const ExprNode *n = stack.back();
+        stack.pop_back();
+        if (n->GetKind() == ExprKind::Operator && n->GetOpType() == optype) {
+            // push in the reverse order to keep the operands in order
+            stack.push_back(n->GetArg(1));
+            stack.push_back(n->GetArg(0));
+        } else {
+            operands.push_back(n);
+        }
+    }
+
+    uint32_t dst = AllocateRegister();
+    EmitInstruction(Opcode::SetBool, dst).m_bool = is_and;
+    std::vector<size_t> exits;
+
+    if (is_and) {
+        // The comparisons of a field with a constant are checked first in
+        // one instruction, as they are the cheapest.
+        const uint32_t first_term = (uint32_t) m_terms.size();
+        std::vector<const ExprNode*> rest;
+        for (const ExprNode *operand : operands) {
+            FieldConstTerm term;
+            if (IsFieldConstOperator(operand, term.m_field, term.m_value,
+                                     term.m_swapped)) {
+                term.m_func = operand->GetFunction();
+                m_terms.push_back(term);
+            } else {
+                rest.push_back(operand);
+            }
+        }
+        if (m_terms.size() > first_term) {
+            Instruction &instr = EmitInstruction(Opcode::AndFieldConst, dst);
+            instr.m_first_term = first_term;
+            instr.m_nterms = (uint32_t) m_terms.size() - first_term;
+            instr.m_null_exits = is_filter_root;
+            exits.push_back(m_code.size() - 1);
+        }
+        operands.swap(rest);
+    }
+
+    // Only the subexpressions computed before the first exit are always
+    // computed when this AND or OR is.
+    size_t ncse = m_cse.size();
+    for (const ExprNode *operand : operands) {
+        const Datum *arg = CompileNode(operand, false);
+        if (exits.empty()) {
+            ncse = m_cse.size();
+        }
+        Instruction &instr = EmitInstruction(
+            is_and ? Opcode::AndStep : Opcode::OrStep, dst);
+        instr.m_args[0] = arg;
+        instr.m_null_exits = is_and && is_filter_root;
+        exits.push_back(m_code.size() - 1);
+    }
+
+    for (size_t pc : exits) {
+        m_code[pc].m_target = (uint32_t) m_code.size();
+    }
+    m_cse.erase(m_cse.begin() + ncse, m_cse.end());
+    return &m_regs[dst];
+}
+
+NullableDatumRef
+ExprProgram::Eval(const char *payload) {
+    ASSERT(!m_is_filter);
+    Run(payload);
+    return NullableDatumRef(*m_result);
+}
+
+bool
+ExprProgram::EvalFilter(const char *payload) {
+    ASSERT(m_is_filter && m_result);
+    Run(payload);
+    return !m_result->isnull() && m_result->GetBool();
+}
+
+bool
+ExprProgram::EvalQuery(const char *payload) {
+    ASSERT(m_is_filter);
+    Run(payload);
+    return !m_result || (!m_result->isnull() && m_result->GetBool());
+}
+
+void
+ExprProgram::Run(const char *payload) {
+    // The registers never own what they reference in the per-tuple context,
+    // and the values of the last record are not valid after this.
+    m_tuple_mctx.Reset();
+    ScopedMemoryContext scoped_mctx(&m_tuple_mctx);
+
+    const Instruction *code = m_code.data();
+    const uint32_t ninstrs = (uint32_t) m_code.size();
+    uint32_t pc = 0;
+    while (pc < ninstrs) {
+        const Instruction &instr = code[pc++];
+        Datum &dst = m_regs[instr.m_dst];
+        switch (instr.m_opcode) {
+        case Opcode::LoadField:
+            SetRegister(dst, m_schema->GetField(instr.m_field, payload));
+            break;
+
+        case Opcode::Call1:
+        {
+            if (instr.m_args[0]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+                break;
+            }
+            NullableDatumRef argv[1] = {*instr.m_args[0]};
+            CallFunction(instr.m_func, instr.m_typparam, argv, 1, dst);
+            break;
+        }
+
+        case Opcode::Call2:
+        {
+            if (instr.m_args[0]->isnull() || instr.m_args[1]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+                break;
+            }
+            NullableDatumRef argv[2] = {*instr.m_args[0], *instr.m_args[1]};
+            CallFunction(instr.m_func, instr.m_typparam, argv, 2, dst);
+            break;
+        }
+
+        case Opcode::CallFieldConst:
+        {
+            Datum field = m_schema->GetField(instr.m_field, payload);
+            if (field.isnull() || instr.m_args[1]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+                break;
+            }
+            const Datum &arg0 = instr.m_swapped ? *instr.m_args[1] : field;
+            const Datum &arg1 = instr.m_swapped ? field : *instr.m_args[1];
+            NullableDatumRef argv[2] = {arg0, arg1};
+            CallFunction(instr.m_func, instr.m_typparam, argv, 2, dst);
+            break;
+        }
+
+        case Opcode::Not:
+            if (instr.m_args[0]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+            } else {
+                SetRegister(dst, Datum::From(!instr.m_args[0]->GetBool()));
+            }
+            break;
+
+        case Opcode::SetBool:
+            SetRegister(dst, Datum::From(instr.m_bool));
+            break;
+
+        case Opcode::AndStep:
+            if (instr.m_args[0]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+                if (instr.m_null_exits) {
+                    pc = instr.m_target;
+                }
+            } else if (!instr.m_args[0]->GetBool()) {
+                SetRegister(dst, Datum::From(false));
+                pc = instr.m_target;
+            }
+            break;
+
+        case Opcode::OrStep:
+            if (instr.m_args[0]->isnull()) {
+                SetRegister(dst, Datum::FromNull());
+            } else if (instr.m_args[0]->GetBool()) {
+                SetRegister(dst, Datum::From(true));
+                pc = instr.m_target;
+            }
+            break;
+
+        case Opcode::AndFieldConst:
+        {
+            const FieldConstTerm *term = m_terms.data() + instr.m_first_term;
+            const FieldConstTerm *end = term + instr.m_nterms;
+            for (; term != end; ++term) {
+                Datum field = m_schema->GetField(term->m_field, payload);
+                bool isnull = field.isnull() || term->m_value->isnull();
+                if (!isnull) {
+                    const Datum &arg0 = term->m_swapped ? *term->m_value
+                                                        : field;
+                    const Datum &arg1 = term->m_swapped ? field
+                                                        : *term->m_value;
+                    Datum res = FunctionCall(term->m_func, arg0, arg1);
+                    if (!res.isnull() && !res.GetBool()) {
+                        SetRegister(dst, Datum::From(false));
+                        pc = instr.m_target;
+                        break;
+                    }
+                    isnull = res.isnull();
+                }
+                if (isnull) {
+                    SetRegister(dst, Datum::FromNull());
+                    if (instr.m_null_exits) {
+                        pc = instr.m_target;
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+
+        case Opcode::ExitUnlessTrue:
+            if (instr.m_args[0]->isnull() || !instr.m_args[0]->GetBool()) {
+                pc = instr.m_target;
+            }
+            break;
+        }
+    }
+}
+
+}   // namespace taco
@@ -0,0 +1,501 @@
+#include "storage/TableSynopsis.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <absl/flags/flag.h>
+
+#include "catalog/CatCache.h"
+#include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+
+ABSL_FLAG(uint32_t, synopsis_pages_per_range, 32,
+          "The number of pages in a range summarized by a table synopsis");
+ABSL_FLAG(uint32_t, synopsis_bloom_bytes, 2048,
+          "The size in bytes of a Bloom filter of a range in a table "
+          "synopsis, which must be a power of 2 no less than 32");
+
+namespace taco {
+
+constexpr size_t TableSynopsis::BloomBlockSize;
+
+namespace {
+
+constexpr uint64_t SYNOPSIS_MAGIC = 0x73796e6f70736973ul;
+constexpr uint32_t SYNOPSIS_VERSION = 1;
+
+/*!
+ * The header of a table synopsis side file. It is followed by the column
+ * IDs of the Bloom filters and then the ranges. Each range starts with a
+ * SynopsisRange header, followed by the null counts of the columns, the
+ * minimum and the maximum values as payloads, and the Bloom filters. All of
+ * these are MAXALIGN'd.
+ */
+struct SynopsisFileHeader {
+    uint64_t    m_magic;
+    uint32_t    m_version;
+
+    //! The CRC32C of everything after the header.
+    uint32_t    m_crc;
+
+    //! The number of bytes after the header.
+    uint64_t    m_length;
+
+    uint64_t    m_nranges;
+    uint32_t    m_pages_per_range;
+    uint32_t    m_bloom_bytes;
+    FieldId     m_nfields;
+    FieldId     m_nbloom_fields;
+};
+
+struct SynopsisRange {
+    uint64_t    m_range;
+    uint64_t    m_nrecs;
+    uint32_t    m_min_len;
+    uint32_t    m_max_len;
+};
+
+/*!
+ * The salts of the split block Bloom filter in the Parquet format. Each one
+ * picks a bit in one of the 8 words of a block.
+ */
+constexpr uint32_t BloomSalts[8] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+}   // anonymous namespace
+
+std::unique_ptr<TableSynopsis>
+TableSynopsis::Create(const Schema *schema,
+                      std::vector<FieldId> bloom_fields,
+                      std::string path) {
+    uint32_t pages_per_range = absl::GetFlag(FLAGS_synopsis_pages_per_range);
+    uint32_t bloom_bytes = absl::GetFlag(FLAGS_synopsis_bloom_bytes);
+    if (pages_per_range == 0) {
+        LOG(kError, "invalid number of pages per synopsis range: %u",
+                    pages_per_range);
+    }
+    if (bloom_bytes < BloomBlockSize ||
+        (bloom_bytes & (bloom_bytes - 1)) != 0) {
+        LOG(kError, "invalid synopsis Bloom filter size: %u", bloom_bytes);
+    }
+    return std::unique_ptr<TableSynopsis>(
+        new TableSynopsis(schema, std::move(bloom_fields), std::move(path),
+                          pages_per_range, bloom_bytes));
+}
+
+std::unique_ptr<TableSynopsis>
+TableSynopsis::Open(const Schema *schema, std::string path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        char *errstr = strerror(errno);
+        LOG(kError, "unable to open table synopsis file %s: %s", path,
+                    errstr);
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        char *errstr = strerror(errno);
+        close(fd);
+        LOG(kError, "unable to stat table synopsis file %s: %s", path,
+                    errstr);
+    }
+    maxaligned_char_buf bytes;
+    bytes.resize(st.st_size);
+    ssize_t nread = pread(fd, bytes.data(), st.st_size, 0);
+    close(fd);
+    if (nread != st.st_size) {
+        LOG(kError, "unable to read table synopsis file %s", path);
+    }
+
+    const SynopsisFileHeader *hdr = (const SynopsisFileHeader*) bytes.data();
+    const char *body = bytes.data() + MAXALIGN(sizeof(SynopsisFileHeader));
+    if ((size_t) st.st_size < MAXALIGN(sizeof(SynopsisFileHeader)) ||
+        hdr->m_magic != SYNOPSIS_MAGIC ||
+        hdr->m_version != SYNOPSIS_VERSION ||
+        hdr->m_length !=
+            st.st_size - MAXALIGN(sizeof(SynopsisFileHeader)) ||
+        CRC32C(0, body, hdr->m_length) != hdr->m_crc) {
+        LOG(kError, "invalid table synopsis file %s", path);
+    }
+    if (hdr->m_nfields != schema->GetNumFields() ||
+        hdr->m_pages_per_range == 0 ||
+        hdr->m_bloom_bytes < BloomBlockSize ||
+        (hdr->m_bloom_bytes & (hdr->m_bloom_bytes - 1)) != 0 ||
+        MAXALIGN(hdr->m_nbloom_fields * sizeof(FieldId)) > hdr->m_length) {
+        LOG(kError, "table synopsis file %s does not match the table", path);
+    }
+
+    std::vector<FieldId> bloom_fields((const FieldId*) body,
+                                      ((const FieldId*) body) +
+                                        hdr->m_nbloom_fields);
+    size_t off = MAXALIGN(hdr->m_nbloom_fields * sizeof(FieldId));
+    std::unique_ptr<TableSynopsis> synopsis(
+        new TableSynopsis(schema, std::move(bloom_fields), std::move(path),
+                          hdr->m_pages_per_range, hdr->m_bloom_bytes));
+    if (!synopsis->DeserializeRanges(body + off, hdr->m_length - off,
+                                     hdr->m_nranges)) {
+        LOG(kError, "invalid table synopsis file %s", synopsis->m_path);
+    }
+    return synopsis;
+}
+
+TableSynopsis::TableSynopsis(const Schema *schema,
+                             std::vector<FieldId> bloom_fields,
+                             std::string path,
+                             uint32_t pages_per_range,
+                             uint32_t bloom_bytes):
+    m_schema(schema),
+    m_bloom_fields(std::move(bloom_fields)),
+    m_path(std::move(path)),
+    m_pages_per_range(pages_per_range),
+    m_bloom_bytes(bloom_bytes) {
+    const FieldId nfields = schema->GetNumFields();
+    std::vector<Oid> typid;
+    std::vector<uint64_t> typparam;
+    typid.reserve(nfields);
+    typparam.reserve(nfields);
+    m_lt_funcs.reserve(nfields);
+    m_eq_funcs.reserve(nfields);
+    for (FieldId i = 0; i < nfields; ++i) {
+        Oid t = schema->GetFieldTypeId(i);
+        typid.push_back(t);
+        typparam.push_back(schema->GetFieldTypeParam(i));
+        m_lt_funcs.push_back(
+            g_catcache->FindOperatorFunction(OPTYPE(LT), t, t));
+        m_eq_funcs.push_back(
+            g_catcache->FindOperatorFunction(OPTYPE(EQ), t, t));
+    }
+    m_bound_schema.reset(Schema::Create(typid, typparam,
+                                        std::vector<bool>(nfields, true)));
+    m_bound_schema->ComputeLayout();
+
+    m_bloom_idx.resize(nfields, -1);
+    m_hash_funcs.reserve(m_bloom_fields.size());
+    for (size_t i = 0; i < m_bloom_fields.size(); ++i) {
+        FieldId field = m_bloom_fields[i];
+        if (field < 0 || field >= nfields || m_bloom_idx[field] != -1) {
+            LOG(kError, "invalid column %d for a synopsis Bloom filter",
+                        (int) field);
+        }
+        const SysTable_Type *typ = g_catcache->FindType(typid[field]);
+        if (!typ || typ->typhashfunc() == InvalidOid) {
+            LOG(kError, "type " OID_FORMAT " of column %d does not have a "
+                        "hash function", typid[field], (int) field);
+        }
+        m_bloom_idx[field] = (int) i;
+        m_hash_funcs.push_back(FindBuiltinFunction(typ->typhashfunc()));
+    }
+}
+
+TableSynopsis::~TableSynopsis() {}
+
+const TableSynopsis::RangeSynopsis*
+TableSynopsis::FindRange(uint64_t range) const {
+    auto iter = m_ranges.find(range);
+    if (iter == m_ranges.end()) {
+        return nullptr;
+    }
+    return iter->second.get();
+}
+
+TableSynopsis::RangeSynopsis*
+TableSynopsis::GetOrCreateRange(uint64_t range) {
+    std::unique_ptr<RangeSynopsis> &rsyn = m_ranges[range];
+    if (!rsyn) {
+        const FieldId nfields = m_schema->GetNumFields();
+        rsyn.reset(new RangeSynopsis());
+        rsyn->m_nrecs = 0;
+        rsyn->m_min.reserve(nfields);
+        rsyn->m_max.reserve(nfields);
+        for (FieldId i = 0; i < nfields; ++i) {
+            rsyn->m_min.emplace_back(Datum::FromNull());
+            rsyn->m_max.emplace_back(Datum::FromNull());
+        }
+        rsyn->m_nnulls.resize(nfields, 0);
+        rsyn->m_bloom.resize(
+            m_bloom_fields.size() * m_bloom_bytes / sizeof(uint32_t), 0);
+    }
+    return rsyn.get();
+}
+
+void
+TableSynopsis::BloomInsert(uint32_t *filter, uint64_t hash) const {
+    // The high bits pick the block and the low bits pick the bits in it.
+    const uint64_t nblocks = m_bloom_bytes / BloomBlockSize;
+    uint32_t *block = filter + ((hash >> 32) * nblocks >> 32) *
+                               (BloomBlockSize / sizeof(uint32_t));
+    const uint32_t key = (uint32_t) hash;
+    for (int i = 0; i < 8; ++i) {
+        block[i] |= ((uint32_t) 1) << ((key * BloomSalts[i]) >> 27);
+    }
+}
+
+bool
+TableSynopsis::BloomMayContain(const uint32_t *filter, uint64_t hash) const {
+    const uint64_t nblocks = m_bloom_bytes / BloomBlockSize;
+    const uint32_t *block = filter + ((hash >> 32) * nblocks >> 32) *
+                                     (BloomBlockSize / sizeof(uint32_t));
+    const uint32_t key = (uint32_t) hash;
+    uint32_t missing = 0;
+    for (int i = 0; i < 8; ++i) {
+        missing |= ~block[i] &
+                   (((uint32_t) 1) << ((key * BloomSalts[i]) >> 27));
+    }
+    return missing == 0;
+}
+
+void
+TableSynopsis::InsertRecord(const Record &rec) {
+    if (!rec.GetRecordId().IsValid()) {
+        LOG(kError, "cannot add a record without a valid record ID to a "
+                    "table synopsis");
+    }
+    const FieldId nfields = m_schema->GetNumFields();
+    std::vector<Datum> data = m_schema->DissemblePayload(rec.GetData());
+
+    // The hash values do not depend on the synopsis, so they are computed
+    // before latching.
+    std::vector<uint64_t> hashes;
+    hashes.reserve(m_bloom_fields.size());
+    for (size_t i = 0; i < m_bloom_fields.size(); ++i) {
+        const Datum &d = data[m_bloom_fields[i]];
+        hashes.push_back(d.isnull() ? 0 :
+                         FunctionCall(m_hash_funcs[i], d).GetUInt64());
+    }
+
+    std::lock_guard<std::mutex> guard(m_latch);
+    RangeSynopsis *rsyn =
+        GetOrCreateRange(GetRangeOfPage(rec.GetRecordId().pid));
+    ++rsyn->m_nrecs;
+    for (FieldId i = 0; i < nfields; ++i) {
+        const Datum &d = data[i];
+        if (d.isnull()) {
+            ++rsyn->m_nnulls[i];
+            continue;
+        }
+        if (!m_lt_funcs[i]) {
+            continue;
+        }
+        if (rsyn->m_min[i].isnull() ||
+            FunctionCall(m_lt_funcs[i], d, rsyn->m_min[i]).GetBool()) {
+            rsyn->m_min[i] = d.DeepCopy();
+        }
+        if (rsyn->m_max[i].isnull() ||
+            FunctionCall(m_lt_funcs[i], rsyn->m_max[i], d).GetBool()) {
+            rsyn->m_max[i] = d.DeepCopy();
+        }
+    }
+    for (size_t i = 0; i < m_bloom_fields.size(); ++i) {
+        if (!data[m_bloom_fields[i]].isnull()) {
+            BloomInsert(GetBloomFilter(rsyn, i), hashes[i]);
+        }
+    }
+}
+
+bool
+TableSynopsis::RangeMayMatch(uint64_t range,
+                             FieldId field,
+                             OpType optype,
+                             const NullableDatumRef &value) const {
+    ASSERT(field >= 0 && field < m_schema->GetNumFields());
+    if (value.isnull()) {
+        return false;
+    }
+    int bloom_idx = m_bloom_idx[field];
+    uint64_t hash = 0;
+    if (optype == OPTYPE(EQ) && bloom_idx >= 0) {
+        hash = FunctionCall(m_hash_funcs[bloom_idx], value).GetUInt64();
+    }
+
+    std::lock_guard<std::mutex> guard(m_latch);
+    const RangeSynopsis *rsyn = FindRange(range);
+    if (!rsyn || rsyn->m_nnulls[field] == rsyn->m_nrecs) {
+        return false;
+    }
+    if (optype == OPTYPE(EQ) && bloom_idx >= 0 &&
+        !BloomMayContain(GetBloomFilter(rsyn, bloom_idx), hash)) {
+        return false;
+    }
+    if (!m_lt_funcs[field]) {
+        return true;
+    }
+
+    const Datum &min = rsyn->m_min[field];
+    const Datum &max = rsyn->m_max[field];
+    FunctionInfo lt = m_lt_funcs[field];
+    switch (optype) {
+    case OPTYPE(EQ):
+        return !FunctionCall(lt, value, min).GetBool() &&
+               !FunctionCall(lt, max, value).GetBool();
+    case OPTYPE(NE):
+        return !m_eq_funcs[field] ||
+               !FunctionCall(m_eq_funcs[field], min, max).GetBool() ||
+               !FunctionCall(m_eq_funcs[field], min, value).GetBool();
+    case OPTYPE(LT):
+        return FunctionCall(lt, min, value).GetBool();
+    case OPTYPE(LE):
+        return !FunctionCall(lt, value, min).GetBool();
+    case OPTYPE(GT):
+        return FunctionCall(lt, value, max).GetBool();
+    case OPTYPE(GE):
+        return !FunctionCall(lt, max, value).GetBool();
+    }
+    return true;
+}
+
+bool
+TableSynopsis::RangeMayHaveNull(uint64_t range, FieldId field) const {
+    ASSERT(field >= 0 && field < m_schema->GetNumFields());
+    std::lock_guard<std::mutex> guard(m_latch);
+    const RangeSynopsis *rsyn = FindRange(range);
+    return rsyn && rsyn->m_nnulls[field] > 0;
+}
+
+uint64_t
+TableSynopsis::GetNumRecordsInRange(uint64_t range) const {
+    std::lock_guard<std::mutex> guard(m_latch);
+    const RangeSynopsis *rsyn = FindRange(range);
+    return rsyn ? rsyn->m_nrecs : 0;
+}
+
+void
+TableSynopsis::SerializeRanges(maxaligned_char_buf &body) const {
+    auto append = [&](const void *data, size_t len) {
+        body.insert(body.end(), (const char*) data, (const char*) data + len);
+        body.resize(MAXALIGN(body.size()), 0);
+    };
+
+    // The ranges are written in order so that the file is deterministic.
+    std::vector<uint64_t> ranges;
+    ranges.reserve(m_ranges.size());
+    for (const auto &p : m_ranges) {
+        ranges.push_back(p.first);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    maxaligned_char_buf min_buf;
+    maxaligned_char_buf max_buf;
+    for (uint64_t range : ranges) {
+        const RangeSynopsis *rsyn = FindRange(range);
+        min_buf.clear();
+        max_buf.clear();
+        FieldOffset min_len =
+            m_bound_schema->WritePayloadToBuffer(rsyn->m_min, min_buf);
+        FieldOffset max_len =
+            m_bound_schema->WritePayloadToBuffer(rsyn->m_max, max_buf);
+        if (min_len == -1 || max_len == -1) {
+            LOG(kError, "unable to write the bounds of range %lu to table "
+                        "synopsis file %s", range, m_path);
+        }
+
+        SynopsisRange rhdr;
+        memset(&rhdr, 0, sizeof(SynopsisRange));
+        rhdr.m_range = range;
+        rhdr.m_nrecs = rsyn->m_nrecs;
+        rhdr.m_min_len = min_len;
+        rhdr.m_max_len = max_len;
+        append(&rhdr, sizeof(SynopsisRange));
+        append(rsyn->m_nnulls.data(), rsyn->m_nnulls.size() * sizeof(uint64_t));
+        append(min_buf.data(), min_len);
+        append(max_buf.data(), max_len);
+        append(rsyn->m_bloom.data(), rsyn->m_bloom.size() * sizeof(uint32_t));
+    }
+}
+
+bool
+TableSynopsis::DeserializeRanges(const char *body,
+                                 size_t len,
+                                 uint64_t nranges) {
+    const FieldId nfields = m_schema->GetNumFields();
+    const size_t nnulls_len = MAXALIGN(nfields * sizeof(uint64_t));
+    const size_t bloom_len = m_bloom_fields.size() * m_bloom_bytes;
+    size_t off = 0;
+    for (uint64_t n = 0; n < nranges; ++n) {
+        if (len - off < MAXALIGN(sizeof(SynopsisRange))) {
+            return false;
+        }
+        const SynopsisRange *rhdr = (const SynopsisRange*)(body + off);
+        off += MAXALIGN(sizeof(SynopsisRange));
+        if (len - off < nnulls_len + bloom_len ||
+            len - off - nnulls_len - bloom_len <
+                (size_t) MAXALIGN(rhdr->m_min_len) +
+                MAXALIGN(rhdr->m_max_len) ||
+            m_ranges.count(rhdr->m_range)) {
+            return false;
+        }
+
+        RangeSynopsis *rsyn = GetOrCreateRange(rhdr->m_range);
+        rsyn->m_nrecs = rhdr->m_nrecs;
+        memcpy(rsyn->m_nnulls.data(), body + off, nfields * sizeof(uint64_t));
+        off += nnulls_len;
+        for (FieldId i = 0; i < nfields; ++i) {
+            rsyn->m_min[i] = m_bound_schema->GetField(i, body + off).DeepCopy();
+        }
+        off += MAXALIGN(rhdr->m_min_len);
+        for (FieldId i = 0; i < nfields; ++i) {
+            rsyn->m_max[i] = m_bound_schema->GetField(i, body + off).DeepCopy();
+        }
+        off += MAXALIGN(rhdr->m_max_len);
+        memcpy(rsyn->m_bloom.data(), body + off, bloom_len);
+        off += bloom_len;
+    }
+    return off == len;
+}
+
+void
+TableSynopsis::Flush() {
+    maxaligned_char_buf body;
+    SynopsisFileHeader hdr;
+    memset(&hdr, 0, sizeof(SynopsisFileHeader));
+    hdr.m_magic = SYNOPSIS_MAGIC;
+    hdr.m_version = SYNOPSIS_VERSION;
+    hdr.m_pages_per_range = m_pages_per_range;
+    hdr.m_bloom_bytes = m_bloom_bytes;
+    hdr.m_nfields = m_schema->GetNumFields();
+    hdr.m_nbloom_fields = (FieldId) m_bloom_fields.size();
+    body.insert(body.end(), (const char*) m_bloom_fields.data(),
+                (const char*)(m_bloom_fields.data() + m_bloom_fields.size()));
+    body.resize(MAXALIGN(body.size()), 0);
+    {
+        std::lock_guard<std::mutex> guard(m_latch);
+        hdr.m_nranges = m_ranges.size();
+        SerializeRanges(body);
+    }
+    hdr.m_length = body.size();
+    hdr.m_crc = CRC32C(0, body.data(), body.size());
+
+    // Write to a temporary file first so that a reader never sees a
+    // partially written synopsis.
+    char hdr_buf[MAXALIGN(sizeof(SynopsisFileHeader))];
+    memset(hdr_buf, 0, sizeof(hdr_buf));
+    memcpy(hdr_buf, &hdr, sizeof(SynopsisFileHeader));
+    std::string tmpfile = m_path + ".tmp";
+    int fd = open(tmpfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        char *errstr = strerror(errno);
+        LOG(kError, "unable to create %s: %s", tmpfile, errstr);
+    }
+    if (write(fd, hdr_buf, sizeof(hdr_buf)) != (ssize_t) sizeof(hdr_buf) ||
+        write(fd, body.data(), body.size()) != (ssize_t) body.size()) {
+        char *errstr = strerror(errno);
+        close(fd);
+        LOG(kError, "unable to write %s: %s", tmpfile, errstr);
+    }
+#ifdef FORCE_FSYNC
+    if (fsync(fd)) {
+        char *errstr = strerror(errno);
+        close(fd);
+        LOG(kError, "unable to fsync %s: %s", tmpfile, errstr);
+    }
+#endif
+    close(fd);
+    if (rename(tmpfile.c_str(), m_path.c_str())) {
+        char *errstr = strerror(errno);
+        LOG(kError, "unable to rename %s to %s: %s", tmpfile, m_path, errstr);
+    }
+}
+
+}   // namespace taco
@@ -0,0 +1,132 @@
+#include "utils/EpochManager.h"
+
+namespace taco {
+
+constexpr size_t EpochManager::MaxThreads;
+constexpr uint64_t EpochManager::InactiveEpoch;
+constexpr size_t EpochManager::InvalidThreadSlotIndex;
+constexpr size_t EpochManager::ReclaimInterval;
+
+thread_local size_t EpochManager::t_thread_slot_index =
+    EpochManager::InvalidThreadSlotIndex;
+
+namespace {
+
+std::mutex s_thread_slot_latch;
+bool s_thread_slot_used[EpochManager::MaxThreads];
+
+/*!
+ * Releases the thread slot index of a thread when it exits.
+ */
+struct ThreadSlotReleaser {
+    size_t  m_index;
+
+    ~ThreadSlotReleaser() {
+        std::lock_guard<std::mutex> guard(s_thread_slot_latch);
+        s_thread_slot_used[m_index] = false;
+    }
+};
+
+}   // namespace
+
+size_t
+EpochManager::AssignThreadSlotIndex() {
+    size_t index = InvalidThreadSlotIndex;
+    {
+        std::lock_guard<std::mutex> guard(s_thread_slot_latch);
+        for (size_t i = 0; i < MaxThreads; ++i) {
+            if (!s_thread_slot_used[i]) {
+                s_thread_slot_used[i] = true;
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index == InvalidThreadSlotIndex) {
+        LOG(kFatal, "too many threads using epoch managers (max %lu)",
+                    MaxThreads);
+    }
+
+    static thread_local ThreadSlotReleaser releaser;
+    releaser.m_index = index;
+    t_thread_slot_index = index;
+    return index;
+}
+
+EpochManager::EpochManager():
+    m_global_epoch(1) {
+    for (size_t i = 0; i < MaxThreads; ++i) {
+        m_slots[i].m_epoch.store(InactiveEpoch, memory_order_relaxed);
+        m_slots[i].m_nesting = 0;
+    }
+}
+
+EpochManager::~EpochManager() {
+    for (const RetiredObject &obj : m_retired) {
+        obj.m_deleter(obj.m_ptr);
+    }
+}
+
+void
+EpochManager::Retire(void *p, void (*deleter)(void*)) {
+    // Any reader that enters after the epoch advances can't see p, as it
+    // has been unlinked before this.
+    uint64_t epoch = m_global_epoch.fetch_add(1, memory_order_acq_rel);
+    bool reclaim;
+    {
+        std::lock_guard<std::mutex> guard(m_retire_latch);
+        m_retired.push_back(RetiredObject{p, deleter, epoch});
+        // Reclaiming scans all the thread slots, so it is only done once
+        // in a while.
+        reclaim = (m_retired.size() % ReclaimInterval == 0);
+    }
+    if (reclaim) {
+        Reclaim();
+    }
+}
+
+void
+EpochManager::Reclaim() {
+    std::vector<RetiredObject> to_free;
+    {
+        std::lock_guard<std::mutex> guard(m_retire_latch);
+        if (m_retired.empty()) {
+            return ;
+        }
+
+        std::atomic_thread_fence(memory_order_seq_cst);
+        uint64_t min_epoch = InactiveEpoch;
+        for (size_t i = 0; i < MaxThreads; ++i) {
+            uint64_t epoch = m_slots[i].m_epoch.load(memory_order_acquire);
+            if (epoch < min_epoch) {
+                min_epoch = epoch;
+            }
+        }
+
+        // An object retired in epoch e may only be seen by the readers that
+        // entered in epoch e or earlier.
+        size_t n = 0;
+        for (size_t i = 0; i < m_retired.size(); ++i) {
+            if (m_retired[i].m_epoch < min_epoch) {
+                to_free.push_back(m_retired[i]);
+            } else {
+                m_retired[n++] = m_retired[i];
+            }
+        }
+        m_retired.resize(n);
+    }
+
+    // The deleters may retire more objects, so they are called without
+    // holding the latch.
+    for (const RetiredObject &obj : to_free) {
+        obj.m_deleter(obj.m_ptr);
+    }
+}
+
+size_t
+EpochManager::GetNumRetired() {
+    std::lock_guard<std::mutex> guard(m_retire_latch);
+    return m_retired.size();
+}
+
+}   // namespace taco
@@ -0,0 +1,315 @@
+#include "utils/ExternalSort.h"
+
+#include <absl/flags/flag.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "utils/fsutils.h"
+
+ABSL_FLAG(uint64_t, sort_mem, 64 * 1024 * 1024,
+          "The default memory limit in bytes of an external sort");
+
+ABSL_FLAG(std::string, sort_tmpdir, "/tmp",
+          "The directory for the temporary files of external sorts");
+
+namespace taco {
+
+constexpr size_t ExternalSort::RunBufferSize;
+
+//! The smallest memory limit of an external sort, which allows merging at
+//! least 3 runs at a time.
+static constexpr size_t MinSortMemLimit = 1024 * 1024;
+
+size_t
+ExternalSort::GetDefaultMemLimit() {
+    return absl::GetFlag(FLAGS_sort_mem);
+}
+
+ExternalSort::ExternalSort(Comparator cmp, size_t mem_limit):
+    m_cmp(std::move(cmp)),
+    m_mem_limit(std::max(mem_limit, MinSortMemLimit)),
+    m_max_fan_in(m_mem_limit / RunBufferSize - 1),
+    m_next_offset_idx(0),
+    m_num_runs(0),
+    m_num_intermediate_merges(0),
+    m_sorted(false),
+    m_merge_started(false),
+    m_cur_item(nullptr),
+    m_cur_item_len(0) {}
+
+ExternalSort::~ExternalSort() {
+    for (int fd : m_runs) {
+        close(fd);
+    }
+    for (RunReader &reader : m_inputs) {
+        close(reader.m_fd);
+    }
+}
+
+void
+ExternalSort::AddItem(const char *item, uint32_t len) {
+    ASSERT(!m_sorted);
+    // The buffer of the run being written is also counted against the memory
+    // limit.
+    size_t item_space = MAXALIGN(sizeof(uint32_t)) + MAXALIGN(len);
+    if (!m_offsets.empty() &&
+        m_buf.size() + item_space +
+        (m_offsets.size() + 1) * sizeof(size_t) >
+        m_mem_limit - RunBufferSize) {
+        WriteRun();
+    }
+
+    size_t offset = m_buf.size();
+    m_buf.resize(offset + item_space);
+    memcpy(&m_buf[offset], &len, sizeof(uint32_t));
+    memcpy(&m_buf[offset + MAXALIGN(sizeof(uint32_t))], item, len);
+    m_offsets.push_back(offset);
+}
+
+void
+ExternalSort::SortBuffer() {
+    const char *buf = m_buf.data();
+    std::sort(m_offsets.begin(), m_offsets.end(),
+        [&](size_t off1, size_t off2) -> bool {
+            return m_cmp(buf + off1 + MAXALIGN(sizeof(uint32_t)),
+                         buf + off2 + MAXALIGN(sizeof(uint32_t))) < 0;
+        });
+}
+
+int
+ExternalSort::CreateRunFile() {
+    std::string path = mktempfile(absl::GetFlag(FLAGS_sort_tmpdir) +
+                                  "/tdb_sort.");
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        char *errstr = strerror(errno);
+        LOG(kFatal, "unable to open temporary file %s: %s", path, errstr);
+    }
+    unlink(path.c_str());
+    return fd;
+}
+
+void
+ExternalSort::WriteToRun(int fd, const void *data, size_t len) {
+    if (m_write_buf.size() + len > RunBufferSize) {
+        FlushRun(fd);
+    }
+    size_t offset = m_write_buf.size();
+    m_write_buf.resize(offset + len);
+    memcpy(&m_write_buf[offset], data, len);
+}
+
+void
+ExternalSort::FlushRun(int fd) {
+    size_t nwritten = 0;
+    while (nwritten < m_write_buf.size()) {
+        ssize_t res = write(fd, m_write_buf.data() + nwritten,
+                            m_write_buf.size() - nwritten);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            char *errstr = strerror(errno);
+            LOG(kFatal, "unable to write to temporary file: %s", errstr);
+        }
+        nwritten += res;
+    }
+    m_write_buf.clear();
+}
+
+void
+ExternalSort::WriteRun() {
+    SortBuffer();
+
+    int fd = CreateRunFile();
+    m_runs.push_back(fd);
+    ++m_num_runs;
+    m_write_buf.reserve(RunBufferSize);
+    for (size_t off : m_offsets) {
+        uint32_t len;
+        memcpy(&len, &m_buf[off], sizeof(uint32_t));
+        WriteToRun(fd, &len, sizeof(uint32_t));
+        WriteToRun(fd, &m_buf[off + MAXALIGN(sizeof(uint32_t))], len);
+    }
+    FlushRun(fd);
+
+    m_buf.clear();
+    m_offsets.clear();
+}
+
+void
+ExternalSort::Sort() {
+    ASSERT(!m_sorted);
+    m_sorted = true;
+    if (m_runs.empty()) {
+        SortBuffer();
+        m_next_offset_idx = 0;
+        return;
+    }
+
+    // Spills the rest of the items so that the buffer may be freed before
+    // the merges.
+    if (!m_offsets.empty()) {
+        WriteRun();
+    }
+    maxaligned_char_buf().swap(m_buf);
+    std::vector<size_t>().swap(m_offsets);
+
+    while (m_runs.size() > m_max_fan_in) {
+        StartMerge(m_max_fan_in);
+        int fd = CreateRunFile();
+        const char *item;
+        uint32_t len;
+        while (NextMergedItem(item, len)) {
+            WriteToRun(fd, &len, sizeof(uint32_t));
+            WriteToRun(fd, item, len);
+        }
+        FlushRun(fd);
+        EndMerge();
+        m_runs.push_back(fd);
+        ++m_num_intermediate_merges;
+    }
+    maxaligned_char_buf().swap(m_write_buf);
+    StartMerge(m_runs.size());
+}
+
+bool
+ExternalSort::ReadFromRun(RunReader &reader, void *data, size_t len) {
+    char *dst = (char*) data;
+    size_t ncopied = 0;
+    while (ncopied < len) {
+        if (reader.m_pos == reader.m_end) {
+            ssize_t res = read(reader.m_fd, reader.m_buf.data(),
+                               reader.m_buf.size());
+            if (res < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                char *errstr = strerror(errno);
+                LOG(kFatal, "unable to read from temporary file: %s",
+                    errstr);
+            }
+            if (res == 0) {
+                if (ncopied == 0) {
+                    return false;
+                }
+                LOG(kFatal, "truncated temporary file");
+            }
+            reader.m_pos = 0;
+            reader.m_end = res;
+        }
+        size_t n = std::min(len - ncopied, reader.m_end - reader.m_pos);
+        memcpy(dst + ncopied, reader.m_buf.data() + reader.m_pos, n);
+        reader.m_pos += n;
+        ncopied += n;
+    }
+    return true;
+}
+
+bool
+ExternalSort::ReadNextItem(RunReader &reader) {
+    uint32_t len;
+    if (!ReadFromRun(reader, &len, sizeof(uint32_t))) {
+        return false;
+    }
+    reader.m_item.resize(std::max((size_t) MAXALIGN(len),
+                                  (size_t) MAXALIGN_OF));
+    if (len > 0 && !ReadFromRun(reader, reader.m_item.data(), len)) {
+        LOG(kFatal, "truncated temporary file");
+    }
+    reader.m_item_len = len;
+    return true;
+}
+
+void
+ExternalSort::StartMerge(size_t n) {
+    ASSERT(m_inputs.empty() && n <= m_runs.size());
+    m_inputs.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        RunReader &reader = m_inputs[i];
+        reader.m_fd = m_runs[i];
+        if (lseek(reader.m_fd, 0, SEEK_SET) < 0) {
+            char *errstr = strerror(errno);
+            LOG(kFatal, "unable to seek in temporary file: %s", errstr);
+        }
+        reader.m_buf.resize(RunBufferSize);
+        reader.m_pos = 0;
+        reader.m_end = 0;
+        reader.m_item_len = 0;
+    }
+    m_runs.erase(m_runs.begin(), m_runs.begin() + n);
+
+    m_heap.clear();
+    m_heap.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (ReadNextItem(m_inputs[i])) {
+            m_heap.push_back(i);
+        }
+    }
+    m_merge_started = false;
+}
+
+bool
+ExternalSort::NextMergedItem(const char *&item, uint32_t &len) {
+    auto heap_cmp = [&](size_t i1, size_t i2) -> bool {
+        return m_cmp(m_inputs[i1].m_item.data(),
+                     m_inputs[i2].m_item.data()) > 0;
+    };
+
+    if (!m_merge_started) {
+        m_merge_started = true;
+        std::make_heap(m_heap.begin(), m_heap.end(), heap_cmp);
+    } else if (!m_heap.empty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), heap_cmp);
+        if (ReadNextItem(m_inputs[m_heap.back()])) {
+            std::push_heap(m_heap.begin(), m_heap.end(), heap_cmp);
+        } else {
+            m_heap.pop_back();
+        }
+    }
+
+    if (m_heap.empty()) {
+        return false;
+    }
+    const RunReader &reader = m_inputs[m_heap.front()];
+    item = reader.m_item.data();
+    len = reader.m_item_len;
+    return true;
+}
+
+void
+ExternalSort::EndMerge() {
+    for (RunReader &reader : m_inputs) {
+        close(reader.m_fd);
+    }
+    m_inputs.clear();
+    m_heap.clear();
+}
+
+bool
+ExternalSort::Next() {
+    ASSERT(m_sorted);
+    bool has_item;
+    if (m_inputs.empty()) {
+        // all the items are in the buffer
+        has_item = m_next_offset_idx < m_offsets.size();
+        if (has_item) {
+            size_t off = m_offsets[m_next_offset_idx++];
+            memcpy(&m_cur_item_len, &m_buf[off], sizeof(uint32_t));
+            m_cur_item = &m_buf[off + MAXALIGN(sizeof(uint32_t))];
+        }
+    } else {
+        has_item = NextMergedItem(m_cur_item, m_cur_item_len);
+    }
+
+    if (!has_item) {
+        m_cur_item = nullptr;
+        m_cur_item_len = 0;
+    }
+    return has_item;
+}
+
+}   // namespace taco
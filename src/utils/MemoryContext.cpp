@@ -0,0 +1,131 @@
+#include "utils/MemoryContext.h"
+
+namespace taco {
+
+constexpr size_t MemoryContext::DefaultInitBlockSize;
+constexpr size_t MemoryContext::DefaultMaxBlockSize;
+constexpr size_t MemoryContext::BlockHeaderSize;
+
+thread_local MemoryContext *g_cur_mctx = nullptr;
+
+MemoryContext::MemoryContext(MemoryContext *parent,
+                             size_t init_block_size,
+                             size_t max_block_size):
+    m_parent(parent),
+    m_first_child(nullptr),
+    m_next_sibling(nullptr),
+    m_blocks(nullptr),
+    m_keeper(nullptr),
+    m_free(nullptr),
+    m_end(nullptr),
+    m_next_block_size(MAXALIGN(init_block_size)),
+    m_init_block_size(MAXALIGN(init_block_size)),
+    m_max_block_size(std::max(MAXALIGN(max_block_size),
+                              MAXALIGN(init_block_size))),
+    m_total_block_size(0) {
+
+    if (m_init_block_size <= BlockHeaderSize) {
+        LOG(kFatal, "initial block size %lu of a memory context is too small",
+            init_block_size);
+    }
+
+    m_keeper = NewBlock(m_init_block_size);
+    m_next_block_size = std::min(m_init_block_size * 2, m_max_block_size);
+
+    if (m_parent) {
+        m_next_sibling = m_parent->m_first_child;
+        m_parent->m_first_child = this;
+    }
+}
+
+MemoryContext::~MemoryContext() {
+    if (m_first_child) {
+        LOG(kFatal, "destructing a memory context with live children");
+    }
+
+    if (m_parent) {
+        MemoryContext **p = &m_parent->m_first_child;
+        while (*p != this) {
+            ASSERT(*p);
+            p = &(*p)->m_next_sibling;
+        }
+        *p = m_next_sibling;
+    }
+
+    while (m_blocks) {
+        Block *next = m_blocks->m_next;
+        free(m_blocks);
+        m_blocks = next;
+    }
+}
+
+void
+MemoryContext::Reset() {
+    for (MemoryContext *child = m_first_child; child;
+            child = child->m_next_sibling) {
+        child->Reset();
+    }
+
+    Block *block = m_blocks;
+    while (block) {
+        Block *next = block->m_next;
+        if (block != m_keeper) {
+            m_total_block_size -= block->m_size;
+            free(block);
+        }
+        block = next;
+    }
+
+    m_blocks = m_keeper;
+    m_keeper->m_next = nullptr;
+    m_free = ((char *) m_keeper) + BlockHeaderSize;
+    m_end = ((char *) m_keeper) + m_keeper->m_size;
+    m_next_block_size = std::min(m_init_block_size * 2, m_max_block_size);
+}
+
+void*
+MemoryContext::AllocateSlow(size_t size) {
+    // Large requests get a dedicated block so that we do not waste the
+    // remaining space in the current block. The dedicated block is linked
+    // after the current one, so we keep allocating from the current block.
+    if (size > (m_max_block_size >> 2)) {
+        Block *block = (Block *) malloc(BlockHeaderSize + size);
+        if (!block) {
+            LOG(kFatal, "out of memory");
+        }
+        block->m_size = BlockHeaderSize + size;
+        m_total_block_size += block->m_size;
+        block->m_next = m_blocks->m_next;
+        m_blocks->m_next = block;
+        return ((char *) block) + BlockHeaderSize;
+    }
+
+    size_t block_size = m_next_block_size;
+    while (block_size - BlockHeaderSize < size) {
+        block_size <<= 1;
+    }
+    m_next_block_size = std::min(block_size * 2, m_max_block_size);
+    NewBlock(block_size);
+
+    char *ret = m_free;
+    m_free += size;
+    return ret;
+}
+
+MemoryContext::Block*
+MemoryContext::NewBlock(size_t size) {
+    Block *block = (Block *) malloc(size);
+    if (!block) {
+        LOG(kFatal, "out of memory");
+    }
+    block->m_size = size;
+    block->m_next = m_blocks;
+    m_blocks = block;
+    m_total_block_size += size;
+
+    m_free = ((char *) block) + BlockHeaderSize;
+    m_end = ((char *) block) + size;
+    return block;
+}
+
+}   // namespace taco
@@ -1,31 +1,30 @@
 #include "utils/builtin_funcs.h"
 
-#include <absl/container/flat_hash_map.h>
-
+#include "catalog/systables.h"
 #include "catalog/systables/builtin_func_table.h"
+#include "catalog/systables/builtin_vecfunc_table.h"
 
 namespace taco {
 
-namespace {
-    absl::flat_hash_map<Oid, FunctionPtr> builtin_func_lookup_table;
-}   // anonymous namespace
-
-void
-InitBuiltinFunctions() {
-    builtin_func_lookup_table.clear();
+// Both dispatch tables are indexed by the function Oid and are
+// constant-initialized, so a lookup is a bound check plus a single load.
+static_assert(builtin_func_dispatch_table_size <= max_sys_oid + 1, "");
+static_assert(builtin_vecfunc_dispatch_table_size <= max_sys_oid + 1, "");
 
-    for (const auto &p : builtin_func_table) {
-        builtin_func_lookup_table[p.first] = p.second;
+FunctionPtr
+FindBuiltinFunction(Oid oid) {
+    if (oid >= builtin_func_dispatch_table_size) {
+        return nullptr;
     }
+    return builtin_func_dispatch_table[oid];
 }
 
-FunctionInfo
-FindBuiltinFunction(Oid oid) {
-    auto iter = builtin_func_lookup_table.find(oid);
-    if (iter == builtin_func_lookup_table.end()) {
-        return FunctionInfo();
+VecFunctionPtr
+FindBuiltinVecFunction(Oid oid) {
+    if (oid >= builtin_vecfunc_dispatch_table_size) {
+        return nullptr;
     }
-    return FunctionInfo(iter->second);
+    return builtin_vecfunc_dispatch_table[oid];
 }
 
 }   // namespace taco
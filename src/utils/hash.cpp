@@ -0,0 +1,216 @@
+#include "utils/hash.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HASH_USE_X86_CRC32
+#endif
+
+namespace taco {
+
+using namespace hash_impl;
+
+namespace {
+
+inline uint64_t
+read_8(const uint8_t *p) {
+    uint64_t x;
+    memcpy(&x, p, 8);
+    return x;
+}
+
+inline uint64_t
+read_4(const uint8_t *p) {
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return x;
+}
+
+/*!
+ * Reads 1 to 3 bytes at \p p into an integer, with the first, the middle and
+ * the last bytes.
+ */
+inline uint64_t
+read_3(const uint8_t *p, size_t len) {
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[len >> 1]) << 8) |
+           p[len - 1];
+}
+
+inline unsigned char
+ascii_tolower(unsigned char c) {
+    return c + ((unsigned char)(c - 'A') < 26) * ('a' - 'A');
+}
+
+}   // namespace
+
+uint64_t
+HashBytes(const void *data, size_t len, uint64_t seed) {
+    const uint8_t *p = (const uint8_t *) data;
+    uint64_t a, b;
+
+    seed ^= Mum(seed ^ P0, P1);
+    if (len <= 16) {
+        if (len >= 4) {
+            // Two possibly overlapping 4-byte reads at each end.
+            size_t mid = (len >> 3) << 2;
+            a = (read_4(p) << 32) | read_4(p + mid);
+            b = (read_4(p + len - 4) << 32) | read_4(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = read_3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            // Three independent lanes to hide the multiplication latency.
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = Mum(read_8(p) ^ P1, read_8(p + 8) ^ seed);
+                see1 = Mum(read_8(p + 16) ^ P2, read_8(p + 24) ^ see1);
+                see2 = Mum(read_8(p + 32) ^ P3, read_8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = Mum(read_8(p) ^ P1, read_8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        // the last 16 bytes, which may overlap with the ones hashed above
+        a = read_8(p + i - 16);
+        b = read_8(p + i - 8);
+    }
+
+    __uint128_t r = (__uint128_t)(a ^ P1) * (b ^ seed);
+    return Mum(((uint64_t) r) ^ P0 ^ len, ((uint64_t)(r >> 64)) ^ P1);
+}
+
+uint64_t
+HashBytesCI(absl::string_view str, uint64_t seed) {
+    char buf[256];
+    std::string longbuf;
+    char *folded = buf;
+    if (str.size() > sizeof(buf)) {
+        longbuf.resize(str.size());
+        folded = &longbuf[0];
+    }
+    for (size_t i = 0; i < str.size(); ++i) {
+        folded[i] = (char) ascii_tolower((unsigned char) str[i]);
+    }
+    return HashBytes(folded, str.size(), seed);
+}
+
+void
+HashCombineBatch(uint64_t *__restrict hashes,
+                 const uint64_t *__restrict colhashes,
+                 const uint8_t *colnulls,
+                 uint32_t n,
+                 bool first) {
+    const uint64_t init = 0;
+    if (!colnulls) {
+        for (uint32_t i = 0; i < n; ++i) {
+            hashes[i] = HashCombine(first ? init : hashes[i], colhashes[i]);
+        }
+        return ;
+    }
+
+    // The hash values of the null rows in colhashes are undefined, so they
+    // are replaced with NullHashValue.
+    for (uint32_t i = 0; i < n; ++i) {
+        bool isnull = colnulls[i >> 3] & (1 << (i & 7));
+        uint64_t val = isnull ? NullHashValue : colhashes[i];
+        hashes[i] = HashCombine(first ? init : hashes[i], val);
+    }
+}
+
+namespace {
+
+/*!
+ * The table for the bytewise software CRC32C, with the reflected polynomial
+ * 0x82f63b78.
+ */
+struct CRC32CTable {
+    uint32_t    m_table[256];
+
+    CRC32CTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c >> 1) ^ (0x82f63b78u & (0 - (c & 1)));
+            }
+            m_table[i] = c;
+        }
+    }
+};
+
+/*!
+ * Returns the CRC32C table. It is built on first use rather than during
+ * static initialization, so that CRC32C() may be called from the static
+ * initializers in other translation units.
+ */
+const CRC32CTable&
+GetCRC32CTable() {
+    static const CRC32CTable table;
+    return table;
+}
+
+uint32_t
+crc32c_sw(uint32_t crc, const uint8_t *p, size_t len) {
+    const CRC32CTable &table = GetCRC32CTable();
+    for (size_t i = 0; i < len; ++i) {
+        crc = table.m_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef HASH_USE_X86_CRC32
+/*!
+ * Returns whether the CPU has the SSE 4.2 crc32 instructions. Like the table
+ * above, this is checked on first use, and __builtin_cpu_init() must be
+ * called first in case that is before the constructors of libgcc have run.
+ */
+bool
+CPUHasSSE42() {
+    static const bool has_sse42 =
+        (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2"));
+    return has_sse42;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t
+crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    uint64_t c = crc;
+    while (len >= 8) {
+        c = _mm_crc32_u64(c, read_8(p));
+        p += 8;
+        len -= 8;
+    }
+    uint32_t c32 = (uint32_t) c;
+    while (len > 0) {
+        c32 = _mm_crc32_u8(c32, *p);
+        ++p;
+        --len;
+    }
+    return c32;
+}
+#endif
+
+}   // namespace
+
+uint32_t
+CRC32C(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *) data;
+    crc = ~crc;
+#ifdef HASH_USE_X86_CRC32
+    if (CPUHasSSE42()) {
+        return ~crc32c_sse42(crc, p, len);
+    }
+#endif
+    return ~crc32c_sw(crc, p, len);
+}
+
+}   // namespace taco
@@ -0,0 +1,546 @@
+#include "utils/numbers.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace taco {
+
+namespace {
+
+const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/*!
+ * Returns whether all the 8 bytes in \p val are ASCII decimal digits.
+ */
+inline bool
+IsEightDigits(std::uint64_t val) {
+    return ((val & 0xF0F0F0F0F0F0F0F0ull) |
+            (((val + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+        == 0x3333333333333333ull;
+}
+
+/*!
+ * Converts 8 ASCII decimal digits loaded in little-endian order into their
+ * value with three multiplications.
+ */
+inline std::uint32_t
+ParseEightDigits(std::uint64_t val) {
+    const std::uint64_t mask = 0x000000FF000000FFull;
+    const std::uint64_t mul1 = 100 + (1000000ull << 32);
+    const std::uint64_t mul2 = 1 + (10000ull << 32);
+    val -= 0x3030303030303030ull;
+    val = (val * 10) + (val >> 8);
+    val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+    return (std::uint32_t) val;
+}
+#endif
+
+}   // anonymous namespace
+
+bool
+ParseDecimalDigits(const char *p, size_t n, std::uint64_t *out) {
+    std::uint64_t val = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (n >= 8) {
+        std::uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        if (!IsEightDigits(chunk)) {
+            return false;
+        }
+        val = val * 100000000 + ParseEightDigits(chunk);
+        p += 8;
+        n -= 8;
+    }
+#endif
+    for (; n > 0; ++p, --n) {
+        unsigned d = (unsigned char) *p - '0';
+        if (d > 9) {
+            return false;
+        }
+        val = val * 10 + d;
+    }
+    *out = val;
+    return true;
+}
+
+size_t
+FormatUInt64(char *buf, std::uint64_t val) {
+    char tmp[IntegerFormatBufLen];
+    char *p = tmp + IntegerFormatBufLen;
+    while (val >= 100) {
+        std::uint64_t q = val / 100;
+        std::uint32_t r = (std::uint32_t)(val - q * 100);
+        p -= 2;
+        memcpy(p, &digit_pairs[2 * r], 2);
+        val = q;
+    }
+    if (val >= 10) {
+        p -= 2;
+        memcpy(p, &digit_pairs[2 * val], 2);
+    } else {
+        *--p = (char)('0' + val);
+    }
+
+    size_t len = tmp + IntegerFormatBufLen - p;
+    memcpy(buf, p, len);
+    return len;
+}
+
+size_t
+FormatInt64(char *buf, std::int64_t val) {
+    if (val < 0) {
+        buf[0] = '-';
+        return FormatUInt64(buf + 1, 0 - (std::uint64_t) val) + 1;
+    }
+    return FormatUInt64(buf, (std::uint64_t) val);
+}
+
+namespace {
+
+/*!
+ * A floating point number f * 2^e with a 64-bit significand and no sign.
+ */
+struct DiyFp {
+    std::uint64_t   f;
+    int             e;
+};
+
+/*!
+ * Returns x * y rounded to the 64 most significant bits.
+ */
+inline DiyFp
+Multiply(DiyFp x, DiyFp y) {
+    const std::uint64_t m32 = 0xFFFFFFFFull;
+    std::uint64_t a = x.f >> 32, b = x.f & m32;
+    std::uint64_t c = y.f >> 32, d = y.f & m32;
+    std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    std::uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+    tmp += 1ull << 31;
+    return DiyFp{ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64};
+}
+
+inline DiyFp
+Normalize(DiyFp x) {
+    while (!(x.f & (1ull << 63))) {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+/*!
+ * The normalized 64-bit approximations of 10^k for k = -348, -340, ...,
+ * 340, rounded to the nearest.
+ */
+struct CachedPower {
+    std::uint64_t   f;
+    std::int16_t    e;
+    std::int16_t    k;
+};
+
+const CachedPower cached_powers[] = {
+    {0xfa8fd5a0081c0288ull, -1220, -348},
+    {0xbaaee17fa23ebf76ull, -1193, -340},
+    {0x8b16fb203055ac76ull, -1166, -332},
+    {0xcf42894a5dce35eaull, -1140, -324},
+    {0x9a6bb0aa55653b2dull, -1113, -316},
+    {0xe61acf033d1a45dfull, -1087, -308},
+    {0xab70fe17c79ac6caull, -1060, -300},
+    {0xff77b1fcbebcdc4full, -1034, -292},
+    {0xbe5691ef416bd60cull, -1007, -284},
+    {0x8dd01fad907ffc3cull, -980, -276},
+    {0xd3515c2831559a83ull, -954, -268},
+    {0x9d71ac8fada6c9b5ull, -927, -260},
+    {0xea9c227723ee8bcbull, -901, -252},
+    {0xaecc49914078536dull, -874, -244},
+    {0x823c12795db6ce57ull, -847, -236},
+    {0xc21094364dfb5637ull, -821, -228},
+    {0x9096ea6f3848984full, -794, -220},
+    {0xd77485cb25823ac7ull, -768, -212},
+    {0xa086cfcd97bf97f4ull, -741, -204},
+    {0xef340a98172aace5ull, -715, -196},
+    {0xb23867fb2a35b28eull, -688, -188},
+    {0x84c8d4dfd2c63f3bull, -661, -180},
+    {0xc5dd44271ad3cdbaull, -635, -172},
+    {0x936b9fcebb25c996ull, -608, -164},
+    {0xdbac6c247d62a584ull, -582, -156},
+    {0xa3ab66580d5fdaf6ull, -555, -148},
+    {0xf3e2f893dec3f126ull, -529, -140},
+    {0xb5b5ada8aaff80b8ull, -502, -132},
+    {0x87625f056c7c4a8bull, -475, -124},
+    {0xc9bcff6034c13053ull, -449, -116},
+    {0x964e858c91ba2655ull, -422, -108},
+    {0xdff9772470297ebdull, -396, -100},
+    {0xa6dfbd9fb8e5b88full, -369, -92},
+    {0xf8a95fcf88747d94ull, -343, -84},
+    {0xb94470938fa89bcfull, -316, -76},
+    {0x8a08f0f8bf0f156bull, -289, -68},
+    {0xcdb02555653131b6ull, -263, -60},
+    {0x993fe2c6d07b7facull, -236, -52},
+    {0xe45c10c42a2b3b06ull, -210, -44},
+    {0xaa242499697392d3ull, -183, -36},
+    {0xfd87b5f28300ca0eull, -157, -28},
+    {0xbce5086492111aebull, -130, -20},
+    {0x8cbccc096f5088ccull, -103, -12},
+    {0xd1b71758e219652cull, -77, -4},
+    {0x9c40000000000000ull, -50, 4},
+    {0xe8d4a51000000000ull, -24, 12},
+    {0xad78ebc5ac620000ull, 3, 20},
+    {0x813f3978f8940984ull, 30, 28},
+    {0xc097ce7bc90715b3ull, 56, 36},
+    {0x8f7e32ce7bea5c70ull, 83, 44},
+    {0xd5d238a4abe98068ull, 109, 52},
+    {0x9f4f2726179a2245ull, 136, 60},
+    {0xed63a231d4c4fb27ull, 162, 68},
+    {0xb0de65388cc8ada8ull, 189, 76},
+    {0x83c7088e1aab65dbull, 216, 84},
+    {0xc45d1df942711d9aull, 242, 92},
+    {0x924d692ca61be758ull, 269, 100},
+    {0xda01ee641a708deaull, 295, 108},
+    {0xa26da3999aef774aull, 322, 116},
+    {0xf209787bb47d6b85ull, 348, 124},
+    {0xb454e4a179dd1877ull, 375, 132},
+    {0x865b86925b9bc5c2ull, 402, 140},
+    {0xc83553c5c8965d3dull, 428, 148},
+    {0x952ab45cfa97a0b3ull, 455, 156},
+    {0xde469fbd99a05fe3ull, 481, 164},
+    {0xa59bc234db398c25ull, 508, 172},
+    {0xf6c69a72a3989f5cull, 534, 180},
+    {0xb7dcbf5354e9beceull, 561, 188},
+    {0x88fcf317f22241e2ull, 588, 196},
+    {0xcc20ce9bd35c78a5ull, 614, 204},
+    {0x98165af37b2153dfull, 641, 212},
+    {0xe2a0b5dc971f303aull, 667, 220},
+    {0xa8d9d1535ce3b396ull, 694, 228},
+    {0xfb9b7cd9a4a7443cull, 720, 236},
+    {0xbb764c4ca7a44410ull, 747, 244},
+    {0x8bab8eefb6409c1aull, 774, 252},
+    {0xd01fef10a657842cull, 800, 260},
+    {0x9b10a4e5e9913129ull, 827, 268},
+    {0xe7109bfba19c0c9dull, 853, 276},
+    {0xac2820d9623bf429ull, 880, 284},
+    {0x80444b5e7aa7cf85ull, 907, 292},
+    {0xbf21e44003acdd2dull, 933, 300},
+    {0x8e679c2f5e44ff8full, 960, 308},
+    {0xd433179d9c8cb841ull, 986, 316},
+    {0x9e19db92b4e31ba9ull, 1013, 324},
+    {0xeb96bf6ebadf77d9ull, 1039, 332},
+    {0xaf87023b9bf0ee6bull, 1066, 340},
+};
+
+constexpr int CachedPowersFirstK = -348;
+constexpr int CachedPowersKStep = 8;
+
+/*!
+ * The range of the binary exponent of the scaled value in Grisu, so that its
+ * integral part fits in 32 bits.
+ */
+constexpr int GrisuMinExponent = -60;
+constexpr int GrisuMaxExponent = -32;
+
+/*!
+ * Returns a cached power 10^k such that the binary exponent of w * 10^k is
+ * in [GrisuMinExponent, GrisuMaxExponent] for a normalized w with the
+ * binary exponent \p e.
+ */
+inline const CachedPower&
+GetCachedPower(int e) {
+    // 0.30102999566398114 = log10(2)
+    int min_e = GrisuMinExponent - (e + 64);
+    int k = (int) std::ceil((min_e + 63) * 0.30102999566398114);
+    int index = (k - CachedPowersFirstK - 1) / CachedPowersKStep + 1;
+    return cached_powers[index];
+}
+
+const std::uint32_t small_powers_of_ten[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+/*!
+ * Adjusts the last digit of the generated digits towards w if that keeps
+ * them inside the boundaries, and returns whether the result is provably
+ * the closest shortest representation. See Florian Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010.
+ */
+bool
+RoundWeed(char *buf, int len, std::uint64_t distance_too_high_w,
+          std::uint64_t unsafe_interval, std::uint64_t rest,
+          std::uint64_t ten_kappa, std::uint64_t unit) {
+    std::uint64_t small_distance = distance_too_high_w - unit;
+    std::uint64_t big_distance = distance_too_high_w + unit;
+    while (rest < small_distance &&
+           unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        --buf[len - 1];
+        rest += ten_kappa;
+    }
+    if (rest < big_distance &&
+        unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance)) {
+        return false;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+/*!
+ * Generates the shortest digits of the positive value f * 2^e into \p buf
+ * with Grisu3, where the boundaries between it and its neighbors are
+ * (2f - 1) * 2^(e-1) (or (4f - 1) * 2^(e-2) if \p lower_is_closer) and
+ * (2f + 1) * 2^(e-1). Returns false if the result can't be proven to be the
+ * shortest, which happens for about 0.5% of the values. Otherwise, sets
+ * \p len and \p exp10 so that the value is buf[0..len) * 10^exp10.
+ */
+bool
+Grisu3(std::uint64_t f, int e, bool lower_is_closer,
+       char *buf, int *len, int *exp10) {
+    DiyFp w = Normalize(DiyFp{f, e});
+    DiyFp plus = Normalize(DiyFp{(f << 1) + 1, e - 1});
+    DiyFp minus = lower_is_closer ? DiyFp{(f << 2) - 1, e - 2}
+                                  : DiyFp{(f << 1) - 1, e - 1};
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const CachedPower &c = GetCachedPower(w.e);
+    DiyFp ten_mk{c.f, c.e};
+    w = Multiply(w, ten_mk);
+    minus = Multiply(minus, ten_mk);
+    plus = Multiply(plus, ten_mk);
+
+    // The scaled boundaries are imprecise by up to one unit, so we only
+    // generate digits inside (too_low, too_high) and check that the result
+    // is also inside the unscaled boundaries in RoundWeed().
+    std::uint64_t unit = 1;
+    std::uint64_t too_low = minus.f - unit;
+    std::uint64_t too_high = plus.f + unit;
+    std::uint64_t unsafe_interval = too_high - too_low;
+    const int shift = -w.e;
+    const std::uint64_t one = 1ull << shift;
+    std::uint32_t integrals = (std::uint32_t)(too_high >> shift);
+    std::uint64_t fractionals = too_high & (one - 1);
+
+    int n = 9;
+    while (n > 0 && integrals < small_powers_of_ten[n]) {
+        --n;
+    }
+    std::uint32_t divisor = small_powers_of_ten[n];
+    int kappa = n + 1;
+    *len = 0;
+    while (kappa > 0) {
+        buf[(*len)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        --kappa;
+        std::uint64_t rest = ((std::uint64_t) integrals << shift) +
+                             fractionals;
+        if (rest < unsafe_interval) {
+            *exp10 = kappa - c.k;
+            return RoundWeed(buf, *len, too_high - w.f, unsafe_interval,
+                             rest, (std::uint64_t) divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buf[(*len)++] = (char)('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        --kappa;
+        if (fractionals < unsafe_interval) {
+            *exp10 = kappa - c.k;
+            return RoundWeed(buf, *len, (too_high - w.f) * unit,
+                             unsafe_interval, fractionals, one, unit);
+        }
+    }
+}
+
+inline bool
+ReadsBackAs(const char *str, double val) {
+    return strtod(str, nullptr) == val;
+}
+
+inline bool
+ReadsBackAs(const char *str, float val) {
+    return strtof(str, nullptr) == val;
+}
+
+/*!
+ * Finds the shortest digits of a positive \p val by trying the decimals with
+ * \p min_digits, \p min_digits + 1, ... significant digits that are next to
+ * \p val, when Grisu3 fails. The correctly rounded one at a precision is
+ * either of them, but the other may be the only one that reads back as \p
+ * val if it is on the side of the wider half of the rounding interval.
+ *
+ * The digits a failed Grisu3 generated are the shortest in an interval
+ * that contains the rounding interval, so there are never fewer digits than
+ * those.
+ */
+template<class T>
+void
+ShortestDigitsSlow(T val, int min_digits, int max_digits,
+                   char *buf, int *len, int *exp10) {
+    char tmp[FloatFormatBufLen];
+    for (int prec = min_digits; ; ++prec) {
+        snprintf(tmp, sizeof(tmp), "%.*e", prec - 1, (double) val);
+        std::uint64_t m = (std::uint64_t)(tmp[0] - '0');
+        const char *p = tmp + 1;
+        if (*p == '.') {
+            for (++p; *p != 'e'; ++p) {
+                m = m * 10 + (std::uint64_t)(*p - '0');
+            }
+        }
+        int e = atoi(p + 1) - (prec - 1);
+
+        std::uint64_t pow = 1;
+        for (int i = 1; i < prec; ++i) {
+            pow *= 10;
+        }
+        struct { std::uint64_t m; int e; } cands[3] = {
+            {m, e}, {m + 1, e},
+            // the predecessor of 10^(prec-1) has prec nines
+            {(m == pow) ? pow * 10 - 1 : m - 1, (m == pow) ? e - 1 : e}
+        };
+        for (int i = 0; i < 3; ++i) {
+            snprintf(tmp, sizeof(tmp), "%llue%d",
+                     (unsigned long long) cands[i].m, cands[i].e);
+            if (prec == max_digits || ReadsBackAs(tmp, val)) {
+                std::uint64_t cm = cands[i].m;
+                *exp10 = cands[i].e;
+                while (cm % 10 == 0) {
+                    cm /= 10;
+                    ++*exp10;
+                }
+                *len = (int) FormatUInt64(buf, cm);
+                return;
+            }
+        }
+    }
+}
+
+/*!
+ * Writes the digits buf[0..len) * 10^exp10 into \p out in the same form as
+ * "%.<prec>g" with prec = max(len, \p min_prec), and returns its length.
+ */
+size_t
+FormatDigits(char *out, const char *digits, int len, int exp10,
+             int min_prec) {
+    // the exponent in the scientific notation
+    int x = exp10 + len - 1;
+    int prec = std::max(len, min_prec);
+    char *p = out;
+    if (x < -4 || x >= prec) {
+        *p++ = digits[0];
+        if (len > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, len - 1);
+            p += len - 1;
+        }
+        *p++ = 'e';
+        *p++ = (x < 0) ? '-' : '+';
+        unsigned ux = (unsigned)((x < 0) ? -x : x);
+        if (ux < 10) {
+            *p++ = '0';
+        }
+        p += FormatUInt64(p, ux);
+    } else if (x < 0) {
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', -x - 1);
+        p += -x - 1;
+        memcpy(p, digits, len);
+        p += len;
+    } else if (x + 1 >= len) {
+        memcpy(p, digits, len);
+        p += len;
+        memset(p, '0', x + 1 - len);
+        p += x + 1 - len;
+    } else {
+        memcpy(p, digits, x + 1);
+        p += x + 1;
+        *p++ = '.';
+        memcpy(p, digits + x + 1, len - x - 1);
+        p += len - x - 1;
+    }
+    *p = '\0';
+    return p - out;
+}
+
+/*!
+ * Formats a finite \p val whose significand and exponent are \p f and \p e
+ * (in the denormal form if \p f does not have the hidden bit), where \p
+ * lower_is_closer says whether the lower boundary is half as far as the
+ * upper one.
+ */
+template<class T>
+size_t
+FormatFloatingPoint(char *buf, T val, std::uint64_t f, int e,
+                    bool lower_is_closer, int min_prec, int max_digits) {
+    char *p = buf;
+    if (std::signbit(val)) {
+        *p++ = '-';
+        val = -val;
+    }
+    if (f == 0) {
+        *p++ = '0';
+        *p = '\0';
+        return p - buf;
+    }
+
+    char digits[FloatFormatBufLen];
+    int len, exp10;
+    if (!Grisu3(f, e, lower_is_closer, digits, &len, &exp10)) {
+        ShortestDigitsSlow(val, std::min(len, max_digits), max_digits,
+                           digits, &len, &exp10);
+    }
+    return (p - buf) + FormatDigits(p, digits, len, exp10, min_prec);
+}
+
+}   // anonymous namespace
+
+size_t
+FormatDouble(char *buf, double val) {
+    if (!std::isfinite(val)) {
+        return snprintf(buf, FloatFormatBufLen, "%g", val);
+    }
+    std::uint64_t bits;
+    memcpy(&bits, &val, sizeof(double));
+    std::uint64_t f = bits & ((1ull << 52) - 1);
+    int biased_e = (int)((bits >> 52) & 0x7FF);
+    int e = (biased_e == 0) ? -1074 : biased_e - 1075;
+    if (biased_e != 0) {
+        f |= 1ull << 52;
+    }
+    return FormatFloatingPoint(buf, val, f, e, f == (1ull << 52) &&
+                               biased_e > 1, DBL_DIG, 17);
+}
+
+size_t
+FormatFloat(char *buf, float val) {
+    if (!std::isfinite(val)) {
+        return snprintf(buf, FloatFormatBufLen, "%g", (double) val);
+    }
+    std::uint32_t bits;
+    memcpy(&bits, &val, sizeof(float));
+    std::uint64_t f = bits & ((1u << 23) - 1);
+    int biased_e = (int)((bits >> 23) & 0xFF);
+    int e = (biased_e == 0) ? -149 : biased_e - 150;
+    if (biased_e != 0) {
+        f |= 1u << 23;
+    }
+    return FormatFloatingPoint(buf, val, f, e, f == (1u << 23) &&
+                               biased_e > 1, FLT_DIG, 9);
+}
+
+}   // namespace taco
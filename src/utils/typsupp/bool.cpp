@@ -10,6 +10,9 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
+#include "utils/typsupp/nkey.h"
 
 namespace taco {
 
@@ -43,6 +46,30 @@ BUILTIN_ARGTYPE(BOOL)
     return Datum::FromCString("false");
 }
 
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(BOOL_nkey, 782)
+BUILTIN_ARGTYPE(BOOL)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(uint8_t)];
+    NKeyStoreInteger(buf, (uint8_t) FMGR_ARG(0).GetBool());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(BOOL_hash, 783)
+BUILTIN_ARGTYPE(BOOL)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetBool()));
+}
+
 BUILTIN_RETTYPE(BOOL)
 BUILTIN_FUNC(BOOL_not, 772)
 BUILTIN_ARGTYPE(BOOL)
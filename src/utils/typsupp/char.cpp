@@ -4,7 +4,10 @@
 #include "tdb.h"
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/string_utils.h"
+#include "utils/typsupp/nkey.h"
 
 namespace taco {
 
@@ -35,12 +38,12 @@ BUILTIN_ARGTYPE(__STRING)
                     "specified maximum %lu", size, max_size);
     }
 
-    auto buffer = unique_malloc(max_size);
-    memcpy(buffer.get(), str.data(), size);
-    if (size < max_size) {
-        memset((char*) buffer.get() + size, ' ', max_size - size);
-    }
-    return Datum::FromVarlenBytes(std::move(buffer), max_size);
+    return CreateVarlenDatum(max_size, [&](char *buffer) {
+        memcpy(buffer, str.data(), size);
+        if (size < max_size) {
+            memset(buffer + size, ' ', max_size - size);
+        }
+    });
 }
 
 BUILTIN_RETTYPE(__STRING)
@@ -52,9 +55,63 @@ BUILTIN_ARGTYPE(CHAR)
     }
 
     absl::string_view &&str = FMGR_ARG(0).GetVarlenAsStringView();
-    auto buffer = unique_malloc(str.size());
-    memcpy(buffer.get(), str.data(), str.size());
-    return Datum::FromVarlenBytes(std::move(buffer), str.size());
+    return CreateVarlenDatum(str.data(), str.size());
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(CHAR_nkey, 906)
+BUILTIN_ARGTYPE(CHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str =
+        remove_trailing_space(FMGR_ARG(0).GetVarlenAsStringView());
+    return CreateVarlenDatum(NKeyStringLength(str), [&](char *buf) {
+        NKeyStoreString(buf, str, false);
+    });
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(CHAR_nkey_ci, 907)
+BUILTIN_ARGTYPE(CHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str =
+        remove_trailing_space(FMGR_ARG(0).GetVarlenAsStringView());
+    return CreateVarlenDatum(NKeyStringLength(str), [&](char *buf) {
+        NKeyStoreString(buf, str, true);
+    });
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(CHAR_hash, 908)
+BUILTIN_ARGTYPE(CHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str =
+        remove_trailing_space(FMGR_ARG(0).GetVarlenAsStringView());
+    return Datum::From(HashBytes(str));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(CHAR_hash_ci, 909)
+BUILTIN_ARGTYPE(CHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str =
+        remove_trailing_space(FMGR_ARG(0).GetVarlenAsStringView());
+    return Datum::From(HashBytesCI(str));
 }
 
 BUILTIN_RETTYPE(INT2)
@@ -97,9 +154,35 @@ BUILTIN_OPR(IMPLICIT_CAST, CAST)
         }
     }
 
-    auto buffer = unique_malloc(str_trunc.size());
-    memcpy(buffer.get(), str_trunc.data(), str_trunc.size());
-    return Datum::FromVarlenBytes(std::move(buffer), str_trunc.size());
+    return CreateVarlenDatum(str_trunc.data(), str_trunc.size());
+}
+
+BUILTIN_RETTYPE(CHAR)
+BUILTIN_FUNC(CHAR_to_CHAR, 884)
+BUILTIN_ARGTYPE(CHAR)
+BUILTIN_OPR(CAST)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    uint64_t max_size = FMGR_TYPPARAM();
+
+    absl::string_view &&str = FMGR_ARG(0).GetVarlenAsStringView();
+    if (max_size == 0) {
+        max_size = str.size();
+    } else {
+        // truncated or padded with spaces to the new length
+        if (str.size() > max_size) {
+            str = str.substr(0, max_size);
+        }
+    }
+
+    return CreateVarlenDatum(max_size, [&](char *buffer) {
+        memcpy(buffer, str.data(), str.size());
+        if (str.size() < max_size)
+            memset(buffer + str.size(), ' ', max_size - str.size());
+    });
 }
 
 BUILTIN_RETTYPE(BOOL)
@@ -6,10 +6,12 @@
 
 #include <cinttypes>
 
-#include <absl/strings/str_cat.h>
-
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
@@ -38,10 +40,33 @@ BUILTIN_ARGTYPE(DOUBLE)
     }
 
     double val = FMGR_ARG(0).GetDouble();
-    std::string s = absl::StrCat(val);
-    auto buffer = unique_malloc(s.size());
-    memcpy((char*) buffer.get(), s.data(), s.size());
-    return Datum::FromVarlenBytes(std::move(buffer), s.size());
+    char buf[FloatFormatBufLen];
+    size_t len = FormatDouble(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(DOUBLE_nkey, 843)
+BUILTIN_ARGTYPE(DOUBLE)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(double)];
+    NKeyStoreInteger(buf, NKeyFloatingPointBits(FMGR_ARG(0).GetDouble()));
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(DOUBLE_hash, 844)
+BUILTIN_ARGTYPE(DOUBLE)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashDouble(FMGR_ARG(0).GetDouble()));
 }
 
 BUILTIN_RETTYPE(DOUBLE)
@@ -208,6 +233,63 @@ BUILTIN_OPR(GE)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(DOUBLE_hash)
+{
+    VecFuncUnary<double, uint64_t>(vfcinfo_, [](double val) -> uint64_t {
+        return HashDouble(val);
+    });
+}
+
+BUILTIN_VECFUNC(DOUBLE_add)
+{
+    VecFuncBinary<double, double, double>(vfcinfo_, std::plus<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_sub)
+{
+    VecFuncBinary<double, double, double>(vfcinfo_, std::minus<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_mul)
+{
+    VecFuncBinary<double, double, double>(vfcinfo_, std::multiplies<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_div)
+{
+    VecFuncBinary<double, double, double>(vfcinfo_, std::divides<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_eq)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_, std::equal_to<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_ne)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_, std::not_equal_to<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_lt)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_, std::less<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_le)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_, std::less_equal<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_gt)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_, std::greater<double>());
+}
+
+BUILTIN_VECFUNC(DOUBLE_ge)
+{
+    VecFuncBinary<double, double, bool>(vfcinfo_,
+                                        std::greater_equal<double>());
+}
 
 }   // namespace taco
 
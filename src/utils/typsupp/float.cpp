@@ -6,10 +6,12 @@
 
 #include <cinttypes>
 
-#include <absl/strings/str_cat.h>
-
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
@@ -38,10 +40,33 @@ BUILTIN_ARGTYPE(FLOAT)
     }
 
     float val = FMGR_ARG(0).GetFloat();
-    std::string s = absl::StrCat(val);
-    auto buffer = unique_malloc(s.size());
-    memcpy((char*) buffer.get(), s.data(), s.size());
-    return Datum::FromVarlenBytes(std::move(buffer), s.size());
+    char buf[FloatFormatBufLen];
+    size_t len = FormatFloat(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(FLOAT_nkey, 813)
+BUILTIN_ARGTYPE(FLOAT)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(float)];
+    NKeyStoreInteger(buf, NKeyFloatingPointBits(FMGR_ARG(0).GetFloat()));
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(FLOAT_hash, 814)
+BUILTIN_ARGTYPE(FLOAT)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashDouble(FMGR_ARG(0).GetFloat()));
 }
 
 BUILTIN_RETTYPE(FLOAT)
@@ -208,6 +233,62 @@ BUILTIN_OPR(GE)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(FLOAT_hash)
+{
+    VecFuncUnary<float, uint64_t>(vfcinfo_, [](float val) -> uint64_t {
+        return HashDouble(val);
+    });
+}
+
+BUILTIN_VECFUNC(FLOAT_add)
+{
+    VecFuncBinary<float, float, float>(vfcinfo_, std::plus<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_sub)
+{
+    VecFuncBinary<float, float, float>(vfcinfo_, std::minus<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_mul)
+{
+    VecFuncBinary<float, float, float>(vfcinfo_, std::multiplies<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_div)
+{
+    VecFuncBinary<float, float, float>(vfcinfo_, std::divides<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_eq)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::equal_to<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_ne)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::not_equal_to<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_lt)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::less<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_le)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::less_equal<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_gt)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::greater<float>());
+}
+
+BUILTIN_VECFUNC(FLOAT_ge)
+{
+    VecFuncBinary<float, float, bool>(vfcinfo_, std::greater_equal<float>());
+}
 
 }   // namespace taco
 
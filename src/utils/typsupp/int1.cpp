@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(INT1)
 BUILTIN_FUNC(INT1_in, 500)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(INT1)
     }
 
     int8_t val = FMGR_ARG(0).GetInt8();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRId8, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(INT1_nkey, 520)
+BUILTIN_ARGTYPE(INT1)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(int8_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetInt8());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(INT1_hash, 521)
+BUILTIN_ARGTYPE(INT1)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetInt8()));
 }
 
 BUILTIN_RETTYPE(INT1)
@@ -327,6 +347,71 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(INT1_hash)
+{
+    VecFuncUnary<int8_t, uint64_t>(vfcinfo_, [](int8_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(INT1_add)
+{
+    VecFuncBinary<int8_t, int8_t, int8_t>(vfcinfo_, std::plus<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_sub)
+{
+    VecFuncBinary<int8_t, int8_t, int8_t>(vfcinfo_, std::minus<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_mul)
+{
+    VecFuncBinary<int8_t, int8_t, int8_t>(vfcinfo_, std::multiplies<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_div)
+{
+    VecFuncBinaryNonZeroDivisor<int8_t, int8_t, int8_t>(
+        vfcinfo_, std::divides<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_mod)
+{
+    VecFuncBinaryNonZeroDivisor<int8_t, int8_t, int8_t>(
+        vfcinfo_, std::modulus<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_eq)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_, std::equal_to<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_ne)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_, std::not_equal_to<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_lt)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_, std::less<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_le)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_, std::less_equal<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_gt)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_, std::greater<int8_t>());
+}
+
+BUILTIN_VECFUNC(INT1_ge)
+{
+    VecFuncBinary<int8_t, int8_t, bool>(vfcinfo_,
+                                        std::greater_equal<int8_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_INT1_H
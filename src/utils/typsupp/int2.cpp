@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(INT2)
 BUILTIN_FUNC(INT2_in, 530)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(INT2)
     }
 
     int16_t val = FMGR_ARG(0).GetInt16();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRId16, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(INT2_nkey, 550)
+BUILTIN_ARGTYPE(INT2)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(int16_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetInt16());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(INT2_hash, 551)
+BUILTIN_ARGTYPE(INT2)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetInt16()));
 }
 
 BUILTIN_RETTYPE(INT2)
@@ -327,6 +347,74 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(INT2_hash)
+{
+    VecFuncUnary<int16_t, uint64_t>(vfcinfo_, [](int16_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(INT2_add)
+{
+    VecFuncBinary<int16_t, int16_t, int16_t>(vfcinfo_, std::plus<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_sub)
+{
+    VecFuncBinary<int16_t, int16_t, int16_t>(vfcinfo_, std::minus<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_mul)
+{
+    VecFuncBinary<int16_t, int16_t, int16_t>(vfcinfo_,
+                                             std::multiplies<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_div)
+{
+    VecFuncBinaryNonZeroDivisor<int16_t, int16_t, int16_t>(
+        vfcinfo_, std::divides<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_mod)
+{
+    VecFuncBinaryNonZeroDivisor<int16_t, int16_t, int16_t>(
+        vfcinfo_, std::modulus<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_eq)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_, std::equal_to<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_ne)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_,
+                                          std::not_equal_to<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_lt)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_, std::less<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_le)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_,
+                                          std::less_equal<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_gt)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_, std::greater<int16_t>());
+}
+
+BUILTIN_VECFUNC(INT2_ge)
+{
+    VecFuncBinary<int16_t, int16_t, bool>(vfcinfo_,
+                                          std::greater_equal<int16_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_INT2_H
@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(INT4)
 BUILTIN_FUNC(INT4_in, 560)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(INT4)
     }
 
     int32_t val = FMGR_ARG(0).GetInt32();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRId32, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(INT4_nkey, 580)
+BUILTIN_ARGTYPE(INT4)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(int32_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetInt32());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(INT4_hash, 581)
+BUILTIN_ARGTYPE(INT4)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetInt32()));
 }
 
 BUILTIN_RETTYPE(INT4)
@@ -327,6 +347,74 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(INT4_hash)
+{
+    VecFuncUnary<int32_t, uint64_t>(vfcinfo_, [](int32_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(INT4_add)
+{
+    VecFuncBinary<int32_t, int32_t, int32_t>(vfcinfo_, std::plus<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_sub)
+{
+    VecFuncBinary<int32_t, int32_t, int32_t>(vfcinfo_, std::minus<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_mul)
+{
+    VecFuncBinary<int32_t, int32_t, int32_t>(vfcinfo_,
+                                             std::multiplies<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_div)
+{
+    VecFuncBinaryNonZeroDivisor<int32_t, int32_t, int32_t>(
+        vfcinfo_, std::divides<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_mod)
+{
+    VecFuncBinaryNonZeroDivisor<int32_t, int32_t, int32_t>(
+        vfcinfo_, std::modulus<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_eq)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_, std::equal_to<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_ne)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_,
+                                          std::not_equal_to<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_lt)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_, std::less<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_le)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_,
+                                          std::less_equal<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_gt)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_, std::greater<int32_t>());
+}
+
+BUILTIN_VECFUNC(INT4_ge)
+{
+    VecFuncBinary<int32_t, int32_t, bool>(vfcinfo_,
+                                          std::greater_equal<int32_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_INT4_H
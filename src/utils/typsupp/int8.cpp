@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(INT8)
 BUILTIN_FUNC(INT8_in, 590)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(INT8)
     }
 
     int64_t val = FMGR_ARG(0).GetInt64();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRId64, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(INT8_nkey, 610)
+BUILTIN_ARGTYPE(INT8)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(int64_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetInt64());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(INT8_hash, 611)
+BUILTIN_ARGTYPE(INT8)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetInt64()));
 }
 
 BUILTIN_RETTYPE(INT8)
@@ -327,6 +347,74 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(INT8_hash)
+{
+    VecFuncUnary<int64_t, uint64_t>(vfcinfo_, [](int64_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(INT8_add)
+{
+    VecFuncBinary<int64_t, int64_t, int64_t>(vfcinfo_, std::plus<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_sub)
+{
+    VecFuncBinary<int64_t, int64_t, int64_t>(vfcinfo_, std::minus<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_mul)
+{
+    VecFuncBinary<int64_t, int64_t, int64_t>(vfcinfo_,
+                                             std::multiplies<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_div)
+{
+    VecFuncBinaryNonZeroDivisor<int64_t, int64_t, int64_t>(
+        vfcinfo_, std::divides<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_mod)
+{
+    VecFuncBinaryNonZeroDivisor<int64_t, int64_t, int64_t>(
+        vfcinfo_, std::modulus<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_eq)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_, std::equal_to<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_ne)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_,
+                                          std::not_equal_to<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_lt)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_, std::less<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_le)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_,
+                                          std::less_equal<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_gt)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_, std::greater<int64_t>());
+}
+
+BUILTIN_VECFUNC(INT8_ge)
+{
+    VecFuncBinary<int64_t, int64_t, bool>(vfcinfo_,
+                                          std::greater_equal<int64_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_INT8_H
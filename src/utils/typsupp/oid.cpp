@@ -7,17 +7,13 @@
 #include <cinttypes>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(OID)
 BUILTIN_FUNC(OID_in, 740)
 BUILTIN_ARGTYPE(__STRING)
@@ -43,10 +39,33 @@ BUILTIN_ARGTYPE(OID)
     }
 
     Oid val = FMGR_ARG(0).GetOid();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRIu32, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(OID_nkey, 748)
+BUILTIN_ARGTYPE(OID)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(Oid)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetOid());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(OID_hash, 749)
+BUILTIN_ARGTYPE(OID)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetOid()));
 }
 
 BUILTIN_RETTYPE(BOOL)
@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(UINT1)
 BUILTIN_FUNC(UINT1_in, 620)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(UINT1)
     }
 
     uint8_t val = FMGR_ARG(0).GetUInt8();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRIu8, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(UINT1_nkey, 640)
+BUILTIN_ARGTYPE(UINT1)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(uint8_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetUInt8());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(UINT1_hash, 641)
+BUILTIN_ARGTYPE(UINT1)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetUInt8()));
 }
 
 BUILTIN_RETTYPE(UINT1)
@@ -327,6 +347,74 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(UINT1_hash)
+{
+    VecFuncUnary<uint8_t, uint64_t>(vfcinfo_, [](uint8_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(UINT1_add)
+{
+    VecFuncBinary<uint8_t, uint8_t, uint8_t>(vfcinfo_, std::plus<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_sub)
+{
+    VecFuncBinary<uint8_t, uint8_t, uint8_t>(vfcinfo_, std::minus<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_mul)
+{
+    VecFuncBinary<uint8_t, uint8_t, uint8_t>(vfcinfo_,
+                                             std::multiplies<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_div)
+{
+    VecFuncBinaryNonZeroDivisor<uint8_t, uint8_t, uint8_t>(
+        vfcinfo_, std::divides<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_mod)
+{
+    VecFuncBinaryNonZeroDivisor<uint8_t, uint8_t, uint8_t>(
+        vfcinfo_, std::modulus<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_eq)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_, std::equal_to<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_ne)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_,
+                                          std::not_equal_to<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_lt)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_, std::less<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_le)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_,
+                                          std::less_equal<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_gt)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_, std::greater<uint8_t>());
+}
+
+BUILTIN_VECFUNC(UINT1_ge)
+{
+    VecFuncBinary<uint8_t, uint8_t, bool>(vfcinfo_,
+                                          std::greater_equal<uint8_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_UINT1_H
@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(UINT2)
 BUILTIN_FUNC(UINT2_in, 650)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(UINT2)
     }
 
     uint16_t val = FMGR_ARG(0).GetUInt16();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRIu16, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(UINT2_nkey, 670)
+BUILTIN_ARGTYPE(UINT2)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(uint16_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetUInt16());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(UINT2_hash, 671)
+BUILTIN_ARGTYPE(UINT2)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetUInt16()));
 }
 
 BUILTIN_RETTYPE(UINT2)
@@ -327,6 +347,78 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(UINT2_hash)
+{
+    VecFuncUnary<uint16_t, uint64_t>(vfcinfo_, [](uint16_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(UINT2_add)
+{
+    VecFuncBinary<uint16_t, uint16_t, uint16_t>(vfcinfo_,
+                                                std::plus<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_sub)
+{
+    VecFuncBinary<uint16_t, uint16_t, uint16_t>(vfcinfo_,
+                                                std::minus<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_mul)
+{
+    VecFuncBinary<uint16_t, uint16_t, uint16_t>(vfcinfo_,
+                                                std::multiplies<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_div)
+{
+    VecFuncBinaryNonZeroDivisor<uint16_t, uint16_t, uint16_t>(
+        vfcinfo_, std::divides<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_mod)
+{
+    VecFuncBinaryNonZeroDivisor<uint16_t, uint16_t, uint16_t>(
+        vfcinfo_, std::modulus<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_eq)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_,
+                                            std::equal_to<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_ne)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_,
+                                            std::not_equal_to<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_lt)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_, std::less<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_le)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_,
+                                            std::less_equal<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_gt)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_,
+                                            std::greater<uint16_t>());
+}
+
+BUILTIN_VECFUNC(UINT2_ge)
+{
+    VecFuncBinary<uint16_t, uint16_t, bool>(vfcinfo_,
+                                            std::greater_equal<uint16_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_UINT2_H
@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(UINT4)
 BUILTIN_FUNC(UINT4_in, 680)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(UINT4)
     }
 
     uint32_t val = FMGR_ARG(0).GetUInt32();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRIu32, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(UINT4_nkey, 700)
+BUILTIN_ARGTYPE(UINT4)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(uint32_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetUInt32());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(UINT4_hash, 701)
+BUILTIN_ARGTYPE(UINT4)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetUInt32()));
 }
 
 BUILTIN_RETTYPE(UINT4)
@@ -327,6 +347,78 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(UINT4_hash)
+{
+    VecFuncUnary<uint32_t, uint64_t>(vfcinfo_, [](uint32_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(UINT4_add)
+{
+    VecFuncBinary<uint32_t, uint32_t, uint32_t>(vfcinfo_,
+                                                std::plus<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_sub)
+{
+    VecFuncBinary<uint32_t, uint32_t, uint32_t>(vfcinfo_,
+                                                std::minus<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_mul)
+{
+    VecFuncBinary<uint32_t, uint32_t, uint32_t>(vfcinfo_,
+                                                std::multiplies<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_div)
+{
+    VecFuncBinaryNonZeroDivisor<uint32_t, uint32_t, uint32_t>(
+        vfcinfo_, std::divides<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_mod)
+{
+    VecFuncBinaryNonZeroDivisor<uint32_t, uint32_t, uint32_t>(
+        vfcinfo_, std::modulus<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_eq)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_,
+                                            std::equal_to<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_ne)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_,
+                                            std::not_equal_to<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_lt)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_, std::less<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_le)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_,
+                                            std::less_equal<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_gt)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_,
+                                            std::greater<uint32_t>());
+}
+
+BUILTIN_VECFUNC(UINT4_ge)
+{
+    VecFuncBinary<uint32_t, uint32_t, bool>(vfcinfo_,
+                                            std::greater_equal<uint32_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_UINT4_H
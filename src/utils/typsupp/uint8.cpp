@@ -9,17 +9,14 @@
 #include <absl/strings/numbers.h>
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/numbers.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
-namespace {
-
-// The longest 64-bit integer is 20 digits long. Adding a possible sign and
-// the space for '\0' gives us 22.
-constexpr const size_t STRING_OUTPUT_BUFLEN = 22;
-}
-
 BUILTIN_RETTYPE(UINT8)
 BUILTIN_FUNC(UINT8_in, 710)
 BUILTIN_ARGTYPE(__STRING)
@@ -45,10 +42,33 @@ BUILTIN_ARGTYPE(UINT8)
     }
 
     uint64_t val = FMGR_ARG(0).GetUInt64();
-    auto buffer = unique_malloc(STRING_OUTPUT_BUFLEN);
-    absl::SNPrintF((char*) buffer.get(), STRING_OUTPUT_BUFLEN, "%" PRIu64, val);
-    return Datum::FromVarlenBytes(std::move(buffer),
-                                  strlen((char*) buffer.get()));
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return CreateVarlenDatum(buf, (uint32_t) len);
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(UINT8_nkey, 730)
+BUILTIN_ARGTYPE(UINT8)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    char buf[sizeof(uint64_t)];
+    NKeyStoreInteger(buf, FMGR_ARG(0).GetUInt64());
+    return CreateVarlenDatum(buf, sizeof(buf));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(UINT8_hash, 731)
+BUILTIN_ARGTYPE(UINT8)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    return Datum::From(HashInteger((uint64_t) FMGR_ARG(0).GetUInt64()));
 }
 
 BUILTIN_RETTYPE(UINT8)
@@ -327,6 +347,78 @@ BUILTIN_OPR(RSH)
     return Datum::From(res);
 }
 
+BUILTIN_VECFUNC(UINT8_hash)
+{
+    VecFuncUnary<uint64_t, uint64_t>(vfcinfo_, [](uint64_t val) -> uint64_t {
+        return HashInteger((uint64_t) val);
+    });
+}
+
+BUILTIN_VECFUNC(UINT8_add)
+{
+    VecFuncBinary<uint64_t, uint64_t, uint64_t>(vfcinfo_,
+                                                std::plus<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_sub)
+{
+    VecFuncBinary<uint64_t, uint64_t, uint64_t>(vfcinfo_,
+                                                std::minus<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_mul)
+{
+    VecFuncBinary<uint64_t, uint64_t, uint64_t>(vfcinfo_,
+                                                std::multiplies<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_div)
+{
+    VecFuncBinaryNonZeroDivisor<uint64_t, uint64_t, uint64_t>(
+        vfcinfo_, std::divides<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_mod)
+{
+    VecFuncBinaryNonZeroDivisor<uint64_t, uint64_t, uint64_t>(
+        vfcinfo_, std::modulus<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_eq)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_,
+                                            std::equal_to<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_ne)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_,
+                                            std::not_equal_to<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_lt)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_, std::less<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_le)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_,
+                                            std::less_equal<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_gt)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_,
+                                            std::greater<uint64_t>());
+}
+
+BUILTIN_VECFUNC(UINT8_ge)
+{
+    VecFuncBinary<uint64_t, uint64_t, bool>(vfcinfo_,
+                                            std::greater_equal<uint64_t>());
+}
+
 }   // namespace taco
 
 #endif      // UTILS_TYPSUPP_UINT8_H
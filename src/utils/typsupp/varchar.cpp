@@ -13,7 +13,11 @@
 #include "tdb.h"
 
 #include "utils/builtin_funcs.h"
+#include "utils/hash.h"
+#include "utils/MemoryContext.h"
 #include "utils/string_utils.h"
+#include "utils/typsupp/nkey.h"
+#include "utils/typsupp/vecfuncs.h"
 
 namespace taco {
 
@@ -43,9 +47,7 @@ BUILTIN_ARGTYPE(__STRING)
                     "specified maximum %lu", size, max_size);
     }
 
-    auto buffer = unique_malloc(size);
-    memcpy(buffer.get(), str.data(), size);
-    return Datum::FromVarlenBytes(std::move(buffer), size);
+    return CreateVarlenDatum(str.data(), size);
 }
 
 BUILTIN_RETTYPE(__STRING)
@@ -59,9 +61,59 @@ BUILTIN_ARGTYPE(VARCHAR)
     absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
 
     // must make a copy in the output function
-    auto buffer = unique_malloc(str.size());
-    memcpy(buffer.get(), str.data(), str.size());
-    return Datum::FromVarlenBytes(std::move(buffer), str.size());
+    return CreateVarlenDatum(str.data(), str.size());
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(VARCHAR_nkey, 880)
+BUILTIN_ARGTYPE(VARCHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
+    return CreateVarlenDatum(NKeyStringLength(str), [&](char *buf) {
+        NKeyStoreString(buf, str, false);
+    });
+}
+
+BUILTIN_RETTYPE(__STRING)
+BUILTIN_FUNC(VARCHAR_nkey_ci, 881)
+BUILTIN_ARGTYPE(VARCHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
+    return CreateVarlenDatum(NKeyStringLength(str), [&](char *buf) {
+        NKeyStoreString(buf, str, true);
+    });
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(VARCHAR_hash, 882)
+BUILTIN_ARGTYPE(VARCHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
+    return Datum::From(HashBytes(str));
+}
+
+BUILTIN_RETTYPE(UINT8)
+BUILTIN_FUNC(VARCHAR_hash_ci, 883)
+BUILTIN_ARGTYPE(VARCHAR)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
+    return Datum::From(HashBytesCI(str));
 }
 
 BUILTIN_RETTYPE(INT2)
@@ -91,10 +143,10 @@ BUILTIN_ARGTYPE(VARCHAR, VARCHAR)
         LOG(kError, "string too long: %lu", new_sz);
     }
 
-    char *str = (char*) malloc(new_sz);
-    memcpy(str, str0.data(), str0.size());
-    memcpy(str + str0.size(), str1.data(), str1.size());
-    return Datum::FromVarlenBytes(unique_malloced_ptr(str), new_sz);
+    return CreateVarlenDatum(new_sz, [&](char *str) {
+        memcpy(str, str0.data(), str0.size());
+        memcpy(str + str0.size(), str1.data(), str1.size());
+    });
 }
 
 BUILTIN_RETTYPE(BOOL)
@@ -207,12 +259,31 @@ BUILTIN_OPR(CAST)
         }
     }
 
-    auto buffer = unique_malloc(max_size);
-    memcpy(buffer.get(), str.data(), str.size());
-    // fill the trailing spaces
-    if (str.size() < max_size)
-        memset((char*) buffer.get() + str.size(), ' ', max_size - str.size());
-    return Datum::FromVarlenBytes(std::move(buffer), max_size);
+    return CreateVarlenDatum(max_size, [&](char *buffer) {
+        memcpy(buffer, str.data(), str.size());
+        // fill the trailing spaces
+        if (str.size() < max_size)
+            memset(buffer + str.size(), ' ', max_size - str.size());
+    });
+}
+
+BUILTIN_RETTYPE(VARCHAR)
+BUILTIN_FUNC(VARCHAR_to_VARCHAR, 862)
+BUILTIN_ARGTYPE(VARCHAR)
+BUILTIN_OPR(CAST)
+{
+    if (FMGR_ARG(0).isnull()) {
+        return Datum::FromNull();
+    }
+
+    uint64_t max_size = FMGR_TYPPARAM();
+
+    absl::string_view &&str = varchar_to_string_view(FMGR_ARG(0));
+    // silently truncated to the new max size
+    if (max_size != 0 && str.size() > max_size) {
+        str = str.substr(0, max_size);
+    }
+    return CreateVarlenDatum(str.data(), str.size());
 }
 
 // compares a varchar to an internal string
@@ -327,6 +398,50 @@ BUILTIN_ARGTYPE(VARCHAR, __STRING)
     return Datum::From(string_equal_ci(str0, str1));
 }
 
+BUILTIN_VECFUNC(VARCHAR_hash)
+{
+    VecFuncUnary<absl::string_view, uint64_t>(vfcinfo_,
+        [](absl::string_view str) -> uint64_t {
+            return HashBytes(str);
+        });
+}
+
+BUILTIN_VECFUNC(VARCHAR_eq)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::equal_to<absl::string_view>());
+}
+
+BUILTIN_VECFUNC(VARCHAR_ne)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::not_equal_to<absl::string_view>());
+}
+
+BUILTIN_VECFUNC(VARCHAR_lt)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::less<absl::string_view>());
+}
+
+BUILTIN_VECFUNC(VARCHAR_le)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::less_equal<absl::string_view>());
+}
+
+BUILTIN_VECFUNC(VARCHAR_gt)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::greater<absl::string_view>());
+}
+
+BUILTIN_VECFUNC(VARCHAR_ge)
+{
+    VecFuncBinary<absl::string_view, absl::string_view, bool>(
+        vfcinfo_, std::greater_equal<absl::string_view>());
+}
+
 }
 
 #endif      // UTILS_TYPSUPP_VARCHAR_H
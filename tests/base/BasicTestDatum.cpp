@@ -0,0 +1,135 @@
+#include "base/TDBNonDBTest.h"
+
+#include "utils/MemoryContext.h"
+
+namespace taco {
+
+using BasicTestDatum = TDBNonDBTest;
+
+static std::string
+MakeString(size_t len) {
+    std::string str;
+    for (size_t i = 0; i < len; ++i) {
+        str.push_back((char)('a' + i % 26));
+    }
+    return str;
+}
+
+/*!
+ * Returns whether \p p points into the object \p d.
+ */
+static bool
+PointsInto(const char *p, const Datum &d) {
+    const char *begin = (const char *) &d;
+    return p >= begin && p < begin + sizeof(Datum);
+}
+
+TEST_F(BasicTestDatum, TestInlineBoundary) {
+    TDB_TEST_BEGIN
+    for (uint32_t size : { Datum::MaxInlineVarlenSize,
+                           Datum::MaxInlineVarlenSize + 1 }) {
+        SCOPED_TRACE(size);
+        const bool is_inline = (size <= Datum::MaxInlineVarlenSize);
+        std::string str = MakeString(size);
+
+        Datum d = CreateVarlenDatum(str.data(), size);
+        ASSERT_FALSE(d.isnull());
+        EXPECT_EQ(d.IsInlineVarlen(), is_inline);
+        EXPECT_FALSE(d.HasExternalRef());
+        EXPECT_EQ(d.GetVarlenSize(), size);
+        EXPECT_EQ(PointsInto(d.GetVarlenBytes(), d), is_inline);
+        EXPECT_EQ(d.GetVarlenAsStringView(), str);
+
+        // An inline value moves along with the datum, while an out-of-line
+        // one is handed over to the new datum.
+        const char *old_bytes = d.GetVarlenBytes();
+        Datum d2(std::move(d));
+        EXPECT_TRUE(d.isnull());
+        EXPECT_EQ(d2.IsInlineVarlen(), is_inline);
+        EXPECT_EQ(d2.GetVarlenAsStringView(), str);
+        EXPECT_EQ(d2.GetVarlenBytes() == old_bytes, !is_inline);
+        EXPECT_EQ(PointsInto(d2.GetVarlenBytes(), d2), is_inline);
+
+        Datum d3 = Datum::FromNull();
+        d3 = std::move(d2);
+        EXPECT_TRUE(d2.isnull());
+        EXPECT_EQ(d3.GetVarlenAsStringView(), str);
+        EXPECT_EQ(DatumRef(d3).GetVarlenAsStringView(), str);
+        EXPECT_EQ(NullableDatumRef(d3).GetVarlenSize(), size);
+
+        // A deep copy of an owned or inline value is independent of it.
+        Datum copy = d3.DeepCopy();
+        EXPECT_EQ(copy.IsInlineVarlen(), is_inline);
+        EXPECT_FALSE(copy.HasExternalRef());
+        EXPECT_EQ(copy.GetVarlenAsStringView(), str);
+        if (!is_inline) {
+            EXPECT_NE(copy.GetVarlenBytes(), d3.GetVarlenBytes());
+        }
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestDatum, TestExternalRefAtBoundary) {
+    TDB_TEST_BEGIN
+    for (uint32_t size : { Datum::MaxInlineVarlenSize,
+                           Datum::MaxInlineVarlenSize + 1 }) {
+        SCOPED_TRACE(size);
+        const bool is_inline = (size <= Datum::MaxInlineVarlenSize);
+        std::string str = MakeString(size);
+
+        // A reference to the caller's bytes is never inline.
+        Datum ref = Datum::FromVarlenBytes(str.data(), size);
+        EXPECT_FALSE(ref.IsInlineVarlen());
+        EXPECT_TRUE(ref.HasExternalRef());
+        EXPECT_EQ(ref.GetVarlenBytes(), str.data());
+
+        // Its deep copy is inline if it fits, or owned otherwise, so that it
+        // survives the referenced bytes.
+        Datum copy = ref.DeepCopy();
+        EXPECT_EQ(copy.IsInlineVarlen(), is_inline);
+        EXPECT_FALSE(copy.HasExternalRef());
+        str.assign(size, '*');
+        EXPECT_EQ(copy.GetVarlenAsStringView(), MakeString(size));
+        EXPECT_EQ(ref.GetVarlenAsStringView(), str);
+
+        // The values in a memory context are not owned by the datums.
+        MemoryContext mctx;
+        ScopedMemoryContext scoped_mctx(&mctx);
+        Datum d = CreateVarlenDatum(str.data(), size);
+        EXPECT_EQ(d.IsInlineVarlen(), is_inline);
+        EXPECT_EQ(d.HasExternalRef(), !is_inline);
+        EXPECT_EQ(d.GetVarlenAsStringView(), str);
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestDatum, TestOwnershipReleasedOnMove) {
+    TDB_TEST_BEGIN
+    // Each owned value below must be freed exactly once, which the address
+    // sanitizer checks.
+    constexpr uint32_t size = Datum::MaxInlineVarlenSize + 1;
+    std::string str = MakeString(size);
+    std::vector<Datum> data;
+    for (int i = 0; i < 100; ++i) {
+        unique_malloced_ptr bytes = unique_malloc(size);
+        memcpy(bytes.get(), str.data(), size);
+        data.emplace_back(Datum::FromVarlenBytes(std::move(bytes), size));
+        EXPECT_FALSE(data.back().HasExternalRef());
+    }
+    // Growing and shrinking the vector moves the datums.
+    std::vector<Datum> data2;
+    for (Datum &d : data) {
+        data2.emplace_back(std::move(d));
+    }
+    data.clear();
+    data2.erase(data2.begin(), data2.begin() + 50);
+    for (const Datum &d : data2) {
+        EXPECT_EQ(d.GetVarlenAsStringView(), str);
+    }
+
+    // A null owned pointer is a null datum.
+    EXPECT_TRUE(Datum::FromVarlenBytes(unique_malloced_ptr(), size).isnull());
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,156 @@
+#include "base/TDBDBTest.h"
+
+#include <thread>
+
+#include <absl/strings/str_cat.h>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+
+namespace taco {
+
+using BasicTestCatCacheConcurrentLookup = TDBDBTest;
+
+static constexpr int NumReaders = 8;
+static constexpr int NumNewTables = 200;
+
+TEST_F(BasicTestCatCacheConcurrentLookup, TestConcurrentMap) {
+    TDB_TEST_BEGIN
+
+    EpochManager epoch;
+    CCConcurrentMap<uint64_t, uint64_t> map;
+    constexpr uint64_t NumKeys = 100000;
+    atomic<uint64_t> num_inserted(0);
+    atomic<bool> failed(false);
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < NumReaders; ++i) {
+        readers.emplace_back([&]() {
+            while (num_inserted.load(memory_order_acquire) < NumKeys) {
+                uint64_t n = num_inserted.load(memory_order_acquire);
+                EpochGuard epoch_guard(&epoch);
+                for (uint64_t key = 0; key < n; key += 97) {
+                    const uint64_t *value = map.Find(key);
+                    if (!value || *value != key * 3 + 1) {
+                        failed.store(true, memory_order_relaxed);
+                    }
+                }
+                if (map.Find(NumKeys + n)) {
+                    failed.store(true, memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (uint64_t key = 0; key < NumKeys; ++key) {
+        ASSERT_TRUE(map.Insert(&epoch, key, key * 3 + 1));
+        num_inserted.store(key + 1, memory_order_release);
+    }
+    for (std::thread &t : readers) {
+        t.join();
+    }
+    EXPECT_FALSE(failed.load());
+
+    ASSERT_FALSE(map.Insert(&epoch, 10, 0));
+    map.InsertOrAssign(&epoch, 10, 5);
+    EpochGuard epoch_guard(&epoch);
+    ASSERT_NE(map.Find(10), nullptr);
+    EXPECT_EQ(*map.Find(10), 5u);
+    EXPECT_EQ(map.Find(NumKeys), nullptr);
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestCatCacheConcurrentLookup, TestConcurrentLookupsAndInserts) {
+    TDB_TEST_BEGIN
+
+    std::vector<Oid> new_tabids(NumNewTables, InvalidOid);
+    atomic<int> num_new_tables(0);
+    atomic<int> num_failed_readers(0);
+
+    auto reader = [&]() {
+        TDBError e = R([&]() {
+            do {
+                int n = num_new_tables.load(memory_order_acquire);
+                if (g_catcache->FindTableByName("table") !=
+                        initoids::TAB_Table ||
+                    g_catcache->FindTableByName("Column") !=
+                        initoids::TAB_Column ||
+                    !g_catcache->FindType(initoids::TYP_INT4) ||
+                    !g_catcache->FindTableDesc(initoids::TAB_Index) ||
+                    !g_catcache->FindFunctionArgs(initoids::FUNC_INT4_eq, 0) ||
+                    g_catcache->FindOperator(OPTYPE(EQ), initoids::TYP_INT4,
+                                             initoids::TYP_INT4) !=
+                        initoids::FUNC_INT4_eq ||
+                    g_catcache->FindOperator(OPTYPE(EQ), initoids::TYP_INT4,
+                                             initoids::TYP_VARCHAR) !=
+                        InvalidOid) {
+                    LOG(kError, "unexpected result of a system table lookup");
+                }
+                for (int i = 0; i < n; ++i) {
+                    std::string tabname = absl::StrCat("T", i);
+                    Oid tabid = g_catcache->FindTableByName(tabname);
+                    if (tabid != new_tabids[i]) {
+                        LOG(kError, "table %s not found", tabname);
+                    }
+                    const TableDesc *tabdesc = g_catcache->FindTableDesc(tabid);
+                    if (!tabdesc || tabdesc->GetSchema()->GetNumFields() != 2) {
+                        LOG(kError, "wrong table descriptor of %s", tabname);
+                    }
+                    if (g_catcache->FindAllIndexesOfTable(tabid).size() > 1) {
+                        LOG(kError, "table %s has too many indexes", tabname);
+                    }
+                }
+            } while (num_new_tables.load(memory_order_acquire) <
+                     NumNewTables);
+        });
+        if (e.GetSeverity() != kNoError) {
+            num_failed_readers.fetch_add(1, memory_order_relaxed);
+            std::cerr << e.GetMessage() << std::endl;
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < NumReaders; ++i) {
+        readers.emplace_back(reader);
+    }
+
+    // The tables and indexes are never accessed, so any file ID will do.
+    for (int i = 0; i < NumNewTables; ++i) {
+        new_tabids[i] = g_catcache->AddTable(
+            absl::StrCat("t", i), {initoids::TYP_INT4, initoids::TYP_VARCHAR},
+            {0, 20}, {"a", "b"}, {false, true}, {false, false}, 1);
+        ASSERT_NE(new_tabids[i], InvalidOid);
+        num_new_tables.store(i + 1, memory_order_release);
+        if (i % 2 == 0) {
+            ASSERT_EQ(g_catcache->FindAllIndexesOfTable(new_tabids[i]).size(),
+                      0u);
+            Oid idxid = g_catcache->AddIndex(
+                absl::StrCat("t", i, "_a"), new_tabids[i], IDXTYP(BTREE),
+                true, {0}, {}, 1, {}, {});
+            ASSERT_NE(idxid, InvalidOid);
+        }
+    }
+
+    for (std::thread &t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(num_failed_readers.load(), 0);
+
+    for (int i = 0; i < NumNewTables; ++i) {
+        std::vector<Oid> idxids =
+            g_catcache->FindAllIndexesOfTable(new_tabids[i]);
+        if (i % 2 == 0) {
+            ASSERT_EQ(idxids.size(), 1u);
+            EXPECT_EQ(idxids[0], g_catcache->FindIndexByName(
+                absl::StrCat("T", i, "_A")));
+        } else {
+            EXPECT_TRUE(idxids.empty());
+        }
+    }
+
+    TDB_TEST_END
+}
+
+}   // namespace taco
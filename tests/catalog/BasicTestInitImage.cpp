@@ -0,0 +1,102 @@
+#include "base/TDBDBTest.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <absl/flags/declare.h>
+#include <absl/flags/flag.h>
+#include <absl/flags/reflection.h>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+
+ABSL_DECLARE_FLAG(std::string, init_data);
+ABSL_DECLARE_FLAG(std::string, init_image);
+
+namespace taco {
+
+using BasicTestInitImage = TDBDBTest;
+
+static std::string
+ReadFile(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    std::ostringstream oss;
+    oss << f.rdbuf();
+    return oss.str();
+}
+
+static void
+WriteFile(const std::string &path, const std::string &bytes) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(bytes.data(), bytes.size());
+}
+
+TEST_F(BasicTestInitImage, TestPrebuiltImageMatchesInitData) {
+    TDB_TEST_BEGIN
+    const std::string init_data = absl::GetFlag(FLAGS_init_data);
+    const std::string prebuilt = ReadFile(absl::GetFlag(FLAGS_init_image));
+    ASSERT_FALSE(prebuilt.empty());
+
+    // The database opened in SetUp() is created from the prebuilt image, and
+    // writes it back as is.
+    std::string from_image = MakeTempFile();
+    g_catcache->WriteInitImage(from_image, init_data);
+    EXPECT_TRUE(ReadFile(from_image) == prebuilt);
+
+    // A database bootstrapped from the init data file has the same catalog
+    // files, record by record, and the same next OID.
+    absl::FlagSaver flag_saver;
+    absl::SetFlag(&FLAGS_init_image, "");
+    ASSERT_NO_ERROR(g_db->close());
+    ASSERT_NO_ERROR(g_db->open(MakeTempDir(), GetBufferPoolSize(), true,
+                               false));
+    std::string from_init_data = MakeTempFile();
+    g_catcache->WriteInitImage(from_init_data, init_data);
+    EXPECT_TRUE(ReadFile(from_init_data) == prebuilt);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestInitImage, TestCreateFromImage) {
+    TDB_TEST_BEGIN
+    // The image is built for an init data file that does not exist, so a
+    // database can only be created from the image.
+    const std::string init_data = absl::GetFlag(FLAGS_init_data);
+    const std::string missing_init_data = MakeTempDir() + "/init.dat";
+    std::string image_path = MakeTempFile();
+    g_catcache->WriteInitImage(image_path, missing_init_data);
+
+    absl::FlagSaver flag_saver;
+    absl::SetFlag(&FLAGS_init_data, missing_init_data);
+    absl::SetFlag(&FLAGS_init_image, image_path);
+    ASSERT_NO_ERROR(g_db->close());
+    ASSERT_NO_ERROR(g_db->open(MakeTempDir(), GetBufferPoolSize(), true,
+                               false));
+    EXPECT_EQ(g_catcache->FindTableByName("Table"), initoids::TAB_Table);
+    EXPECT_EQ(g_catcache->FindOperator(OPTYPE(EQ), initoids::TYP_INT4,
+                                       initoids::TYP_INT4),
+              initoids::FUNC_INT4_eq);
+    Oid tabid = g_catcache->AddTable("t", {initoids::TYP_INT4}, {}, {"a"},
+                                     {false}, {false}, 2);
+    ASSERT_NE(tabid, InvalidOid);
+    EXPECT_EQ(g_catcache->FindTableByName("t"), tabid);
+
+    // A corrupted image is ignored with a warning, and the database is
+    // bootstrapped from the init data file instead.
+    std::string image = ReadFile(image_path);
+    ASSERT_GT(image.size(), 100u);
+    image[image.size() / 2] ^= 1;
+    WriteFile(image_path, image);
+    absl::SetFlag(&FLAGS_init_data, init_data);
+    ASSERT_NO_ERROR(g_db->close());
+    EnableCaptureWarning();
+    ASSERT_NO_ERROR(g_db->open(MakeTempDir(), GetBufferPoolSize(), true,
+                               false));
+    EXPECT_NE(CapturedMessage().find("corrupted catalog image"),
+              std::string::npos);
+    DisableCaptureLog();
+    EXPECT_EQ(g_catcache->FindTableByName("Table"), initoids::TAB_Table);
+    EXPECT_EQ(g_catcache->FindTableByName("t"), InvalidOid);
+    TDB_TEST_END
+}
+
+}   // namespace taco
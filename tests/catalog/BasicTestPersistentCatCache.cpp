@@ -0,0 +1,92 @@
+#include "base/TDBDBTest.h"
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+
+namespace taco {
+
+/*!
+ * This test is only built when the persistent catalog cache is configured
+ * (i.e., -DUSE_VOLATILE_CATCACHE=OFF), as the volatile one can't reopen a
+ * database.
+ */
+using BasicTestPersistentCatCache = TDBDBTest;
+
+TEST_F(BasicTestPersistentCatCache, TestCreateCloseOpen) {
+    TDB_TEST_BEGIN
+    const std::string db_path = g_db->GetLastDBPath();
+    Oid tabid = g_catcache->AddTable("t",
+        {initoids::TYP_INT4, initoids::TYP_VARCHAR}, {0, 20}, {"a", "b"},
+        {false, true}, {false, false}, 2);
+    ASSERT_NE(tabid, InvalidOid);
+    Oid idxid = g_catcache->AddIndex("t_a", tabid, IDXTYP(BTREE), true, {0},
+                                     {1}, 3, {}, {});
+    ASSERT_NE(idxid, InvalidOid);
+
+    ASSERT_NO_ERROR(g_db->close());
+    ASSERT_NO_ERROR(g_db->open(db_path, GetBufferPoolSize(), false, false));
+    ASSERT_TRUE(g_db->is_open());
+
+    // The system tables are still there.
+    EXPECT_EQ(g_catcache->FindTableByName("Table"), initoids::TAB_Table);
+    EXPECT_NE(g_catcache->FindType(initoids::TYP_INT4), nullptr);
+    EXPECT_EQ(g_catcache->FindOperator(OPTYPE(EQ), initoids::TYP_INT4,
+                                       initoids::TYP_INT4),
+              initoids::FUNC_INT4_eq);
+
+    // So are the table and the index created before the database is closed.
+    EXPECT_EQ(g_catcache->FindTableByName("t"), tabid);
+    const SysTable_Table *table = g_catcache->FindTable(tabid);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(table->tabfid(), 2u);
+    const TableDesc *tabdesc = g_catcache->FindTableDesc(tabid);
+    ASSERT_NE(tabdesc, nullptr);
+    const Schema *sch = tabdesc->GetSchema();
+    ASSERT_EQ(sch->GetNumFields(), 2u);
+    EXPECT_EQ(sch->GetFieldTypeId(0), initoids::TYP_INT4);
+    EXPECT_EQ(sch->GetFieldTypeId(1), initoids::TYP_VARCHAR);
+    EXPECT_EQ(sch->GetFieldTypeParam(1), 20u);
+    EXPECT_FALSE(sch->FieldIsNullable(0));
+    EXPECT_TRUE(sch->FieldIsNullable(1));
+    EXPECT_EQ(sch->GetFieldIdFromFieldName("b"), 1);
+
+    EXPECT_EQ(g_catcache->FindIndexByName("t_a"), idxid);
+    std::vector<Oid> idxids = g_catcache->FindAllIndexesOfTable(tabid);
+    ASSERT_EQ(idxids.size(), 1u);
+    EXPECT_EQ(idxids[0], idxid);
+    const IndexDesc *idxdesc = g_catcache->FindIndexDesc(idxid);
+    ASSERT_NE(idxdesc, nullptr);
+    EXPECT_TRUE(idxdesc->GetIndexEntry()->idxunique());
+    EXPECT_EQ(idxdesc->GetIndexEntry()->idxfid(), 3u);
+    EXPECT_EQ(idxdesc->GetIndexEntry()->idxninclcols(), 1);
+    EXPECT_EQ(idxdesc->GetKeySchema()->GetNumFields(), 2u);
+
+    // New OIDs don't collide with those allocated before.
+    Oid tabid2 = g_catcache->AddTable("t2", {initoids::TYP_INT4}, {}, {"a"},
+                                      {false}, {false}, 4);
+    EXPECT_GT(tabid2, idxid);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestPersistentCatCache, TestCreateOverExistingDatabase) {
+    TDB_TEST_BEGIN
+    const std::string db_path = g_db->GetLastDBPath();
+    ASSERT_NE(g_catcache->AddTable("t", {initoids::TYP_INT4}, {}, {"a"},
+                                   {false}, {false}, 2),
+              InvalidOid);
+    ASSERT_NO_ERROR(g_db->close());
+
+    // A new database is not created over an existing one unless it may be
+    // overwritten, in which case the old one is removed.
+    EXPECT_REGULAR_ERROR(
+        g_db->open(db_path, GetBufferPoolSize(), true, false));
+    ASSERT_NO_ERROR(g_db->close());
+    ASSERT_NO_ERROR(g_db->open(db_path, GetBufferPoolSize(), true, true));
+    ASSERT_TRUE(g_db->is_open());
+    EXPECT_EQ(g_catcache->FindTableByName("Table"), initoids::TAB_Table);
+    EXPECT_EQ(g_catcache->FindTableByName("t"), InvalidOid);
+    TDB_TEST_END
+}
+
+}   // namespace taco
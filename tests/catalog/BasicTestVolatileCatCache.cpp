@@ -0,0 +1,240 @@
+#include "base/TDBNonDBTest.h"
+
+#include "catalog/VolatileCatCache.h"
+
+namespace taco {
+
+/*!
+ * The test fixture is a friend of VolatileCatCache, so that the tests can
+ * append, read and update the records in its in-memory files directly. The
+ * records are never interpreted, so no system table is needed.
+ */
+class BasicTestVolatileCatCache: public TDBNonDBTest {
+protected:
+    static constexpr size_t ChunkSize = VolatileCatCache::ChunkSize;
+
+    static constexpr int PageNumberBits = VolatileCatCache::PageNumberBits;
+
+    /*!
+     * Creates the DB meta file and a heap file in \p catcache, and returns
+     * the file ID of the latter.
+     */
+    static FileId
+    CreateHeapFile(VolatileCatCache &catcache) {
+        catcache.CreateCatalogFile(false);
+        return catcache.CreateCatalogFile(true);
+    }
+
+    static RecordId
+    Append(VolatileCatCache &catcache, FileId fid, const std::string &data) {
+        VolatileCatCache::FileHandle fh = fid;
+        Record rec(data.data(), (FieldOffset) data.size());
+        catcache.AppendRecord(fh, rec);
+        return rec.GetRecordId();
+    }
+
+    /*!
+     * Returns the record \p rid, which must be in a single chunk, or nullptr
+     * if it does not exist.
+     */
+    static const char*
+    Find(VolatileCatCache &catcache, FileId fid, RecordId rid) {
+        VolatileCatCache::FileHandle fh = fid;
+        VolatileCatCache::CatFileIterator iter =
+            catcache.IterateCatEntryFrom(fh, rid);
+        if (!catcache.NextCatEntry(iter)) {
+            return nullptr;
+        }
+        RecordId cur_rid = catcache.GetCurrentCatEntryRecordId(iter);
+        EXPECT_EQ(cur_rid.pid, rid.pid);
+        EXPECT_EQ(cur_rid.sid, rid.sid);
+        const char *data = catcache.GetCurrentCatEntry(iter);
+        catcache.EndIterateCatEntry(iter);
+
+        const VolatileCatCache::InmemFile *f = catcache.GetInmemFile(fid);
+        size_t len = ParseLength(data);
+        bool in_chunk = false;
+        for (const unique_malloced_ptr &chunk : f->m_chunks) {
+            const char *begin = (const char*) chunk.get();
+            if (data >= begin && data + len <= begin + ChunkSize) {
+                in_chunk = true;
+                break;
+            }
+        }
+        EXPECT_TRUE(in_chunk);
+        return data;
+    }
+
+    static std::string
+    Read(VolatileCatCache &catcache, FileId fid, RecordId rid) {
+        const char *data = Find(catcache, fid, rid);
+        if (!data) {
+            return "";
+        }
+        return std::string(data, ParseLength(data));
+    }
+
+    static void
+    Update(VolatileCatCache &catcache, FileId fid, RecordId rid,
+           const std::string &data) {
+        VolatileCatCache::FileHandle fh = fid;
+        VolatileCatCache::CatFileIterator iter =
+            catcache.IterateCatEntryFrom(fh, rid);
+        ASSERT_TRUE(catcache.NextCatEntry(iter));
+        Record rec(data.data(), (FieldOffset) data.size());
+        catcache.UpdateCurrentCatEntry(iter, rec);
+        catcache.EndIterateCatEntry(iter);
+        // The record ID never changes.
+        EXPECT_EQ(rec.GetRecordId().pid, rid.pid);
+        EXPECT_EQ(rec.GetRecordId().sid, rid.sid);
+    }
+
+    static size_t
+    GetNumRecords(VolatileCatCache &catcache, FileId fid) {
+        VolatileCatCache::FileHandle fh = fid;
+        VolatileCatCache::CatFileIterator iter = catcache.IterateCatEntry(fh);
+        size_t n = 0;
+        while (catcache.NextCatEntry(iter)) {
+            ++n;
+        }
+        catcache.EndIterateCatEntry(iter);
+        return n;
+    }
+
+    static size_t
+    GetNumChunks(VolatileCatCache &catcache, FileId fid) {
+        return catcache.GetInmemFile(fid)->m_chunks.size();
+    }
+
+    static RecordId
+    MakeRecordId(FileId fid, uint32_t idx) {
+        return VolatileCatCache::MakeRecordId(fid, idx);
+    }
+
+    /*!
+     * Returns a record of \p len >= 8 bytes, which starts with its length
+     * and the number \p n.
+     */
+    static std::string
+    MakeRecord(uint32_t n, uint16_t len) {
+        std::string rec(len, '\0');
+        memcpy(&rec[0], &len, sizeof(uint16_t));
+        memcpy(&rec[2], &n, sizeof(uint32_t));
+        for (uint16_t i = 6; i < len; ++i) {
+            rec[i] = (char)('a' + (n + i) % 26);
+        }
+        return rec;
+    }
+
+    static uint16_t
+    ParseLength(const char *data) {
+        uint16_t len;
+        memcpy(&len, data, sizeof(uint16_t));
+        return len;
+    }
+};
+
+TEST_F(BasicTestVolatileCatCache, TestArenaAcrossChunks) {
+    TDB_TEST_BEGIN
+    VolatileCatCache catcache;
+    FileId fid = CreateHeapFile(catcache);
+
+    // Fill a bit more than 4 chunks. A record never spans two chunks, so the
+    // rest of a chunk that does not fit the next record is left unused.
+    constexpr uint16_t RecLen = 1000;
+    constexpr size_t RecsPerChunk = ChunkSize / MAXALIGN(RecLen);
+    constexpr uint32_t NumRecs = 4 * RecsPerChunk + 2;
+    std::vector<RecordId> rids;
+    for (uint32_t i = 0; i < NumRecs; ++i) {
+        rids.push_back(Append(catcache, fid, MakeRecord(i, RecLen)));
+    }
+    EXPECT_EQ(GetNumChunks(catcache, fid), 5u);
+    EXPECT_EQ(GetNumRecords(catcache, fid), (size_t) NumRecs);
+    for (uint32_t i = 0; i < NumRecs; ++i) {
+        EXPECT_EQ(Read(catcache, fid, rids[i]), MakeRecord(i, RecLen));
+    }
+
+    // A shorter record is updated in place.
+    const char *data = Find(catcache, fid, rids[0]);
+    Update(catcache, fid, rids[0], MakeRecord(0, RecLen / 2));
+    EXPECT_EQ(Find(catcache, fid, rids[0]), data);
+
+    // A longer one is moved and its old space is reused by the next record
+    // of the same length.
+    data = Find(catcache, fid, rids[1]);
+    Update(catcache, fid, rids[1], MakeRecord(1, 2 * RecLen));
+    EXPECT_NE(Find(catcache, fid, rids[1]), data);
+    RecordId rid = Append(catcache, fid, MakeRecord(NumRecs, RecLen));
+    EXPECT_EQ(Find(catcache, fid, rid), data);
+    EXPECT_EQ(Read(catcache, fid, rid), MakeRecord(NumRecs, RecLen));
+    EXPECT_EQ(GetNumChunks(catcache, fid), 5u);
+
+    // Growing the records a little moves them and leaves their old space
+    // unused, until the file is compacted.
+    bool compacted = false;
+    uint16_t new_len = RecLen;
+    for (int round = 0; round < 3; ++round) {
+        new_len += MAXALIGN_OF;
+        for (uint32_t i = 0; i < NumRecs; ++i) {
+            size_t num_chunks = GetNumChunks(catcache, fid);
+            Update(catcache, fid, rids[i], MakeRecord(i + 1000, new_len));
+            if (GetNumChunks(catcache, fid) < num_chunks) {
+                compacted = true;
+            }
+        }
+    }
+    EXPECT_TRUE(compacted);
+    EXPECT_EQ(GetNumRecords(catcache, fid), (size_t) NumRecs + 1);
+    for (uint32_t i = 0; i < NumRecs; ++i) {
+        EXPECT_EQ(Read(catcache, fid, rids[i]), MakeRecord(i + 1000, new_len));
+    }
+    EXPECT_EQ(Read(catcache, fid, rid), MakeRecord(NumRecs, RecLen));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestVolatileCatCache, TestSlotsBeyondOnePage) {
+    TDB_TEST_BEGIN
+    VolatileCatCache catcache;
+    FileId fid = CreateHeapFile(catcache);
+
+    // The 32-bit slot index of a record is split into the page number and
+    // the slot ID of its record ID, with up to MaxSlotId slots per page.
+    constexpr uint32_t NumRecs = 2 * (uint32_t) MaxSlotId + 10;
+    constexpr uint16_t RecLen = 16;
+    for (uint32_t i = 0; i < NumRecs; ++i) {
+        RecordId rid = Append(catcache, fid, MakeRecord(i, RecLen));
+        RecordId expected_rid = MakeRecordId(fid, i);
+        ASSERT_EQ(rid.pid, expected_rid.pid);
+        ASSERT_EQ(rid.sid, expected_rid.sid);
+        ASSERT_EQ(rid.pid & ((1u << PageNumberBits) - 1), i / MaxSlotId);
+        ASSERT_EQ(rid.sid, i % MaxSlotId + MinSlotId);
+    }
+    EXPECT_EQ(GetNumRecords(catcache, fid), (size_t) NumRecs);
+
+    const uint32_t idxs[] = { 0, 1, MaxSlotId - 1, MaxSlotId, MaxSlotId + 1,
+                              2 * MaxSlotId - 1, 2 * MaxSlotId, NumRecs - 1 };
+    for (uint32_t idx : idxs) {
+        EXPECT_EQ(Read(catcache, fid, MakeRecordId(fid, idx)),
+                  MakeRecord(idx, RecLen));
+    }
+
+    // Updating records, in place or not, keeps their record IDs.
+    for (uint32_t idx : idxs) {
+        uint16_t len = (idx % 2) ? RecLen / 2 : RecLen * 4;
+        Update(catcache, fid, MakeRecordId(fid, idx), MakeRecord(~idx, len));
+    }
+    for (uint32_t idx : idxs) {
+        uint16_t len = (idx % 2) ? RecLen / 2 : RecLen * 4;
+        EXPECT_EQ(Read(catcache, fid, MakeRecordId(fid, idx)),
+                  MakeRecord(~idx, len));
+    }
+    EXPECT_EQ(Read(catcache, fid, MakeRecordId(fid, 2)),
+              MakeRecord(2, RecLen));
+    EXPECT_EQ(GetNumRecords(catcache, fid), (size_t) NumRecs);
+
+    // There is no record past the last one.
+    EXPECT_EQ(Find(catcache, fid, MakeRecordId(fid, NumRecs)), nullptr);
+    TDB_TEST_END
+}
+
+}   // namespace taco
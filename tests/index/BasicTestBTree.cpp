@@ -0,0 +1,380 @@
+#include "base/TDBDBTest.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+#include "index/btree/BTree.h"
+
+namespace taco {
+
+class BasicTestBTree: public TDBDBTest {
+protected:
+    /*!
+     * Creates an index over an INT4 column with the BTree descriptor in
+     * m_idxdesc.
+     */
+    void
+    CreateIndexDesc(bool unique) {
+        TDB_TEST_BEGIN
+        // The BTree pages are allocated in memory, so the files are never
+        // accessed.
+        Oid tabid = g_catcache->AddTable("t", {initoids::TYP_INT4}, {},
+                                         {"a"}, {true}, {false}, 1);
+        Oid idxid = g_catcache->AddIndex("t_a", tabid, IDXTYP(BTREE),
+                                         unique, {0}, {}, 1, {}, {});
+        m_idxdesc = g_catcache->FindIndexDesc(idxid);
+        ASSERT_NE(m_idxdesc, nullptr);
+        TDB_TEST_END
+    }
+
+    static RecordId
+    MakeRecordId(int32_t key, uint16_t n) {
+        RecordId recid;
+        recid.pid = (PageNumber) key + 1;
+        recid.sid = n + 1;
+        recid.reserved = 0;
+        return recid;
+    }
+
+    static bool
+    InsertKey(Index *index, int32_t key, RecordId recid) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        return index->InsertKey(&idxkey, recid);
+    }
+
+    static bool
+    DeleteKey(Index *index, int32_t key) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        RecordId recid;
+        recid.SetInvalid();
+        return index->DeleteKey(&idxkey, recid);
+    }
+
+    /*!
+     * Returns the keys in the index in the scan order.
+     */
+    std::vector<int32_t>
+    ScanAll(Index *index) {
+        std::vector<int32_t> keys;
+        std::unique_ptr<Index::Iterator> iter =
+            index->StartScan(nullptr, false, nullptr, false);
+        while (iter->Next()) {
+            keys.push_back(m_idxdesc->GetKeySchema()->GetField(
+                0, iter->GetCurrentItem().GetData()).GetInt32());
+        }
+        return keys;
+    }
+
+    /*!
+     * Returns the keys in the index in the range between \p lower and \p
+     * upper in the scan order.
+     */
+    std::vector<int32_t>
+    ScanRange(int32_t lower, bool lower_isstrict,
+              int32_t upper, bool upper_isstrict) {
+        Datum lower_d = Datum::From(lower);
+        NullableDatumRef lower_ref(lower_d);
+        IndexKey lower_key(&lower_ref, 1);
+        Datum upper_d = Datum::From(upper);
+        NullableDatumRef upper_ref(upper_d);
+        IndexKey upper_key(&upper_ref, 1);
+
+        std::vector<int32_t> keys;
+        std::unique_ptr<Index::Iterator> iter =
+            m_index->StartScan(&lower_key, lower_isstrict,
+                               &upper_key, upper_isstrict);
+        while (iter->Next()) {
+            keys.push_back(m_idxdesc->GetKeySchema()->GetField(
+                0, iter->GetCurrentItem().GetData()).GetInt32());
+        }
+        return keys;
+    }
+
+    /*!
+     * A bulk load source over a vector of keys, where each key gets a record
+     * ID derived from its position.
+     */
+    class VectorSource: public Index::BulkLoadSource {
+    public:
+        VectorSource(const std::vector<int32_t> &keys):
+            m_next(0) {
+            for (int32_t key : keys) {
+                m_data.emplace_back(Datum::From(key));
+            }
+        }
+
+        bool
+        Next() override {
+            if (m_next == m_data.size()) {
+                return false;
+            }
+            m_ref.reset(new NullableDatumRef(m_data[m_next++]));
+            m_idxkey.reset(new IndexKey(m_ref.get(), 1));
+            return true;
+        }
+
+        const IndexKey*
+        GetCurrentKey() override {
+            return m_idxkey.get();
+        }
+
+        RecordId
+        GetCurrentRecordId() override {
+            return MakeRecordId((int32_t) m_next, 0);
+        }
+
+    private:
+        std::vector<Datum>                  m_data;
+        size_t                              m_next;
+        std::unique_ptr<NullableDatumRef>   m_ref;
+        std::unique_ptr<IndexKey>           m_idxkey;
+    };
+
+    const IndexDesc *m_idxdesc;
+    std::unique_ptr<Index> m_index;
+};
+
+TEST_F(BasicTestBTree, TestInsertDeleteScan) {
+    CreateIndexDesc(false);
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 20000;
+    m_index = Index::Create(m_idxdesc);
+    BTree *btree = (BTree*) m_index.get();
+
+    // Every key is inserted twice with different record IDs.
+    std::vector<int32_t> keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        keys.push_back(key);
+    }
+    std::mt19937 rng(41);
+    for (uint16_t n = 0; n < 2; ++n) {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int32_t key : keys) {
+            ASSERT_TRUE(InsertKey(m_index.get(), key, MakeRecordId(key, n)));
+        }
+    }
+    EXPECT_GT(btree->GetTreeHeight(), 2u);
+    EXPECT_FALSE(InsertKey(m_index.get(), 10, MakeRecordId(10, 0)));
+
+    std::vector<int32_t> expected_keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        expected_keys.push_back(key);
+        expected_keys.push_back(key);
+    }
+    ASSERT_EQ(ScanAll(m_index.get()), expected_keys);
+
+    std::vector<int32_t> expected_range;
+    for (int32_t key = 100; key <= 5000; ++key) {
+        expected_range.push_back(key);
+        expected_range.push_back(key);
+    }
+    EXPECT_EQ(ScanRange(100, false, 5000, false), expected_range);
+    expected_range.erase(expected_range.begin(), expected_range.begin() + 2);
+    expected_range.resize(expected_range.size() - 2);
+    EXPECT_EQ(ScanRange(100, true, 5000, true), expected_range);
+    EXPECT_TRUE(ScanRange(NumKeys, false, NumKeys + 100, false).empty());
+    EXPECT_TRUE(ScanRange(200, false, 100, false).empty());
+
+    // Deleting both copies of the even keys.
+    for (int32_t key = 0; key < NumKeys; key += 2) {
+        ASSERT_TRUE(DeleteKey(m_index.get(), key));
+        ASSERT_TRUE(DeleteKey(m_index.get(), key));
+        ASSERT_FALSE(DeleteKey(m_index.get(), key));
+    }
+    expected_keys.clear();
+    for (int32_t key = 1; key < NumKeys; key += 2) {
+        expected_keys.push_back(key);
+        expected_keys.push_back(key);
+    }
+    ASSERT_EQ(ScanAll(m_index.get()), expected_keys);
+    EXPECT_EQ(ScanRange(100, false, 103, false),
+              std::vector<int32_t>({101, 101, 103, 103}));
+
+    // The tree does not merge pages, so the scans have to skip the empty
+    // leaf pages left by deleting everything.
+    for (int32_t key = 1; key < NumKeys; key += 2) {
+        ASSERT_TRUE(DeleteKey(m_index.get(), key));
+        ASSERT_TRUE(DeleteKey(m_index.get(), key));
+    }
+    EXPECT_TRUE(ScanAll(m_index.get()).empty());
+    EXPECT_TRUE(ScanRange(0, false, NumKeys, false).empty());
+
+    for (int32_t key = NumKeys - 1; key >= 0; --key) {
+        ASSERT_TRUE(InsertKey(m_index.get(), key, MakeRecordId(key, 0)));
+    }
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(ScanAll(m_index.get()), keys);
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestBTree, TestUniqueViolations) {
+    CreateIndexDesc(true);
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 10000;
+    m_index = Index::Create(m_idxdesc);
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        ASSERT_TRUE(InsertKey(m_index.get(), key, MakeRecordId(key, 0)));
+    }
+
+    // The same key with another record ID, and the same pair.
+    for (int32_t key = 0; key < NumKeys; key += 7) {
+        ASSERT_FALSE(InsertKey(m_index.get(), key, MakeRecordId(key, 1)));
+        ASSERT_FALSE(InsertKey(m_index.get(), key, MakeRecordId(key, 0)));
+    }
+
+    // A deleted key may be inserted again.
+    ASSERT_TRUE(DeleteKey(m_index.get(), 500));
+    EXPECT_TRUE(InsertKey(m_index.get(), 500, MakeRecordId(500, 1)));
+    EXPECT_FALSE(InsertKey(m_index.get(), 500, MakeRecordId(500, 2)));
+
+    std::vector<int32_t> expected_keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        expected_keys.push_back(key);
+    }
+    EXPECT_EQ(ScanAll(m_index.get()), expected_keys);
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestBTree, TestBulkLoadThenInsert) {
+    CreateIndexDesc(false);
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 50000;
+    m_index = Index::Create(m_idxdesc);
+    BTree *btree = (BTree*) m_index.get();
+
+    // Only the even keys are loaded, so that the odd ones go between them.
+    std::vector<int32_t> keys;
+    for (int32_t key = 0; key < NumKeys; key += 2) {
+        keys.push_back(key);
+    }
+    std::mt19937 rng(42);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    VectorSource src(keys);
+    ASSERT_NO_ERROR(m_index->BulkLoad(&src));
+    EXPECT_GT(btree->GetTreeHeight(), 1u);
+    std::sort(keys.begin(), keys.end());
+    ASSERT_EQ(ScanAll(m_index.get()), keys);
+
+    for (int32_t key = 1; key < NumKeys; key += 2) {
+        ASSERT_TRUE(InsertKey(m_index.get(), key, MakeRecordId(key, 0)));
+    }
+    std::vector<int32_t> expected_keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        expected_keys.push_back(key);
+    }
+    EXPECT_EQ(ScanAll(m_index.get()), expected_keys);
+    EXPECT_EQ(ScanRange(1001, true, 1004, false),
+              std::vector<int32_t>({1002, 1003, 1004}));
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestBTree, TestConcurrentUniqueInserts) {
+    CreateIndexDesc(true);
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 20000;
+    constexpr int NumThreads = 4;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+
+    // Every thread inserts all the keys with its own record IDs, so exactly
+    // one of the insertions of each key may succeed.
+    auto insert_all = [&](int32_t modulo, atomic<int32_t> &ninserted) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < NumThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::vector<int32_t> keys;
+                for (int32_t key = 0; key < NumKeys; ++key) {
+                    keys.push_back(key);
+                }
+                std::mt19937 rng(t);
+                std::shuffle(keys.begin(), keys.end(), rng);
+                int32_t n = 0;
+                for (int32_t key : keys) {
+                    if (InsertKey(index.get(), key,
+                                  MakeRecordId(key, modulo * 10 + t))) {
+                        ++n;
+                    }
+                }
+                ninserted.fetch_add(n, memory_order_relaxed);
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    };
+
+    atomic<int32_t> ninserted(0);
+    insert_all(0, ninserted);
+    EXPECT_EQ(ninserted.load(), NumKeys);
+    std::vector<int32_t> expected_keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        expected_keys.push_back(key);
+    }
+    ASSERT_EQ(ScanAll(index.get()), expected_keys);
+
+    // Deleting most of the keys leaves many empty leaf pages, which the
+    // uniqueness checks have to skip to find the neighbors.
+    constexpr int32_t KeptEvery = 97;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        if (key % KeptEvery != 0) {
+            ASSERT_TRUE(DeleteKey(index.get(), key));
+        }
+    }
+    ninserted.store(0);
+    insert_all(1, ninserted);
+    EXPECT_EQ(ninserted.load(), NumKeys - (NumKeys + KeptEvery - 1) /
+                                         KeptEvery);
+    ASSERT_EQ(ScanAll(index.get()), expected_keys);
+
+    // A null key never violates the uniqueness.
+    NullableDatumRef null_ref(Datum::FromNull());
+    IndexKey null_key(&null_ref, 1);
+    EXPECT_TRUE(index->InsertKey(&null_key, MakeRecordId(NumKeys, 0)));
+    EXPECT_TRUE(index->InsertKey(&null_key, MakeRecordId(NumKeys, 1)));
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestBTree, TestFailedBulkLoadLeavesTreeEmpty) {
+    CreateIndexDesc(true);
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 100000;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+    BTree *btree = (BTree*) index.get();
+
+    // The duplicate is only found after many pages have been built.
+    std::vector<int32_t> keys;
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        keys.push_back(NumKeys - 1 - key);
+    }
+    keys.push_back(NumKeys - 10);
+    VectorSource dup_src(keys);
+    EXPECT_REGULAR_ERROR(index->BulkLoad(&dup_src));
+    EXPECT_EQ(btree->GetTreeHeight(), 1u);
+    EXPECT_TRUE(ScanAll(index.get()).empty());
+
+    keys.pop_back();
+    VectorSource src(keys);
+    ASSERT_NO_ERROR(index->BulkLoad(&src));
+    EXPECT_GT(btree->GetTreeHeight(), 1u);
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(ScanAll(index.get()), keys);
+
+    TDB_TEST_END
+}
+
+}   // namespace taco
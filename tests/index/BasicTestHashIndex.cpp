@@ -0,0 +1,228 @@
+#include "base/TDBDBTest.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+#include "index/hash/HashIndex.h"
+
+namespace taco {
+
+class BasicTestHashIndex: public TDBDBTest {
+protected:
+    void
+    SetUp() override {
+        TDBDBTest::SetUp();
+        TDB_TEST_BEGIN
+        // The hash index pages are allocated in memory, so the files are
+        // never accessed.
+        Oid tabid = g_catcache->AddTable("t", {initoids::TYP_INT4}, {},
+                                         {"a"}, {true}, {false}, 1);
+        Oid idxid = g_catcache->AddIndex("t_a", tabid, IDXTYP(HASH),
+                                         false, {0}, {}, 1, {}, {});
+        m_idxdesc = g_catcache->FindIndexDesc(idxid);
+        ASSERT_NE(m_idxdesc, nullptr);
+        TDB_TEST_END
+    }
+
+    static RecordId
+    MakeRecordId(int32_t key, uint16_t n) {
+        RecordId recid;
+        recid.pid = (PageNumber) key + 1;
+        recid.sid = n + 1;
+        recid.reserved = 0;
+        return recid;
+    }
+
+    static bool
+    InsertKey(Index *index, int32_t key, RecordId recid) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        return index->InsertKey(&idxkey, recid);
+    }
+
+    /*!
+     * Returns the record IDs of \p key in the index.
+     */
+    static std::vector<RecordId>
+    Lookup(Index *index, int32_t key) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        std::unique_ptr<Index::Iterator> iter =
+            index->StartScan(&idxkey, false, &idxkey, false);
+        std::vector<RecordId> recids;
+        while (iter->Next()) {
+            recids.push_back(iter->GetCurrentRecordId());
+        }
+        return recids;
+    }
+
+    const IndexDesc *m_idxdesc;
+};
+
+TEST_F(BasicTestHashIndex, TestLookupsAcrossSplits) {
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 50000;
+    constexpr int NumDups = 3;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+    HashIndex *hash_index = (HashIndex*) index.get();
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        for (int n = 0; n < NumDups; ++n) {
+            ASSERT_TRUE(InsertKey(index.get(), key, MakeRecordId(key, n)));
+        }
+    }
+    EXPECT_GT(hash_index->GetNumBuckets(), 64u);
+
+    // Every key is found with all of its record IDs, and a duplicate pair is
+    // rejected.
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        std::vector<RecordId> recids = Lookup(index.get(), key);
+        ASSERT_EQ(recids.size(), (size_t) NumDups) << key;
+        for (int n = 0; n < NumDups; ++n) {
+            EXPECT_THAT(recids, Contains(MakeRecordId(key, n)));
+        }
+    }
+    EXPECT_FALSE(InsertKey(index.get(), 7, MakeRecordId(7, 0)));
+    EXPECT_TRUE(Lookup(index.get(), NumKeys).empty());
+    EXPECT_TRUE(Lookup(index.get(), -1).empty());
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestHashIndex, TestConcurrentLookupsDuringSplits) {
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 40000;
+    constexpr int NumWriters = 2;
+    constexpr int NumReaders = 3;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+
+    // Writer t inserts the keys k with k % NumWriters == t in increasing
+    // order, and publishes how many it has inserted, so that the readers
+    // know which keys must be found while the buckets are being split.
+    atomic<int32_t> progress[NumWriters];
+    for (int t = 0; t < NumWriters; ++t) {
+        progress[t].store(0, memory_order_relaxed);
+    }
+    atomic<bool> done(false);
+    atomic<int32_t> num_lost(0);
+    atomic<int32_t> num_lookups(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < NumReaders; ++r) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 rng(r);
+            while (!done.load(memory_order_acquire)) {
+                int t = (int)(rng() % NumWriters);
+                int32_t n = progress[t].load(memory_order_acquire);
+                if (n == 0) {
+                    continue;
+                }
+                int32_t key = (int32_t)(rng() % n) * NumWriters + t;
+                std::vector<RecordId> recids = Lookup(index.get(), key);
+                if (recids.size() != 1 ||
+                    recids[0] != MakeRecordId(key, 0)) {
+                    num_lost.fetch_add(1, memory_order_relaxed);
+                }
+                num_lookups.fetch_add(1, memory_order_relaxed);
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < NumWriters; ++t) {
+        writers.emplace_back([&, t]() {
+            int32_t n = 0;
+            for (int32_t key = t; key < NumKeys; key += NumWriters) {
+                if (!InsertKey(index.get(), key, MakeRecordId(key, 0))) {
+                    num_lost.fetch_add(1, memory_order_relaxed);
+                }
+                progress[t].store(++n, memory_order_release);
+            }
+        });
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    done.store(true, memory_order_release);
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(num_lost.load(), 0);
+    EXPECT_GT(num_lookups.load(), 0);
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        ASSERT_EQ(Lookup(index.get(), key).size(), 1u) << key;
+    }
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestHashIndex, TestConcurrentLookupsOfRecycledPages) {
+    TDB_TEST_BEGIN
+
+    // The readers keep looking up a fixed set of keys with several record
+    // IDs each, and keys that are never inserted, while a writer inserts
+    // enough keys to split every bucket a few times. Every split recycles
+    // the pages of the old chain, which the readers may still be reading.
+    constexpr int32_t NumFixedKeys = 500;
+    constexpr int NumDups = 4;
+    constexpr int32_t NumKeys = 60000;
+    constexpr int NumReaders = 3;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+    HashIndex *hash_index = (HashIndex*) index.get();
+    for (int32_t key = 0; key < NumFixedKeys; ++key) {
+        for (int n = 0; n < NumDups; ++n) {
+            ASSERT_TRUE(InsertKey(index.get(), -key - 1,
+                                  MakeRecordId(key, n)));
+        }
+    }
+
+    atomic<bool> done(false);
+    atomic<int32_t> num_bad(0);
+    atomic<int32_t> num_lookups(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < NumReaders; ++r) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 rng(r);
+            while (!done.load(memory_order_acquire)) {
+                int32_t key = (int32_t)(rng() % NumFixedKeys);
+                std::vector<RecordId> recids = Lookup(index.get(), -key - 1);
+                bool ok = recids.size() == (size_t) NumDups;
+                for (int n = 0; ok && n < NumDups; ++n) {
+                    ok = std::find(recids.begin(), recids.end(),
+                                   MakeRecordId(key, n)) != recids.end();
+                }
+                if (!ok || !Lookup(index.get(), NumKeys + key).empty()) {
+                    num_bad.fetch_add(1, memory_order_relaxed);
+                }
+                num_lookups.fetch_add(1, memory_order_relaxed);
+            }
+        });
+    }
+
+    uint64_t num_buckets = hash_index->GetNumBuckets();
+    for (int32_t key = 0; key < NumKeys; ++key) {
+        ASSERT_TRUE(InsertKey(index.get(), key, MakeRecordId(key, 0)));
+    }
+    done.store(true, memory_order_release);
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_GT(hash_index->GetNumBuckets(), 4 * num_buckets);
+    EXPECT_EQ(num_bad.load(), 0);
+    EXPECT_GT(num_lookups.load(), 0);
+    for (int32_t key = 0; key < NumFixedKeys; ++key) {
+        ASSERT_EQ(Lookup(index.get(), -key - 1).size(), (size_t) NumDups);
+    }
+
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,217 @@
+#include "base/TDBDBTest.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "catalog/CatCache.h"
+#include "dbmain/Database.h"
+#include "index/idxtyps.h"
+#include "index/volatiletree/VolatileTree.h"
+#include "storage/FileManager.h"
+
+namespace taco {
+
+class BasicTestVolatileTree: public TDBDBTest {
+protected:
+    void
+    SetUp() override {
+        TDBDBTest::SetUp();
+        TDB_TEST_BEGIN
+        // The table is never accessed through its file.
+        Oid tabid = g_catcache->AddTable("t", {initoids::TYP_INT4}, {},
+                                         {"a"}, {false}, {false}, 1);
+        Oid idxid = g_catcache->AddIndex("t_a", tabid,
+                                         IDXTYP(VOLATILETREE), false, {0},
+                                         {}, INVALID_FID, {}, {});
+        m_idxdesc = g_catcache->FindIndexDesc(idxid);
+        ASSERT_NE(m_idxdesc, nullptr);
+        TDB_TEST_END
+    }
+
+    static RecordId
+    GetRecordId(int32_t key) {
+        RecordId recid;
+        recid.pid = (PageNumber) key + 1;
+        recid.sid = 1;
+        recid.reserved = 0;
+        return recid;
+    }
+
+    void
+    InsertKey(Index *index, int32_t key) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        ASSERT_TRUE(index->InsertKey(&idxkey, GetRecordId(key)));
+    }
+
+    void
+    DeleteKey(Index *index, int32_t key) {
+        Datum d = Datum::From(key);
+        NullableDatumRef ref(d);
+        IndexKey idxkey(&ref, 1);
+        RecordId recid = GetRecordId(key);
+        ASSERT_TRUE(index->DeleteKey(&idxkey, recid));
+    }
+
+    /*!
+     * Scans the whole index and returns false if the keys are not strictly
+     * increasing or do not match their record IDs.
+     */
+    bool
+    ScanIsConsistent(Index *index) {
+        std::unique_ptr<Index::Iterator> iter =
+            index->StartScan(nullptr, false, nullptr, false);
+        int64_t last_key = -1;
+        while (iter->Next()) {
+            int32_t key = m_idxdesc->GetKeySchema()->GetField(
+                0, iter->GetCurrentItem().GetData()).GetInt32();
+            if (key <= last_key || iter->GetCurrentRecordId() !=
+                                   GetRecordId(key)) {
+                return false;
+            }
+            last_key = key;
+        }
+        return true;
+    }
+
+    /*!
+     * Returns the keys in the index in the range between \p lower and \p
+     * upper in the scan order.
+     */
+    std::vector<int32_t>
+    ScanRange(Index *index, int32_t lower, bool lower_isstrict,
+              int32_t upper, bool upper_isstrict) {
+        Datum lower_d = Datum::From(lower);
+        NullableDatumRef lower_ref(lower_d);
+        IndexKey lower_key(&lower_ref, 1);
+        Datum upper_d = Datum::From(upper);
+        NullableDatumRef upper_ref(upper_d);
+        IndexKey upper_key(&upper_ref, 1);
+
+        std::vector<int32_t> keys;
+        std::unique_ptr<Index::Iterator> iter =
+            index->StartScan(&lower_key, lower_isstrict,
+                             &upper_key, upper_isstrict);
+        while (iter->Next()) {
+            keys.push_back(m_idxdesc->GetKeySchema()->GetField(
+                0, iter->GetCurrentItem().GetData()).GetInt32());
+        }
+        return keys;
+    }
+
+    const IndexDesc *m_idxdesc;
+};
+
+TEST_F(BasicTestVolatileTree, TestInsertDeleteScan) {
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 10000;
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+    VolatileTree *tree = (VolatileTree *) index.get();
+    std::vector<int32_t> keys(NumKeys);
+    for (int32_t i = 0; i < NumKeys; ++i) {
+        keys[i] = i;
+    }
+    std::mt19937 rng(41);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int32_t key : keys) {
+        InsertKey(index.get(), key);
+    }
+    EXPECT_GT(tree->GetTreeHeight(), 2u);
+    ASSERT_TRUE(ScanIsConsistent(index.get()));
+
+    Datum d = Datum::From((int32_t) 10);
+    NullableDatumRef ref(d);
+    IndexKey idxkey(&ref, 1);
+    EXPECT_FALSE(index->InsertKey(&idxkey, GetRecordId(10)));
+
+    EXPECT_EQ(ScanRange(index.get(), 100, false, 103, false),
+              std::vector<int32_t>({100, 101, 102, 103}));
+    EXPECT_EQ(ScanRange(index.get(), 100, true, 103, true),
+              std::vector<int32_t>({101, 102}));
+    EXPECT_TRUE(ScanRange(index.get(), NumKeys, false,
+                          NumKeys + 10, false).empty());
+
+    // Deleting the odd keys.
+    for (int32_t key = 1; key < NumKeys; key += 2) {
+        DeleteKey(index.get(), key);
+    }
+    // The key 10 exists, but not with this record ID.
+    RecordId recid = GetRecordId(11);
+    EXPECT_FALSE(index->DeleteKey(&idxkey, recid));
+    ASSERT_TRUE(ScanIsConsistent(index.get()));
+    std::vector<int32_t> expected_keys;
+    for (int32_t key = 0; key < NumKeys; key += 2) {
+        expected_keys.push_back(key);
+    }
+    EXPECT_EQ(ScanRange(index.get(), 0, false, NumKeys, false),
+              expected_keys);
+
+    for (int32_t key = 0; key < NumKeys; key += 2) {
+        DeleteKey(index.get(), key);
+    }
+    EXPECT_EQ(tree->GetTreeHeight(), 1u);
+    EXPECT_TRUE(ScanRange(index.get(), 0, false, NumKeys, false).empty());
+
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestVolatileTree, TestConcurrentDeletesAndScans) {
+    TDB_TEST_BEGIN
+
+    constexpr int32_t NumKeys = 5000;
+    constexpr int NumRounds = 5;
+    constexpr int NumScanners = 4;
+
+    std::unique_ptr<Index> index = Index::Create(m_idxdesc);
+    VolatileTree *tree = (VolatileTree *) index.get();
+    std::vector<int32_t> keys(NumKeys);
+    for (int32_t i = 0; i < NumKeys; ++i) {
+        keys[i] = i;
+    }
+
+    atomic<bool> done(false);
+    atomic<int> num_inconsistent_scans(0);
+    std::vector<std::thread> scanners;
+    for (int i = 0; i < NumScanners; ++i) {
+        scanners.emplace_back([&]() {
+            while (!done.load(memory_order_acquire)) {
+                if (!ScanIsConsistent(index.get())) {
+                    num_inconsistent_scans.fetch_add(1, memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    // Deleting all the keys in a random order leaves internal nodes with no
+    // separator at several levels, which are removed when they get to the
+    // top while the scanners may still be reading them.
+    std::mt19937 rng(20260);
+    for (int round = 0; round < NumRounds; ++round) {
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int32_t key : keys) {
+            InsertKey(index.get(), key);
+        }
+        EXPECT_GT(tree->GetTreeHeight(), 2u);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (int32_t key : keys) {
+            DeleteKey(index.get(), key);
+        }
+        EXPECT_EQ(tree->GetTreeHeight(), 1u);
+    }
+
+    done.store(true, memory_order_release);
+    for (std::thread &t : scanners) {
+        t.join();
+    }
+    EXPECT_EQ(num_inconsistent_scans.load(), 0);
+
+    std::unique_ptr<Index::Iterator> iter =
+        index->StartScan(nullptr, false, nullptr, false);
+    EXPECT_FALSE(iter->Next());
+
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,370 @@
+#include "base/TDBDBTest.h"
+
+#include "catalog/Schema.h"
+#include "catalog/systables/initoids.h"
+#include "query/expr/ExprNode.h"
+#include "query/expr/ExprProgram.h"
+#include "query/expr/optypes.h"
+#include "utils/MemoryContext.h"
+
+namespace taco {
+
+static constexpr int64_t Null = INT64_MIN;
+
+/*!
+ * The tests are over the records of (a INT4, b INT4, c BOOL), where all the
+ * fields are nullable. The values in the tests are int64_t with Null for a
+ * null value, and a boolean is 0 or 1.
+ */
+class BasicTestExprProgram: public TDBDBTest {
+protected:
+    void
+    SetUp() override {
+        TDBDBTest::SetUp();
+        TDB_TEST_BEGIN
+        m_schema.reset(Schema::Create(
+            {initoids::TYP_INT4, initoids::TYP_INT4, initoids::TYP_BOOL},
+            {0, 0, 0}, {true, true, true}));
+        m_schema->ComputeLayout();
+        TDB_TEST_END
+    }
+
+    static std::unique_ptr<ExprNode>
+    Col(FieldId field) {
+        return ExprNode::CreateColumn(field);
+    }
+
+    static std::unique_ptr<ExprNode>
+    Int(int64_t value) {
+        return ExprNode::CreateConstant((value == Null) ? Datum::FromNull() :
+                                        Datum::From((int32_t) value),
+                                        initoids::TYP_INT4);
+    }
+
+    static std::unique_ptr<ExprNode>
+    Bool(int64_t value) {
+        return ExprNode::CreateConstant((value == Null) ? Datum::FromNull() :
+                                        Datum::From((bool) value),
+                                        initoids::TYP_BOOL);
+    }
+
+    static std::unique_ptr<ExprNode>
+    Op(OpType optype, std::unique_ptr<ExprNode> arg0,
+       std::unique_ptr<ExprNode> arg1 = nullptr) {
+        return ExprNode::CreateOperator(optype, std::move(arg0),
+                                        std::move(arg1));
+    }
+
+    /*!
+     * Returns the payload of the record (a, b, c), which is valid until the
+     * next call.
+     */
+    const char*
+    MakeRecord(int64_t a, int64_t b, int64_t c) {
+        std::vector<Datum> data;
+        data.emplace_back((a == Null) ? Datum::FromNull() :
+                          Datum::From((int32_t) a));
+        data.emplace_back((b == Null) ? Datum::FromNull() :
+                          Datum::From((int32_t) b));
+        data.emplace_back((c == Null) ? Datum::FromNull() :
+                          Datum::From((bool) c));
+        m_buf.clear();
+        if (m_schema->WritePayloadToBuffer(data, m_buf) == -1) {
+            return nullptr;
+        }
+        return m_buf.data();
+    }
+
+    static int64_t
+    GetBool(const NullableDatumRef &value) {
+        return value.isnull() ? Null : (int64_t) value.GetBool();
+    }
+
+    static int64_t
+    GetInt(const NullableDatumRef &value) {
+        return value.isnull() ? Null : (int64_t) value.GetInt32();
+    }
+
+    std::unique_ptr<Schema> m_schema;
+    maxaligned_char_buf     m_buf;
+};
+
+static int64_t
+ExpectedAnd(int64_t x, int64_t y) {
+    if (x == 0 || y == 0) {
+        return 0;
+    }
+    if (x == Null || y == Null) {
+        return Null;
+    }
+    return 1;
+}
+
+static int64_t
+ExpectedOr(int64_t x, int64_t y) {
+    if (x == 1 || y == 1) {
+        return 1;
+    }
+    if (x == Null || y == Null) {
+        return Null;
+    }
+    return 0;
+}
+
+TEST_F(BasicTestExprProgram, TestArithmetic) {
+    TDB_TEST_BEGIN
+    // (a + b) * 2 - a / b
+    std::unique_ptr<ExprNode> expr =
+        Op(OPTYPE(SUB), Op(OPTYPE(MUL), Op(OPTYPE(ADD), Col(0), Col(1)),
+                           Int(2)),
+           Op(OPTYPE(DIV), Col(0), Col(1)));
+    expr->Bind(m_schema.get());
+    std::unique_ptr<ExprProgram> prog =
+        ExprProgram::Compile(expr.get(), m_schema.get());
+
+    EXPECT_EQ(GetInt(prog->Eval(MakeRecord(7, 2, 1))), 15);
+    EXPECT_EQ(GetInt(prog->Eval(MakeRecord(-9, 4, 0))), -8);
+    EXPECT_EQ(GetInt(prog->Eval(MakeRecord(Null, 4, 0))), Null);
+    EXPECT_EQ(GetInt(prog->Eval(MakeRecord(3, Null, 0))), Null);
+    EXPECT_REGULAR_ERROR(prog->Eval(MakeRecord(3, 0, 0)));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExprProgram, TestThreeValuedLogic) {
+    TDB_TEST_BEGIN
+    // a > 0 is true, false or null as a is 5, -5 or null.
+    const int64_t values[] = { 1, 0, Null };
+    const int64_t ints[] = { 5, -5, Null };
+
+    // The comparisons are over a column and a constant, so that the AND
+    // of two is fused into one instruction, while c is a plain column.
+    for (bool x_is_column : { false, true }) {
+        auto make_x = [&]() {
+            return x_is_column ? Col(2) : Op(OPTYPE(GT), Col(0), Int(0));
+        };
+        auto make_y = [&]() {
+            return Op(OPTYPE(GT), Col(1), Int(0));
+        };
+        std::unique_ptr<ExprNode> and_expr =
+            Op(OPTYPE(AND), make_x(), make_y());
+        std::unique_ptr<ExprNode> or_expr =
+            Op(OPTYPE(OR), make_x(), make_y());
+        std::unique_ptr<ExprNode> not_expr = Op(OPTYPE(NOT), make_x());
+        and_expr->Bind(m_schema.get());
+        or_expr->Bind(m_schema.get());
+        not_expr->Bind(m_schema.get());
+        std::unique_ptr<ExprProgram> and_prog =
+            ExprProgram::Compile(and_expr.get(), m_schema.get());
+        std::unique_ptr<ExprProgram> and_filter =
+            ExprProgram::CompileFilter(and_expr.get(), m_schema.get());
+        std::unique_ptr<ExprProgram> or_prog =
+            ExprProgram::Compile(or_expr.get(), m_schema.get());
+        std::unique_ptr<ExprProgram> or_filter =
+            ExprProgram::CompileFilter(or_expr.get(), m_schema.get());
+        std::unique_ptr<ExprProgram> not_prog =
+            ExprProgram::Compile(not_expr.get(), m_schema.get());
+        std::unique_ptr<ExprProgram> not_filter =
+            ExprProgram::CompileFilter(not_expr.get(), m_schema.get());
+
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                SCOPED_TRACE(std::to_string(x_is_column) + " " +
+                             std::to_string(i) + " " + std::to_string(j));
+                int64_t x = values[i];
+                int64_t y = values[j];
+                const char *rec = x_is_column ?
+                    MakeRecord(0, ints[j], x) : MakeRecord(ints[i], ints[j], 0);
+                ASSERT_NE(rec, nullptr);
+
+                int64_t expected = ExpectedAnd(x, y);
+                EXPECT_EQ(GetBool(and_prog->Eval(rec)), expected);
+                EXPECT_EQ(and_filter->EvalFilter(rec), expected == 1);
+                expected = ExpectedOr(x, y);
+                EXPECT_EQ(GetBool(or_prog->Eval(rec)), expected);
+                EXPECT_EQ(or_filter->EvalFilter(rec), expected == 1);
+                expected = (x == Null) ? Null : !x;
+                EXPECT_EQ(GetBool(not_prog->Eval(rec)), expected);
+                EXPECT_EQ(not_filter->EvalFilter(rec), expected == 1);
+            }
+        }
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExprProgram, TestConstantFolding) {
+    TDB_TEST_BEGIN
+    // (1 + 2) * a
+    std::unique_ptr<ExprNode> expr =
+        Op(OPTYPE(MUL), Op(OPTYPE(ADD), Int(1), Int(2)), Col(0));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Operator);
+    ASSERT_EQ(expr->GetArg(0)->GetKind(), ExprKind::Constant);
+    EXPECT_EQ(expr->GetArg(0)->GetValue().GetInt32(), 3);
+    std::unique_ptr<ExprProgram> prog =
+        ExprProgram::Compile(expr.get(), m_schema.get());
+    EXPECT_EQ(GetInt(prog->Eval(MakeRecord(5, 0, 0))), 15);
+
+    // 2 * 3 > 5
+    expr = Op(OPTYPE(GT), Op(OPTYPE(MUL), Int(2), Int(3)), Int(5));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    EXPECT_TRUE(expr->GetValue().GetBool());
+
+    // NULL + 1
+    expr = Op(OPTYPE(ADD), Int(Null), Int(1));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    EXPECT_TRUE(expr->GetValue().isnull());
+
+    // NULL AND false, and NULL OR true
+    expr = Op(OPTYPE(AND), Bool(Null), Bool(0));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    ASSERT_FALSE(expr->GetValue().isnull());
+    EXPECT_FALSE(expr->GetValue().GetBool());
+    expr = Op(OPTYPE(OR), Bool(Null), Bool(1));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    ASSERT_FALSE(expr->GetValue().isnull());
+    EXPECT_TRUE(expr->GetValue().GetBool());
+
+    // a > 0 AND false, and a > 0 OR true
+    expr = Op(OPTYPE(AND), Op(OPTYPE(GT), Col(0), Int(0)), Bool(0));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    EXPECT_FALSE(expr->GetValue().GetBool());
+    expr = Op(OPTYPE(OR), Bool(1), Op(OPTYPE(GT), Col(0), Int(0)));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Constant);
+    EXPECT_TRUE(expr->GetValue().GetBool());
+
+    // c OR false, and true AND c
+    expr = Op(OPTYPE(OR), Col(2), Bool(0));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Column);
+    EXPECT_EQ(expr->GetField(), 2);
+    expr = Op(OPTYPE(AND), Bool(1), Col(2));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Column);
+    EXPECT_EQ(expr->GetField(), 2);
+
+    // c AND NULL is not folded, as it is false when c is false and null
+    // otherwise.
+    expr = Op(OPTYPE(AND), Col(2), Bool(Null));
+    expr->Bind(m_schema.get());
+    ASSERT_EQ(expr->GetKind(), ExprKind::Operator);
+    prog = ExprProgram::Compile(expr.get(), m_schema.get());
+    EXPECT_EQ(GetBool(prog->Eval(MakeRecord(0, 0, 0))), 0);
+    EXPECT_EQ(GetBool(prog->Eval(MakeRecord(0, 0, 1))), Null);
+    EXPECT_EQ(GetBool(prog->Eval(MakeRecord(0, 0, Null))), Null);
+
+    // The errors on the constants are raised by Bind().
+    expr = Op(OPTYPE(DIV), Int(1), Int(0));
+    EXPECT_REGULAR_ERROR(expr->Bind(m_schema.get()));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExprProgram, TestCommonSubexpressions) {
+    TDB_TEST_BEGIN
+    // (a + b) * (a + b) computes a + b once, so it needs fewer instructions
+    // than (a + b) * (a - b).
+    std::unique_ptr<ExprNode> square =
+        Op(OPTYPE(MUL), Op(OPTYPE(ADD), Col(0), Col(1)),
+           Op(OPTYPE(ADD), Col(0), Col(1)));
+    std::unique_ptr<ExprNode> product =
+        Op(OPTYPE(MUL), Op(OPTYPE(ADD), Col(0), Col(1)),
+           Op(OPTYPE(SUB), Col(0), Col(1)));
+    square->Bind(m_schema.get());
+    product->Bind(m_schema.get());
+    EXPECT_TRUE(square->GetArg(0)->Equals(square->GetArg(1)));
+    EXPECT_FALSE(product->GetArg(0)->Equals(product->GetArg(1)));
+    std::unique_ptr<ExprProgram> square_prog =
+        ExprProgram::Compile(square.get(), m_schema.get());
+    std::unique_ptr<ExprProgram> product_prog =
+        ExprProgram::Compile(product.get(), m_schema.get());
+    EXPECT_LT(square_prog->GetNumInstructions(),
+              product_prog->GetNumInstructions());
+    EXPECT_EQ(GetInt(square_prog->Eval(MakeRecord(3, 4, 0))), 49);
+    EXPECT_EQ(GetInt(product_prog->Eval(MakeRecord(3, 4, 0))), -7);
+    EXPECT_EQ(GetInt(square_prog->Eval(MakeRecord(3, Null, 0))), Null);
+
+    // The qualification a + b > 0 and the target a + b share a + b.
+    std::unique_ptr<ExprNode> shared_qual =
+        Op(OPTYPE(GT), Op(OPTYPE(ADD), Col(0), Col(1)), Int(0));
+    std::unique_ptr<ExprNode> other_qual =
+        Op(OPTYPE(GT), Op(OPTYPE(SUB), Col(0), Col(1)), Int(0));
+    std::unique_ptr<ExprNode> target = Op(OPTYPE(ADD), Col(0), Col(1));
+    shared_qual->Bind(m_schema.get());
+    other_qual->Bind(m_schema.get());
+    target->Bind(m_schema.get());
+    std::unique_ptr<ExprProgram> shared_prog = ExprProgram::CompileQuery(
+        shared_qual.get(), {target.get()}, m_schema.get());
+    std::unique_ptr<ExprProgram> other_prog = ExprProgram::CompileQuery(
+        other_qual.get(), {target.get()}, m_schema.get());
+    EXPECT_LT(shared_prog->GetNumInstructions(),
+              other_prog->GetNumInstructions());
+    ASSERT_TRUE(shared_prog->EvalQuery(MakeRecord(3, 4, 0)));
+    EXPECT_EQ(GetInt(shared_prog->GetTarget(0)), 7);
+    EXPECT_FALSE(shared_prog->EvalQuery(MakeRecord(-3, 2, 0)));
+    EXPECT_FALSE(shared_prog->EvalQuery(MakeRecord(Null, 2, 0)));
+
+    // In c OR a + b > 0, a + b is not computed when c is true, so the
+    // target may not reuse it.
+    std::unique_ptr<ExprNode> or_qual =
+        Op(OPTYPE(OR), Col(2),
+           Op(OPTYPE(GT), Op(OPTYPE(ADD), Col(0), Col(1)), Int(0)));
+    or_qual->Bind(m_schema.get());
+    std::unique_ptr<ExprProgram> or_prog = ExprProgram::CompileQuery(
+        or_qual.get(), {target.get()}, m_schema.get());
+    ASSERT_TRUE(or_prog->EvalQuery(MakeRecord(1, 1, 0)));
+    EXPECT_EQ(GetInt(or_prog->GetTarget(0)), 2);
+    ASSERT_TRUE(or_prog->EvalQuery(MakeRecord(10, 20, 1)));
+    EXPECT_EQ(GetInt(or_prog->GetTarget(0)), 30);
+    ASSERT_TRUE(or_prog->EvalQuery(MakeRecord(Null, 20, 1)));
+    EXPECT_EQ(GetInt(or_prog->GetTarget(0)), Null);
+    EXPECT_FALSE(or_prog->EvalQuery(MakeRecord(-10, 2, 0)));
+    EXPECT_FALSE(or_prog->EvalQuery(MakeRecord(-10, 2, Null)));
+    ASSERT_TRUE(or_prog->EvalQuery(MakeRecord(-10, 20, Null)));
+    EXPECT_EQ(GetInt(or_prog->GetTarget(0)), 10);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExprProgram, TestVarlenResultsInTupleContext) {
+    TDB_TEST_BEGIN
+    std::unique_ptr<Schema> schema(Schema::Create(
+        {initoids::TYP_VARCHAR}, {100}, {true}));
+    schema->ComputeLayout();
+
+    // CAST(s AS VARCHAR(60)) copies the first 60 bytes of s.
+    std::unique_ptr<ExprNode> expr =
+        ExprNode::CreateCast(Col(0), initoids::TYP_VARCHAR, 60);
+    expr->Bind(schema.get());
+    std::unique_ptr<ExprProgram> prog =
+        ExprProgram::Compile(expr.get(), schema.get());
+    MemoryContext *tuple_mctx = prog->GetTupleMemoryContext();
+    EXPECT_EQ(tuple_mctx->GetParent(), prog->GetQueryMemoryContext());
+
+    constexpr int NumRecords = 1000;
+    std::string str(100, 'x');
+    maxaligned_char_buf buf;
+    for (int i = 0; i < NumRecords; ++i) {
+        str[0] = (char)('a' + i % 26);
+        std::vector<Datum> data;
+        data.emplace_back(Datum::FromVarlenAsStringView(str));
+        buf.clear();
+        ASSERT_NE(schema->WritePayloadToBuffer(data, buf), -1);
+        NullableDatumRef res = prog->Eval(buf.data());
+        ASSERT_FALSE(res.isnull());
+        ASSERT_EQ(res.GetVarlenAsStringView(),
+                  absl::string_view(str).substr(0, 60));
+    }
+
+    // The results of all the records would have taken 60KB without the
+    // reset on every evaluation.
+    EXPECT_EQ(tuple_mctx->GetTotalBlockSize(),
+              MemoryContext::DefaultInitBlockSize);
+    EXPECT_EQ(GetCurrentMemoryContext(), nullptr);
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,291 @@
+#include "base/TDBDBTest.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <absl/flags/declare.h>
+#include <absl/flags/flag.h>
+#include <absl/flags/reflection.h>
+#include <absl/strings/str_cat.h>
+
+#include "catalog/CatCache.h"
+#include "storage/TableSynopsis.h"
+
+ABSL_DECLARE_FLAG(uint32_t, synopsis_pages_per_range);
+
+namespace taco {
+
+/*!
+ * The tests are over the records of (a INT4, b VARCHAR(20)), where both
+ * fields are nullable, with Null for a null value of a and nullptr for a
+ * null value of b. A record on page `pid' is in range `pid / 32' with the
+ * default `--synopsis_pages_per_range'.
+ */
+class BasicTestTableSynopsis: public TDBDBTest {
+protected:
+    void
+    SetUp() override {
+        TDBDBTest::SetUp();
+        TDB_TEST_BEGIN
+        m_schema.reset(Schema::Create(
+            {initoids::TYP_INT4, initoids::TYP_VARCHAR}, {0, 20},
+            {true, true}));
+        m_schema->ComputeLayout();
+        TDB_TEST_END
+    }
+
+    void
+    Insert(TableSynopsis *synopsis, PageNumber pid, int64_t a,
+           const char *b) {
+        std::vector<Datum> data;
+        data.emplace_back((a == Null) ? Datum::FromNull() :
+                          Datum::From((int32_t) a));
+        data.emplace_back(b ? Datum::FromCString(b) : Datum::FromNull());
+        maxaligned_char_buf buf;
+        ASSERT_NE(m_schema->WritePayloadToBuffer(data, buf), -1);
+        Record rec(buf);
+        rec.GetRecordId().pid = pid;
+        rec.GetRecordId().sid = 1;
+        synopsis->InsertRecord(rec);
+    }
+
+    static bool
+    MayMatchA(const TableSynopsis *synopsis, uint64_t range, OpType optype,
+              int64_t a) {
+        Datum value = (a == Null) ? Datum::FromNull() :
+                      Datum::From((int32_t) a);
+        return synopsis->RangeMayMatch(range, 0, optype, value);
+    }
+
+    static bool
+    MayMatchB(const TableSynopsis *synopsis, uint64_t range, OpType optype,
+              const std::string &b) {
+        Datum value = Datum::FromVarlenAsStringView(b);
+        return synopsis->RangeMayMatch(range, 1, optype, value);
+    }
+
+    /*!
+     * Fills \p synopsis with:
+     * - range 0: a in [10, 20] and b in ["k10", "k20"], no nulls;
+     * - range 1: a in [100, 110] and a null a, with b all null;
+     * - range 2: a always null, b = "x";
+     * - range 3: a always 7, b = "y".
+     */
+    void
+    Fill(TableSynopsis *synopsis) {
+        for (int64_t a = 20; a >= 10; --a) {
+            Insert(synopsis, (PageNumber)(1 + a), a,
+                   absl::StrCat("k", a).c_str());
+        }
+        for (int64_t a = 100; a <= 110; ++a) {
+            Insert(synopsis, 32 + (PageNumber) a % 32, a, nullptr);
+        }
+        Insert(synopsis, 40, Null, nullptr);
+        for (PageNumber pid = 64; pid < 96; ++pid) {
+            Insert(synopsis, pid, Null, "x");
+        }
+        for (PageNumber pid = 96; pid < 98; ++pid) {
+            Insert(synopsis, pid, 7, "y");
+        }
+    }
+
+    /*!
+     * Returns a vector of the results of a number of calls to \p synopsis,
+     * so that two synopses can be compared.
+     */
+    static std::vector<bool>
+    Probe(const TableSynopsis *synopsis) {
+        std::vector<bool> res;
+        const OpType optypes[] = { OPTYPE(EQ), OPTYPE(NE), OPTYPE(LT),
+                                   OPTYPE(LE), OPTYPE(GT), OPTYPE(GE) };
+        for (uint64_t range = 0; range < 5; ++range) {
+            res.push_back(synopsis->GetNumRecordsInRange(range));
+            res.push_back(synopsis->RangeMayHaveNull(range, 0));
+            res.push_back(synopsis->RangeMayHaveNull(range, 1));
+            for (OpType optype : optypes) {
+                for (int64_t a = 0; a < 120; ++a) {
+                    res.push_back(MayMatchA(synopsis, range, optype, a));
+                }
+                for (int i = 0; i < 30; ++i) {
+                    res.push_back(MayMatchB(synopsis, range, optype,
+                                            absl::StrCat("k", i)));
+                }
+            }
+        }
+        return res;
+    }
+
+    static constexpr int64_t Null = INT64_MIN;
+
+    std::unique_ptr<Schema> m_schema;
+};
+
+constexpr int64_t BasicTestTableSynopsis::Null;
+
+static std::string
+ReadFile(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    std::ostringstream oss;
+    oss << f.rdbuf();
+    return oss.str();
+}
+
+static void
+WriteFile(const std::string &path, const std::string &bytes) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(bytes.data(), bytes.size());
+}
+
+TEST_F(BasicTestTableSynopsis, TestZoneMapRangeMayMatch) {
+    TDB_TEST_BEGIN
+    std::unique_ptr<TableSynopsis> synopsis =
+        TableSynopsis::Create(m_schema.get(), {}, MakeTempFile());
+    ASSERT_EQ(synopsis->GetPagesPerRange(), 32u);
+    Fill(synopsis.get());
+    EXPECT_EQ(synopsis->GetRangeOfPage(31), 0u);
+    EXPECT_EQ(synopsis->GetRangeOfPage(32), 1u);
+    EXPECT_EQ(synopsis->GetNumRecordsInRange(0), 11u);
+    EXPECT_EQ(synopsis->GetNumRecordsInRange(1), 12u);
+    EXPECT_EQ(synopsis->GetNumRecordsInRange(4), 0u);
+
+    // range 0: a in [10, 20]
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), 10));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), 15));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), 20));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), 9));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), 21));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(LT), 10));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(LT), 11));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(LE), 9));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(LE), 10));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(GT), 20));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(GT), 19));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(GE), 21));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(GE), 20));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(NE), 15));
+    EXPECT_FALSE(synopsis->RangeMayHaveNull(0, 0));
+    EXPECT_FALSE(synopsis->RangeMayHaveNull(0, 1));
+
+    // A predicate over a null value is never satisfied, while the other
+    // operators are never pruned.
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 0, OPTYPE(EQ), Null));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(ADD), 100));
+
+    // The varlen bounds are copied into the synopsis.
+    EXPECT_TRUE(MayMatchB(synopsis.get(), 0, OPTYPE(EQ), "k15"));
+    EXPECT_FALSE(MayMatchB(synopsis.get(), 0, OPTYPE(EQ), "k09"));
+    EXPECT_FALSE(MayMatchB(synopsis.get(), 0, OPTYPE(EQ), "k21"));
+    EXPECT_FALSE(MayMatchB(synopsis.get(), 0, OPTYPE(LT), "k10"));
+    EXPECT_FALSE(MayMatchB(synopsis.get(), 0, OPTYPE(GT), "k20"));
+    EXPECT_TRUE(MayMatchB(synopsis.get(), 0, OPTYPE(GE), "k20"));
+
+    // range 1: a in [100, 110] with a null, and b all null
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 1, OPTYPE(EQ), 105));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 1, OPTYPE(LT), 100));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 1, OPTYPE(EQ), 15));
+    EXPECT_TRUE(synopsis->RangeMayHaveNull(1, 0));
+    EXPECT_TRUE(synopsis->RangeMayHaveNull(1, 1));
+    EXPECT_FALSE(MayMatchB(synopsis.get(), 1, OPTYPE(NE), "k15"));
+
+    // range 2: a all null
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 2, OPTYPE(NE), 0));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 2, OPTYPE(GE), INT32_MIN));
+    EXPECT_TRUE(synopsis->RangeMayHaveNull(2, 0));
+    EXPECT_TRUE(MayMatchB(synopsis.get(), 2, OPTYPE(EQ), "x"));
+
+    // range 3: a is always 7
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 3, OPTYPE(NE), 7));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 3, OPTYPE(NE), 8));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 3, OPTYPE(EQ), 7));
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 3, OPTYPE(GT), 7));
+
+    // range 4 is empty
+    EXPECT_FALSE(MayMatchA(synopsis.get(), 4, OPTYPE(NE), 0));
+    EXPECT_FALSE(synopsis->RangeMayHaveNull(4, 0));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestTableSynopsis, TestBloomFilterNoFalseNegatives) {
+    TDB_TEST_BEGIN
+    std::unique_ptr<TableSynopsis> synopsis =
+        TableSynopsis::Create(m_schema.get(), {0, 1}, MakeTempFile());
+
+    // The values are spread over the whole range of the zone map, so only
+    // the Bloom filter may prune the absent ones.
+    constexpr int64_t NumValues = 500;
+    for (int64_t i = 0; i < NumValues; ++i) {
+        Insert(synopsis.get(), (PageNumber)(1 + i % 31), i * 2,
+               absl::StrCat("v", i * 2).c_str());
+    }
+    int64_t num_pruned_a = 0;
+    int64_t num_pruned_b = 0;
+    for (int64_t i = 0; i < 2 * NumValues; ++i) {
+        bool a_may_match = MayMatchA(synopsis.get(), 0, OPTYPE(EQ), i);
+        bool b_may_match = MayMatchB(synopsis.get(), 0, OPTYPE(EQ),
+                                     absl::StrCat("v", i));
+        if (i % 2 == 0) {
+            // never a false negative
+            ASSERT_TRUE(a_may_match) << i;
+            ASSERT_TRUE(b_may_match) << i;
+        } else {
+            num_pruned_a += !a_may_match;
+            num_pruned_b += !b_may_match;
+        }
+    }
+    EXPECT_GT(num_pruned_a, NumValues * 9 / 10);
+    EXPECT_GT(num_pruned_b, NumValues * 9 / 10);
+
+    // The Bloom filters only prune the equality predicates.
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(LE), 1));
+    EXPECT_TRUE(MayMatchA(synopsis.get(), 0, OPTYPE(NE), 1));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestTableSynopsis, TestFlushOpenRoundTrip) {
+    TDB_TEST_BEGIN
+    absl::FlagSaver flag_saver;
+    absl::SetFlag(&FLAGS_synopsis_pages_per_range, 16);
+    std::string path = MakeTempDir() + "/synopsis";
+    std::unique_ptr<TableSynopsis> synopsis =
+        TableSynopsis::Create(m_schema.get(), {1}, path);
+    Fill(synopsis.get());
+    synopsis->Flush();
+
+    // The file records the number of pages per range, which may have
+    // changed since.
+    absl::SetFlag(&FLAGS_synopsis_pages_per_range, 32);
+    std::unique_ptr<TableSynopsis> synopsis2 =
+        TableSynopsis::Open(m_schema.get(), path);
+    EXPECT_EQ(synopsis2->GetPagesPerRange(), 16u);
+    EXPECT_TRUE(Probe(synopsis2.get()) == Probe(synopsis.get()));
+
+    // Flushing again replaces the file.
+    Insert(synopsis.get(), 200, 1000, "z");
+    synopsis->Flush();
+    synopsis2 = TableSynopsis::Open(m_schema.get(), path);
+    EXPECT_EQ(synopsis2->GetNumRecordsInRange(200 / 16), 1u);
+    EXPECT_TRUE(Probe(synopsis2.get()) == Probe(synopsis.get()));
+
+    // A file that fails the CRC check or is truncated is refused.
+    const std::string bytes = ReadFile(path);
+    ASSERT_GT(bytes.size(), 100u);
+    std::string corrupted = bytes;
+    corrupted[bytes.size() - 10] ^= 1;
+    WriteFile(path, corrupted);
+    EXPECT_REGULAR_ERROR(TableSynopsis::Open(m_schema.get(), path));
+    WriteFile(path, bytes.substr(0, bytes.size() - 8));
+    EXPECT_REGULAR_ERROR(TableSynopsis::Open(m_schema.get(), path));
+    WriteFile(path, bytes.substr(0, 10));
+    EXPECT_REGULAR_ERROR(TableSynopsis::Open(m_schema.get(), path));
+
+    // So is a file of another table.
+    WriteFile(path, bytes);
+    std::unique_ptr<Schema> schema2(Schema::Create(
+        {initoids::TYP_INT4}, {0}, {true}));
+    schema2->ComputeLayout();
+    EXPECT_REGULAR_ERROR(TableSynopsis::Open(schema2.get(), path));
+    EXPECT_NO_ERROR(TableSynopsis::Open(m_schema.get(), path));
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,119 @@
+#include "base/TDBNonDBTest.h"
+
+#include <condition_variable>
+#include <thread>
+
+#include "utils/EpochManager.h"
+
+namespace taco {
+
+using BasicTestEpochManager = TDBNonDBTest;
+
+static atomic<size_t> s_num_freed(0);
+
+static void
+FreeCounted(void *p) {
+    delete (int*) p;
+    s_num_freed.fetch_add(1, memory_order_relaxed);
+}
+
+TEST_F(BasicTestEpochManager, TestReclaimWithoutReaders) {
+    TDB_TEST_BEGIN
+    s_num_freed.store(0);
+    EpochManager epoch;
+    epoch.Retire(new int(0), FreeCounted);
+    epoch.Retire(new int(1), FreeCounted);
+    EXPECT_EQ(epoch.GetNumRetired(), 2u);
+    epoch.Reclaim();
+    EXPECT_EQ(epoch.GetNumRetired(), 0u);
+    EXPECT_EQ(s_num_freed.load(), 2u);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestEpochManager, TestReaderBlocksReclamation) {
+    TDB_TEST_BEGIN
+    s_num_freed.store(0);
+    EpochManager epoch;
+
+    // Retired before the reader enters, so the reader can't see it.
+    epoch.Retire(new int(0), FreeCounted);
+    {
+        EpochGuard guard(&epoch);
+        {
+            // Nested sections do not move the reader's epoch.
+            EpochGuard nested_guard(&epoch);
+            epoch.Retire(new int(1), FreeCounted);
+        }
+        epoch.Retire(new int(2), FreeCounted);
+        epoch.Reclaim();
+        EXPECT_EQ(s_num_freed.load(), 1u);
+        EXPECT_EQ(epoch.GetNumRetired(), 2u);
+    }
+    epoch.Reclaim();
+    EXPECT_EQ(s_num_freed.load(), 3u);
+    EXPECT_EQ(epoch.GetNumRetired(), 0u);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestEpochManager, TestReaderOnAnotherThread) {
+    TDB_TEST_BEGIN
+    s_num_freed.store(0);
+    EpochManager epoch;
+    std::mutex latch;
+    std::condition_variable cv;
+    bool entered = false;
+    bool may_leave = false;
+
+    std::thread reader([&]() {
+        EpochGuard guard(&epoch);
+        std::unique_lock<std::mutex> lock(latch);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return may_leave; });
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(latch);
+        cv.wait(lock, [&]() { return entered; });
+    }
+
+    // Retiring enough objects to trigger the opportunistic reclamation in
+    // Retire() must not free any of them while the reader is in.
+    constexpr int NumObjects = 100;
+    for (int i = 0; i < NumObjects; ++i) {
+        epoch.Retire(new int(i), FreeCounted);
+    }
+    epoch.Reclaim();
+    EXPECT_EQ(s_num_freed.load(), 0u);
+    EXPECT_EQ(epoch.GetNumRetired(), (size_t) NumObjects);
+
+    {
+        std::unique_lock<std::mutex> lock(latch);
+        may_leave = true;
+        cv.notify_all();
+    }
+    reader.join();
+
+    epoch.Reclaim();
+    EXPECT_EQ(s_num_freed.load(), (size_t) NumObjects);
+    EXPECT_EQ(epoch.GetNumRetired(), 0u);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestEpochManager, TestDestructorFreesRetired) {
+    TDB_TEST_BEGIN
+    s_num_freed.store(0);
+    {
+        EpochManager epoch;
+        {
+            EpochGuard guard(&epoch);
+            epoch.Retire(new int(0), FreeCounted);
+            epoch.Reclaim();
+            EXPECT_EQ(s_num_freed.load(), 0u);
+        }
+    }
+    EXPECT_EQ(s_num_freed.load(), 1u);
+    TDB_TEST_END
+}
+
+}   // namespace taco
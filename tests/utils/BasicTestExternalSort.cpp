@@ -0,0 +1,111 @@
+#include "base/TDBNonDBTest.h"
+
+#include <algorithm>
+
+#include "utils/ExternalSort.h"
+
+namespace taco {
+
+using BasicTestExternalSort = TDBNonDBTest;
+
+/*!
+ * Writes an item with the key \p key into \p buf, which is followed by
+ * a number of bytes derived from the key, and returns its length.
+ */
+static uint32_t
+MakeItem(int64_t key, char *buf) {
+    uint32_t npad = (uint32_t)(key % 97) * 3;
+    memcpy(buf, &key, sizeof(int64_t));
+    for (uint32_t i = 0; i < npad; ++i) {
+        buf[sizeof(int64_t) + i] = (char)(key + i);
+    }
+    return sizeof(int64_t) + npad;
+}
+
+static int
+CompareItems(const char *item1, const char *item2) {
+    int64_t key1, key2;
+    memcpy(&key1, item1, sizeof(int64_t));
+    memcpy(&key2, item2, sizeof(int64_t));
+    return (key1 < key2) ? -1 : ((key1 > key2) ? 1 : 0);
+}
+
+/*!
+ * Adds the keys in \p keys in the order given, and checks that the items
+ * come back sorted and intact.
+ */
+static void
+SortAndCheck(ExternalSort &sorter, std::vector<int64_t> keys) {
+    char buf[sizeof(int64_t) + 300];
+    for (int64_t key : keys) {
+        sorter.AddItem(buf, MakeItem(key, buf));
+    }
+    sorter.Sort();
+
+    std::sort(keys.begin(), keys.end());
+    size_t n = 0;
+    while (sorter.Next()) {
+        ASSERT_LT(n, keys.size());
+        uint32_t len = MakeItem(keys[n], buf);
+        ASSERT_EQ(sorter.GetCurrentItemLength(), len);
+        ASSERT_EQ(((uintptr_t) sorter.GetCurrentItem()) % MAXALIGN_OF, 0);
+        ASSERT_EQ(memcmp(sorter.GetCurrentItem(), buf, len), 0);
+        ++n;
+    }
+    ASSERT_EQ(n, keys.size());
+    ASSERT_FALSE(sorter.Next());
+}
+
+TEST_F(BasicTestExternalSort, TestInMemory) {
+    TDB_TEST_BEGIN
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < 1000; ++i) {
+        keys.push_back((i * 7919) % 1000);
+    }
+    ExternalSort sorter(CompareItems, 0);
+    SortAndCheck(sorter, keys);
+    EXPECT_EQ(sorter.GetNumRuns(), 0);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExternalSort, TestEmpty) {
+    TDB_TEST_BEGIN
+    ExternalSort sorter(CompareItems, 0);
+    sorter.Sort();
+    EXPECT_FALSE(sorter.Next());
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExternalSort, TestMultiPassMerge) {
+    TDB_TEST_BEGIN
+    // With the smallest memory limit, there are more runs than may be
+    // merged at once, so some of them must be merged into new runs first.
+    std::vector<int64_t> keys;
+    std::mt19937_64 rng(0x5eed);
+    for (int64_t i = 0; i < 100000; ++i) {
+        keys.push_back((int64_t)(rng() % 50000));
+    }
+    ExternalSort sorter(CompareItems, 0);
+    SortAndCheck(sorter, keys);
+    EXPECT_GT(sorter.GetNumRuns(), sorter.GetMaxMergeFanIn());
+    EXPECT_GT(sorter.GetNumIntermediateMerges(), 0);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestExternalSort, TestSpillWithoutIntermediateMerge) {
+    TDB_TEST_BEGIN
+    // A few runs that may all be merged at once. The items left in the
+    // buffer are written as the last run before the final merge.
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < 12000; ++i) {
+        keys.push_back(12000 - i);
+    }
+    ExternalSort sorter(CompareItems, 0);
+    SortAndCheck(sorter, keys);
+    EXPECT_GE(sorter.GetNumRuns(), 1);
+    EXPECT_LE(sorter.GetNumRuns(), sorter.GetMaxMergeFanIn());
+    EXPECT_EQ(sorter.GetNumIntermediateMerges(), 0);
+    TDB_TEST_END
+}
+
+}   // namespace taco
@@ -0,0 +1,110 @@
+#include "base/TDBNonDBTest.h"
+
+#include "utils/MemoryContext.h"
+
+namespace taco {
+
+using BasicTestMemoryContext = TDBNonDBTest;
+
+static std::string
+MakeString(size_t len, char c) {
+    std::string str;
+    for (size_t i = 0; i < len; ++i) {
+        str.push_back((char)(c + i % 26));
+    }
+    return str;
+}
+
+TEST_F(BasicTestMemoryContext, TestArenaDatumsSurviveUntilReset) {
+    TDB_TEST_BEGIN
+    MemoryContext mctx;
+    std::string str = MakeString(100, 'a');
+    const char *bytes;
+    Datum copy = Datum::FromNull();
+    {
+        ScopedMemoryContext scoped_mctx(&mctx);
+        ASSERT_EQ(GetCurrentMemoryContext(), &mctx);
+        Datum d = CreateVarlenDatum(str.data(), (uint32_t) str.size());
+        EXPECT_TRUE(d.HasExternalRef());
+        bytes = d.GetVarlenBytes();
+        copy = d.DeepCopy();
+        EXPECT_FALSE(copy.HasExternalRef());
+        // ~Datum must not free the bytes in the arena.
+    }
+    EXPECT_EQ(GetCurrentMemoryContext(), nullptr);
+    EXPECT_EQ(absl::string_view(bytes, str.size()), str);
+
+    // Allocating more doesn't touch the bytes of the earlier datums.
+    for (int i = 0; i < 1000; ++i) {
+        memset(mctx.Allocate(100), 0xff, 100);
+    }
+    EXPECT_EQ(absl::string_view(bytes, str.size()), str);
+    EXPECT_GT(mctx.GetTotalBlockSize(), MemoryContext::DefaultInitBlockSize);
+
+    mctx.Reset();
+    EXPECT_EQ(mctx.GetTotalBlockSize(), MemoryContext::DefaultInitBlockSize);
+    EXPECT_EQ(copy.GetVarlenAsStringView(), str);
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestMemoryContext, TestShortAndUnscopedValues) {
+    TDB_TEST_BEGIN
+    MemoryContext mctx;
+    std::string short_str = MakeString(Datum::MaxInlineVarlenSize, 'A');
+    std::string long_str = MakeString(Datum::MaxInlineVarlenSize + 1, 'A');
+    {
+        ScopedMemoryContext scoped_mctx(&mctx);
+        // A short value is inline, so it is not in the arena.
+        Datum d = CreateVarlenDatum(short_str.data(),
+                                    (uint32_t) short_str.size());
+        EXPECT_TRUE(d.IsInlineVarlen());
+        EXPECT_FALSE(d.HasExternalRef());
+
+        // Nested scopes restore the outer context.
+        {
+            ScopedMemoryContext no_mctx(nullptr);
+            Datum owned = CreateVarlenDatum(long_str.data(),
+                                            (uint32_t) long_str.size());
+            EXPECT_FALSE(owned.HasExternalRef());
+            EXPECT_EQ(owned.GetVarlenAsStringView(), long_str);
+        }
+        EXPECT_EQ(GetCurrentMemoryContext(), &mctx);
+        Datum in_arena = CreateVarlenDatum(long_str.data(),
+                                           (uint32_t) long_str.size());
+        EXPECT_TRUE(in_arena.HasExternalRef());
+        EXPECT_EQ(in_arena.GetVarlenAsStringView(), long_str);
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestMemoryContext, TestResetChildren) {
+    TDB_TEST_BEGIN
+    MemoryContext query_mctx;
+    MemoryContext tuple_mctx(&query_mctx);
+    EXPECT_EQ(tuple_mctx.GetParent(), &query_mctx);
+
+    // A large allocation gets its own block.
+    tuple_mctx.Allocate(MemoryContext::DefaultMaxBlockSize);
+    for (int i = 0; i < 1000; ++i) {
+        query_mctx.Allocate(64);
+        tuple_mctx.Allocate(64);
+    }
+    EXPECT_GT(tuple_mctx.GetTotalBlockSize(),
+              MemoryContext::DefaultMaxBlockSize);
+
+    tuple_mctx.Reset();
+    EXPECT_EQ(tuple_mctx.GetTotalBlockSize(),
+              MemoryContext::DefaultInitBlockSize);
+    EXPECT_GT(query_mctx.GetTotalBlockSize(),
+              MemoryContext::DefaultInitBlockSize);
+
+    tuple_mctx.Allocate(10000);
+    query_mctx.Reset();
+    EXPECT_EQ(query_mctx.GetTotalBlockSize(),
+              MemoryContext::DefaultInitBlockSize);
+    EXPECT_EQ(tuple_mctx.GetTotalBlockSize(),
+              MemoryContext::DefaultInitBlockSize);
+    TDB_TEST_END
+}
+
+}   // namespace taco
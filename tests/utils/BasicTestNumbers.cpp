@@ -0,0 +1,286 @@
+#include "base/TDBNonDBTest.h"
+
+#include <cfloat>
+#include <random>
+
+#include "utils/numbers.h"
+
+namespace taco {
+
+using BasicTestNumbers = TDBNonDBTest;
+
+template<class IntType>
+static std::string
+FormatToString(IntType val) {
+    char buf[IntegerFormatBufLen];
+    size_t len = FormatInteger(buf, val);
+    return std::string(buf, len);
+}
+
+static std::string
+FormatDoubleToString(double val) {
+    char buf[FloatFormatBufLen];
+    size_t len = FormatDouble(buf, val);
+    EXPECT_EQ(strlen(buf), len);
+    return std::string(buf, len);
+}
+
+static std::string
+FormatFloatToString(float val) {
+    char buf[FloatFormatBufLen];
+    size_t len = FormatFloat(buf, val);
+    EXPECT_EQ(strlen(buf), len);
+    return std::string(buf, len);
+}
+
+/*!
+ * Returns the number of significant digits in a formatted number.
+ */
+static int
+CountDigits(const std::string &str) {
+    size_t end = str.find('e');
+    if (end == std::string::npos) {
+        end = str.size();
+    }
+    std::string digits;
+    for (size_t i = 0; i < end; ++i) {
+        if (str[i] >= '0' && str[i] <= '9') {
+            digits.push_back(str[i]);
+        }
+    }
+    size_t first = digits.find_first_not_of('0');
+    if (first == std::string::npos) {
+        return 1;
+    }
+    size_t last = digits.find_last_not_of('0');
+    return (int)(last - first + 1);
+}
+
+TEST_F(BasicTestNumbers, TestFormatInteger) {
+    TDB_TEST_BEGIN
+    EXPECT_EQ(FormatToString((int64_t) 0), "0");
+    EXPECT_EQ(FormatToString((uint64_t) 0), "0");
+    for (int64_t val : { (int64_t) 1, (int64_t) 9, (int64_t) 10,
+                         (int64_t) 99, (int64_t) 100, (int64_t) 101,
+                         (int64_t) 999999999, (int64_t) 1000000000,
+                         (int64_t) -1, (int64_t) -10, (int64_t) -99,
+                         std::numeric_limits<int64_t>::max(),
+                         std::numeric_limits<int64_t>::min() }) {
+        EXPECT_EQ(FormatToString(val), std::to_string(val));
+    }
+    EXPECT_EQ(FormatToString(std::numeric_limits<int64_t>::min()),
+              "-9223372036854775808");
+    EXPECT_EQ(FormatToString(std::numeric_limits<uint64_t>::max()),
+              "18446744073709551615");
+    EXPECT_EQ(FormatToString(std::numeric_limits<int8_t>::min()), "-128");
+    EXPECT_EQ(FormatToString(std::numeric_limits<uint8_t>::max()), "255");
+    EXPECT_EQ(FormatToString(std::numeric_limits<int16_t>::min()),
+              "-32768");
+    EXPECT_EQ(FormatToString(std::numeric_limits<int32_t>::min()),
+              "-2147483648");
+    EXPECT_EQ(FormatToString(std::numeric_limits<uint32_t>::max()),
+              "4294967295");
+
+    // Every number of digits.
+    uint64_t val = 0;
+    for (int i = 0; i < 20; ++i) {
+        val = val * 10 + (uint64_t)(i % 9 + 1);
+        EXPECT_EQ(FormatToString(val), std::to_string(val));
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestNumbers, TestParseDecimalDigits) {
+    TDB_TEST_BEGIN
+    uint64_t val;
+    ASSERT_TRUE(ParseDecimalDigits("0", 1, &val));
+    EXPECT_EQ(val, 0u);
+    ASSERT_TRUE(ParseDecimalDigits("1234567890123456789", 19, &val));
+    EXPECT_EQ(val, 1234567890123456789ull);
+    ASSERT_TRUE(ParseDecimalDigits("9999999999999999999", 19, &val));
+    EXPECT_EQ(val, 9999999999999999999ull);
+    ASSERT_TRUE(ParseDecimalDigits("0000000012345678", 16, &val));
+    EXPECT_EQ(val, 12345678u);
+
+    // A non-digit anywhere in or after an 8-digit chunk.
+    std::string digits = "1234567890123456789";
+    for (size_t i = 0; i < digits.size(); ++i) {
+        for (char c : { '/', ':', 'a', ' ', '\0', '\xb0' }) {
+            std::string str = digits;
+            str[i] = c;
+            EXPECT_FALSE(ParseDecimalDigits(str.data(), str.size(), &val))
+                << i << " " << (int) c;
+        }
+    }
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestNumbers, TestSimpleAtoi) {
+    TDB_TEST_BEGIN
+    int64_t i64;
+    EXPECT_TRUE(SimpleAtoiWrapper("0", &i64));
+    EXPECT_EQ(i64, 0);
+    EXPECT_TRUE(SimpleAtoiWrapper("-0", &i64));
+    EXPECT_EQ(i64, 0);
+    EXPECT_TRUE(SimpleAtoiWrapper("+42", &i64));
+    EXPECT_EQ(i64, 42);
+    EXPECT_TRUE(SimpleAtoiWrapper("-9223372036854775808", &i64));
+    EXPECT_EQ(i64, std::numeric_limits<int64_t>::min());
+    EXPECT_TRUE(SimpleAtoiWrapper("9223372036854775807", &i64));
+    EXPECT_EQ(i64, std::numeric_limits<int64_t>::max());
+    EXPECT_FALSE(SimpleAtoiWrapper("-9223372036854775809", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("9223372036854775808", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("99999999999999999999", &i64));
+
+    // The forms the fast path leaves to absl::SimpleAtoi().
+    EXPECT_TRUE(SimpleAtoiWrapper(" 12", &i64));
+    EXPECT_EQ(i64, 12);
+    EXPECT_TRUE(SimpleAtoiWrapper(" -12 ", &i64));
+    EXPECT_EQ(i64, -12);
+    EXPECT_TRUE(SimpleAtoiWrapper("00000000000000000000001", &i64));
+    EXPECT_EQ(i64, 1);
+    EXPECT_FALSE(SimpleAtoiWrapper("", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("-", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("+", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("12a", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("1 2", &i64));
+    EXPECT_FALSE(SimpleAtoiWrapper("--1", &i64));
+
+    uint64_t u64;
+    EXPECT_TRUE(SimpleAtoiWrapper("18446744073709551615", &u64));
+    EXPECT_EQ(u64, std::numeric_limits<uint64_t>::max());
+    EXPECT_FALSE(SimpleAtoiWrapper("18446744073709551616", &u64));
+    EXPECT_FALSE(SimpleAtoiWrapper("-1", &u64));
+    EXPECT_TRUE(SimpleAtoiWrapper("+1", &u64));
+    EXPECT_EQ(u64, 1u);
+
+    int32_t i32;
+    EXPECT_TRUE(SimpleAtoiWrapper("-2147483648", &i32));
+    EXPECT_EQ(i32, std::numeric_limits<int32_t>::min());
+    EXPECT_FALSE(SimpleAtoiWrapper("2147483648", &i32));
+    uint32_t u32;
+    EXPECT_TRUE(SimpleAtoiWrapper("4294967295", &u32));
+    EXPECT_EQ(u32, std::numeric_limits<uint32_t>::max());
+    EXPECT_FALSE(SimpleAtoiWrapper("4294967296", &u32));
+    int16_t i16;
+    EXPECT_TRUE(SimpleAtoiWrapper("-32768", &i16));
+    EXPECT_EQ(i16, -32768);
+    EXPECT_FALSE(SimpleAtoiWrapper("32768", &i16));
+    EXPECT_FALSE(SimpleAtoiWrapper(" 32768", &i16));
+    int8_t i8;
+    EXPECT_TRUE(SimpleAtoiWrapper("127", &i8));
+    EXPECT_EQ(i8, 127);
+    EXPECT_FALSE(SimpleAtoiWrapper("128", &i8));
+    EXPECT_FALSE(SimpleAtoiWrapper("-129", &i8));
+    uint8_t u8;
+    EXPECT_TRUE(SimpleAtoiWrapper("255", &u8));
+    EXPECT_EQ(u8, 255);
+    EXPECT_FALSE(SimpleAtoiWrapper("256", &u8));
+    EXPECT_FALSE(SimpleAtoiWrapper("-1", &u8));
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestNumbers, TestFormatDouble) {
+    TDB_TEST_BEGIN
+    EXPECT_EQ(FormatDoubleToString(0.0), "0");
+    EXPECT_EQ(FormatDoubleToString(-0.0), "-0");
+    EXPECT_EQ(FormatDoubleToString(1.0), "1");
+    EXPECT_EQ(FormatDoubleToString(-1.5), "-1.5");
+    EXPECT_EQ(FormatDoubleToString(0.1), "0.1");
+    EXPECT_EQ(FormatDoubleToString(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(FormatDoubleToString(1.0 / 3), "0.3333333333333333");
+    EXPECT_EQ(FormatDoubleToString(100.0), "100");
+    EXPECT_EQ(FormatDoubleToString(123456789012345.0), "123456789012345");
+    EXPECT_EQ(FormatDoubleToString(1e15), "1e+15");
+    EXPECT_EQ(FormatDoubleToString(1e23), "1e+23");
+    EXPECT_EQ(FormatDoubleToString(0.0001), "0.0001");
+    EXPECT_EQ(FormatDoubleToString(0.00001), "1e-05");
+    EXPECT_EQ(FormatDoubleToString(9007199254740992.0),
+              "9007199254740992");
+    EXPECT_EQ(FormatDoubleToString(DBL_MAX), "1.7976931348623157e+308");
+    EXPECT_EQ(FormatDoubleToString(DBL_MIN), "2.2250738585072014e-308");
+    EXPECT_EQ(FormatDoubleToString(5e-324), "5e-324");
+    EXPECT_EQ(FormatDoubleToString(-5e-324), "-5e-324");
+    EXPECT_EQ(FormatDoubleToString(std::numeric_limits<double>::infinity()),
+              "inf");
+    EXPECT_EQ(FormatDoubleToString(-std::numeric_limits<double>::infinity()),
+              "-inf");
+    TDB_TEST_END
+}
+
+TEST_F(BasicTestNumbers, TestFormatFloat) {
+    TDB_TEST_BEGIN
+    EXPECT_EQ(FormatFloatToString(0.0f), "0");
+    EXPECT_EQ(FormatFloatToString(-0.0f), "-0");
+    EXPECT_EQ(FormatFloatToString(0.1f), "0.1");
+    EXPECT_EQ(FormatFloatToString(1.0f / 3), "0.33333334");
+    EXPECT_EQ(FormatFloatToString(16777216.0f), "16777216");
+    EXPECT_EQ(FormatFloatToString(1e6f), "1e+06");
+    EXPECT_EQ(FormatFloatToString(123456.0f), "123456");
+    EXPECT_EQ(FormatFloatToString(FLT_MAX), "3.4028235e+38");
+    EXPECT_EQ(FormatFloatToString(FLT_MIN), "1.1754944e-38");
+    EXPECT_EQ(FormatFloatToString(std::numeric_limits<float>::denorm_min()),
+              "1e-45");
+    TDB_TEST_END
+}
+
+/*!
+ * Checks that \p str reads back as \p val and that it has no more digits
+ * than the correctly rounded representation with the least precision that
+ * reads back as \p val.
+ */
+template<class T, class Parser>
+static void
+CheckRoundTrip(T val, const std::string &str, int max_digits,
+               Parser parse) {
+    ASSERT_EQ(parse(str.c_str()), val) << str;
+    char buf[64];
+    for (int prec = 1; prec <= max_digits; ++prec) {
+        snprintf(buf, sizeof(buf), "%.*e", prec - 1, (double) val);
+        if (parse(buf) == val) {
+            ASSERT_LE(CountDigits(str), prec) << str << " " << buf;
+            return;
+        }
+    }
+}
+
+TEST_F(BasicTestNumbers, TestFloatingPointRoundTrip) {
+    TDB_TEST_BEGIN
+    std::mt19937_64 rng(31);
+    auto parse_double = [](const char *s) { return strtod(s, nullptr); };
+    auto parse_float = [](const char *s) { return strtof(s, nullptr); };
+
+    // Random bit patterns cover all the exponents, and some of them are
+    // among the values Grisu3 can't handle.
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = rng();
+        double d;
+        memcpy(&d, &bits, sizeof(double));
+        if (std::isfinite(d)) {
+            CheckRoundTrip(d, FormatDoubleToString(d), 17, parse_double);
+        }
+        uint32_t bits32 = (uint32_t) bits;
+        float f;
+        memcpy(&f, &bits32, sizeof(float));
+        if (std::isfinite(f)) {
+            CheckRoundTrip(f, FormatFloatToString(f), 9, parse_float);
+        }
+    }
+
+    // Short decimals and powers of two, where the lower boundary is closer.
+    for (int i = 0; i < 100000; ++i) {
+        double d = (double)(rng() % 1000000) / 1000;
+        CheckRoundTrip(d, FormatDoubleToString(d), 17, parse_double);
+    }
+    for (int e = -1074; e <= 1023; ++e) {
+        double d = std::ldexp(1.0, e);
+        CheckRoundTrip(d, FormatDoubleToString(d), 17, parse_double);
+    }
+    for (int e = -149; e <= 127; ++e) {
+        float f = std::ldexp(1.0f, e);
+        CheckRoundTrip(f, FormatFloatToString(f), 9, parse_float);
+    }
+    TDB_TEST_END
+}
+
+}   // namespace taco